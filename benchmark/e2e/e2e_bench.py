@@ -0,0 +1,362 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""End-to-end Matter timings against a Linux accessory.
+
+Starts a Linux Matter accessory (e.g. chip-all-clusters-app from
+connectedhomeip) on this machine, has the controller commission it on-network
+through /api/pairing and then measures, through the REST API:
+
+- commissioning time, with the PASE and commissioning stages of the job
+- CASE establishment, by restarting the accessory so the session has to be
+  set up again
+- invoke, read and write round trips, split into the Server-Timing stages
+- subscription report latency, from the accessory sending the report to the
+  report arriving on the controller's /api/subscriptions/<id>/stream, both
+  clocks being this machine's
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import http.client
+import json
+import os
+import re
+import subprocess
+import sys
+import threading
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'load'))
+from loadgen import Client, Stats  # noqa: E402
+
+READY_RE = re.compile(r'Server (Listening|initialization complete)|mDNS service published')
+# [1697040123.456789][12345:12346] CHIP:DMG: <RE> Sending report ...
+CHIP_LOG_RE = re.compile(r'^\[(\d+\.\d+)\]\[[\d:]+\] CHIP:(\w+): (.*)$')
+REPORT_RE = re.compile(r'<RE> Sending report')
+
+ON_OFF_CLUSTER = 0x0006
+ON_OFF_ATTRIBUTE = 0x0000
+ON_TIME_ATTRIBUTE = 0x4001  # Writable u16 of the On/Off cluster
+TOGGLE_COMMAND = 0x02
+
+
+class Accessory:
+    """Linux accessory process whose log lines are timestamped as they arrive"""
+
+    def __init__(self, args):
+        self.args = args
+        self.proc = None
+        self.lines = []  # (timestamp, category, message)
+        self.lock = threading.Lock()
+        self.ready = threading.Event()
+
+    def start(self, fresh):
+        if fresh and os.path.exists(self.args.kvs):
+            os.remove(self.args.kvs)
+        self.ready.clear()
+        cmd = [self.args.accessory, '--discriminator', str(self.args.discriminator),
+               '--passcode', str(self.args.pincode), '--KVS', self.args.kvs,
+               '--secured-device-port', str(self.args.accessory_port)]
+        self.proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                     universal_newlines=True, errors='replace')
+        threading.Thread(target=self._read, args=(self.proc,), daemon=True).start()
+        if not self.ready.wait(self.args.accessory_timeout):
+            raise RuntimeError('accessory not ready after %d s' % self.args.accessory_timeout)
+
+    def _read(self, proc):
+        for line in proc.stdout:
+            line = line.rstrip('\n')
+            m = CHIP_LOG_RE.match(line)
+            # CHIP stamps its lines with the epoch time, fall back to the time we read them
+            entry = (float(m.group(1)), m.group(2), m.group(3)) if m else (time.time(), '', line)
+            with self.lock:
+                self.lines.append(entry)
+            if READY_RE.search(line):
+                self.ready.set()
+            if self.args.verbose:
+                print('    [accessory] %s' % line, file=sys.stderr)
+
+    def stop(self):
+        if self.proc is not None:
+            self.proc.terminate()
+            try:
+                self.proc.wait(5)
+            except subprocess.TimeoutExpired:
+                self.proc.kill()
+                self.proc.wait()
+            self.proc = None
+
+    def wait_for(self, pattern, after, timeout_s):
+        """Timestamp of the first log line matching pattern logged after the given time"""
+        deadline = time.monotonic() + timeout_s
+        while time.monotonic() < deadline:
+            with self.lock:
+                for ts, _, msg in self.lines:
+                    if ts >= after and pattern.search(msg):
+                        return ts
+            time.sleep(0.005)
+        return None
+
+    def forget(self):
+        with self.lock:
+            self.lines = []
+
+
+class ReportStream:
+    """Server-Sent Events stream of a subscription whose reports are timestamped as they arrive"""
+
+    def __init__(self, args, subscription_id):
+        self.arrivals = []
+        self.lock = threading.Lock()
+        self.opened = threading.Event()
+        # No read timeout, the controller only sends keepalives every 15 s and stop() closes the socket
+        self.conn = http.client.HTTPConnection(args.host, args.port)
+        # window_ms=0 pushes every report as it comes instead of at the end of a coalescing window
+        self.conn.request('GET', '/api/subscriptions/%d/stream?window_ms=0' % subscription_id)
+        self.resp = self.conn.getresponse()
+        if self.resp.status != 200:
+            raise RuntimeError('stream refused: %d' % self.resp.status)
+        threading.Thread(target=self._read, daemon=True).start()
+        if not self.opened.wait(5.0):
+            raise RuntimeError('stream did not open')
+
+    def _read(self):
+        event = None
+        try:
+            for line in self.resp:
+                line = line.decode(errors='replace').rstrip('\r\n')
+                if line.startswith('event: '):
+                    event = line[7:]
+                elif line.startswith('data: ') and event == 'open':
+                    self.opened.set()
+                elif line.startswith('data: ') and event == 'report':
+                    with self.lock:
+                        self.arrivals.append(time.time())
+        except (OSError, ValueError, http.client.HTTPException):
+            pass
+
+    def wait_for(self, after, timeout_s):
+        """Arrival time of the first report received after the given time"""
+        deadline = time.monotonic() + timeout_s
+        while time.monotonic() < deadline:
+            with self.lock:
+                for ts in self.arrivals:
+                    if ts >= after:
+                        return ts
+            time.sleep(0.005)
+        return None
+
+    def stop(self):
+        self.conn.close()
+
+
+class Bench:
+    def __init__(self, args):
+        self.args = args
+        self.client = Client(args.host, args.port, args.timeout)
+        self.rtt = {}     # operation -> Stats of the client-side round trips
+        self.stages = {}  # operation -> {stage: [ms]}
+        self.results = {}
+
+    def post(self, path, body, timing=True):
+        if timing:
+            path += '?timing=1'
+        latency_ms, status, data = self.client.send('POST', path, json.dumps(body),
+                                                    {'Content-Type': 'application/json'})
+        try:
+            payload = json.loads(data.decode()) if data else {}
+        except ValueError:
+            payload = {}
+        return latency_ms, status, payload
+
+    def server_timing(self):
+        """Stages of the last response from its Server-Timing header, in milliseconds"""
+        stages = {}
+        for part in self.client.headers.get('server-timing', '').split(','):
+            m = re.match(r'\s*(\w+);dur=([\d.]+)', part)
+            if m:
+                stages[m.group(1)] = float(m.group(2))
+        return stages
+
+    def record(self, op, latency_ms, status):
+        self.rtt.setdefault(op, Stats()).record(latency_ms, status)
+        if status < 400:
+            for stage, ms in self.server_timing().items():
+                self.stages.setdefault(op, {}).setdefault(stage, []).append(ms)
+
+    def read_on_off(self):
+        return self.post('/api/read-attribute', {
+            'node_id': self.args.node_id, 'endpoint_ids': [self.args.endpoint],
+            'cluster_ids': [ON_OFF_CLUSTER], 'attribute_ids': [ON_OFF_ATTRIBUTE]})
+
+    def toggle(self):
+        return self.post('/api/invoke-command', {
+            'node_id': self.args.node_id, 'endpoint_id': self.args.endpoint,
+            'cluster_id': ON_OFF_CLUSTER, 'command_id': TOGGLE_COMMAND})
+
+    def commission(self):
+        start = time.monotonic()
+        latency_ms, status, payload = self.post('/api/pairing', {
+            'method': 'onnetwork', 'node_id': self.args.node_id, 'pincode': self.args.pincode}, timing=False)
+        if status != 202:
+            raise RuntimeError('pairing refused: %d %s' % (status, payload))
+        location = payload['location']
+        while True:
+            _, status, data = self.client.send('GET', location, None, {})
+            job = json.loads(data.decode()) if status == 200 else {}
+            if job.get('state') in ('succeeded', 'failed'):
+                break
+            if time.monotonic() - start > self.args.commission_timeout:
+                raise RuntimeError('commissioning did not finish in %d s' % self.args.commission_timeout)
+            time.sleep(0.1)
+        if job['state'] != 'succeeded':
+            raise RuntimeError('commissioning failed: %s' % job.get('error'))
+        self.results['commissioning'] = {
+            'total_ms': job['elapsed_ms'],
+            'stages_ms': {s['name']: s['duration_ms'] for s in job.get('stages', [])},
+        }
+
+    def case_establishment(self, accessory):
+        """Restart the accessory and time the first read that gets through again"""
+        samples = []
+        for _ in range(self.args.case_samples):
+            accessory.stop()
+            accessory.start(fresh=False)
+            start = time.monotonic()
+            while time.monotonic() - start < self.args.commission_timeout:
+                latency_ms, status, _ = self.read_on_off()
+                if status == 200:
+                    samples.append({
+                        'recovery_ms': round((time.monotonic() - start) * 1000.0, 1),
+                        'case_ms': self.server_timing().get('case'),
+                        'read_ms': round(latency_ms, 2),
+                    })
+                    break
+        self.results['case'] = samples
+
+    def round_trips(self):
+        for i in range(self.args.iterations):
+            self.record('invoke', *self.toggle()[:2])
+            self.record('read', *self.read_on_off()[:2])
+            latency_ms, status, _ = self.post('/api/write-attribute', {
+                'node_id': self.args.node_id, 'endpoint_ids': [self.args.endpoint],
+                'cluster_ids': [ON_OFF_CLUSTER], 'attribute_ids': [ON_TIME_ATTRIBUTE],
+                'attribute_value': '{"0:U16": %d}' % (i % 100)})
+            self.record('write', latency_ms, status)
+
+    def subscription_reports(self, accessory):
+        latency_ms, status, payload = self.post('/api/subscribe-attribute', {
+            'node_id': self.args.node_id, 'endpoint_ids': [self.args.endpoint],
+            'cluster_ids': [ON_OFF_CLUSTER], 'attribute_ids': [ON_OFF_ATTRIBUTE],
+            'min_interval': 0, 'max_interval': 60})
+        self.record('subscribe', latency_ms, status)
+        if status >= 400:
+            raise RuntimeError('subscribe failed: %d %s' % (status, payload))
+        stream = ReportStream(self.args, payload['id'])
+        # Let the priming report go out before changing the attribute
+        time.sleep(1.0)
+        reports = Stats()
+        missed = 0
+        try:
+            for _ in range(self.args.iterations):
+                accessory.forget()
+                start = time.time()
+                _, status, _ = self.toggle()
+                sent = accessory.wait_for(REPORT_RE, start, 5.0) if status < 400 else None
+                arrived = stream.wait_for(sent, 5.0) if sent else None
+                if arrived:
+                    reports.record((arrived - sent) * 1000.0, 200)
+                else:
+                    missed += 1
+                time.sleep(0.2)
+        finally:
+            stream.stop()
+        self.rtt['subscription-report'] = reports
+        self.results['subscription_reports_missed'] = missed
+        self.post('/api/shutdown-all-subscriptions', {'node_id': self.args.node_id}, timing=False)
+
+    def report(self):
+        result = dict(self.results)
+        result['operations'] = {}
+        for op, stats in self.rtt.items():
+            summary = stats.summary(1.0)
+            del summary['rps']
+            stage_ms = {}
+            for stage, values in self.stages.get(op, {}).items():
+                values = sorted(values)
+                stage_ms[stage] = round(values[len(values) // 2], 3)
+            summary['median_stages_ms'] = stage_ms
+            result['operations'][op] = summary
+        return result
+
+
+def print_report(result):
+    c = result.get('commissioning')
+    if c:
+        stages = ', '.join('%s %d' % kv for kv in c['stages_ms'].items())
+        print('commissioning: %d ms (%s)' % (c['total_ms'], stages))
+    for i, s in enumerate(result.get('case', [])):
+        print('CASE sample %d: case %s ms, first read %.2f ms, %.1f ms after restart' % (
+            i + 1, s['case_ms'], s['read_ms'], s['recovery_ms']))
+    print('%-20s %6s %9s %9s %9s %9s %7s  median stages (ms)' % ('operation', 'count', 'p50 ms', 'p90 ms', 'p99 ms',
+                                                               'max ms', 'err %'))
+    if result.get('subscription_reports_missed'):
+        print('subscription reports missed: %d' % result['subscription_reports_missed'])
+    for op, s in result['operations'].items():
+        stages = ' '.join('%s=%.2f' % kv for kv in s['median_stages_ms'].items() if kv[0] != 'total')
+        print('%-20s %6d %9.2f %9.2f %9.2f %9.2f %7.2f  %s' % (op, s['count'], s['p50_ms'] or 0, s['p90_ms'] or 0,
+                                                             s['p99_ms'] or 0, s['max_ms'] or 0,
+                                                             s['error_rate'] * 100, stages))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--host', required=True, help='controller address')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--accessory', help='path of the accessory, e.g. out/linux-x64-all-clusters/chip-all-clusters-app;'
+                                            ' without it an already commissioned accessory is used and the CASE and'
+                                            ' subscription report measurements are skipped')
+    parser.add_argument('--accessory-port', type=int, default=5540)
+    parser.add_argument('--accessory-timeout', type=int, default=30)
+    parser.add_argument('--kvs', default='/tmp/e2e_bench_kvs')
+    parser.add_argument('--node-id', type=int, default=0x1234)
+    parser.add_argument('--endpoint', type=int, default=1)
+    parser.add_argument('--pincode', type=int, default=20202021)
+    parser.add_argument('--discriminator', type=int, default=3840)
+    parser.add_argument('--iterations', type=int, default=50)
+    parser.add_argument('--case-samples', type=int, default=3)
+    parser.add_argument('--commission-timeout', type=int, default=120)
+    parser.add_argument('--timeout', type=float, default=15.0, help='request timeout, seconds')
+    parser.add_argument('--json', help='also write the results to this file')
+    parser.add_argument('-v', '--verbose', action='store_true', help='echo the accessory log')
+    args = parser.parse_args()
+
+    bench = Bench(args)
+    accessory = Accessory(args) if args.accessory else None
+    try:
+        if accessory:
+            accessory.start(fresh=True)
+            bench.commission()
+        bench.round_trips()
+        if accessory:
+            bench.subscription_reports(accessory)
+            bench.case_establishment(accessory)
+    finally:
+        if accessory:
+            accessory.stop()
+
+    result = bench.report()
+    print_report(result)
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(result, f, indent=2)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Serves the controller REST API on port 8080 with the simulated backend, so
+ * the HTTP layer can be load tested and profiled on a dev machine without
+ * devices, Wi-Fi or the Matter SDK.
+ */
+
+#include <esp_matter_controller_http_backend_sim.h>
+#include <esp_matter_controller_http_server.h>
+#include <esp_log.h>
+
+using namespace esp_matter::controller::http_server;
+
+static const char *TAG = "host_server";
+
+// A light on node 1, endpoint 1: OnOff, LevelControl and BasicInformation
+static void add_light(void)
+{
+    sim_backend_set_attribute(1, 1, 0x0006, 0x0000, "false");
+    sim_backend_set_attribute(1, 1, 0x0008, 0x0000, "{\"0:U8\": 128}");
+    sim_backend_set_attribute(1, 0, 0x0028, 0x0001, "\"Espressif\"");
+    sim_backend_set_attribute(1, 0, 0x0028, 0x0003, "\"Simulated Light\"");
+}
+
+extern "C" void app_main(void)
+{
+    sim_backend_config_t sim_config = SIM_BACKEND_DEFAULT_CONFIG();
+    controller_backend *backend = http_sim_backend(&sim_config);
+    if (!backend) {
+        ESP_LOGE(TAG, "Failed to create the simulated backend");
+        return;
+    }
+    add_light();
+
+    http_server_config_t config = HTTP_SERVER_DEFAULT_CONFIG();
+    config.backend = backend;
+    // Every run starts from the same state, without subscriptions of the previous one
+    config.persist_subscriptions = false;
+    esp_err_t ret = start_http_server(&config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start HTTP server: %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGI(TAG, "Serving http://localhost:%d/api/help", config.port);
+}
@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Compares the two ways the REST API parses an /api/invoke-command body:
+ * the cJSON tree used by parse_json_request() and the in-place tokenizer
+ * fast path. Both fill the same schema, so only the parsing cost differs.
+ */
+
+#include <esp_matter_controller_http_schema.h>
+#include <esp_matter_controller_http_tokenizer.h>
+#include <cJSON.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace esp_matter::controller::http_server;
+
+#define BENCH_ITERATIONS 20000
+#define BENCH_MAX_BODY 512
+#define BENCH_MAX_TOKENS 32
+
+// Same parameters and schema as invoke_command_handler()
+struct invoke_command_params {
+    uint64_t node_id;
+    uint16_t endpoint_id;
+    uint32_t cluster_id;
+    uint32_t command_id;
+    schema::optional<const char *> command_data;
+    schema::optional<uint16_t> timed_invoke_timeout_ms;
+};
+
+static constexpr auto s_invoke_command_schema = schema::make(
+    schema::field("node_id", &invoke_command_params::node_id),
+    schema::field("endpoint_id", &invoke_command_params::endpoint_id),
+    schema::field("cluster_id", &invoke_command_params::cluster_id),
+    schema::field("command_id", &invoke_command_params::command_id),
+    schema::field("command_data", &invoke_command_params::command_data),
+    schema::field("timed_invoke_timeout_ms", &invoke_command_params::timed_invoke_timeout_ms));
+
+typedef struct {
+    const char *name;
+    const char *body;
+} bench_case_t;
+
+static const bench_case_t s_cases[] = {
+    {"toggle", "{\"node_id\": 1, \"endpoint_id\": 1, \"cluster_id\": 6, \"command_id\": 2}"},
+    {"move-to-level",
+     "{\"node_id\": 1, \"endpoint_id\": 1, \"cluster_id\": 8, \"command_id\": 0, "
+     "\"command_data\": \"{\\\"0:U8\\\": 128, \\\"1:U16\\\": 10, \\\"2:U8\\\": 0, \\\"3:U8\\\": 0}\"}"},
+    {"timed-64bit-node",
+     "{\"node_id\": \"0xFEDCBA9876543210\", \"endpoint_id\": 1, \"cluster_id\": 257, \"command_id\": 0, "
+     "\"command_data\": \"{\\\"0:STR\\\": \\\"1234\\\"}\", \"timed_invoke_timeout_ms\": 1000}"},
+    // \u escapes are left to cJSON, this one measures the fallback overhead
+    {"unicode-fallback",
+     "{\"node_id\": 1, \"endpoint_id\": 1, \"cluster_id\": 40, \"command_id\": 0, "
+     "\"command_data\": \"{\\\"0:STR\\\": \\\"caf\\u00e9\\\"}\"}"},
+};
+
+static uint32_t s_allocations;
+
+static void *counting_malloc(size_t size)
+{
+    s_allocations++;
+    return malloc(size);
+}
+
+typedef struct {
+    int64_t elapsed_us;
+    uint32_t allocations;
+    bool ok;
+} bench_result_t;
+
+// Both paths start from a fresh copy of the body, as a request read with httpd_req_recv() would
+static bench_result_t bench_cjson(const char *body, size_t len)
+{
+    char buf[BENCH_MAX_BODY];
+    bench_result_t result = {0, 0, true};
+    s_allocations = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        memcpy(buf, body, len + 1);
+        cJSON *json = cJSON_Parse(buf);
+        invoke_command_params params{};
+        schema::error_t err;
+        result.ok &= json && schema::parse(json, s_invoke_command_schema, &params, &err);
+        cJSON_Delete(json);
+    }
+    result.elapsed_us = esp_timer_get_time() - start;
+    result.allocations = s_allocations;
+    return result;
+}
+
+static bench_result_t bench_fast_path(const char *body, size_t len)
+{
+    char buf[BENCH_MAX_BODY];
+    json_token_t tokens[BENCH_MAX_TOKENS];
+    bench_result_t result = {0, 0, true};
+    s_allocations = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_ITERATIONS; ++i) {
+        memcpy(buf, body, len + 1);
+        size_t count = 0;
+        invoke_command_params params{};
+        schema::error_t err;
+        if (json_tokenize(buf, len, tokens, BENCH_MAX_TOKENS, &count) == JSON_TOKENIZE_OK) {
+            result.ok &= schema::parse_value(token_value(buf, tokens, 0), s_invoke_command_schema, &params, &err);
+        } else {
+            // Fallback, as in parse_request_params_fast()
+            cJSON *json = cJSON_Parse(buf);
+            result.ok &= json && schema::parse(json, s_invoke_command_schema, &params, &err);
+            cJSON_Delete(json);
+        }
+    }
+    result.elapsed_us = esp_timer_get_time() - start;
+    result.allocations = s_allocations;
+    return result;
+}
+
+static void print_result(const char *name, const char *path, const bench_result_t *result)
+{
+    printf("%-18s %-10s %8" PRIu64 " ns/op %6.2f allocs/op%s\n", name, path,
+           (uint64_t)(result->elapsed_us * 1000 / BENCH_ITERATIONS), (double)result->allocations / BENCH_ITERATIONS,
+           result->ok ? "" : "  PARSE FAILED");
+}
+
+extern "C" void app_main(void)
+{
+    cJSON_Hooks hooks = {counting_malloc, free};
+    cJSON_InitHooks(&hooks);
+
+    printf("invoke-command body parsing, %d iterations per case\n", BENCH_ITERATIONS);
+    for (const bench_case_t &bench_case : s_cases) {
+        size_t len = strlen(bench_case.body);
+        if (len >= BENCH_MAX_BODY) {
+            printf("%-18s body too long\n", bench_case.name);
+            continue;
+        }
+        bench_result_t cjson = bench_cjson(bench_case.body, len);
+        bench_result_t fast = bench_fast_path(bench_case.body, len);
+        print_result(bench_case.name, "cjson", &cjson);
+        print_result(bench_case.name, "tokenizer", &fast);
+    }
+}
@@ -0,0 +1,417 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: Apache-2.0
+
+"""Load generator for the controller REST API.
+
+Runs the scenarios in scenarios/*.json against a controller (a device or the
+benchmark/host_server linux build) and prints, per request type, the request
+rate, latency percentiles and error rate, plus the free heap trend sampled
+from /api/metrics. Results are compared with baseline.json and the exit code
+is 1 if a scenario regressed.
+
+Only the Python standard library is used, so it runs in the ESP-IDF Python
+environment as is.
+"""
+
+import argparse
+import http.client
+import json
+import os
+import random
+import re
+import sys
+import threading
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_SCENARIO_DIR = os.path.join(SCRIPT_DIR, 'scenarios')
+DEFAULT_BASELINE = os.path.join(SCRIPT_DIR, 'baseline.json')
+
+HEAP_SAMPLE_INTERVAL_S = 1.0
+HEAP_METRIC_RE = re.compile(r'^matter_heap_free_bytes\{region="(\w+)"\} (\d+)$', re.M)
+
+
+class Template:
+    """Request body with ${...} placeholders, expanded for every request.
+
+    ${node}       one of the scenario's "nodes", picked at random
+    ${worker}     index of the worker sending the request
+    ${seq}        per-worker request counter
+    ${rand:a:b}   random integer in [a, b]
+    """
+
+    PLACEHOLDER_RE = re.compile(r'\$\{(\w+)(?::(-?\d+):(-?\d+))?\}')
+
+    def __init__(self, body):
+        # Placeholders standing for a whole JSON string value become numbers
+        text = json.dumps(body) if body is not None else ''
+        self.text = re.sub(r'"(\$\{[^}]+\})"', r'\1', text)
+
+    def render(self, rng, nodes, worker, seq):
+        def expand(m):
+            name = m.group(1)
+            if name == 'node':
+                return str(rng.choice(nodes))
+            if name == 'worker':
+                return str(worker)
+            if name == 'seq':
+                return str(seq)
+            if name == 'rand':
+                return str(rng.randint(int(m.group(2)), int(m.group(3))))
+            raise ValueError('unknown placeholder ${%s}' % name)
+        return self.PLACEHOLDER_RE.sub(expand, self.text)
+
+
+class Request:
+    def __init__(self, spec):
+        self.name = spec.get('name', spec['path'])
+        self.method = spec.get('method', 'POST')
+        self.path = spec['path']
+        self.weight = spec.get('weight', 1)
+        self.repeat = spec.get('repeat', 1)
+        self.headers = {'Content-Type': 'application/json'}
+        self.headers.update(spec.get('headers', {}))
+        self.body = Template(spec.get('body'))
+
+
+class Stats:
+    """Latencies and outcomes of one request type, shared by all workers"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies_ms = []
+        self.statuses = {}
+        self.errors = 0
+
+    def record(self, latency_ms, status):
+        with self.lock:
+            self.latencies_ms.append(latency_ms)
+            self.statuses[status] = self.statuses.get(status, 0) + 1
+            # status 0 is a connection error
+            if status == 0 or status >= 400:
+                self.errors += 1
+
+    def summary(self, duration_s):
+        lat = sorted(self.latencies_ms)
+        count = len(lat)
+
+        def pct(p):
+            if not lat:
+                return None
+            return round(lat[min(count - 1, max(0, int(round(p / 100.0 * count)) - 1))], 2)
+
+        return {
+            'count': count,
+            'rps': round(count / duration_s, 1) if duration_s > 0 else 0.0,
+            'p50_ms': pct(50),
+            'p90_ms': pct(90),
+            'p99_ms': pct(99),
+            'max_ms': round(lat[-1], 2) if lat else None,
+            'error_rate': round(self.errors / count, 4) if count else 0.0,
+            'statuses': {str(k): v for k, v in sorted(self.statuses.items())},
+        }
+
+
+class Client:
+    """One keep-alive connection, reopened after errors"""
+
+    def __init__(self, host, port, timeout_s):
+        self.host = host
+        self.port = port
+        self.timeout_s = timeout_s
+        self.conn = None
+        self.headers = {}  # Of the last response, lower-case names
+
+    def send(self, method, path, body, headers):
+        start = time.perf_counter()
+        try:
+            if self.conn is None:
+                self.conn = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout_s)
+            # bytes go out in the same segment as the headers, a str body would be
+            # a second write and meet delayed ACKs
+            self.conn.request(method, path, body=body.encode() if body else None, headers=headers)
+            resp = self.conn.getresponse()
+            data = resp.read()
+            status = resp.status
+            self.headers = {k.lower(): v for k, v in resp.getheaders()}
+            if resp.getheader('Connection', '').lower() == 'close':
+                self.close()
+        except (OSError, http.client.HTTPException):
+            self.close()
+            self.headers = {}
+            data = b''
+            status = 0
+        return (time.perf_counter() - start) * 1000.0, status, data
+
+    def close(self):
+        if self.conn is not None:
+            self.conn.close()
+            self.conn = None
+
+
+class HeapSampler(threading.Thread):
+    """Samples matter_heap_free_bytes from /api/metrics while the load runs"""
+
+    def __init__(self, host, port, timeout_s):
+        super().__init__(daemon=True)
+        self.client = Client(host, port, timeout_s)
+        self.stop_event = threading.Event()
+        self.samples = []  # (seconds since start, {region: free bytes})
+
+    def sample(self, t0):
+        _, status, data = self.client.send('GET', '/api/metrics', None, {})
+        if status == 200:
+            regions = {m.group(1): int(m.group(2)) for m in HEAP_METRIC_RE.finditer(data.decode(errors='replace'))}
+            if regions:
+                self.samples.append((time.monotonic() - t0, regions))
+
+    def run(self):
+        t0 = time.monotonic()
+        while not self.stop_event.is_set():
+            self.sample(t0)
+            self.stop_event.wait(HEAP_SAMPLE_INTERVAL_S)
+        self.sample(t0)
+        self.client.close()
+
+    def trend(self):
+        """Free heap at the start and end, its minimum and least-squares slope per region"""
+        result = {}
+        regions = set()
+        for _, r in self.samples:
+            regions.update(r)
+        for region in sorted(regions):
+            points = [(t, r[region]) for t, r in self.samples if region in r]
+            if not points:
+                continue
+            n = len(points)
+            mean_t = sum(t for t, _ in points) / n
+            mean_v = sum(v for _, v in points) / n
+            var_t = sum((t - mean_t) ** 2 for t, _ in points)
+            slope = sum((t - mean_t) * (v - mean_v) for t, v in points) / var_t if var_t > 0 else 0.0
+            result[region] = {
+                'start': points[0][1],
+                'end': points[-1][1],
+                'min': min(v for _, v in points),
+                'slope_bytes_per_min': round(slope * 60.0, 1),
+            }
+        return result
+
+
+def run_requests(args, requests, nodes, stats, stop_at, worker, rng):
+    """Closed loop: each worker sends its next request once the previous one is answered"""
+    client = Client(args.host, args.port, args.timeout)
+    weights = [r.weight for r in requests]
+    seq = 0
+    while time.monotonic() < stop_at:
+        req = rng.choices(requests, weights)[0]
+        body = req.body.render(rng, nodes, worker, seq)
+        latency_ms, status, _ = client.send(req.method, req.path, body, req.headers)
+        if stats is not None:
+            stats[req.name].record(latency_ms, status)
+        seq += 1
+    client.close()
+
+
+def run_phase(args, specs, nodes, label):
+    """Setup and teardown requests: sent once each, in order, from one connection"""
+    client = Client(args.host, args.port, args.timeout)
+    rng = random.Random(args.seed)
+    failures = 0
+    seq = 0
+    for spec in specs:
+        req = Request(spec)
+        for _ in range(req.repeat):
+            _, status, data = client.send(req.method, req.path, req.body.render(rng, nodes, 0, seq), req.headers)
+            seq += 1
+            if status == 0 or status >= 400:
+                failures += 1
+                if args.verbose:
+                    print('  %s %s -> %d %s' % (label, req.path, status, data[:200]), file=sys.stderr)
+    client.close()
+    return failures
+
+
+def run_scenario(args, scenario):
+    nodes = scenario.get('nodes', [1])
+    requests = [Request(spec) for spec in scenario['requests']]
+    concurrency = args.concurrency or scenario.get('concurrency', 4)
+    duration_s = args.duration or scenario.get('duration_s', 30)
+    warmup_s = scenario.get('warmup_s', 2)
+
+    setup_failures = run_phase(args, scenario.get('setup', []), nodes, 'setup')
+
+    # Warm-up fills sessions and caches on the controller and is not recorded
+    if warmup_s > 0:
+        stop_at = time.monotonic() + warmup_s
+        threads = [threading.Thread(target=run_requests,
+                                    args=(args, requests, nodes, None, stop_at, w, random.Random(args.seed + w)))
+                   for w in range(concurrency)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+    stats = {r.name: Stats() for r in requests}
+    sampler = HeapSampler(args.host, args.port, args.timeout)
+    sampler.start()
+    start = time.monotonic()
+    stop_at = start + duration_s
+    threads = [threading.Thread(target=run_requests,
+                                args=(args, requests, nodes, stats, stop_at, w, random.Random(args.seed + 1000 + w)))
+               for w in range(concurrency)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - start
+    sampler.stop_event.set()
+    sampler.join()
+
+    teardown_failures = run_phase(args, scenario.get('teardown', []), nodes, 'teardown')
+
+    total = Stats()
+    for s in stats.values():
+        total.latencies_ms.extend(s.latencies_ms)
+        total.errors += s.errors
+        for k, v in s.statuses.items():
+            total.statuses[k] = total.statuses.get(k, 0) + v
+
+    return {
+        'scenario': scenario['name'],
+        'concurrency': concurrency,
+        'duration_s': round(elapsed, 1),
+        'setup_failures': setup_failures,
+        'teardown_failures': teardown_failures,
+        'total': total.summary(elapsed),
+        'requests': {name: s.summary(elapsed) for name, s in stats.items()},
+        'heap': sampler.trend(),
+    }
+
+
+def print_result(result):
+    print('\n== %s (%d workers, %.1f s)' % (result['scenario'], result['concurrency'], result['duration_s']))
+    if result['setup_failures'] or result['teardown_failures']:
+        print('   setup failures: %d, teardown failures: %d' % (result['setup_failures'], result['teardown_failures']))
+    print('   %-28s %8s %8s %9s %9s %9s %9s %7s' % ('request', 'count', 'req/s', 'p50 ms', 'p90 ms', 'p99 ms',
+                                                 'max ms', 'err %'))
+    rows = list(result['requests'].items()) + [('total', result['total'])]
+    for name, s in rows:
+        def ms(v):
+            return '%9.2f' % v if v is not None else '%9s' % '-'
+        print('   %-28s %8d %8.1f %s %s %s %s %7.2f' % (name, s['count'], s['rps'], ms(s['p50_ms']), ms(s['p90_ms']),
+                                                      ms(s['p99_ms']), ms(s['max_ms']), s['error_rate'] * 100))
+    codes = ', '.join('%s: %d' % (k if k != '0' else 'conn error', v) for k, v in result['total']['statuses'].items())
+    print('   status codes: %s' % codes)
+    for region, h in result['heap'].items():
+        print('   heap %-9s start %d, end %d, min %d, trend %+.1f B/min' % (region, h['start'], h['end'], h['min'],
+                                                                          h['slope_bytes_per_min']))
+
+
+def check_baseline(result, baseline, tolerance):
+    """Regressions of result against the baseline entry, as human readable strings"""
+    issues = []
+    total = result['total']
+    if 'rps' in baseline and total['rps'] < baseline['rps'] * (1 - tolerance['rps']):
+        issues.append('req/s %.1f < baseline %.1f' % (total['rps'], baseline['rps']))
+    if 'p99_ms' in baseline and total['p99_ms'] is not None and \
+            total['p99_ms'] > baseline['p99_ms'] * (1 + tolerance['p99_ms']):
+        issues.append('p99 %.2f ms > baseline %.2f ms' % (total['p99_ms'], baseline['p99_ms']))
+    if 'error_rate' in baseline and total['error_rate'] > baseline['error_rate'] + tolerance['error_rate']:
+        issues.append('error rate %.2f%% > baseline %.2f%%' % (total['error_rate'] * 100,
+                                                               baseline['error_rate'] * 100))
+    heap = result['heap'].get('all')
+    if heap and 'heap_slope_bytes_per_min' in baseline and \
+            heap['slope_bytes_per_min'] < baseline['heap_slope_bytes_per_min'] - tolerance['heap_slope_bytes_per_min']:
+        issues.append('heap trend %+.1f B/min below baseline %+.1f B/min' % (heap['slope_bytes_per_min'],
+                                                                           baseline['heap_slope_bytes_per_min']))
+    return issues
+
+
+def baseline_entry(result):
+    entry = {
+        'rps': result['total']['rps'],
+        'p99_ms': result['total']['p99_ms'],
+        'error_rate': result['total']['error_rate'],
+    }
+    heap = result['heap'].get('all')
+    if heap:
+        entry['heap_slope_bytes_per_min'] = heap['slope_bytes_per_min']
+    return entry
+
+
+def load_scenarios(paths):
+    scenarios = []
+    for path in paths:
+        if os.path.isdir(path):
+            scenarios.extend(load_scenarios(sorted(os.path.join(path, f) for f in os.listdir(path)
+                                                   if f.endswith('.json'))))
+            continue
+        with open(path) as f:
+            scenario = json.load(f)
+        scenario.setdefault('name', os.path.splitext(os.path.basename(path))[0])
+        scenarios.append(scenario)
+    return scenarios
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('scenarios', nargs='*', default=[DEFAULT_SCENARIO_DIR],
+                        help='scenario files or directories (default: all scenarios)')
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--target', default='host',
+                        help='baseline section to compare with, e.g. host or esp32s3 (default: host)')
+    parser.add_argument('--baseline', default=DEFAULT_BASELINE)
+    parser.add_argument('--update-baseline', action='store_true',
+                        help='store the results as the new baseline of the target instead of comparing')
+    parser.add_argument('--duration', type=float, help='override the scenario duration, seconds')
+    parser.add_argument('--concurrency', type=int, help='override the scenario worker count')
+    parser.add_argument('--timeout', type=float, default=10.0, help='request timeout, seconds')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--json', help='also write the results to this file')
+    parser.add_argument('-v', '--verbose', action='store_true')
+    args = parser.parse_args()
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    tolerance = baseline['tolerance']
+    target_baseline = baseline['targets'].setdefault(args.target, {})
+
+    results = []
+    regressions = 0
+    for scenario in load_scenarios(args.scenarios):
+        result = run_scenario(args, scenario)
+        results.append(result)
+        print_result(result)
+        if args.update_baseline:
+            target_baseline[result['scenario']] = baseline_entry(result)
+            continue
+        entry = target_baseline.get(result['scenario'])
+        if not entry:
+            print('   no %s baseline' % args.target)
+            continue
+        issues = check_baseline(result, entry, tolerance)
+        for issue in issues:
+            print('   REGRESSION: %s' % issue)
+        regressions += bool(issues)
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump({'target': args.target, 'results': results}, f, indent=2)
+    if args.update_baseline:
+        with open(args.baseline, 'w') as f:
+            json.dump(baseline, f, indent=2)
+            f.write('\n')
+        print('\nBaseline for %s updated in %s' % (args.target, args.baseline))
+        return 0
+    if regressions:
+        print('\n%d scenario(s) regressed against the %s baseline' % (regressions, args.target))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,296 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Measures the two per-attribute hot paths of a read: decode_attribute_record()
+ * turning a reported TLV element into a result record on the CHIP thread, and
+ * the response serializers turning records into the body sent to the client.
+ * The payloads are synthetic: they are written with TLVWriter in the shapes
+ * devices report, from a boolean to the access control list, not captured
+ * from real devices.
+ */
+
+#include <esp_matter_controller_http_decode.h>
+#include <esp_matter_controller_http_encoding.h>
+#include <esp_matter_controller_http_results.h>
+#include <cJSON.h>
+#include <esp_timer.h>
+#include <lib/support/CodeUtils.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace esp_matter::controller::http_server;
+
+#define BENCH_DECODE_ITERATIONS 20000
+#define BENCH_SERIALIZE_ITERATIONS 2000
+#define BENCH_PAYLOAD_MAX 512
+#define BENCH_RECORDS_MAX 16 // Reports per response in the largest serializer case
+
+static uint32_t s_allocations;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    s_allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    s_allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    s_allocations++;
+    return __real_realloc(ptr, size);
+}
+}
+
+typedef struct {
+    const char *name;
+    chip::app::ConcreteDataAttributePath path;
+    CHIP_ERROR (*write)(chip::TLV::TLVWriter &writer);
+    uint8_t payload[BENCH_PAYLOAD_MAX];
+    uint32_t payload_len;
+} bench_case_t;
+
+static CHIP_ERROR write_bool(chip::TLV::TLVWriter &writer)
+{
+    return writer.PutBoolean(chip::TLV::AnonymousTag(), true);
+}
+
+static CHIP_ERROR write_uint8(chip::TLV::TLVWriter &writer)
+{
+    return writer.Put(chip::TLV::AnonymousTag(), (uint8_t)128);
+}
+
+static CHIP_ERROR write_int16(chip::TLV::TLVWriter &writer)
+{
+    return writer.Put(chip::TLV::AnonymousTag(), (int16_t)-200);
+}
+
+static CHIP_ERROR write_uint64(chip::TLV::TLVWriter &writer)
+{
+    return writer.Put(chip::TLV::AnonymousTag(), (uint64_t)0xFEDCBA9876543210ULL);
+}
+
+static CHIP_ERROR write_float(chip::TLV::TLVWriter &writer)
+{
+    return writer.Put(chip::TLV::AnonymousTag(), 21.5f);
+}
+
+static CHIP_ERROR write_null(chip::TLV::TLVWriter &writer)
+{
+    return writer.PutNull(chip::TLV::AnonymousTag());
+}
+
+static CHIP_ERROR write_short_string(chip::TLV::TLVWriter &writer)
+{
+    return writer.PutString(chip::TLV::AnonymousTag(), "Espressif");
+}
+
+// Longer than RESULT_RECORD_STR_MAX, so the decoder truncates it
+static CHIP_ERROR write_long_string(chip::TLV::TLVWriter &writer)
+{
+    char str[300];
+    for (size_t i = 0; i < sizeof(str) - 1; ++i) {
+        str[i] = 'a' + i % 26;
+    }
+    str[sizeof(str) - 1] = '\0';
+    return writer.PutString(chip::TLV::AnonymousTag(), str);
+}
+
+// Descriptor ServerList of a device with many clusters
+static CHIP_ERROR write_server_list(chip::TLV::TLVWriter &writer)
+{
+    static const uint32_t clusters[] = {0x0003, 0x0004, 0x0005, 0x0006, 0x0008, 0x001D, 0x001E, 0x0028,
+                                        0x002A, 0x002B, 0x002C, 0x002E, 0x0030, 0x0031, 0x0033, 0x0034,
+                                        0x0035, 0x0037, 0x003C, 0x003E, 0x003F, 0x0040, 0x0041, 0x0300};
+    chip::TLV::TLVType outer;
+    ReturnErrorOnFailure(writer.StartContainer(chip::TLV::AnonymousTag(), chip::TLV::kTLVType_Array, outer));
+    for (uint32_t cluster : clusters) {
+        ReturnErrorOnFailure(writer.Put(chip::TLV::AnonymousTag(), cluster));
+    }
+    return writer.EndContainer(outer);
+}
+
+// AccessControl ACL: a list of structures nesting a list of subjects
+static CHIP_ERROR write_acl(chip::TLV::TLVWriter &writer)
+{
+    chip::TLV::TLVType list, entry, subjects;
+    ReturnErrorOnFailure(writer.StartContainer(chip::TLV::AnonymousTag(), chip::TLV::kTLVType_Array, list));
+    for (uint8_t i = 0; i < 3; ++i) {
+        ReturnErrorOnFailure(writer.StartContainer(chip::TLV::AnonymousTag(), chip::TLV::kTLVType_Structure, entry));
+        ReturnErrorOnFailure(writer.Put(chip::TLV::ContextTag(1), (uint8_t)(i == 0 ? 5 : 3))); // Privilege
+        ReturnErrorOnFailure(writer.Put(chip::TLV::ContextTag(2), (uint8_t)2));               // AuthMode CASE
+        ReturnErrorOnFailure(writer.StartContainer(chip::TLV::ContextTag(3), chip::TLV::kTLVType_Array, subjects));
+        for (uint64_t subject = 0; subject <= i; ++subject) {
+            ReturnErrorOnFailure(writer.Put(chip::TLV::AnonymousTag(), (uint64_t)(0x1122334455667700ULL + subject)));
+        }
+        ReturnErrorOnFailure(writer.EndContainer(subjects));
+        ReturnErrorOnFailure(writer.PutNull(chip::TLV::ContextTag(4))); // Targets
+        ReturnErrorOnFailure(writer.Put(chip::TLV::ContextTag(254), (uint8_t)1));
+        ReturnErrorOnFailure(writer.EndContainer(entry));
+    }
+    return writer.EndContainer(list);
+}
+
+static bench_case_t s_cases[] = {
+    {"bool", {1, 0x0006, 0x0000}, write_bool},
+    {"uint8", {1, 0x0008, 0x0000}, write_uint8},
+    {"int16", {1, 0x0402, 0x0000}, write_int16},
+    {"uint64", {0, 0x0028, 0x0014}, write_uint64},
+    {"float", {1, 0x0402, 0x0000}, write_float},
+    {"null", {1, 0x0008, 0x0011}, write_null},
+    {"string-short", {0, 0x0028, 0x0001}, write_short_string},
+    {"string-long", {0, 0x0028, 0x0005}, write_long_string},
+    {"list-u32", {0, 0x001D, 0x0001}, write_server_list},
+    {"list-struct", {0, 0x001F, 0x0000}, write_acl},
+};
+
+static bool build_payload(bench_case_t *bench_case)
+{
+    chip::TLV::TLVWriter writer;
+    writer.Init(bench_case->payload, sizeof(bench_case->payload));
+    if (bench_case->write(writer) != CHIP_NO_ERROR || writer.Finalize() != CHIP_NO_ERROR) {
+        return false;
+    }
+    bench_case->payload_len = writer.GetLengthWritten();
+    return true;
+}
+
+typedef struct {
+    int64_t elapsed_us;
+    uint32_t allocations;
+    size_t bytes; // Output size of one iteration
+    bool ok;
+} bench_result_t;
+
+// As ReadClient hands an AttributeDataIB's data to the read callback: positioned on the element
+static bench_result_t bench_decode(const bench_case_t *bench_case, result_record_t *record)
+{
+    bench_result_t result = {0, 0, sizeof(*record), true};
+    s_allocations = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < BENCH_DECODE_ITERATIONS; ++i) {
+        chip::TLV::TLVReader reader;
+        reader.Init(bench_case->payload, bench_case->payload_len);
+        result.ok &= reader.Next() == CHIP_NO_ERROR;
+        decode_attribute_record(0x1234, bench_case->path, &reader, record);
+    }
+    result.elapsed_us = esp_timer_get_time() - start;
+    result.allocations = s_allocations;
+    return result;
+}
+
+typedef enum {
+    SERIALIZE_JSON,             // send_json_response(): cJSON tree, cJSON_Print()
+    SERIALIZE_JSON_UNFORMATTED, // Same tree, cJSON_PrintUnformatted()
+    SERIALIZE_CBOR,
+    SERIALIZE_TLV,
+} serializer_t;
+
+static const char *const s_serializer_names[] = {"json", "json-compact", "cbor", "tlv"};
+
+static bool serialize_once(serializer_t serializer, pending_op *op, uint8_t *buf, size_t size, size_t *out_len)
+{
+    if (serializer == SERIALIZE_CBOR || serializer == SERIALIZE_TLV) {
+        http_encoding_t encoding = serializer == SERIALIZE_CBOR ? HTTP_ENCODING_CBOR : HTTP_ENCODING_TLV;
+        return http_encode_records(encoding, op, buf, size, out_len) == ESP_OK;
+    }
+    // The body read_attribute_handler() sends
+    cJSON *response = cJSON_CreateObject();
+    if (!response) {
+        return false;
+    }
+    cJSON_AddStringToObject(response, "status", "success");
+    cJSON_AddStringToObject(response, "message", "Read attribute completed successfully");
+    cJSON_AddItemToObject(response, "attributes", http_records_to_json(op, true));
+    char *json = serializer == SERIALIZE_JSON ? cJSON_Print(response) : cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+    if (!json) {
+        return false;
+    }
+    *out_len = strlen(json);
+    cJSON_free(json);
+    return true;
+}
+
+// Each iteration serializes record_count copies of the record; refilling the ring is not timed
+static bench_result_t bench_serialize(serializer_t serializer, pending_op *op, uint32_t record_count, uint8_t *buf,
+                                      size_t size)
+{
+    bench_result_t result = {0, 0, 0, true};
+    s_allocations = 0;
+    for (int i = 0; i < BENCH_SERIALIZE_ITERATIONS; ++i) {
+        op->ring.reset();
+        op->ring.head.store(record_count, std::memory_order_release);
+        int64_t start = esp_timer_get_time();
+        result.ok &= serialize_once(serializer, op, buf, size, &result.bytes);
+        result.elapsed_us += esp_timer_get_time() - start;
+    }
+    result.allocations = s_allocations;
+    return result;
+}
+
+static void print_result(const char *name, const char *path, uint32_t iterations, const bench_result_t *result)
+{
+    printf("%-14s %-16s %8" PRIu64 " ns/op %7.2f allocs/op %6u B%s\n", name, path,
+           (uint64_t)(result->elapsed_us * 1000 / iterations), (double)result->allocations / iterations,
+           (unsigned)result->bytes, result->ok ? "" : "  FAILED");
+}
+
+extern "C" void app_main(void)
+{
+    static result_record_t s_records[BENCH_RECORDS_MAX];
+    static pending_op s_op;
+    size_t buf_size = http_records_encoded_size(BENCH_RECORDS_MAX);
+    uint8_t *buf = (uint8_t *)malloc(buf_size);
+    if (!buf) {
+        printf("Out of memory\n");
+        return;
+    }
+    s_op.ring.attach(s_records, BENCH_RECORDS_MAX);
+
+    printf("decode_attribute_record(), %d iterations per case\n", BENCH_DECODE_ITERATIONS);
+    for (bench_case_t &bench_case : s_cases) {
+        if (!build_payload(&bench_case)) {
+            printf("%-14s payload does not fit\n", bench_case.name);
+            continue;
+        }
+        bench_result_t decode = bench_decode(&bench_case, &s_records[0]);
+        print_result(bench_case.name, "decode", BENCH_DECODE_ITERATIONS, &decode);
+    }
+
+    printf("\nresponse serialization, %d iterations per case\n", BENCH_SERIALIZE_ITERATIONS);
+    for (const bench_case_t &bench_case : s_cases) {
+        if (bench_case.payload_len == 0) {
+            continue;
+        }
+        // The ring holds BENCH_RECORDS_MAX copies of this case's record
+        bench_decode(&bench_case, &s_records[0]);
+        for (uint32_t i = 1; i < BENCH_RECORDS_MAX; ++i) {
+            s_records[i] = s_records[0];
+        }
+        for (uint32_t record_count : {1u, (uint32_t)BENCH_RECORDS_MAX}) {
+            for (int serializer = SERIALIZE_JSON; serializer <= SERIALIZE_TLV; ++serializer) {
+                char path[32];
+                snprintf(path, sizeof(path), "%s x%" PRIu32, s_serializer_names[serializer], record_count);
+                bench_result_t result = bench_serialize((serializer_t)serializer, &s_op, record_count, buf, buf_size);
+                print_result(bench_case.name, path, BENCH_SERIALIZE_ITERATIONS, &result);
+            }
+        }
+    }
+    free(buf);
+}
@@ -0,0 +1,162 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_arena.h>
+#include <esp_matter_controller_http_memory.h>
+#include <cJSON.h>
+#include <esp_log.h>
+#include <atomic>
+#include <stdlib.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static const char *TAG = "controller_httparena";
+
+// cJSON nodes hold doubles, keep every block 8-byte aligned
+#define HTTP_ARENA_ALIGN 8
+
+struct http_arena {
+    uint8_t *buffer;
+    size_t used;
+    std::atomic<TaskHandle_t> owner;
+};
+
+static http_arena s_arenas[HTTP_ARENA_COUNT];
+static bool s_arena_initialized = false;
+
+static std::atomic<uint32_t> s_scopes{0};
+static std::atomic<uint32_t> s_scopes_no_arena{0};
+static std::atomic<uint32_t> s_allocations{0};
+static std::atomic<uint32_t> s_heap_fallbacks{0};
+static std::atomic<size_t> s_peak_used{0};
+
+static http_arena *current_arena()
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < HTTP_ARENA_COUNT; ++i) {
+        if (s_arenas[i].owner.load(std::memory_order_relaxed) == self) {
+            return &s_arenas[i];
+        }
+    }
+    return nullptr;
+}
+
+static bool in_arena(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (size_t i = 0; i < HTTP_ARENA_COUNT; ++i) {
+        if (p >= s_arenas[i].buffer && p < s_arenas[i].buffer + HTTP_ARENA_SIZE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void *arena_malloc(size_t size)
+{
+    http_arena *arena = current_arena();
+    if (!arena) {
+        // cJSON is shared with the rest of the firmware, its other users keep the plain heap
+        return malloc(size);
+    }
+    size_t aligned = (size + HTTP_ARENA_ALIGN - 1) & ~(size_t)(HTTP_ARENA_ALIGN - 1);
+    if (aligned > HTTP_ARENA_SIZE - arena->used) {
+        s_heap_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        return http_mem_alloc(size, HTTP_MEM_TRANSIENT);
+    }
+    void *ptr = arena->buffer + arena->used;
+    arena->used += aligned;
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+}
+
+static void arena_free(void *ptr)
+{
+    // Arena blocks are reclaimed all at once when their scope ends, http_mem blocks go back through free()
+    if (ptr && !in_arena(ptr)) {
+        free(ptr);
+    }
+}
+
+esp_err_t http_arena_init(void)
+{
+    if (s_arena_initialized) {
+        return ESP_OK;
+    }
+    for (size_t i = 0; i < HTTP_ARENA_COUNT; ++i) {
+        s_arenas[i].buffer = (uint8_t *)http_mem_alloc(HTTP_ARENA_SIZE, HTTP_MEM_LONG_LIVED);
+        if (!s_arenas[i].buffer) {
+            ESP_LOGE(TAG, "Failed to allocate arena %u", (unsigned)i);
+            for (size_t j = 0; j < i; ++j) {
+                http_mem_free(s_arenas[j].buffer);
+                s_arenas[j].buffer = nullptr;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+        s_arenas[i].used = 0;
+        s_arenas[i].owner.store(nullptr);
+    }
+
+    cJSON_Hooks hooks = {
+        .malloc_fn = arena_malloc,
+        .free_fn = arena_free,
+    };
+    cJSON_InitHooks(&hooks);
+    s_arena_initialized = true;
+    return ESP_OK;
+}
+
+void http_arena_get_stats(http_arena_stats_t *stats)
+{
+    stats->scopes = s_scopes.load(std::memory_order_relaxed);
+    stats->scopes_no_arena = s_scopes_no_arena.load(std::memory_order_relaxed);
+    stats->allocations = s_allocations.load(std::memory_order_relaxed);
+    stats->heap_fallbacks = s_heap_fallbacks.load(std::memory_order_relaxed);
+    stats->peak_used = s_peak_used.load(std::memory_order_relaxed);
+}
+
+http_arena_scope::http_arena_scope()
+    : m_arena(nullptr)
+{
+    if (!s_arena_initialized || current_arena()) {
+        // Nested scopes share the arena of the outer one
+        return;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (size_t i = 0; i < HTTP_ARENA_COUNT; ++i) {
+        TaskHandle_t expected = nullptr;
+        if (s_arenas[i].owner.compare_exchange_strong(expected, self)) {
+            m_arena = &s_arenas[i];
+            m_arena->used = 0;
+            s_scopes.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    s_scopes_no_arena.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t http_arena_scope::used() const
+{
+    return m_arena ? m_arena->used : 0;
+}
+
+http_arena_scope::~http_arena_scope()
+{
+    if (!m_arena) {
+        return;
+    }
+    size_t peak = s_peak_used.load(std::memory_order_relaxed);
+    while (m_arena->used > peak && !s_peak_used.compare_exchange_weak(peak, m_arena->used)) {
+    }
+    m_arena->used = 0;
+    m_arena->owner.store(nullptr);
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
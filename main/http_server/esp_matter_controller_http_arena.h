@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_ARENA_COUNT 1        // Arenas in the pool: request handlers all run on the single httpd task
+#define HTTP_ARENA_SIZE 16384     // Bytes per arena, larger requests spill over to the heap
+
+/**
+ * @brief Usage counters of the arena pool
+ */
+typedef struct {
+    uint32_t scopes;          // Scopes that got an arena
+    uint32_t scopes_no_arena; // Scopes that ran on the heap because every arena was taken
+    uint32_t allocations;     // Allocations served from an arena
+    uint32_t heap_fallbacks;  // Allocations inside a scope that did not fit and went to the heap
+    size_t peak_used;         // Largest number of bytes used by a single scope
+} http_arena_stats_t;
+
+/**
+ * @brief Allocate the arena pool and install it as the cJSON allocator
+ *
+ * cJSON allocations made outside an arena scope keep going to malloc() and
+ * free(), so other users of cJSON (and other tasks) are unaffected: neither
+ * the PSRAM placement policy nor the API memory counters apply to them.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the arenas cannot be allocated
+ */
+esp_err_t http_arena_init(void);
+
+/**
+ * @brief Snapshot of the arena pool counters
+ */
+void http_arena_get_stats(http_arena_stats_t *stats);
+
+/**
+ * @brief Route the cJSON allocations of the current task to an arena
+ *
+ * Every cJSON tree and printed string created while the scope is alive is
+ * bump-allocated, freeing them is a no-op, and the whole arena is reset in
+ * one step when the scope ends. Nothing allocated inside the scope may be
+ * kept after it ends, which is why job bodies, whose result trees outlive
+ * them, run without one.
+ */
+class http_arena_scope {
+public:
+    http_arena_scope();
+    ~http_arena_scope();
+
+    /**
+     * @brief Bytes bump-allocated in this scope so far
+     */
+    size_t used() const;
+
+    http_arena_scope(const http_arena_scope &) = delete;
+    http_arena_scope &operator=(const http_arena_scope &) = delete;
+
+private:
+    struct http_arena *m_arena;
+};
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_backend.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static controller_backend *s_backend = nullptr;
+
+controller_backend *http_backend()
+{
+    return s_backend;
+}
+
+void http_backend_set(controller_backend *backend)
+{
+    s_backend = backend;
+}
+
+#if !HTTP_SERVER_MATTER_BACKEND
+controller_backend *http_matter_backend()
+{
+    return nullptr;
+}
+#endif
+
+void cancel_pending_op(pending_op *op)
+{
+    controller_backend *backend = http_backend();
+    if (!backend) {
+        return;
+    }
+    backend->lock(portMAX_DELAY);
+    if (op->cancel.cancel_fn) {
+        op->cancel.cancel_fn(op->cancel.context);
+    }
+    backend->unlock();
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
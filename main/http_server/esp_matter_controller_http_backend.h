@@ -0,0 +1,231 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_bit_defs.h>
+#include <esp_err.h>
+#include <esp_matter_controller_http_metrics.h>
+#include <esp_matter_controller_http_results.h>
+#include <freertos/FreeRTOS.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Whether the Matter SDK is part of the build
+ *
+ * The linux target builds the REST layer on its own for host benchmarks: only
+ * the simulated backend is available and Matter TLV bodies are not supported.
+ */
+#if CONFIG_IDF_TARGET_LINUX
+#define HTTP_SERVER_MATTER_BACKEND 0
+#else
+#define HTTP_SERVER_MATTER_BACKEND 1
+#endif
+
+/**
+ * @brief Whether /api/ble-scan and BLE pairing are served
+ */
+#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN || !HTTP_SERVER_MATTER_BACKEND
+#define HTTP_SERVER_BLE 1
+#else
+#define HTTP_SERVER_BLE 0
+#endif
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+/**
+ * @brief Attribute or event paths of a request
+ *
+ * The three lists are passed as the client sent them; backends that need one
+ * entry per path check that the lengths match.
+ */
+typedef struct {
+    const uint16_t *endpoint_ids;
+    size_t endpoint_count;
+    const uint32_t *cluster_ids;
+    size_t cluster_count;
+    const uint32_t *ids; // Attribute or event IDs
+    size_t id_count;
+} backend_paths_t;
+
+typedef enum {
+    BACKEND_PAIRING_ON_NETWORK,
+    BACKEND_PAIRING_BLE_WIFI,
+    BACKEND_PAIRING_BLE_THREAD,
+    BACKEND_PAIRING_CODE,
+} backend_pairing_method_t;
+
+typedef struct {
+    backend_pairing_method_t method;
+    uint64_t node_id;
+    uint32_t pincode;
+    uint16_t discriminator;
+    char ssid[33];
+    char password[65];
+    char payload[128];
+    uint8_t dataset[254];
+    uint8_t dataset_len;
+} backend_pairing_t;
+
+// Pairing progress reported to the callback given to start_pairing()
+#define BACKEND_PAIRING_PASE_OK BIT(0)
+#define BACKEND_PAIRING_PASE_FAILED BIT(1)
+#define BACKEND_PAIRING_COMMISSIONED BIT(2)
+#define BACKEND_PAIRING_COMMISSIONING_FAILED BIT(3)
+
+/**
+ * @brief Pairing progress callback, error is set for the failure events
+ */
+typedef void (*backend_pairing_cb_t)(uint32_t event, const char *error);
+
+typedef struct {
+    uint64_t node_id;
+    bool is_enhanced;
+    uint16_t window_timeout;
+    uint32_t iteration;
+    uint16_t discriminator;
+} backend_ocw_t;
+
+/**
+ * @brief Called once the commissioning window is open
+ */
+typedef void (*backend_ocw_cb_t)(const char *manual_code, const char *qr_code);
+
+/**
+ * @brief Controller the REST handlers drive
+ *
+ * The handlers only deal with HTTP, parameters and result slots; everything
+ * that talks to devices goes through this interface. Every method but
+ * init(), lock() and write_metrics() is called with lock() held. Methods a
+ * backend does not implement return ESP_ERR_NOT_SUPPORTED.
+ */
+class controller_backend {
+public:
+    virtual ~controller_backend() = default;
+
+    virtual const char *name() const = 0;
+
+    /**
+     * @brief Called once by start_http_server() before the first request
+     */
+    virtual esp_err_t init() { return ESP_OK; }
+
+    /**
+     * @brief Serialize access to the controller, the CHIP stack lock for Matter
+     */
+    virtual bool lock(TickType_t timeout) = 0;
+    virtual void unlock() = 0;
+
+    virtual esp_err_t start_pairing(const backend_pairing_t &params, backend_pairing_cb_t callback) = 0;
+    virtual esp_err_t open_commissioning_window(const backend_ocw_t &params, uint32_t timeout_ms,
+                                                backend_ocw_cb_t callback) = 0;
+
+    /**
+     * @brief Invoke a command, command_data being the console's JSON format or NULL
+     */
+    virtual esp_err_t invoke(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                             const char *command_data, uint16_t timed_invoke_timeout_ms) = 0;
+
+    /**
+     * @brief Invoke a command whose fields the client encoded as one anonymous TLV structure
+     * @return ESP_ERR_INVALID_ARG if fields is not such a structure
+     */
+    virtual esp_err_t invoke_tlv(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                                 const uint8_t *fields, size_t fields_len, uint16_t timed_invoke_timeout_ms) = 0;
+
+    /**
+     * @brief Read attributes into an armed PENDING_OP_READ, completing it when done
+     *
+     * The backend sets op->cancel so cancel_pending_op() can abort the read.
+     */
+    virtual esp_err_t read_attributes(pending_op *op, uint64_t node_id, const backend_paths_t &paths) = 0;
+
+    /**
+     * @brief Write attributes, reporting statuses to the PENDING_OP_WRITE armed for the node
+     */
+    virtual esp_err_t write_attributes(pending_op *op, uint64_t node_id, const backend_paths_t &paths,
+                                       const char *value, uint16_t timed_write_timeout_ms) = 0;
+
+    virtual esp_err_t read_events(uint64_t node_id, const backend_paths_t &paths) = 0;
+
+    /**
+     * @brief Subscribe on behalf of the subscription registry, under its backend ID
+     *
+     * Only called by http_subscription_add(), which may share one subscription
+     * between several clients. The backend reports the lifecycle of the
+     * subscription to the registry and calls http_subscription_ended() once
+     * it is gone. On error the subscription was not started.
+     */
+    virtual esp_err_t subscribe_attributes(uint32_t id, uint64_t node_id, const backend_paths_t &paths,
+                                           uint16_t min_interval, uint16_t max_interval) = 0;
+    virtual esp_err_t subscribe_events(uint32_t id, uint64_t node_id, const backend_paths_t &paths,
+                                       uint16_t min_interval, uint16_t max_interval) = 0;
+
+    /**
+     * @brief Tear down a subscription started under a backend ID, whatever its state
+     * @return ESP_ERR_NOT_FOUND if the backend does not know the ID
+     */
+    virtual esp_err_t unsubscribe(uint32_t id) = 0;
+
+    /**
+     * @brief Shut down a subscription by its Matter ID, for those the registry does not know
+     */
+    virtual esp_err_t shutdown_subscription(uint64_t node_id, uint32_t subscription_id) = 0;
+
+    /**
+     * @brief Shut down the subscriptions to one node, or to every node if node_id is NULL
+     */
+    virtual esp_err_t shutdown_subscriptions(const uint64_t *node_id) = 0;
+
+    virtual esp_err_t ble_scan_start(uint16_t timeout_s, bool show_details) = 0;
+    virtual bool ble_scan_running() = 0;
+    virtual void ble_scan_stop() = 0;
+
+    virtual esp_err_t show_groups() { return ESP_ERR_NOT_SUPPORTED; }
+    virtual esp_err_t add_group(const char *name, uint16_t group_id) { return ESP_ERR_NOT_SUPPORTED; }
+    virtual esp_err_t remove_group(uint16_t group_id) { return ESP_ERR_NOT_SUPPORTED; }
+
+    /**
+     * @brief User Directed Commissioning: action is "reset", "print" or "commission"
+     */
+    virtual esp_err_t udc(const char *action, uint32_t pincode, uint32_t index) { return ESP_ERR_NOT_SUPPORTED; }
+
+    /**
+     * @brief Append backend-specific series to /api/metrics, without the lock held
+     */
+    virtual void write_metrics(metrics_writer *writer) {}
+};
+
+/**
+ * @brief Backend serving the requests, selected by start_http_server()
+ */
+controller_backend *http_backend();
+
+/**
+ * @brief Select the backend, before start_http_server() only
+ */
+void http_backend_set(controller_backend *backend);
+
+/**
+ * @brief Controller backed by the Matter SDK, NULL when built without it
+ */
+controller_backend *http_matter_backend();
+
+/**
+ * @brief Abort the interaction still attached to a pending operation
+ *
+ * Takes the backend lock, so it must be called without it. After this
+ * returns no backend callback will touch the operation again, and it is safe
+ * to release it.
+ */
+void cancel_pending_op(pending_op *op);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,409 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_backend_matter.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_operations.h>
+#include <esp_matter_controller_client.h>
+#include <esp_matter_controller_cluster_command.h>
+#include <esp_matter_controller_commissioning_window_opener.h>
+#include <esp_matter_controller_group_settings.h>
+#include <esp_matter_controller_pairing_command.h>
+#include <esp_matter_controller_read_command.h>
+#include <esp_matter_controller_subscribe_command.h>
+#include <esp_matter_core.h>
+#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
+#include <esp_matter_controller_ble_scan_command.h>
+#endif
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <app/InteractionModelEngine.h>
+#include <lib/core/CHIPCore.h>
+#include <lib/support/CHIPMem.h>
+#include <protocols/secure_channel/RendezvousParameters.h>
+#include <protocols/user_directed_commissioning/UserDirectedCommissioning.h>
+
+using chip::Platform::ScopedMemoryBufferWithSize;
+using chip::app::AttributePathParams;
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define METRICS_LOCK_TIMEOUT_MS 50 // Matter stack state is skipped rather than stalling a scrape
+
+// The console commands take their lists as ScopedMemoryBufferWithSize
+template <typename T>
+static bool copy_ids(const T *ids, size_t count, ScopedMemoryBufferWithSize<T> &out)
+{
+    out.Alloc(count);
+    if (!out.Get()) {
+        return false;
+    }
+    memcpy(out.Get(), ids, count * sizeof(T));
+    return true;
+}
+
+typedef struct {
+    ScopedMemoryBufferWithSize<uint16_t> endpoint_ids;
+    ScopedMemoryBufferWithSize<uint32_t> cluster_ids;
+    ScopedMemoryBufferWithSize<uint32_t> ids;
+} scoped_paths_t;
+
+static bool copy_paths(const backend_paths_t &paths, scoped_paths_t *out)
+{
+    return copy_ids(paths.endpoint_ids, paths.endpoint_count, out->endpoint_ids) &&
+        copy_ids(paths.cluster_ids, paths.cluster_count, out->cluster_ids) &&
+        copy_ids(paths.ids, paths.id_count, out->ids);
+}
+
+static backend_pairing_cb_t s_pairing_callback = nullptr;
+
+#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+// The application's callbacks, ours replace them on the shared pairing_command only while a job pairs
+static pairing_command_callbacks_t s_app_pairing_callbacks = {};
+
+void http_matter_backend_set_pairing_callbacks(const pairing_command_callbacks_t &callbacks)
+{
+    s_app_pairing_callbacks = callbacks;
+    if (!s_pairing_callback) {
+        controller::pairing_command::get_instance().set_callbacks(callbacks);
+    }
+}
+
+// Hand the pairing command back to the application once the pairing job has its outcome
+static void end_pairing()
+{
+    s_pairing_callback = nullptr;
+    controller::pairing_command::get_instance().set_callbacks(s_app_pairing_callbacks);
+}
+
+static void pairing_pase_callback(CHIP_ERROR err)
+{
+    backend_pairing_cb_t callback = s_pairing_callback;
+    if (err != CHIP_NO_ERROR) {
+        // Commissioning does not start, no further callback will come
+        end_pairing();
+    }
+    if (s_app_pairing_callbacks.pase_callback) {
+        s_app_pairing_callbacks.pase_callback(err);
+    }
+    if (!callback) {
+        return;
+    }
+    if (err == CHIP_NO_ERROR) {
+        callback(BACKEND_PAIRING_PASE_OK, nullptr);
+    } else {
+        char error[96];
+        snprintf(error, sizeof(error), "PASE session failed: %" CHIP_ERROR_FORMAT, err.Format());
+        callback(BACKEND_PAIRING_PASE_FAILED, error);
+    }
+}
+
+static void pairing_success_callback(chip::ScopedNodeId peer_id)
+{
+    backend_pairing_cb_t callback = s_pairing_callback;
+    end_pairing();
+    if (s_app_pairing_callbacks.commissioning_success_callback) {
+        s_app_pairing_callbacks.commissioning_success_callback(peer_id);
+    }
+    if (callback) {
+        callback(BACKEND_PAIRING_COMMISSIONED, nullptr);
+    }
+}
+
+static void pairing_failure_callback(chip::ScopedNodeId peer_id, CHIP_ERROR error,
+                                     chip::Controller::CommissioningStage stage,
+                                     std::optional<chip::Credentials::AttestationVerificationResult> additional_err_info)
+{
+    backend_pairing_cb_t callback = s_pairing_callback;
+    end_pairing();
+    if (s_app_pairing_callbacks.commissioning_failure_callback) {
+        s_app_pairing_callbacks.commissioning_failure_callback(peer_id, error, stage, additional_err_info);
+    }
+    if (!callback) {
+        return;
+    }
+    char message[96];
+    snprintf(message, sizeof(message), "Commissioning failed at stage %s: %" CHIP_ERROR_FORMAT,
+             chip::Controller::StageToString(stage), error.Format());
+    callback(BACKEND_PAIRING_COMMISSIONING_FAILED, message);
+}
+#endif // CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+
+// Same for the shared commissioning window opener
+static backend_ocw_cb_t s_app_ocw_callback = nullptr;
+static backend_ocw_cb_t s_ocw_callback = nullptr;
+
+void http_matter_backend_set_commissioning_window_callback(backend_ocw_cb_t callback)
+{
+    s_app_ocw_callback = callback;
+    if (!s_ocw_callback) {
+        controller::commissioning_window_opener::get_instance().set_callback(callback);
+    }
+}
+
+static void end_commissioning_window()
+{
+    s_ocw_callback = nullptr;
+    controller::commissioning_window_opener::get_instance().set_callback(s_app_ocw_callback);
+}
+
+static void ocw_open_callback(const char *manual_code, const char *qr_code)
+{
+    backend_ocw_cb_t callback = s_ocw_callback;
+    end_commissioning_window();
+    if (s_app_ocw_callback) {
+        s_app_ocw_callback(manual_code, qr_code);
+    }
+    if (callback) {
+        callback(manual_code, qr_code);
+    }
+}
+
+#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
+static controller::ble_scan::ConsoleBLEScanCallback s_ble_scan_callback;
+#endif
+
+class matter_backend : public controller_backend {
+public:
+    const char *name() const override { return "matter"; }
+
+    esp_err_t init() override { return ESP_OK; }
+
+    bool lock(TickType_t timeout) override
+    {
+        return esp_matter::lock::chip_stack_lock(timeout) == esp_matter::lock::SUCCESS;
+    }
+
+    void unlock() override { esp_matter::lock::chip_stack_unlock(); }
+
+    esp_err_t start_pairing(const backend_pairing_t &params, backend_pairing_cb_t callback) override
+    {
+#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+        // Pairing jobs learn the commissioning outcome from these, the application's are chained
+        s_pairing_callback = callback;
+        controller::pairing_command::get_instance().set_callbacks(
+            {pairing_pase_callback, pairing_success_callback, pairing_failure_callback});
+#endif
+        esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+        switch (params.method) {
+            case BACKEND_PAIRING_ON_NETWORK:
+                err = controller::pairing_on_network(params.node_id, params.pincode);
+                break;
+#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
+            case BACKEND_PAIRING_BLE_WIFI:
+                err = controller::pairing_ble_wifi(params.node_id, params.pincode, params.discriminator,
+                                                   params.ssid, params.password);
+                break;
+            case BACKEND_PAIRING_BLE_THREAD:
+                err = controller::pairing_ble_thread(params.node_id, params.pincode, params.discriminator,
+                                                     const_cast<uint8_t *>(params.dataset), params.dataset_len);
+                break;
+#endif
+            case BACKEND_PAIRING_CODE:
+                err = controller::pairing_code(params.node_id, params.payload);
+                break;
+            default:
+                break;
+        }
+#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+        if (err != ESP_OK) {
+            end_pairing();
+        }
+#endif
+        return err;
+    }
+
+    esp_err_t open_commissioning_window(const backend_ocw_t &params, uint32_t timeout_ms,
+                                        backend_ocw_cb_t callback) override
+    {
+        s_ocw_callback = callback;
+        controller::commissioning_window_opener::get_instance().set_callback(ocw_open_callback);
+        esp_err_t err = controller::commissioning_window_opener::get_instance().send_open_commissioning_window_command(
+            params.node_id, params.is_enhanced, params.window_timeout, params.iteration, params.discriminator,
+            timeout_ms);
+        if (err != ESP_OK) {
+            end_commissioning_window();
+        }
+        return err;
+    }
+
+    esp_err_t invoke(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                     const char *command_data, uint16_t timed_invoke_timeout_ms) override
+    {
+        if (timed_invoke_timeout_ms > 0) {
+            return controller::send_invoke_cluster_command(node_id, endpoint_id, cluster_id, command_id, command_data,
+                                                           chip::MakeOptional(timed_invoke_timeout_ms));
+        }
+        return controller::send_invoke_cluster_command(node_id, endpoint_id, cluster_id, command_id, command_data);
+    }
+
+    esp_err_t invoke_tlv(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                         const uint8_t *fields, size_t fields_len, uint16_t timed_invoke_timeout_ms) override
+    {
+        return start_tlv_invoke_operation(node_id, endpoint_id, cluster_id, command_id, fields, fields_len,
+                                          timed_invoke_timeout_ms);
+    }
+
+    esp_err_t read_attributes(pending_op *op, uint64_t node_id, const backend_paths_t &paths) override
+    {
+        if (paths.endpoint_count != paths.cluster_count || paths.endpoint_count != paths.id_count) {
+            HTTP_LOGE(HTTP_LOG_BACKEND, "Array length mismatch");
+            return ESP_ERR_INVALID_ARG;
+        }
+        ScopedMemoryBufferWithSize<AttributePathParams> attr_paths;
+        attr_paths.Alloc(paths.endpoint_count);
+        if (!attr_paths.Get()) {
+            HTTP_LOGE(HTTP_LOG_BACKEND, "Failed to alloc memory for attribute paths");
+            return ESP_ERR_NO_MEM;
+        }
+        for (size_t i = 0; i < attr_paths.AllocatedSize(); ++i) {
+            attr_paths[i] = AttributePathParams(paths.endpoint_ids[i], paths.cluster_ids[i], paths.ids[i]);
+        }
+        return start_read_operation(op, node_id, std::move(attr_paths));
+    }
+
+    esp_err_t write_attributes(pending_op *op, uint64_t node_id, const backend_paths_t &paths, const char *value,
+                               uint16_t timed_write_timeout_ms) override
+    {
+        if (paths.endpoint_count != paths.cluster_count || paths.endpoint_count != paths.id_count) {
+            HTTP_LOGE(HTTP_LOG_BACKEND, "Array length mismatch");
+            return ESP_ERR_INVALID_ARG;
+        }
+        return start_write_operation(op, node_id, paths, value, timed_write_timeout_ms);
+    }
+
+    esp_err_t read_events(uint64_t node_id, const backend_paths_t &paths) override
+    {
+        scoped_paths_t scoped;
+        if (!copy_paths(paths, &scoped)) {
+            return ESP_ERR_NO_MEM;
+        }
+        return controller::send_read_event_command(node_id, scoped.endpoint_ids, scoped.cluster_ids, scoped.ids);
+    }
+
+    esp_err_t subscribe_attributes(uint32_t id, uint64_t node_id, const backend_paths_t &paths,
+                                   uint16_t min_interval, uint16_t max_interval) override
+    {
+        return start_subscribe_operation(id, node_id, false, paths, min_interval, max_interval);
+    }
+
+    esp_err_t subscribe_events(uint32_t id, uint64_t node_id, const backend_paths_t &paths, uint16_t min_interval,
+                               uint16_t max_interval) override
+    {
+        return start_subscribe_operation(id, node_id, true, paths, min_interval, max_interval);
+    }
+
+    esp_err_t unsubscribe(uint32_t id) override { return stop_subscribe_operation(id); }
+
+    esp_err_t shutdown_subscription(uint64_t node_id, uint32_t subscription_id) override
+    {
+        return controller::send_shutdown_subscription(node_id, subscription_id);
+    }
+
+    esp_err_t shutdown_subscriptions(const uint64_t *node_id) override
+    {
+        if (node_id) {
+            controller::send_shutdown_subscriptions(*node_id);
+        } else {
+            controller::send_shutdown_all_subscriptions();
+        }
+        return ESP_OK;
+    }
+
+#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
+    esp_err_t ble_scan_start(uint16_t timeout_s, bool show_details) override
+    {
+        s_ble_scan_callback.SetShowDetails(show_details);
+        return controller::ble_scan::EnhancedBLEDeviceScanner::GetInstance().StartScan(timeout_s,
+                                                                                      &s_ble_scan_callback);
+    }
+
+    bool ble_scan_running() override { return controller::ble_scan::EnhancedBLEDeviceScanner::GetInstance().IsScanning(); }
+
+    void ble_scan_stop() override { controller::ble_scan::EnhancedBLEDeviceScanner::GetInstance().StopScan(); }
+#else
+    esp_err_t ble_scan_start(uint16_t timeout_s, bool show_details) override { return ESP_ERR_NOT_SUPPORTED; }
+
+    bool ble_scan_running() override { return false; }
+
+    void ble_scan_stop() override {}
+#endif
+
+#ifndef CONFIG_ESP_MATTER_ENABLE_MATTER_SERVER
+    esp_err_t show_groups() override { return controller::group_settings::show_groups(); }
+
+    esp_err_t add_group(const char *name, uint16_t group_id) override
+    {
+        return controller::group_settings::add_group(const_cast<char *>(name), group_id);
+    }
+
+    esp_err_t remove_group(uint16_t group_id) override { return controller::group_settings::remove_group(group_id); }
+#endif
+
+#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE && CHIP_DEVICE_CONFIG_ENABLE_COMMISSIONER_DISCOVERY
+    esp_err_t udc(const char *action, uint32_t pincode, uint32_t index) override
+    {
+        controller::matter_controller_client &instance = controller::matter_controller_client::get_instance();
+        auto *udc_server = instance.get_commissioner()->GetUserDirectedCommissioningServer();
+        if (strcmp(action, "reset") == 0) {
+            udc_server->ResetUDCClientProcessingStates();
+            return ESP_OK;
+        }
+        if (strcmp(action, "print") == 0) {
+            udc_server->PrintUDCClients();
+            return ESP_OK;
+        }
+        if (strcmp(action, "commission") != 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        UDCClientState *state = udc_server->GetUDCClients().GetUDCClientState(index);
+        if (state == nullptr) {
+            return ESP_FAIL;
+        }
+        state->SetUDCClientProcessingState(
+            chip::Protocols::UserDirectedCommissioning::UDCClientProcessingState::kCommissioningNode);
+
+        chip::NodeId remote_id = chip::kTestDeviceNodeId;
+        chip::RendezvousParameters params = chip::RendezvousParameters()
+                                                .SetSetupPINCode(pincode)
+                                                .SetDiscriminator(state->GetLongDiscriminator())
+                                                .SetPeerAddress(state->GetPeerAddress());
+        do {
+            chip::Crypto::DRBG_get_bytes(reinterpret_cast<uint8_t *>(&remote_id), sizeof(remote_id));
+        } while (!chip::IsOperationalNodeId(remote_id));
+
+        return instance.get_commissioner()->PairDevice(remote_id, params) == CHIP_NO_ERROR ? ESP_OK : ESP_FAIL;
+    }
+#endif
+
+    void write_metrics(metrics_writer *writer) override
+    {
+        // The client list belongs to the CHIP thread, a busy stack only costs this one gauge
+        if (!lock(pdMS_TO_TICKS(METRICS_LOCK_TIMEOUT_MS))) {
+            return;
+        }
+        uint32_t read_clients = chip::app::InteractionModelEngine::GetInstance()->GetNumActiveReadClients();
+        unlock();
+        writer->family("matter_read_clients_active", "gauge", "Active subscriptions and in-flight reads");
+        writer->printf("matter_read_clients_active %" PRIu32 "\n", read_clients);
+    }
+};
+
+static matter_backend s_matter_backend;
+
+controller_backend *http_matter_backend()
+{
+    return &s_matter_backend;
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
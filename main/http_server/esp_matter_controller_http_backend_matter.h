@@ -0,0 +1,45 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_matter_controller_http_backend.h>
+#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+#include <esp_matter_controller_pairing_command.h>
+#endif
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+/**
+ * @brief Register the application's own pairing callbacks
+ *
+ * The Matter backend installs its callbacks on the shared pairing_command
+ * only while a pairing job runs, forwards every event to these and puts them
+ * back once the pairing has an outcome. Applications register here instead of
+ * calling pairing_command::set_callbacks(), which would be overwritten by the
+ * next pairing job. Call with the Matter stack lock held.
+ *
+ * @param callbacks Copied, members may be NULL
+ */
+void http_matter_backend_set_pairing_callbacks(const pairing_command_callbacks_t &callbacks);
+#endif
+
+/**
+ * @brief Register the application's own commissioning window callback
+ *
+ * Same as http_matter_backend_set_pairing_callbacks() for the shared
+ * commissioning_window_opener. Call with the Matter stack lock held.
+ *
+ * @param callback NULL to drop a previous one
+ */
+void http_matter_backend_set_commissioning_window_callback(backend_ocw_cb_t callback);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
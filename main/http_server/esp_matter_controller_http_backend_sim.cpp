@@ -0,0 +1,785 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_backend_sim.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_memory.h>
+#include <esp_matter_controller_http_stream.h>
+#include <esp_matter_controller_http_subscriptions.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <atomic>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/semphr.h>
+#include <freertos/timers.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static const char *TAG = "controller_httpsim";
+
+#define SIM_ATTRIBUTES_MAX 64 // Attributes written or set, reads of the others are derived from their path
+#define SIM_SESSIONS_MAX 16   // Nodes whose CASE session is kept, the oldest is evicted first
+#define SIM_STRING_MAX 64     // Longest string value stored, including the terminator
+#define SIM_WILDCARD_ENDPOINT 0xFFFF
+#define SIM_WILDCARD_ID 0xFFFFFFFF
+#define SIM_STATUS_FAILURE 0x01 // Interaction model FAILURE status
+
+// Codes of the Matter test setup payload, what a window opened with the defaults reports
+#define SIM_MANUAL_CODE "34970112332"
+#define SIM_QR_CODE "MT:Y.K9042C00KA0648G00"
+
+typedef struct {
+    uint64_t node_id;
+    uint32_t cluster_id;
+    uint32_t attribute_id;
+    uint16_t endpoint_id;
+    record_value_type_t type;
+    union {
+        bool b;
+        uint64_t u;
+        int64_t i;
+        double f;
+    } value;
+    char str[SIM_STRING_MAX];
+} sim_attribute_t;
+
+typedef enum : uint8_t {
+    SIM_READ = 0,
+    SIM_WRITE,
+    SIM_INVOKE,
+} sim_interaction_kind_t;
+
+typedef struct {
+    uint16_t endpoint_id;
+    uint32_t cluster_id;
+    uint32_t attribute_id;
+} sim_path_t;
+
+// Interaction waiting for its latency to elapse, owned by the timer that completes it
+typedef struct {
+    sim_interaction_kind_t kind;
+    bool cancelled;
+    bool failed;
+    pending_op *op; // Reads only, write statuses reach the slot armed for the node like Matter's
+    uint64_t node_id;
+    int64_t start_us;
+    uint32_t case_us;
+    char value[SIM_STRING_MAX];
+    size_t path_count;
+    sim_path_t paths[];
+} sim_interaction_t;
+
+// Subscription kept alive by an auto-reload timer, whose ID is the registry ID
+typedef struct {
+    uint32_t id; // Registry ID, 0 for a free entry
+    uint32_t subscription_id;
+    uint64_t node_id;
+    bool events;
+    uint16_t min_interval;
+    uint16_t max_interval;
+    TimerHandle_t timer;
+    size_t path_count;
+    sim_path_t paths[HTTP_SUBSCRIPTION_PATHS_MAX];
+} sim_subscription_t;
+
+// Everything below is protected by s_mutex, the backend lock
+static sim_backend_config_t s_config = SIM_BACKEND_DEFAULT_CONFIG();
+static SemaphoreHandle_t s_mutex = nullptr;
+static sim_attribute_t *s_attributes = nullptr;
+static size_t s_attribute_count = 0;
+static uint64_t s_sessions[SIM_SESSIONS_MAX];
+static size_t s_session_count = 0;
+static uint32_t s_random = 0;
+static sim_subscription_t s_subscriptions[HTTP_SUBSCRIPTIONS_MAX];
+static uint32_t s_next_subscription_id = 1;
+static result_record_t s_report_record; // Too large for the timer task stack
+
+static std::atomic<uint32_t> s_in_flight{0};
+static backend_pairing_cb_t s_pairing_callback = nullptr;
+static std::atomic<bool> s_pairing{false};
+static uint64_t s_pairing_node_id = 0;
+static backend_ocw_cb_t s_ocw_callback = nullptr;
+static std::atomic<bool> s_ble_scanning{false};
+static std::atomic<uint32_t> s_ble_generation{0};
+
+// xorshift32, good enough for jitter and failure injection
+static uint32_t sim_random()
+{
+    s_random ^= s_random << 13;
+    s_random ^= s_random >> 17;
+    s_random ^= s_random << 5;
+    return s_random;
+}
+
+static uint32_t sim_latency_ms(uint32_t base_ms)
+{
+    return s_config.jitter_ms > 0 ? base_ms + sim_random() % (s_config.jitter_ms + 1) : base_ms;
+}
+
+static bool sim_fails()
+{
+    return s_config.failure_percent > 0 && sim_random() % 100 < s_config.failure_percent;
+}
+
+// CASE latency of an interaction with the node, zero once a session is kept
+static uint32_t sim_session_latency_ms(uint64_t node_id)
+{
+    size_t kept = s_session_count < SIM_SESSIONS_MAX ? s_session_count : SIM_SESSIONS_MAX;
+    for (size_t i = 0; i < kept; ++i) {
+        if (s_sessions[i] == node_id) {
+            return 0;
+        }
+    }
+    s_sessions[s_session_count++ % SIM_SESSIONS_MAX] = node_id;
+    return sim_latency_ms(s_config.case_latency_ms);
+}
+
+static sim_attribute_t *sim_find_attribute(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id,
+                                           uint32_t attribute_id)
+{
+    for (size_t i = 0; i < s_attribute_count; ++i) {
+        sim_attribute_t *attribute = &s_attributes[i];
+        if (attribute->node_id == node_id && attribute->endpoint_id == endpoint_id &&
+            attribute->cluster_id == cluster_id && attribute->attribute_id == attribute_id) {
+            return attribute;
+        }
+    }
+    return nullptr;
+}
+
+// Parse a JSON scalar, or the console's {"0:TYPE": value} form, into an attribute
+static void sim_parse_value(const char *value, sim_attribute_t *attribute)
+{
+    char buf[SIM_STRING_MAX];
+    const char *start = value;
+    if (*start == '{' && strrchr(start, ':')) {
+        start = strrchr(start, ':') + 1;
+    }
+    while (*start == ' ' || *start == '"') {
+        start++;
+    }
+    strlcpy(buf, start, sizeof(buf));
+    char *end = buf + strlen(buf);
+    while (end > buf && (end[-1] == ' ' || end[-1] == '}' || end[-1] == '"')) {
+        *--end = '\0';
+    }
+
+    attribute->str[0] = '\0';
+    if (strcmp(buf, "null") == 0) {
+        attribute->type = RECORD_VALUE_NULL;
+        return;
+    }
+    if (strcmp(buf, "true") == 0 || strcmp(buf, "false") == 0) {
+        attribute->type = RECORD_VALUE_BOOL;
+        attribute->value.b = buf[0] == 't';
+        return;
+    }
+    char *parse_end = nullptr;
+    if (buf[0] != '-') {
+        attribute->value.u = strtoull(buf, &parse_end, 0);
+        attribute->type = RECORD_VALUE_UINT;
+    } else {
+        attribute->value.i = strtoll(buf, &parse_end, 0);
+        attribute->type = RECORD_VALUE_INT;
+    }
+    if (parse_end > buf && *parse_end == '\0') {
+        return;
+    }
+    attribute->value.f = strtod(buf, &parse_end);
+    attribute->type = RECORD_VALUE_FLOAT;
+    if (parse_end > buf && *parse_end == '\0') {
+        return;
+    }
+    attribute->type = RECORD_VALUE_STRING;
+    strlcpy(attribute->str, buf, sizeof(attribute->str));
+}
+
+static esp_err_t sim_store_attribute(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id,
+                                     uint32_t attribute_id, const char *value)
+{
+    sim_attribute_t *attribute = sim_find_attribute(node_id, endpoint_id, cluster_id, attribute_id);
+    if (!attribute) {
+        if (s_attribute_count == SIM_ATTRIBUTES_MAX) {
+            return ESP_ERR_NO_MEM;
+        }
+        attribute = &s_attributes[s_attribute_count++];
+        attribute->node_id = node_id;
+        attribute->endpoint_id = endpoint_id;
+        attribute->cluster_id = cluster_id;
+        attribute->attribute_id = attribute_id;
+    }
+    sim_parse_value(value, attribute);
+    return ESP_OK;
+}
+
+static void sim_fill_record(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                            result_record_t *record)
+{
+    record->node_id = node_id;
+    record->endpoint_id = endpoint_id;
+    record->cluster_id = cluster_id;
+    record->attribute_id = attribute_id;
+    record->status = 0;
+    record->raw_len = 0;
+    const sim_attribute_t *attribute = sim_find_attribute(node_id, endpoint_id, cluster_id, attribute_id);
+    if (!attribute) {
+        // Stable across reads, so clients can tell the paths apart
+        record->type = RECORD_VALUE_UINT;
+        record->value.u = (endpoint_id * 31u + cluster_id * 7u + attribute_id) & 0xFF;
+        return;
+    }
+    record->type = attribute->type;
+    memcpy(&record->value, &attribute->value, sizeof(record->value));
+    strlcpy(record->str, attribute->str, sizeof(record->str));
+}
+
+static uint32_t sim_fanout(uint32_t id, uint32_t wildcard)
+{
+    return id == wildcard && s_config.wildcard_fanout > 0 ? s_config.wildcard_fanout : 1;
+}
+
+static uint32_t sim_expand(uint32_t id, uint32_t wildcard, uint32_t index)
+{
+    return id == wildcard ? index : id;
+}
+
+static void sim_complete_read(sim_interaction_t *interaction)
+{
+    pending_op *op = interaction->op;
+    uint32_t round_trip_us = http_elapsed_us(interaction->start_us) - interaction->case_us;
+    esp_err_t status = ESP_OK;
+    if (interaction->failed) {
+        status = ESP_FAIL;
+    } else {
+        int64_t decode_start_us = esp_timer_get_time();
+        for (size_t i = 0; i < interaction->path_count; ++i) {
+            const sim_path_t &path = interaction->paths[i];
+            for (uint32_t e = 0; e < sim_fanout(path.endpoint_id, SIM_WILDCARD_ENDPOINT); ++e) {
+                for (uint32_t c = 0; c < sim_fanout(path.cluster_id, SIM_WILDCARD_ID); ++c) {
+                    for (uint32_t a = 0; a < sim_fanout(path.attribute_id, SIM_WILDCARD_ID); ++a) {
+                        result_record_t *record = op->ring.reserve();
+                        if (record) {
+                            sim_fill_record(interaction->node_id,
+                                            sim_expand(path.endpoint_id, SIM_WILDCARD_ENDPOINT, e),
+                                            sim_expand(path.cluster_id, SIM_WILDCARD_ID, c),
+                                            sim_expand(path.attribute_id, SIM_WILDCARD_ID, a), record);
+                            op->ring.commit();
+                        }
+                        op->received.fetch_add(1);
+                    }
+                }
+            }
+        }
+        uint32_t decode_us = http_elapsed_us(decode_start_us);
+        op->timing.add(HTTP_STAGE_DECODE, decode_us);
+        round_trip_us -= std::min(round_trip_us, decode_us);
+    }
+    op->timing.add(HTTP_STAGE_DEVICE, round_trip_us);
+    http_metrics_observe_matter(MATTER_OP_READ, round_trip_us, status == ESP_OK);
+    op->cancel.context = nullptr;
+    op->cancel.cancel_fn = nullptr;
+    pending_op_complete(op, status);
+}
+
+static bool sim_path_matches(const sim_path_t &subscribed, const sim_path_t &path)
+{
+    return (subscribed.endpoint_id == SIM_WILDCARD_ENDPOINT || subscribed.endpoint_id == path.endpoint_id) &&
+           (subscribed.cluster_id == SIM_WILDCARD_ID || subscribed.cluster_id == path.cluster_id) &&
+           (subscribed.attribute_id == SIM_WILDCARD_ID || subscribed.attribute_id == path.attribute_id);
+}
+
+// Values are only produced while a stream listens, like the Matter backend only decodes them then
+static void sim_report_value(const sim_subscription_t &subscription, uint16_t endpoint_id, uint32_t cluster_id,
+                             uint32_t attribute_id)
+{
+    if (http_streams_active()) {
+        sim_fill_record(subscription.node_id, endpoint_id, cluster_id, attribute_id, &s_report_record);
+        http_subscription_attribute(subscription.id, &s_report_record);
+    }
+}
+
+// The priming report carries every subscribed path, wildcards expanded as for a read
+static void sim_report_priming(const sim_subscription_t &subscription)
+{
+    if (subscription.events) {
+        return;
+    }
+    for (size_t i = 0; i < subscription.path_count; ++i) {
+        const sim_path_t &path = subscription.paths[i];
+        for (uint32_t e = 0; e < sim_fanout(path.endpoint_id, SIM_WILDCARD_ENDPOINT); ++e) {
+            for (uint32_t c = 0; c < sim_fanout(path.cluster_id, SIM_WILDCARD_ID); ++c) {
+                for (uint32_t a = 0; a < sim_fanout(path.attribute_id, SIM_WILDCARD_ID); ++a) {
+                    sim_report_value(subscription, sim_expand(path.endpoint_id, SIM_WILDCARD_ENDPOINT, e),
+                                     sim_expand(path.cluster_id, SIM_WILDCARD_ID, c),
+                                     sim_expand(path.attribute_id, SIM_WILDCARD_ID, a));
+                }
+            }
+        }
+    }
+}
+
+// A written attribute is reported at once to the established subscriptions covering it
+static void sim_report_write(uint64_t node_id, const sim_path_t &path)
+{
+    for (const sim_subscription_t &subscription : s_subscriptions) {
+        if (subscription.id == 0 || subscription.events || subscription.subscription_id == 0 ||
+            subscription.node_id != node_id) {
+            continue;
+        }
+        for (size_t i = 0; i < subscription.path_count; ++i) {
+            if (sim_path_matches(subscription.paths[i], path)) {
+                sim_report_value(subscription, path.endpoint_id, path.cluster_id, path.attribute_id);
+                http_subscription_report(subscription.id);
+                break;
+            }
+        }
+    }
+}
+
+static void sim_complete_write(sim_interaction_t *interaction)
+{
+    pending_op *op = pending_op_enter(PENDING_OP_WRITE, interaction->node_id);
+    for (size_t i = 0; i < interaction->path_count; ++i) {
+        const sim_path_t &path = interaction->paths[i];
+        uint8_t status = interaction->failed ? SIM_STATUS_FAILURE : 0;
+        if (status == 0 && sim_store_attribute(interaction->node_id, path.endpoint_id, path.cluster_id,
+                                               path.attribute_id, interaction->value) != ESP_OK) {
+            status = SIM_STATUS_FAILURE;
+        }
+        if (status == 0) {
+            sim_report_write(interaction->node_id, path);
+        }
+        if (!op) {
+            continue;
+        }
+        result_record_t *record = op->ring.reserve();
+        if (record) {
+            record->node_id = interaction->node_id;
+            record->endpoint_id = path.endpoint_id;
+            record->cluster_id = path.cluster_id;
+            record->attribute_id = path.attribute_id;
+            record->status = status;
+            op->ring.commit();
+        }
+        op->received.fetch_add(1);
+    }
+    if (op) {
+        pending_op_complete(op);
+        pending_op_leave(op);
+    }
+}
+
+static void sim_interaction_done(TimerHandle_t timer)
+{
+    sim_interaction_t *interaction = (sim_interaction_t *)pvTimerGetTimerID(timer);
+    xTimerDelete(timer, 0);
+
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    if (!interaction->cancelled) {
+        if (interaction->case_us > 0) {
+            http_metrics_observe_matter(MATTER_OP_CASE, interaction->case_us, true);
+        }
+        switch (interaction->kind) {
+        case SIM_READ:
+            interaction->op->timing.add(HTTP_STAGE_CASE, interaction->case_us);
+            sim_complete_read(interaction);
+            break;
+        case SIM_WRITE:
+            sim_complete_write(interaction);
+            break;
+        case SIM_INVOKE:
+            http_metrics_observe_matter(MATTER_OP_INVOKE, http_elapsed_us(interaction->start_us) - interaction->case_us,
+                                        !interaction->failed);
+            break;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    s_in_flight.fetch_sub(1);
+    http_mem_free(interaction);
+}
+
+// Called with the lock held, like the completion, so the two never race
+static void sim_cancel(void *context)
+{
+    sim_interaction_t *interaction = (sim_interaction_t *)context;
+    HTTP_LOGW(HTTP_LOG_BACKEND, "Cancelling read from node 0x%" PRIx64, interaction->node_id);
+    interaction->cancelled = true;
+    interaction->op->cancel.context = nullptr;
+    interaction->op->cancel.cancel_fn = nullptr;
+}
+
+static esp_err_t sim_timer_start(uint32_t delay_ms, TimerCallbackFunction_t callback, void *arg)
+{
+    TickType_t ticks = pdMS_TO_TICKS(delay_ms);
+    TimerHandle_t timer = xTimerCreate("http_sim", ticks > 0 ? ticks : 1, pdFALSE, arg, callback);
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTimerStart(timer, 0) != pdPASS) {
+        xTimerDelete(timer, 0);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_start_interaction(sim_interaction_kind_t kind, pending_op *op, uint64_t node_id,
+                                       const backend_paths_t *paths, const char *value, uint32_t latency_ms)
+{
+    size_t path_count = 0;
+    if (paths) {
+        path_count = std::min(paths->endpoint_count, std::min(paths->cluster_count, paths->id_count));
+    }
+    sim_interaction_t *interaction = (sim_interaction_t *)http_mem_calloc(
+        1, sizeof(sim_interaction_t) + path_count * sizeof(sim_path_t), HTTP_MEM_TRANSIENT);
+    if (!interaction) {
+        return ESP_ERR_NO_MEM;
+    }
+    interaction->kind = kind;
+    interaction->op = op;
+    interaction->node_id = node_id;
+    interaction->start_us = esp_timer_get_time();
+    interaction->failed = sim_fails();
+    if (value) {
+        strlcpy(interaction->value, value, sizeof(interaction->value));
+    }
+    interaction->path_count = path_count;
+    for (size_t i = 0; i < path_count; ++i) {
+        interaction->paths[i].endpoint_id = paths->endpoint_ids[i];
+        interaction->paths[i].cluster_id = paths->cluster_ids[i];
+        interaction->paths[i].attribute_id = paths->ids[i];
+    }
+    uint32_t case_ms = sim_session_latency_ms(node_id);
+    interaction->case_us = case_ms * 1000;
+
+    esp_err_t err = sim_timer_start(case_ms + sim_latency_ms(latency_ms), sim_interaction_done, interaction);
+    if (err != ESP_OK) {
+        http_mem_free(interaction);
+        return err;
+    }
+    if (op) {
+        op->cancel.context = interaction;
+        op->cancel.cancel_fn = sim_cancel;
+    }
+    s_in_flight.fetch_add(1);
+    return ESP_OK;
+}
+
+static sim_subscription_t *sim_find_subscription(uint32_t id)
+{
+    for (sim_subscription_t &subscription : s_subscriptions) {
+        if (subscription.id != 0 && subscription.id == id) {
+            return &subscription;
+        }
+    }
+    return nullptr;
+}
+
+static void sim_end_subscription(sim_subscription_t *subscription)
+{
+    xTimerDelete(subscription->timer, 0);
+    http_subscription_ended(subscription->id);
+    subscription->id = 0;
+}
+
+// First run: the subscription is established after CASE and the priming read.
+// Then once per max interval, the report a device sends when nothing changed.
+static void sim_subscription_tick(TimerHandle_t timer)
+{
+    uint32_t id = (uint32_t)(uintptr_t)pvTimerGetTimerID(timer);
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    sim_subscription_t *subscription = sim_find_subscription(id);
+    if (!subscription) {
+        // Torn down while this run was already due, the timer is being deleted
+        xSemaphoreGive(s_mutex);
+        return;
+    }
+    if (subscription->subscription_id == 0) {
+        if (sim_fails()) {
+            HTTP_LOGW(HTTP_LOG_BACKEND, "Subscription %" PRIu32 " to node 0x%" PRIx64 " failed (simulated)", id,
+                      subscription->node_id);
+            sim_end_subscription(subscription);
+            xSemaphoreGive(s_mutex);
+            return;
+        }
+        subscription->subscription_id = s_next_subscription_id++;
+        http_subscription_established(id, subscription->subscription_id, subscription->min_interval,
+                                      subscription->max_interval);
+        uint32_t period_ms = std::max<uint32_t>(subscription->max_interval, 1) * 1000;
+        xTimerChangePeriod(timer, pdMS_TO_TICKS(period_ms), 0);
+        sim_report_priming(*subscription);
+    }
+    http_subscription_report(id);
+    xSemaphoreGive(s_mutex);
+}
+
+static esp_err_t sim_subscribe(uint32_t id, uint64_t node_id, bool events, const backend_paths_t &paths,
+                               uint16_t min_interval, uint16_t max_interval)
+{
+    sim_subscription_t *subscription = nullptr;
+    for (sim_subscription_t &candidate : s_subscriptions) {
+        if (candidate.id == 0) {
+            subscription = &candidate;
+            break;
+        }
+    }
+    size_t path_count = std::min(paths.endpoint_count, std::min(paths.cluster_count, paths.id_count));
+    if (!subscription || path_count > HTTP_SUBSCRIPTION_PATHS_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    uint32_t delay_ms = sim_session_latency_ms(node_id) + sim_latency_ms(s_config.read_latency_ms);
+    TickType_t ticks = pdMS_TO_TICKS(delay_ms);
+    TimerHandle_t timer = xTimerCreate("http_sim_sub", ticks > 0 ? ticks : 1, pdTRUE, (void *)(uintptr_t)id,
+                                       sim_subscription_tick);
+    if (!timer) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTimerStart(timer, 0) != pdPASS) {
+        xTimerDelete(timer, 0);
+        return ESP_FAIL;
+    }
+    subscription->id = id;
+    subscription->subscription_id = 0;
+    subscription->node_id = node_id;
+    subscription->events = events;
+    subscription->min_interval = min_interval;
+    subscription->max_interval = max_interval;
+    subscription->timer = timer;
+    subscription->path_count = path_count;
+    for (size_t i = 0; i < path_count; ++i) {
+        subscription->paths[i].endpoint_id = paths.endpoint_ids[i];
+        subscription->paths[i].cluster_id = paths.cluster_ids[i];
+        subscription->paths[i].attribute_id = paths.ids[i];
+    }
+    return ESP_OK;
+}
+
+static void sim_pairing_done(TimerHandle_t timer)
+{
+    xTimerDelete(timer, 0);
+    s_pairing.store(false);
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool failed = sim_fails();
+    if (!failed) {
+        sim_session_latency_ms(s_pairing_node_id);
+    }
+    xSemaphoreGive(s_mutex);
+    if (failed) {
+        s_pairing_callback(BACKEND_PAIRING_COMMISSIONING_FAILED, "Commissioning failed (simulated)");
+    } else {
+        s_pairing_callback(BACKEND_PAIRING_COMMISSIONED, nullptr);
+    }
+}
+
+static void sim_pairing_pase(TimerHandle_t timer)
+{
+    xTimerDelete(timer, 0);
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    bool failed = sim_fails();
+    uint32_t commission_ms = sim_latency_ms(s_config.commission_latency_ms);
+    xSemaphoreGive(s_mutex);
+    if (failed) {
+        s_pairing.store(false);
+        s_pairing_callback(BACKEND_PAIRING_PASE_FAILED, "PASE session failed (simulated)");
+        return;
+    }
+    s_pairing_callback(BACKEND_PAIRING_PASE_OK, nullptr);
+    if (sim_timer_start(commission_ms, sim_pairing_done, nullptr) != ESP_OK) {
+        s_pairing.store(false);
+        s_pairing_callback(BACKEND_PAIRING_COMMISSIONING_FAILED, "Out of timers");
+    }
+}
+
+static void sim_ocw_done(TimerHandle_t timer)
+{
+    xTimerDelete(timer, 0);
+    if (s_ocw_callback) {
+        s_ocw_callback(SIM_MANUAL_CODE, SIM_QR_CODE);
+    }
+}
+
+static void sim_ble_scan_done(TimerHandle_t timer)
+{
+    uint32_t generation = (uint32_t)(uintptr_t)pvTimerGetTimerID(timer);
+    xTimerDelete(timer, 0);
+    if (s_ble_generation.load() == generation) {
+        s_ble_scanning.store(false);
+    }
+}
+
+class sim_backend : public controller_backend {
+public:
+    const char *name() const override { return "sim"; }
+
+    bool lock(TickType_t timeout) override { return xSemaphoreTake(s_mutex, timeout) == pdTRUE; }
+
+    void unlock() override { xSemaphoreGive(s_mutex); }
+
+    esp_err_t start_pairing(const backend_pairing_t &params, backend_pairing_cb_t callback) override
+    {
+        bool expected = false;
+        if (!s_pairing.compare_exchange_strong(expected, true)) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        s_pairing_callback = callback;
+        s_pairing_node_id = params.node_id;
+        esp_err_t err = sim_timer_start(sim_latency_ms(s_config.case_latency_ms), sim_pairing_pase, nullptr);
+        if (err != ESP_OK) {
+            s_pairing.store(false);
+        }
+        return err;
+    }
+
+    esp_err_t open_commissioning_window(const backend_ocw_t &params, uint32_t timeout_ms,
+                                        backend_ocw_cb_t callback) override
+    {
+        s_ocw_callback = callback;
+        if (sim_fails()) {
+            // The opener only reports success, the job times out like with a device
+            return ESP_OK;
+        }
+        return sim_timer_start(sim_session_latency_ms(params.node_id) + sim_latency_ms(s_config.invoke_latency_ms),
+                               sim_ocw_done, nullptr);
+    }
+
+    esp_err_t invoke(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                     const char *command_data, uint16_t timed_invoke_timeout_ms) override
+    {
+        return sim_start_interaction(SIM_INVOKE, nullptr, node_id, nullptr, nullptr, s_config.invoke_latency_ms);
+    }
+
+    esp_err_t invoke_tlv(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                         const uint8_t *fields, size_t fields_len, uint16_t timed_invoke_timeout_ms) override
+    {
+        // Anonymous structure control byte first, end of container last
+        if (fields_len < 2 || fields[0] != 0x15 || fields[fields_len - 1] != 0x18) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        return sim_start_interaction(SIM_INVOKE, nullptr, node_id, nullptr, nullptr, s_config.invoke_latency_ms);
+    }
+
+    esp_err_t read_attributes(pending_op *op, uint64_t node_id, const backend_paths_t &paths) override
+    {
+        if (paths.endpoint_count != paths.cluster_count || paths.endpoint_count != paths.id_count) {
+            HTTP_LOGE(HTTP_LOG_BACKEND, "Array length mismatch");
+            return ESP_ERR_INVALID_ARG;
+        }
+        return sim_start_interaction(SIM_READ, op, node_id, &paths, nullptr, s_config.read_latency_ms);
+    }
+
+    esp_err_t write_attributes(pending_op *op, uint64_t node_id, const backend_paths_t &paths, const char *value,
+                               uint16_t timed_write_timeout_ms) override
+    {
+        return sim_start_interaction(SIM_WRITE, nullptr, node_id, &paths, value, s_config.write_latency_ms);
+    }
+
+    esp_err_t read_events(uint64_t node_id, const backend_paths_t &paths) override { return ESP_OK; }
+
+    esp_err_t subscribe_attributes(uint32_t id, uint64_t node_id, const backend_paths_t &paths,
+                                   uint16_t min_interval, uint16_t max_interval) override
+    {
+        return sim_subscribe(id, node_id, false, paths, min_interval, max_interval);
+    }
+
+    esp_err_t subscribe_events(uint32_t id, uint64_t node_id, const backend_paths_t &paths, uint16_t min_interval,
+                               uint16_t max_interval) override
+    {
+        return sim_subscribe(id, node_id, true, paths, min_interval, max_interval);
+    }
+
+    esp_err_t unsubscribe(uint32_t id) override
+    {
+        sim_subscription_t *subscription = sim_find_subscription(id);
+        if (!subscription) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        sim_end_subscription(subscription);
+        return ESP_OK;
+    }
+
+    esp_err_t shutdown_subscription(uint64_t node_id, uint32_t subscription_id) override
+    {
+        for (sim_subscription_t &subscription : s_subscriptions) {
+            if (subscription.id != 0 && subscription.node_id == node_id &&
+                subscription.subscription_id == subscription_id) {
+                sim_end_subscription(&subscription);
+                return ESP_OK;
+            }
+        }
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t shutdown_subscriptions(const uint64_t *node_id) override
+    {
+        for (sim_subscription_t &subscription : s_subscriptions) {
+            if (subscription.id != 0 && (!node_id || subscription.node_id == *node_id)) {
+                sim_end_subscription(&subscription);
+            }
+        }
+        return ESP_OK;
+    }
+
+    esp_err_t ble_scan_start(uint16_t timeout_s, bool show_details) override
+    {
+        uint32_t generation = s_ble_generation.fetch_add(1) + 1;
+        s_ble_scanning.store(true);
+        esp_err_t err = sim_timer_start(timeout_s * 1000, sim_ble_scan_done, (void *)(uintptr_t)generation);
+        if (err != ESP_OK) {
+            s_ble_scanning.store(false);
+        }
+        return err;
+    }
+
+    bool ble_scan_running() override { return s_ble_scanning.load(); }
+
+    void ble_scan_stop() override { s_ble_scanning.store(false); }
+
+    void write_metrics(metrics_writer *writer) override
+    {
+        writer->family("sim_interactions_in_flight", "gauge", "Simulated interactions waiting for their latency");
+        writer->printf("sim_interactions_in_flight %" PRIu32 "\n", s_in_flight.load());
+    }
+};
+
+static sim_backend s_sim_backend;
+
+controller_backend *http_sim_backend(const sim_backend_config_t *config)
+{
+    if (!s_mutex) {
+        s_mutex = xSemaphoreCreateMutex();
+        s_attributes = (sim_attribute_t *)http_mem_calloc(SIM_ATTRIBUTES_MAX, sizeof(sim_attribute_t),
+                                                          HTTP_MEM_LONG_LIVED);
+        if (!s_mutex || !s_attributes) {
+            ESP_LOGE(TAG, "Failed to allocate the simulated devices");
+            return nullptr;
+        }
+    }
+    if (config) {
+        s_config = *config;
+    }
+    s_random = (uint32_t)esp_timer_get_time() | 1;
+    return &s_sim_backend;
+}
+
+esp_err_t sim_backend_set_attribute(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id,
+                                    uint32_t attribute_id, const char *value)
+{
+    if (!s_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    esp_err_t err = sim_store_attribute(node_id, endpoint_id, cluster_id, attribute_id, value);
+    xSemaphoreGive(s_mutex);
+    return err;
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
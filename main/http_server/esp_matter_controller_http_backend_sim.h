@@ -0,0 +1,71 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_matter_controller_http_backend.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+/**
+ * @brief Behaviour of the simulated devices
+ *
+ * Latencies are added on the timer task, so the REST layer sees the same
+ * asynchronous completions as with real devices without holding the lock
+ * while they elapse.
+ */
+typedef struct {
+    uint32_t case_latency_ms;       // First interaction with a node, sessions are kept afterwards
+    uint32_t read_latency_ms;       // Read request to last report
+    uint32_t write_latency_ms;      // Write request to last status
+    uint32_t invoke_latency_ms;     // Invoke request to response
+    uint32_t commission_latency_ms; // PASE to commissioning complete
+    uint32_t jitter_ms;             // Up to this much is added to every latency
+    uint8_t failure_percent;        // Interactions failing with a device error
+    uint8_t wildcard_fanout;        // Values a wildcard endpoint, cluster or attribute ID expands to
+} sim_backend_config_t;
+
+#define SIM_BACKEND_DEFAULT_CONFIG()       \
+    {                                      \
+        .case_latency_ms = 150,            \
+        .read_latency_ms = 40,             \
+        .write_latency_ms = 50,            \
+        .invoke_latency_ms = 40,           \
+        .commission_latency_ms = 3000,     \
+        .jitter_ms = 10,                   \
+        .failure_percent = 0,              \
+        .wildcard_fanout = 4,              \
+    }
+
+/**
+ * @brief Controller answering from an in-memory attribute table instead of devices
+ *
+ * Used by the linux host build and for benchmarking the REST layer on its
+ * own. Attributes never set read back a value derived from their path, writes
+ * update the table. Group settings and UDC are not supported.
+ *
+ * @param config Behaviour of the devices, copied; NULL for the defaults
+ */
+controller_backend *http_sim_backend(const sim_backend_config_t *config);
+
+/**
+ * @brief Set the value an attribute reads back
+ *
+ * The value is a JSON scalar or the console's {"0:TYPE": value} form, like
+ * attribute_value in /api/write-attribute. Numbers, true/false and null are
+ * stored typed, anything else as a string.
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE before http_sim_backend(),
+ *         ESP_ERR_NO_MEM if the attribute table is full
+ */
+esp_err_t sim_backend_set_attribute(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id,
+                                    uint32_t attribute_id, const char *value);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
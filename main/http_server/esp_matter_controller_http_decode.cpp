@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_decode.h>
+#include <algorithm>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+void decode_attribute_record(uint64_t node_id, const chip::app::ConcreteDataAttributePath &path,
+                             chip::TLV::TLVReader *data, result_record_t *record)
+{
+    record->node_id = node_id;
+    record->endpoint_id = path.mEndpointId;
+    record->cluster_id = path.mClusterId;
+    record->attribute_id = path.mAttributeId;
+    record->type = RECORD_VALUE_NULL;
+
+    if (data == nullptr) {
+        return;
+    }
+
+    chip::TLV::TLVReader reader;
+    reader.Init(*data);
+
+    switch (reader.GetType()) {
+        case chip::TLV::kTLVType_Boolean:
+            if (reader.Get(record->value.b) == CHIP_NO_ERROR) {
+                record->type = RECORD_VALUE_BOOL;
+            }
+            break;
+        case chip::TLV::kTLVType_UnsignedInteger:
+            if (reader.Get(record->value.u) == CHIP_NO_ERROR) {
+                record->type = RECORD_VALUE_UINT;
+            }
+            break;
+        case chip::TLV::kTLVType_SignedInteger:
+            if (reader.Get(record->value.i) == CHIP_NO_ERROR) {
+                record->type = RECORD_VALUE_INT;
+            }
+            break;
+        case chip::TLV::kTLVType_UTF8String: {
+            chip::CharSpan value;
+            if (reader.Get(value) == CHIP_NO_ERROR) {
+                size_t copy_len = std::min(value.size(), sizeof(record->str) - 1);
+                memcpy(record->str, value.data(), copy_len);
+                record->str[copy_len] = '\0';
+                record->type = RECORD_VALUE_STRING;
+            }
+            break;
+        }
+        case chip::TLV::kTLVType_FloatingPointNumber:
+            if (reader.Get(record->value.f) == CHIP_NO_ERROR) {
+                record->type = RECORD_VALUE_FLOAT;
+            }
+            break;
+        default: {
+            // Structures, lists, byte strings and nulls are kept encoded, for the binary response formats
+            chip::TLV::TLVWriter writer;
+            writer.Init(reinterpret_cast<uint8_t *>(record->str), sizeof(record->str));
+            if (writer.CopyElement(chip::TLV::AnonymousTag(), reader) == CHIP_NO_ERROR &&
+                writer.Finalize() == CHIP_NO_ERROR) {
+                record->raw_len = writer.GetLengthWritten();
+            }
+            record->type = RECORD_VALUE_RAW;
+            break;
+        }
+    }
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
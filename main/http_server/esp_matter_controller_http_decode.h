@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_matter_controller_http_results.h>
+#include <app/ConcreteAttributePath.h>
+#include <lib/core/TLV.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+/**
+ * @brief Decode one attribute report into a result record
+ *
+ * Runs on the CHIP thread: it only copies plain values and never allocates.
+ */
+void decode_attribute_record(uint64_t node_id, const chip::app::ConcreteDataAttributePath &path,
+                             chip::TLV::TLVReader *data, result_record_t *record);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
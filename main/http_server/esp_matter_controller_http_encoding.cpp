@@ -0,0 +1,564 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_encoding.h>
+#include <esp_matter_controller_http_backend.h>
+#if HTTP_SERVER_MATTER_BACKEND
+#include <lib/core/TLV.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_MEDIA_HEADER_MAX 128  // Longer headers are matched on their first part only
+#define RECORDS_HEADER_SIZE_MAX 64 // Top-level container, status and dropped report count
+#define RECORD_SIZE_MAX (96 + RESULT_RECORD_STR_MAX)
+
+typedef struct {
+    const char *mime;
+    http_encoding_t encoding;
+} media_type_t;
+
+static const media_type_t s_media_types[] = {
+    {HTTP_MIME_JSON, HTTP_ENCODING_JSON},
+    {"application/*", HTTP_ENCODING_JSON},
+    {"*/*", HTTP_ENCODING_JSON},
+    {HTTP_MIME_CBOR, HTTP_ENCODING_CBOR},
+    {HTTP_MIME_TLV, HTTP_ENCODING_TLV},
+};
+
+static bool read_header(httpd_req_t *req, const char *name, char *buf, size_t size)
+{
+    esp_err_t err = httpd_req_get_hdr_value_str(req, name, buf, size);
+    return err == ESP_OK || err == ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+static char *trim(char *str)
+{
+    while (*str == ' ' || *str == '\t') {
+        str++;
+    }
+    char *end = str + strlen(str);
+    while (end > str && (end[-1] == ' ' || end[-1] == '\t')) {
+        *--end = '\0';
+    }
+    return str;
+}
+
+// Match one media range such as "application/cbor;q=0.9", split in place; out_q is 1 without a q parameter
+static bool match_media_range(char *range, http_encoding_t *out, double *out_q)
+{
+    double q = 1;
+    char *params = strchr(range, ';');
+    if (params) {
+        *params++ = '\0';
+        char *save = NULL;
+        for (char *param = strtok_r(params, ";", &save); param; param = strtok_r(NULL, ";", &save)) {
+            param = trim(param);
+            if ((param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                q = strtod(param + 2, NULL);
+            }
+        }
+        // q=0 means "not acceptable"
+        if (!(q > 0)) {
+            return false;
+        }
+    }
+    range = trim(range);
+    for (const media_type_t &type : s_media_types) {
+        if (strcasecmp(range, type.mime) == 0) {
+            *out = type.encoding;
+            *out_q = q;
+            return true;
+        }
+    }
+    return false;
+}
+
+http_encoding_t http_accept_encoding(httpd_req_t *req)
+{
+    char accept[HTTP_MEDIA_HEADER_MAX];
+    if (!read_header(req, "Accept", accept, sizeof(accept))) {
+        return HTTP_ENCODING_JSON;
+    }
+    http_encoding_t best = HTTP_ENCODING_JSON;
+    double best_q = 0;
+    char *save = NULL;
+    for (char *range = strtok_r(accept, ",", &save); range; range = strtok_r(NULL, ",", &save)) {
+        http_encoding_t encoding;
+        double q;
+        if (!match_media_range(range, &encoding, &q)) {
+            continue;
+        }
+#if !HTTP_SERVER_MATTER_BACKEND
+        // Without the SDK there is no TLV writer, TLV request bodies are still accepted
+        if (encoding == HTTP_ENCODING_TLV) {
+            continue;
+        }
+#endif
+        // Strictly greater: on equal q-values the range listed first wins
+        if (q > best_q) {
+            best = encoding;
+            best_q = q;
+        }
+    }
+    return best;
+}
+
+http_encoding_t http_content_encoding(httpd_req_t *req)
+{
+    char content_type[HTTP_MEDIA_HEADER_MAX];
+    http_encoding_t encoding;
+    double q;
+    if (!read_header(req, "Content-Type", content_type, sizeof(content_type)) ||
+        !match_media_range(content_type, &encoding, &q)) {
+        return HTTP_ENCODING_JSON;
+    }
+    return encoding;
+}
+
+const char *http_encoding_mime(http_encoding_t encoding)
+{
+    switch (encoding) {
+    case HTTP_ENCODING_CBOR:
+        return HTTP_MIME_CBOR;
+    case HTTP_ENCODING_TLV:
+        return HTTP_MIME_TLV;
+    default:
+        return HTTP_MIME_JSON;
+    }
+}
+
+void cbor_writer::init(uint8_t *buffer, size_t buffer_size)
+{
+    buf = buffer;
+    size = buffer_size;
+    len = 0;
+    overflow = false;
+}
+
+void cbor_writer::put_raw(const void *data, size_t data_len)
+{
+    if (overflow || size - len < data_len) {
+        overflow = true;
+        return;
+    }
+    memcpy(buf + len, data, data_len);
+    len += data_len;
+}
+
+void cbor_writer::put_head(uint8_t major, uint64_t value)
+{
+    uint8_t head[9];
+    size_t arg_len;
+    if (value < 24) {
+        head[0] = (major << 5) | value;
+        arg_len = 0;
+    } else if (value <= UINT8_MAX) {
+        head[0] = (major << 5) | 24;
+        arg_len = 1;
+    } else if (value <= UINT16_MAX) {
+        head[0] = (major << 5) | 25;
+        arg_len = 2;
+    } else if (value <= UINT32_MAX) {
+        head[0] = (major << 5) | 26;
+        arg_len = 4;
+    } else {
+        head[0] = (major << 5) | 27;
+        arg_len = 8;
+    }
+    // Arguments are big-endian
+    for (size_t i = 0; i < arg_len; ++i) {
+        head[1 + i] = value >> (8 * (arg_len - 1 - i));
+    }
+    put_raw(head, 1 + arg_len);
+}
+
+void cbor_writer::put_uint(uint64_t value)
+{
+    put_head(0, value);
+}
+
+void cbor_writer::put_int(int64_t value)
+{
+    if (value >= 0) {
+        put_head(0, value);
+    } else {
+        // Major type 1 encodes -1 - n
+        put_head(1, ~(uint64_t)value);
+    }
+}
+
+void cbor_writer::put_double(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint8_t item[9] = {0xfb};
+    for (size_t i = 0; i < 8; ++i) {
+        item[1 + i] = bits >> (8 * (7 - i));
+    }
+    put_raw(item, sizeof(item));
+}
+
+void cbor_writer::put_bool(bool value)
+{
+    uint8_t item = value ? 0xf5 : 0xf4;
+    put_raw(&item, 1);
+}
+
+void cbor_writer::put_null()
+{
+    uint8_t item = 0xf6;
+    put_raw(&item, 1);
+}
+
+void cbor_writer::put_text(const char *str)
+{
+    size_t str_len = strlen(str);
+    put_head(3, str_len);
+    put_raw(str, str_len);
+}
+
+void cbor_writer::put_bytes(const uint8_t *data, size_t data_len)
+{
+    put_head(2, data_len);
+    put_raw(data, data_len);
+}
+
+void cbor_writer::start_array(size_t count)
+{
+    put_head(4, count);
+}
+
+void cbor_writer::start_map(size_t pairs)
+{
+    put_head(5, pairs);
+}
+
+size_t http_records_encoded_size(uint32_t record_count)
+{
+    return RECORDS_HEADER_SIZE_MAX + (size_t)record_count * RECORD_SIZE_MAX;
+}
+
+const char *http_record_type_name(record_value_type_t type)
+{
+    switch (type) {
+    case RECORD_VALUE_BOOL:
+        return "boolean";
+    case RECORD_VALUE_UINT:
+        return "uint";
+    case RECORD_VALUE_INT:
+        return "int";
+    case RECORD_VALUE_FLOAT:
+        return "float";
+    case RECORD_VALUE_STRING:
+        return "string";
+    case RECORD_VALUE_RAW:
+        return "raw";
+    default:
+        return "null";
+    }
+}
+
+const char *http_im_status_name(uint8_t status)
+{
+    switch (status) {
+    case 0x00: return "SUCCESS";
+    case 0x01: return "FAILURE";
+    case 0x7d: return "INVALID_SUBSCRIPTION";
+    case 0x7e: return "UNSUPPORTED_ACCESS";
+    case 0x7f: return "UNSUPPORTED_ENDPOINT";
+    case 0x80: return "INVALID_ACTION";
+    case 0x81: return "UNSUPPORTED_COMMAND";
+    case 0x85: return "INVALID_COMMAND";
+    case 0x86: return "UNSUPPORTED_ATTRIBUTE";
+    case 0x87: return "CONSTRAINT_ERROR";
+    case 0x88: return "UNSUPPORTED_WRITE";
+    case 0x89: return "RESOURCE_EXHAUSTED";
+    case 0x8b: return "NOT_FOUND";
+    case 0x8c: return "UNREPORTABLE_ATTRIBUTE";
+    case 0x8d: return "INVALID_DATA_TYPE";
+    case 0x8f: return "UNSUPPORTED_READ";
+    case 0x92: return "DATA_VERSION_MISMATCH";
+    case 0x94: return "TIMEOUT";
+    case 0x9c: return "BUSY";
+    case 0xc3: return "UNSUPPORTED_CLUSTER";
+    case 0xc6: return "NEEDS_TIMED_INTERACTION";
+    case 0xc8: return "PATHS_EXHAUSTED";
+    case 0xc9: return "TIMED_REQUEST_MISMATCH";
+    case 0xca: return "FAILSAFE_REQUIRED";
+    case 0xcb: return "INVALID_IN_STATE";
+    default: return "UNKNOWN";
+    }
+}
+
+static void encode_record_cbor(cbor_writer *writer, const result_record_t *record)
+{
+    writer->start_map(6);
+    writer->put_text("node_id");
+    writer->put_uint(record->node_id);
+    writer->put_text("endpoint_id");
+    writer->put_uint(record->endpoint_id);
+    writer->put_text("cluster_id");
+    writer->put_uint(record->cluster_id);
+    writer->put_text("attribute_id");
+    writer->put_uint(record->attribute_id);
+    writer->put_text("type");
+    writer->put_text(http_record_type_name(record->type));
+    writer->put_text("value");
+    switch (record->type) {
+    case RECORD_VALUE_BOOL:
+        writer->put_bool(record->value.b);
+        break;
+    case RECORD_VALUE_UINT:
+        writer->put_uint(record->value.u);
+        break;
+    case RECORD_VALUE_INT:
+        writer->put_int(record->value.i);
+        break;
+    case RECORD_VALUE_FLOAT:
+        writer->put_double(record->value.f);
+        break;
+    case RECORD_VALUE_STRING:
+        writer->put_text(record->str);
+        break;
+    case RECORD_VALUE_RAW:
+        if (record->raw_len > 0) {
+            writer->put_bytes(reinterpret_cast<const uint8_t *>(record->str), record->raw_len);
+        } else {
+            writer->put_null();
+        }
+        break;
+    default:
+        writer->put_null();
+        break;
+    }
+}
+
+static esp_err_t encode_records_cbor(pending_op *op, uint8_t *buf, size_t size, size_t *out_len)
+{
+    uint32_t count = pending_op_record_count(op);
+    cbor_writer writer;
+    writer.init(buf, size);
+    writer.start_map(2);
+    writer.put_text("status");
+    writer.put_text("success");
+    writer.put_text("attributes");
+    writer.start_array(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        encode_record_cbor(&writer, pending_op_peek(op));
+        pending_op_pop(op);
+    }
+    if (writer.overflow) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = writer.len;
+    return ESP_OK;
+}
+
+#if HTTP_SERVER_MATTER_BACKEND
+static CHIP_ERROR encode_record_tlv(chip::TLV::TLVWriter &writer, const result_record_t *record)
+{
+    using chip::TLV::ContextTag;
+    chip::TLV::TLVType container;
+    ReturnErrorOnFailure(writer.StartContainer(chip::TLV::AnonymousTag(), chip::TLV::kTLVType_Structure, container));
+    ReturnErrorOnFailure(writer.Put(ContextTag(0), record->node_id));
+    ReturnErrorOnFailure(writer.Put(ContextTag(1), (uint64_t)record->endpoint_id));
+    ReturnErrorOnFailure(writer.Put(ContextTag(2), (uint64_t)record->cluster_id));
+    ReturnErrorOnFailure(writer.Put(ContextTag(3), (uint64_t)record->attribute_id));
+    switch (record->type) {
+    case RECORD_VALUE_BOOL:
+        ReturnErrorOnFailure(writer.PutBoolean(ContextTag(4), record->value.b));
+        break;
+    case RECORD_VALUE_UINT:
+        ReturnErrorOnFailure(writer.Put(ContextTag(4), record->value.u));
+        break;
+    case RECORD_VALUE_INT:
+        ReturnErrorOnFailure(writer.Put(ContextTag(4), record->value.i));
+        break;
+    case RECORD_VALUE_FLOAT:
+        ReturnErrorOnFailure(writer.Put(ContextTag(4), record->value.f));
+        break;
+    case RECORD_VALUE_STRING:
+        ReturnErrorOnFailure(writer.PutString(ContextTag(4), record->str));
+        break;
+    case RECORD_VALUE_RAW:
+        if (record->raw_len > 0) {
+            // Re-tag the element the device sent, without decoding it
+            chip::TLV::TLVReader reader;
+            reader.Init(reinterpret_cast<const uint8_t *>(record->str), record->raw_len);
+            ReturnErrorOnFailure(reader.Next());
+            ReturnErrorOnFailure(writer.CopyElement(ContextTag(4), reader));
+        }
+        break;
+    default:
+        break;
+    }
+    return writer.EndContainer(container);
+}
+
+static CHIP_ERROR encode_records_tlv(pending_op *op, chip::TLV::TLVWriter &writer)
+{
+    chip::TLV::TLVType outer;
+    chip::TLV::TLVType attributes;
+    ReturnErrorOnFailure(writer.StartContainer(chip::TLV::AnonymousTag(), chip::TLV::kTLVType_Structure, outer));
+    ReturnErrorOnFailure(writer.StartContainer(chip::TLV::ContextTag(0), chip::TLV::kTLVType_Array, attributes));
+    const result_record_t *record;
+    while ((record = pending_op_peek(op)) != nullptr) {
+        ReturnErrorOnFailure(encode_record_tlv(writer, record));
+        pending_op_pop(op);
+    }
+    ReturnErrorOnFailure(writer.EndContainer(attributes));
+    ReturnErrorOnFailure(writer.EndContainer(outer));
+    return writer.Finalize();
+}
+#endif // HTTP_SERVER_MATTER_BACKEND
+
+esp_err_t http_encode_records(http_encoding_t encoding, pending_op *op, uint8_t *buf, size_t size, size_t *out_len)
+{
+    if (encoding == HTTP_ENCODING_CBOR) {
+        return encode_records_cbor(op, buf, size, out_len);
+    }
+    if (encoding != HTTP_ENCODING_TLV) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if HTTP_SERVER_MATTER_BACKEND
+    chip::TLV::TLVWriter writer;
+    writer.Init(buf, size);
+    if (encode_records_tlv(op, writer) != CHIP_NO_ERROR) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = writer.GetLengthWritten();
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t http_encode_record(http_encoding_t encoding, const result_record_t *record, uint8_t *buf, size_t size,
+                             size_t *out_len)
+{
+    if (encoding == HTTP_ENCODING_CBOR) {
+        cbor_writer writer;
+        writer.init(buf, size);
+        encode_record_cbor(&writer, record);
+        if (writer.overflow) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        *out_len = writer.len;
+        return ESP_OK;
+    }
+    if (encoding != HTTP_ENCODING_TLV) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if HTTP_SERVER_MATTER_BACKEND
+    chip::TLV::TLVWriter writer;
+    writer.Init(buf, size);
+    if (encode_record_tlv(writer, record) != CHIP_NO_ERROR || writer.Finalize() != CHIP_NO_ERROR) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = writer.GetLengthWritten();
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+cJSON *http_records_to_json(pending_op *op, bool include_value)
+{
+    cJSON *array = cJSON_CreateArray();
+    if (!array) {
+        return nullptr;
+    }
+    const result_record_t *record;
+    while ((record = pending_op_peek(op)) != nullptr) {
+        cJSON *obj = cJSON_CreateObject();
+        cJSON_AddNumberToObject(obj, "node_id", record->node_id);
+        cJSON_AddNumberToObject(obj, "endpoint_id", record->endpoint_id);
+        cJSON_AddNumberToObject(obj, "cluster_id", record->cluster_id);
+        cJSON_AddNumberToObject(obj, "attribute_id", record->attribute_id);
+        if (op->kind == PENDING_OP_WRITE) {
+            cJSON_AddNumberToObject(obj, "status", record->status);
+            if (record->status != 0) {
+                cJSON_AddStringToObject(obj, "error", http_im_status_name(record->status));
+            }
+        }
+        if (include_value) {
+            switch (record->type) {
+            case RECORD_VALUE_BOOL:
+                cJSON_AddBoolToObject(obj, "value", record->value.b);
+                break;
+            case RECORD_VALUE_UINT:
+                cJSON_AddNumberToObject(obj, "value", record->value.u);
+                break;
+            case RECORD_VALUE_INT:
+                cJSON_AddNumberToObject(obj, "value", record->value.i);
+                break;
+            case RECORD_VALUE_FLOAT:
+                cJSON_AddNumberToObject(obj, "value", record->value.f);
+                break;
+            case RECORD_VALUE_STRING:
+                cJSON_AddStringToObject(obj, "value", record->str);
+                break;
+            case RECORD_VALUE_RAW:
+                cJSON_AddStringToObject(obj, "value", "raw_data");
+                break;
+            default:
+                cJSON_AddNullToObject(obj, "value");
+                break;
+            }
+            cJSON_AddStringToObject(obj, "type", http_record_type_name(record->type));
+        }
+        cJSON_AddItemToArray(array, obj);
+        pending_op_pop(op);
+    }
+    return array;
+}
+
+esp_err_t http_encode_status(http_encoding_t encoding, const char *status, const char *message, uint8_t *buf,
+                             size_t size, size_t *out_len)
+{
+    if (encoding == HTTP_ENCODING_CBOR) {
+        cbor_writer writer;
+        writer.init(buf, size);
+        writer.start_map(2);
+        writer.put_text("status");
+        writer.put_text(status);
+        writer.put_text("message");
+        writer.put_text(message);
+        if (writer.overflow) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        *out_len = writer.len;
+        return ESP_OK;
+    }
+    if (encoding != HTTP_ENCODING_TLV) {
+        return ESP_ERR_INVALID_ARG;
+    }
+#if HTTP_SERVER_MATTER_BACKEND
+    chip::TLV::TLVWriter writer;
+    chip::TLV::TLVType outer;
+    writer.Init(buf, size);
+    if (writer.StartContainer(chip::TLV::AnonymousTag(), chip::TLV::kTLVType_Structure, outer) != CHIP_NO_ERROR ||
+        writer.PutString(chip::TLV::ContextTag(0), status) != CHIP_NO_ERROR ||
+        writer.PutString(chip::TLV::ContextTag(1), message) != CHIP_NO_ERROR ||
+        writer.EndContainer(outer) != CHIP_NO_ERROR || writer.Finalize() != CHIP_NO_ERROR) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *out_len = writer.GetLengthWritten();
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include <esp_matter_controller_http_results.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_MIME_JSON "application/json"
+#define HTTP_MIME_CBOR "application/cbor"
+#define HTTP_MIME_TLV "application/x-matter-tlv"
+#define HTTP_MIME_CBOR_SEQ "application/cbor-seq" // RFC 8742, CBOR items back to back
+
+/**
+ * @brief Wire format of a request or response body
+ */
+typedef enum : uint8_t {
+    HTTP_ENCODING_JSON = 0,
+    HTTP_ENCODING_CBOR,
+    HTTP_ENCODING_TLV, // Matter TLV
+} http_encoding_t;
+
+/**
+ * @brief Pick the response format from the Accept header
+ *
+ * The range the server produces with the highest q-value wins, the one
+ * listed first among equal q-values; q=0 excludes a range. Without a usable
+ * Accept header the response is JSON.
+ */
+http_encoding_t http_accept_encoding(httpd_req_t *req);
+
+/**
+ * @brief Format of the request body according to its Content-Type header
+ */
+http_encoding_t http_content_encoding(httpd_req_t *req);
+
+/**
+ * @brief MIME type sent as the Content-Type of a response
+ */
+const char *http_encoding_mime(http_encoding_t encoding);
+
+/**
+ * @brief Name of a record value type, as sent in the "type" field of the responses
+ */
+const char *http_record_type_name(record_value_type_t type);
+
+/**
+ * @brief Name of an Interaction Model status code, e.g. "CONSTRAINT_ERROR" for 0x87
+ */
+const char *http_im_status_name(uint8_t status);
+
+/**
+ * @brief Append-only CBOR (RFC 8949) encoder over a caller-provided buffer
+ *
+ * Only definite-length items are written. Running out of space sets
+ * overflow and drops everything written afterwards.
+ */
+struct cbor_writer {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+
+    void init(uint8_t *buffer, size_t buffer_size);
+    void put_uint(uint64_t value);
+    void put_int(int64_t value);
+    void put_double(double value);
+    void put_bool(bool value);
+    void put_null();
+    void put_text(const char *str);
+    void put_bytes(const uint8_t *data, size_t data_len);
+    void start_array(size_t count);
+    void start_map(size_t pairs);
+
+private:
+    void put_head(uint8_t major, uint64_t value);
+    void put_raw(const void *data, size_t data_len);
+};
+
+/**
+ * @brief Upper bound of the encoded size of a records response, in either binary format
+ */
+size_t http_records_encoded_size(uint32_t record_count);
+
+/**
+ * @brief Drain the records of a completed operation into a CBOR or TLV document
+ *
+ * CBOR: a map with "status" and "attributes"; attributes carry the same
+ * keys as the JSON response.
+ * Values decoded to a scalar are native CBOR items, RAW values are the
+ * attribute's TLV element as a byte string.
+ *
+ * TLV: an anonymous structure holding an array of attribute structures at
+ * context tag 0. Each
+ * attribute structure is {0: node ID, 1: endpoint ID, 2: cluster ID,
+ * 3: attribute ID, 4: value}, the value being omitted for paths that
+ * returned an error or whose value was too large to keep.
+ *
+ * @param encoding HTTP_ENCODING_CBOR or HTTP_ENCODING_TLV
+ * @param op Completed operation, its records are consumed
+ * @param buf Output buffer, at least http_records_encoded_size() bytes
+ * @param size Size of buf
+ * @param out_len Encoded length
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if buf is too small
+ */
+esp_err_t http_encode_records(http_encoding_t encoding, pending_op *op, uint8_t *buf, size_t size, size_t *out_len);
+
+/**
+ * @brief Encode one record as a top-level item, an element of a CBOR sequence or TLV stream
+ *
+ * The item has the shape of one entry of the "attributes" of
+ * http_encode_records(): a CBOR map or an anonymous TLV structure.
+ *
+ * @param encoding HTTP_ENCODING_CBOR or HTTP_ENCODING_TLV
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if buf is too small
+ */
+esp_err_t http_encode_record(http_encoding_t encoding, const result_record_t *record, uint8_t *buf, size_t size,
+                             size_t *out_len);
+
+/**
+ * @brief Drain the records of a completed operation into the JSON array of a response
+ *
+ * Each record becomes {node_id, endpoint_id, cluster_id, attribute_id} plus
+ * "value" and "type" when include_value is set. RAW values are not converted
+ * to JSON and read "raw_data". Records of a write carry the Interaction Model
+ * "status" of the path, and its name as "error" when it is not SUCCESS.
+ *
+ * @return The array, NULL if it could not be allocated
+ */
+cJSON *http_records_to_json(pending_op *op, bool include_value);
+
+/**
+ * @brief Encode a {status, message} reply
+ *
+ * CBOR: a map with both keys. TLV: an anonymous structure with the status
+ * at context tag 0 and the message at tag 1.
+ */
+esp_err_t http_encode_status(http_encoding_t encoding, const char *status, const char *message, uint8_t *buf,
+                             size_t size, size_t *out_len);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
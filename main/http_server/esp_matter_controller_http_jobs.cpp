@@ -0,0 +1,294 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_jobs.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <atomic>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static const char *TAG = "controller_httpjobs";
+
+typedef struct {
+    const char *name;
+    int64_t start_us;
+    int64_t end_us;
+} job_stage_t;
+
+struct job {
+    uint32_t id;
+    const char *type;
+    job_state_t state;
+    uint8_t progress;
+    int64_t created_us;
+    int64_t started_us;
+    int64_t finished_us;
+    job_stage_t stages[JOB_MAX_STAGES];
+    uint8_t stage_count;
+    cJSON *result;
+    char error[96];
+    job_fn_t fn;
+    void *arg;
+    TaskHandle_t worker;
+};
+
+// Job table, protected by s_jobs_mutex. Finished jobs stay readable until
+// their slot is recycled for a newer job.
+static job_t s_jobs[JOB_HISTORY_MAX];
+static SemaphoreHandle_t s_jobs_mutex = nullptr;
+static QueueHandle_t s_job_queue = nullptr;
+static uint32_t s_next_job_id = 1;
+static std::atomic<uint32_t> s_jobs_running{0};
+
+static const char *job_state_to_string(job_state_t state)
+{
+    switch (state) {
+        case JOB_STATE_QUEUED: return "queued";
+        case JOB_STATE_RUNNING: return "running";
+        case JOB_STATE_SUCCEEDED: return "succeeded";
+        case JOB_STATE_FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+static bool job_is_finished(const job_t *job)
+{
+    return job->state == JOB_STATE_SUCCEEDED || job->state == JOB_STATE_FAILED;
+}
+
+// Close the open stage; caller holds s_jobs_mutex
+static void job_stage_close_locked(job_t *job, int64_t now)
+{
+    if (job->stage_count > 0 && job->stages[job->stage_count - 1].end_us == 0) {
+        job->stages[job->stage_count - 1].end_us = now;
+    }
+}
+
+static void job_worker_task(void *arg)
+{
+    job_t *job;
+    while (true) {
+        if (xQueueReceive(s_job_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+        job->state = JOB_STATE_RUNNING;
+        job->started_us = esp_timer_get_time();
+        job->worker = xTaskGetCurrentTaskHandle();
+        job_fn_t fn = job->fn;
+        void *job_arg = job->arg;
+        xSemaphoreGive(s_jobs_mutex);
+
+        s_jobs_running.fetch_add(1, std::memory_order_relaxed);
+        esp_err_t err = fn(job, job_arg);
+        s_jobs_running.fetch_sub(1, std::memory_order_relaxed);
+
+        xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+        int64_t now = esp_timer_get_time();
+        job_stage_close_locked(job, now);
+        job->finished_us = now;
+        job->state = err == ESP_OK ? JOB_STATE_SUCCEEDED : JOB_STATE_FAILED;
+        if (err == ESP_OK) {
+            job->progress = 100;
+        } else if (job->error[0] == '\0') {
+            strlcpy(job->error, esp_err_to_name(err), sizeof(job->error));
+        }
+        job->worker = nullptr;
+        job->arg = nullptr;
+        uint32_t id = job->id;
+        const char *type = job->type;
+        xSemaphoreGive(s_jobs_mutex);
+
+        free(job_arg);
+        HTTP_LOGI(HTTP_LOG_JOBS, "Job %" PRIu32 " (%s) %s", id, type, err == ESP_OK ? "succeeded" : "failed");
+    }
+}
+
+esp_err_t jobs_init(BaseType_t core_id, UBaseType_t priority)
+{
+    if (s_jobs_mutex) {
+        return ESP_OK;
+    }
+    s_jobs_mutex = xSemaphoreCreateMutex();
+    s_job_queue = xQueueCreate(JOB_HISTORY_MAX, sizeof(job_t *));
+    if (!s_jobs_mutex || !s_job_queue) {
+        ESP_LOGE(TAG, "Failed to create job queue");
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < JOB_WORKER_COUNT; ++i) {
+        if (xTaskCreatePinnedToCore(job_worker_task, "http_job", JOB_WORKER_STACK_SIZE, NULL, priority, NULL,
+                                    core_id) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create job worker %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t job_submit(const char *type, job_fn_t fn, void *arg, uint32_t *out_id)
+{
+    if (!s_jobs_mutex) {
+        free(arg);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    // Reuse an empty slot, otherwise recycle the job that finished first
+    job_t *slot = nullptr;
+    for (size_t i = 0; i < JOB_HISTORY_MAX; ++i) {
+        job_t *job = &s_jobs[i];
+        if (job->id == 0) {
+            slot = job;
+            break;
+        }
+        if (job_is_finished(job) && (!slot || job->finished_us < slot->finished_us)) {
+            slot = job;
+        }
+    }
+    if (!slot) {
+        xSemaphoreGive(s_jobs_mutex);
+        free(arg);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (slot->result) {
+        cJSON_Delete(slot->result);
+    }
+    memset(slot, 0, sizeof(*slot));
+    slot->id = s_next_job_id++;
+    slot->type = type;
+    slot->state = JOB_STATE_QUEUED;
+    slot->created_us = esp_timer_get_time();
+    slot->fn = fn;
+    slot->arg = arg;
+    *out_id = slot->id;
+
+    if (xQueueSend(s_job_queue, &slot, 0) != pdTRUE) {
+        // Cannot happen while the queue is as deep as the job table
+        slot->id = 0;
+        slot->arg = nullptr;
+        xSemaphoreGive(s_jobs_mutex);
+        free(arg);
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreGive(s_jobs_mutex);
+    return ESP_OK;
+}
+
+void job_set_progress(job_t *job, uint8_t progress)
+{
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    job->progress = progress > 100 ? 100 : progress;
+    xSemaphoreGive(s_jobs_mutex);
+}
+
+void job_stage_begin(job_t *job, const char *stage)
+{
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+    job_stage_close_locked(job, now);
+    if (job->stage_count < JOB_MAX_STAGES) {
+        job->stages[job->stage_count].name = stage;
+        job->stages[job->stage_count].start_us = now;
+        job->stages[job->stage_count].end_us = 0;
+        job->stage_count++;
+    }
+    xSemaphoreGive(s_jobs_mutex);
+}
+
+void job_set_result(job_t *job, cJSON *result)
+{
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    if (job->result) {
+        cJSON_Delete(job->result);
+    }
+    job->result = result;
+    xSemaphoreGive(s_jobs_mutex);
+}
+
+void job_set_error(job_t *job, const char *message)
+{
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    strlcpy(job->error, message, sizeof(job->error));
+    xSemaphoreGive(s_jobs_mutex);
+}
+
+TaskHandle_t job_get_worker(job_t *job)
+{
+    return job->worker;
+}
+
+void jobs_get_load(uint32_t *queued, uint32_t *running)
+{
+    *queued = s_job_queue ? uxQueueMessagesWaiting(s_job_queue) : 0;
+    *running = s_jobs_running.load(std::memory_order_relaxed);
+}
+
+cJSON *job_to_json(uint32_t id)
+{
+    if (!s_jobs_mutex || id == 0) {
+        return nullptr;
+    }
+
+    xSemaphoreTake(s_jobs_mutex, portMAX_DELAY);
+    job_t *job = nullptr;
+    for (size_t i = 0; i < JOB_HISTORY_MAX; ++i) {
+        if (s_jobs[i].id == id) {
+            job = &s_jobs[i];
+            break;
+        }
+    }
+    if (!job) {
+        xSemaphoreGive(s_jobs_mutex);
+        return nullptr;
+    }
+
+    int64_t now = esp_timer_get_time();
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "job_id", job->id);
+    cJSON_AddStringToObject(json, "type", job->type);
+    cJSON_AddStringToObject(json, "state", job_state_to_string(job->state));
+    cJSON_AddNumberToObject(json, "progress", job->progress);
+    int64_t end_us = job_is_finished(job) ? job->finished_us : now;
+    cJSON_AddNumberToObject(json, "elapsed_ms", (end_us - job->created_us) / 1000);
+    if (job->started_us) {
+        cJSON_AddNumberToObject(json, "queued_ms", (job->started_us - job->created_us) / 1000);
+    }
+
+    cJSON *stages = cJSON_AddArrayToObject(json, "stages");
+    for (uint8_t i = 0; i < job->stage_count; ++i) {
+        const job_stage_t *stage = &job->stages[i];
+        cJSON *stage_json = cJSON_CreateObject();
+        cJSON_AddStringToObject(stage_json, "name", stage->name);
+        cJSON_AddNumberToObject(stage_json, "start_ms", (stage->start_us - job->created_us) / 1000);
+        cJSON_AddNumberToObject(stage_json, "duration_ms", ((stage->end_us ? stage->end_us : now) - stage->start_us) / 1000);
+        cJSON_AddBoolToObject(stage_json, "done", stage->end_us != 0);
+        cJSON_AddItemToArray(stages, stage_json);
+    }
+
+    if (job->result) {
+        cJSON_AddItemToObject(json, "result", cJSON_Duplicate(job->result, true));
+    }
+    if (job->error[0] != '\0') {
+        cJSON_AddStringToObject(json, "error", job->error);
+    }
+    xSemaphoreGive(s_jobs_mutex);
+    return json;
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <cJSON.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define JOB_HISTORY_MAX 16    // Jobs kept, including finished ones, before the oldest finished job is recycled
+#define JOB_MAX_STAGES 6      // Stage timings recorded per job
+#define JOB_WORKER_COUNT 2    // Worker tasks executing jobs
+#define JOB_WORKER_STACK_SIZE 8192
+
+/**
+ * @brief Lifecycle state of an asynchronous job
+ */
+typedef enum {
+    JOB_STATE_QUEUED = 0,
+    JOB_STATE_RUNNING,
+    JOB_STATE_SUCCEEDED,
+    JOB_STATE_FAILED,
+} job_state_t;
+
+typedef struct job job_t;
+
+/**
+ * @brief Job body, executed on a worker task
+ * @return ESP_OK if the job succeeded
+ */
+typedef esp_err_t (*job_fn_t)(job_t *job, void *arg);
+
+/**
+ * @brief Start the job worker pool
+ * @param core_id Core the workers are pinned to, tskNO_AFFINITY for any core
+ * @param priority Priority of the worker tasks
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jobs_init(BaseType_t core_id, UBaseType_t priority);
+
+/**
+ * @brief Queue a job
+ * @param type Short job type name, must have static storage
+ * @param fn Job body
+ * @param arg Argument passed to fn, released with free() once the job finishes
+ * @param out_id ID to report to the client
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if every slot holds an unfinished job
+ */
+esp_err_t job_submit(const char *type, job_fn_t fn, void *arg, uint32_t *out_id);
+
+/**
+ * @brief Report progress from a running job, in percent
+ */
+void job_set_progress(job_t *job, uint8_t progress);
+
+/**
+ * @brief Close the current stage, if any, and open a new one
+ * @param stage Stage name, must have static storage
+ */
+void job_stage_begin(job_t *job, const char *stage);
+
+/**
+ * @brief Attach the result object of a job, taking ownership
+ */
+void job_set_result(job_t *job, cJSON *result);
+
+/**
+ * @brief Attach an error message to a job
+ */
+void job_set_error(job_t *job, const char *message);
+
+/**
+ * @brief Task running a job, for CHIP callbacks that need to wake it
+ */
+TaskHandle_t job_get_worker(job_t *job);
+
+/**
+ * @brief Jobs waiting for a worker and jobs being run, without taking the job table lock
+ */
+void jobs_get_load(uint32_t *queued, uint32_t *running);
+
+/**
+ * @brief Snapshot of a job as JSON
+ * @return New cJSON object, or NULL if the ID is unknown or was recycled
+ */
+cJSON *job_to_json(uint32_t id);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,219 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_log.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static_assert((HTTP_LOG_SLOTS & (HTTP_LOG_SLOTS - 1)) == 0, "HTTP_LOG_SLOTS must be a power of two");
+
+// The short name is used to set the level, the tag is printed like an ESP_LOG tag
+static const char *const s_module_names[HTTP_LOG_MODULE_COUNT] = {
+    "server", "ops", "backend", "results", "jobs", "subscriptions", "stream"};
+static const char *const s_module_tags[HTTP_LOG_MODULE_COUNT] = {
+    "controller_httpserver", "controller_httpops", "controller_httpbackend", "controller_httpresults",
+    "controller_httpjobs", "controller_httpsubs", "controller_httpstream"};
+static const char *const s_level_names[] = {"none", "error", "warn", "info", "debug", "verbose"};
+static_assert(HTTP_LOG_MODULE_COUNT == 7, "Add the new module to the tables below");
+
+// Bounded multi-producer queue: a slot is free for the writer at position
+// pos while its seq equals pos, and ready for the drain task once seq is
+// pos + 1. Writers that find the slot still in use drop the message.
+typedef struct {
+    std::atomic<uint32_t> seq;
+    uint32_t timestamp;
+    uint8_t module;
+    uint8_t level;
+    char text[HTTP_LOG_LINE_MAX];
+} http_log_slot_t;
+
+static http_log_slot_t s_slots[HTTP_LOG_SLOTS];
+static std::atomic<uint32_t> s_head{0};
+static std::atomic<uint32_t> s_tail{0}; // Only advanced by the drain task
+static std::atomic<uint32_t> s_written{0};
+static std::atomic<uint32_t> s_dropped{0};
+static std::atomic<uint8_t> s_levels[HTTP_LOG_MODULE_COUNT] = {ESP_LOG_INFO, ESP_LOG_INFO, ESP_LOG_INFO, ESP_LOG_INFO,
+                                                                  ESP_LOG_INFO, ESP_LOG_INFO, ESP_LOG_INFO};
+static std::atomic<TaskHandle_t> s_task{nullptr};
+
+static char level_letter(esp_log_level_t level)
+{
+    switch (level) {
+        case ESP_LOG_ERROR: return 'E';
+        case ESP_LOG_WARN: return 'W';
+        case ESP_LOG_INFO: return 'I';
+        case ESP_LOG_DEBUG: return 'D';
+        default: return 'V';
+    }
+}
+
+static void print_message(http_log_module_t module, esp_log_level_t level, uint32_t timestamp, const char *text)
+{
+    const char *tag = s_module_tags[module];
+    esp_log_write(level, tag, "%c (%" PRIu32 ") %s: %s\n", level_letter(level), timestamp, tag, text);
+}
+
+static void log_drain_task(void *arg)
+{
+    uint32_t reported_drops = 0;
+    uint32_t tail = s_tail.load(std::memory_order_relaxed);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+        while (true) {
+            http_log_slot_t *slot = &s_slots[tail & (HTTP_LOG_SLOTS - 1)];
+            if (slot->seq.load(std::memory_order_acquire) != tail + 1) {
+                break;
+            }
+            print_message((http_log_module_t)slot->module, (esp_log_level_t)slot->level, slot->timestamp, slot->text);
+            slot->seq.store(tail + HTTP_LOG_SLOTS, std::memory_order_release);
+            s_tail.store(++tail, std::memory_order_relaxed);
+        }
+        uint32_t dropped = s_dropped.load(std::memory_order_relaxed);
+        if (dropped != reported_drops) {
+            char text[48];
+            snprintf(text, sizeof(text), "%" PRIu32 " log messages dropped", dropped - reported_drops);
+            print_message(HTTP_LOG_SERVER, ESP_LOG_WARN, esp_log_timestamp(), text);
+            reported_drops = dropped;
+        }
+    }
+}
+
+bool http_log_enabled(http_log_module_t module, esp_log_level_t level)
+{
+    return level <= s_levels[module].load(std::memory_order_relaxed);
+}
+
+void http_log_write(http_log_module_t module, esp_log_level_t level, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    TaskHandle_t task = s_task.load(std::memory_order_acquire);
+    if (!task) {
+        char text[HTTP_LOG_LINE_MAX];
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        print_message(module, level, esp_log_timestamp(), text);
+        return;
+    }
+
+    uint32_t pos = s_head.load(std::memory_order_relaxed);
+    http_log_slot_t *slot;
+    while (true) {
+        slot = &s_slots[pos & (HTTP_LOG_SLOTS - 1)];
+        int32_t diff = (int32_t)(slot->seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (s_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The drain task has not written the message a full ring ago yet
+            va_end(args);
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = s_head.load(std::memory_order_relaxed);
+        }
+    }
+    slot->timestamp = esp_log_timestamp();
+    slot->module = module;
+    slot->level = level;
+    vsnprintf(slot->text, sizeof(slot->text), format, args);
+    va_end(args);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    s_written.fetch_add(1, std::memory_order_relaxed);
+    xTaskNotifyGive(task);
+}
+
+esp_err_t http_log_init()
+{
+    if (s_task.load(std::memory_order_acquire)) {
+        return ESP_OK;
+    }
+    for (uint32_t i = 0; i < HTTP_LOG_SLOTS; ++i) {
+        s_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    TaskHandle_t task;
+    if (xTaskCreate(log_drain_task, "http_log", HTTP_LOG_TASK_STACK_SIZE, NULL, HTTP_LOG_TASK_PRIORITY, &task) !=
+        pdPASS) {
+        ESP_LOGE(s_module_tags[HTTP_LOG_SERVER], "Failed to create the log task");
+        return ESP_ERR_NO_MEM;
+    }
+    s_task.store(task, std::memory_order_release);
+    return ESP_OK;
+}
+
+static int find_name(const char *name, const char *const *names, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        if (strcmp(name, names[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// esp_log_write() filters by tag as well, so the tag level follows the module level
+static void set_module_level(size_t module, esp_log_level_t level)
+{
+    s_levels[module].store(level, std::memory_order_relaxed);
+    esp_log_level_set(s_module_tags[module], level);
+}
+
+esp_err_t http_log_set_level(const char *module, const char *level)
+{
+    int level_index = find_name(level, s_level_names, sizeof(s_level_names) / sizeof(s_level_names[0]));
+    if (level_index < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (strcmp(module, "*") == 0) {
+        for (size_t i = 0; i < HTTP_LOG_MODULE_COUNT; ++i) {
+            set_module_level(i, (esp_log_level_t)level_index);
+        }
+        return ESP_OK;
+    }
+    int module_index = find_name(module, s_module_names, HTTP_LOG_MODULE_COUNT);
+    if (module_index < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    set_module_level(module_index, (esp_log_level_t)level_index);
+    return ESP_OK;
+}
+
+cJSON *http_log_to_json()
+{
+    cJSON *json = cJSON_CreateObject();
+    if (!json) {
+        return nullptr;
+    }
+    cJSON *levels = cJSON_AddObjectToObject(json, "levels");
+    for (size_t i = 0; i < HTTP_LOG_MODULE_COUNT; ++i) {
+        cJSON_AddStringToObject(levels, s_module_names[i], s_level_names[s_levels[i].load(std::memory_order_relaxed)]);
+    }
+    uint32_t head = s_head.load(std::memory_order_relaxed);
+    cJSON_AddNumberToObject(json, "slots", HTTP_LOG_SLOTS);
+    cJSON_AddNumberToObject(json, "written", s_written.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(json, "dropped", s_dropped.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(json, "pending", head - s_tail.load(std::memory_order_relaxed));
+    cJSON_AddBoolToObject(json, "deferred", s_task.load(std::memory_order_relaxed) != nullptr);
+    return json;
+}
+
+uint32_t http_log_dropped()
+{
+    return s_dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
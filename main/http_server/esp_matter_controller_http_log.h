@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_err.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_LOG_SLOTS 32       // Messages buffered until the drain task writes them, must be a power of two
+#define HTTP_LOG_LINE_MAX 120   // Longer messages are truncated
+#define HTTP_LOG_TASK_STACK_SIZE 3072
+#define HTTP_LOG_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+/**
+ * @brief Modules with their own runtime log level
+ */
+typedef enum : uint8_t {
+    HTTP_LOG_SERVER = 0,    // Request handlers
+    HTTP_LOG_OPS,           // Matter interactions, logged from CHIP callbacks
+    HTTP_LOG_BACKEND,       // Controller backends
+    HTTP_LOG_RESULTS,       // Result slots
+    HTTP_LOG_JOBS,          // Asynchronous jobs
+    HTTP_LOG_SUBSCRIPTIONS, // Subscription registry and its persistence
+    HTTP_LOG_STREAM,        // Subscription report streams
+    HTTP_LOG_MODULE_COUNT,
+} http_log_module_t;
+
+/**
+ * @brief Whether a message of this level would be kept for the module
+ */
+bool http_log_enabled(http_log_module_t module, esp_log_level_t level);
+
+/**
+ * @brief Format a message into the log ring
+ *
+ * Never blocks: the message is formatted on the calling task and written to
+ * the console later by a low-priority task. When the ring is full the message
+ * is dropped and counted. Before http_log_init() messages go straight to
+ * esp_log_write().
+ */
+void http_log_write(http_log_module_t module, esp_log_level_t level, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+#define HTTP_LOG_LEVEL(module, level, format, ...)                                         \
+    do {                                                                                   \
+        if (LOG_LOCAL_LEVEL >= (level) && http_log_enabled((module), (level))) {           \
+            http_log_write((module), (level), format, ##__VA_ARGS__);                      \
+        }                                                                                  \
+    } while (0)
+
+#define HTTP_LOGE(module, format, ...) HTTP_LOG_LEVEL(module, ESP_LOG_ERROR, format, ##__VA_ARGS__)
+#define HTTP_LOGW(module, format, ...) HTTP_LOG_LEVEL(module, ESP_LOG_WARN, format, ##__VA_ARGS__)
+#define HTTP_LOGI(module, format, ...) HTTP_LOG_LEVEL(module, ESP_LOG_INFO, format, ##__VA_ARGS__)
+#define HTTP_LOGD(module, format, ...) HTTP_LOG_LEVEL(module, ESP_LOG_DEBUG, format, ##__VA_ARGS__)
+
+/**
+ * @brief Start the task draining the log ring, does nothing if it is running
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the task could not be created
+ */
+esp_err_t http_log_init();
+
+/**
+ * @brief Set the runtime level of a module, by name or "*" for all of them
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND for an unknown module or level name
+ */
+esp_err_t http_log_set_level(const char *module, const char *level);
+
+/**
+ * @brief Module levels and ring counters as JSON
+ * @return New cJSON object, NULL on allocation failure
+ */
+cJSON *http_log_to_json();
+
+/**
+ * @brief Messages dropped because the ring was full, since boot
+ */
+uint32_t http_log_dropped();
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_memory.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <atomic>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static const char *TAG = "controller_httpmem";
+
+#define HTTP_MEM_CAPS_INTERNAL (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define HTTP_MEM_CAPS_PSRAM (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+
+typedef enum {
+    HTTP_MEM_REGION_INTERNAL = 0,
+    HTTP_MEM_REGION_PSRAM,
+    HTTP_MEM_REGION_MAX,
+} http_mem_region_t;
+
+typedef struct {
+    std::atomic<uint32_t> allocations;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint32_t> failures;
+} http_mem_region_stats_t;
+
+static http_mem_policy_t s_policy = {
+    .psram_enable = false,
+    .psram_min_size = 0,
+};
+static bool s_psram_available = false;
+static http_mem_region_stats_t s_region_stats[HTTP_MEM_REGION_MAX];
+static std::atomic<uint32_t> s_psram_fallbacks{0};
+
+esp_err_t http_mem_init(const http_mem_policy_t *policy)
+{
+    s_policy = *policy;
+    s_psram_available = heap_caps_get_total_size(HTTP_MEM_CAPS_PSRAM) > 0;
+    if (s_policy.psram_enable && !s_psram_available) {
+        ESP_LOGI(TAG, "No PSRAM available, all API buffers stay in internal RAM");
+    }
+    return ESP_OK;
+}
+
+static bool use_psram(size_t size, http_mem_usage_t usage)
+{
+    if (!s_policy.psram_enable || !s_psram_available) {
+        return false;
+    }
+    switch (usage) {
+        case HTTP_MEM_LONG_LIVED:
+            return true;
+        case HTTP_MEM_TRANSIENT:
+            return size >= s_policy.psram_min_size;
+        default:
+            return false;
+    }
+}
+
+static void *region_alloc(http_mem_region_t region, size_t size)
+{
+    void *ptr = heap_caps_malloc(size, region == HTTP_MEM_REGION_PSRAM ? HTTP_MEM_CAPS_PSRAM : HTTP_MEM_CAPS_INTERNAL);
+    http_mem_region_stats_t *stats = &s_region_stats[region];
+    if (ptr) {
+        stats->allocations.fetch_add(1, std::memory_order_relaxed);
+        stats->bytes.fetch_add(size, std::memory_order_relaxed);
+    } else {
+        stats->failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ptr;
+}
+
+void *http_mem_alloc(size_t size, http_mem_usage_t usage)
+{
+    if (use_psram(size, usage)) {
+        void *ptr = region_alloc(HTTP_MEM_REGION_PSRAM, size);
+        if (ptr) {
+            return ptr;
+        }
+        s_psram_fallbacks.fetch_add(1, std::memory_order_relaxed);
+    }
+    return region_alloc(HTTP_MEM_REGION_INTERNAL, size);
+}
+
+void *http_mem_calloc(size_t count, size_t size, http_mem_usage_t usage)
+{
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+    void *ptr = http_mem_alloc(count * size, usage);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void http_mem_free(void *ptr)
+{
+    heap_caps_free(ptr);
+}
+
+static cJSON *region_to_json(http_mem_region_t region, uint32_t caps)
+{
+    const http_mem_region_stats_t *stats = &s_region_stats[region];
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "total", heap_caps_get_total_size(caps));
+    cJSON_AddNumberToObject(json, "free", heap_caps_get_free_size(caps));
+    cJSON_AddNumberToObject(json, "min_free", heap_caps_get_minimum_free_size(caps));
+    cJSON_AddNumberToObject(json, "largest_free_block", heap_caps_get_largest_free_block(caps));
+    cJSON_AddNumberToObject(json, "api_allocations", stats->allocations.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(json, "api_bytes", (double)stats->bytes.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(json, "api_failures", stats->failures.load(std::memory_order_relaxed));
+    return json;
+}
+
+cJSON *http_mem_usage_to_json(void)
+{
+    cJSON *json = cJSON_CreateObject();
+
+    cJSON *policy = cJSON_AddObjectToObject(json, "policy");
+    cJSON_AddBoolToObject(policy, "psram_enable", s_policy.psram_enable);
+    cJSON_AddBoolToObject(policy, "psram_available", s_psram_available);
+    cJSON_AddNumberToObject(policy, "psram_min_size", s_policy.psram_min_size);
+    cJSON_AddNumberToObject(policy, "psram_fallbacks", s_psram_fallbacks.load(std::memory_order_relaxed));
+
+    cJSON *regions = cJSON_AddObjectToObject(json, "regions");
+    cJSON_AddItemToObject(regions, "internal", region_to_json(HTTP_MEM_REGION_INTERNAL, HTTP_MEM_CAPS_INTERNAL));
+    if (s_psram_available) {
+        cJSON_AddItemToObject(regions, "psram", region_to_json(HTTP_MEM_REGION_PSRAM, HTTP_MEM_CAPS_PSRAM));
+    }
+    return json;
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <cJSON.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+/**
+ * @brief Memory placement policy for the HTTP server's dynamic allocations
+ */
+typedef struct {
+    bool psram_enable;     // Place large and long-lived buffers in PSRAM when the chip has it
+    size_t psram_min_size; // Transient buffers of at least this many bytes go to PSRAM
+} http_mem_policy_t;
+
+/**
+ * @brief How long an allocation lives, which decides where it is placed
+ */
+typedef enum {
+    HTTP_MEM_TRANSIENT = 0, // Buffers freed within the request, PSRAM if at least psram_min_size
+    HTTP_MEM_LONG_LIVED,    // Pools, caches and arenas kept for the server lifetime, PSRAM if enabled
+} http_mem_usage_t;
+
+/**
+ * @brief Set the placement policy, must be called before the first allocation
+ * @return ESP_OK on success
+ */
+esp_err_t http_mem_init(const http_mem_policy_t *policy);
+
+/**
+ * @brief Allocate according to the placement policy
+ *
+ * Falls back to internal RAM when PSRAM is exhausted or absent. The block can
+ * be released with http_mem_free() or free().
+ */
+void *http_mem_alloc(size_t size, http_mem_usage_t usage);
+
+/**
+ * @brief Zeroed variant of http_mem_alloc()
+ */
+void *http_mem_calloc(size_t count, size_t size, http_mem_usage_t usage);
+
+/**
+ * @brief Release a block from http_mem_alloc()
+ */
+void http_mem_free(void *ptr);
+
+/**
+ * @brief Per-region heap usage and the allocations routed by the policy
+ * @return New cJSON object
+ */
+cJSON *http_mem_usage_to_json(void);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
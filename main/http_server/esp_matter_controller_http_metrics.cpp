@@ -0,0 +1,260 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_metrics.h>
+#include <esp_matter_controller_http_arena.h>
+#include <esp_matter_controller_http_backend.h>
+#include <esp_matter_controller_http_jobs.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_memory.h>
+#include <esp_matter_controller_http_results.h>
+#include <esp_matter_controller_http_stream.h>
+#include <esp_matter_controller_http_subscription_store.h>
+#include <esp_matter_controller_http_subscriptions.h>
+#include <esp_matter_controller_http_telemetry.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define METRICS_CHUNK_SIZE 1024 // Bytes collected before each chunk is sent
+
+const uint32_t http_latency_bounds_ms[HTTP_LATENCY_BUCKETS] = {1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+const uint16_t http_metrics_status_codes[HTTP_METRICS_STATUS_CODES] = {200, 201, 202, 204, 400, 404, 408, 409, 413, 429,
+                                                                         500, 501, 502, 503, 507};
+
+static const char *const s_matter_op_names[MATTER_OP_COUNT] = {"case", "read", "write", "invoke"};
+
+static http_histogram s_matter_latency[MATTER_OP_COUNT];
+static std::atomic<uint32_t> s_matter_failures[MATTER_OP_COUNT];
+
+void http_histogram::observe(uint32_t duration_us)
+{
+    size_t bucket = 0;
+    while (bucket < HTTP_LATENCY_BUCKETS && duration_us > http_latency_bounds_ms[bucket] * 1000) {
+        bucket++;
+    }
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum_us.fetch_add(duration_us, std::memory_order_relaxed);
+}
+
+void http_histogram::reset()
+{
+    for (std::atomic<uint32_t> &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    sum_us.store(0, std::memory_order_relaxed);
+}
+
+void http_endpoint_metrics::observe(int status_code, uint32_t duration_us)
+{
+    size_t index = 0;
+    while (index < HTTP_METRICS_STATUS_CODES && http_metrics_status_codes[index] != status_code) {
+        index++;
+    }
+    status[index].fetch_add(1, std::memory_order_relaxed);
+    latency.observe(duration_us);
+}
+
+void http_endpoint_metrics::reset()
+{
+    for (std::atomic<uint32_t> &count : status) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    latency.reset();
+}
+
+void http_metrics_observe_matter(matter_op_t op, uint32_t duration_us, bool success)
+{
+    s_matter_latency[op].observe(duration_us);
+    if (!success) {
+        s_matter_failures[op].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+metrics_writer::metrics_writer(httpd_req_t *req, char *buf, size_t size)
+    : m_req(req), m_buf(buf), m_size(size), m_len(0), m_err(ESP_OK)
+{
+}
+
+void metrics_writer::flush()
+{
+    if (m_len > 0 && m_err == ESP_OK) {
+        m_err = httpd_resp_send_chunk(m_req, m_buf, m_len);
+    }
+    m_len = 0;
+}
+
+void metrics_writer::printf(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    va_list retry;
+    va_copy(retry, args);
+    int len = vsnprintf(m_buf + m_len, m_size - m_len, format, args);
+    if (len >= 0 && (size_t)len >= m_size - m_len) {
+        // Send what came before and write the line again at the start of the buffer
+        flush();
+        len = vsnprintf(m_buf, m_size, format, retry);
+    }
+    if (len > 0) {
+        m_len += (size_t)len < m_size ? len : m_size - 1;
+    }
+    va_end(retry);
+    va_end(args);
+}
+
+void metrics_writer::family(const char *name, const char *type, const char *help)
+{
+    printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void metrics_writer::histogram(const char *name, const char *labels, const http_histogram &histogram)
+{
+    const char *separator = labels[0] ? "," : "";
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < HTTP_LATENCY_BUCKETS; ++i) {
+        cumulative += histogram.buckets[i].load(std::memory_order_relaxed);
+        printf("%s_bucket{%s%sle=\"%g\"} %" PRIu32 "\n", name, labels, separator, http_latency_bounds_ms[i] / 1000.0,
+               cumulative);
+    }
+    cumulative += histogram.buckets[HTTP_LATENCY_BUCKETS].load(std::memory_order_relaxed);
+    printf("%s_bucket{%s%sle=\"+Inf\"} %" PRIu32 "\n", name, labels, separator, cumulative);
+    printf("%s_sum{%s} %.6f\n", name, labels, histogram.sum_us.load(std::memory_order_relaxed) / 1000000.0);
+    printf("%s_count{%s} %" PRIu32 "\n", name, labels, cumulative);
+}
+
+esp_err_t metrics_writer::finish()
+{
+    flush();
+    if (m_err == ESP_OK) {
+        m_err = httpd_resp_send_chunk(m_req, NULL, 0);
+    }
+    return m_err;
+}
+
+static void write_matter_metrics(metrics_writer *writer)
+{
+    writer->family("matter_operation_duration_seconds", "histogram",
+                   "Round trip of Matter interactions started by the server");
+    for (size_t op = 0; op < MATTER_OP_COUNT; ++op) {
+        char labels[32];
+        snprintf(labels, sizeof(labels), "op=\"%s\"", s_matter_op_names[op]);
+        writer->histogram("matter_operation_duration_seconds", labels, s_matter_latency[op]);
+    }
+    writer->family("matter_operation_failures_total", "counter", "Matter interactions that failed or timed out");
+    for (size_t op = 0; op < MATTER_OP_COUNT; ++op) {
+        writer->printf("matter_operation_failures_total{op=\"%s\"} %" PRIu32 "\n", s_matter_op_names[op],
+                       s_matter_failures[op].load(std::memory_order_relaxed));
+    }
+
+    if (http_backend()) {
+        http_backend()->write_metrics(writer);
+    }
+}
+
+static void write_server_metrics(metrics_writer *writer)
+{
+    uint32_t queued, running;
+    jobs_get_load(&queued, &running);
+    writer->family("matter_http_jobs_queued", "gauge", "Asynchronous jobs waiting for a worker");
+    writer->printf("matter_http_jobs_queued %" PRIu32 "\n", queued);
+    writer->family("matter_http_jobs_running", "gauge", "Asynchronous jobs being run");
+    writer->printf("matter_http_jobs_running %" PRIu32 "\n", running);
+    writer->family("matter_http_jobs_capacity", "gauge", "Jobs kept before submissions are refused");
+    writer->printf("matter_http_jobs_capacity %d\n", JOB_HISTORY_MAX);
+
+    pending_ops_stats_t ops;
+    pending_ops_get_stats(&ops);
+    writer->family("matter_http_pending_ops_in_use", "gauge", "Result slots held by synchronous reads and writes");
+    writer->printf("matter_http_pending_ops_in_use %" PRIu32 "\n", ops.in_use);
+    writer->family("matter_http_pending_ops_capacity", "gauge", "Result slots in the pool");
+    writer->printf("matter_http_pending_ops_capacity %d\n", PENDING_OP_MAX);
+    writer->family("matter_http_pending_ops_busy_total", "counter", "Requests refused with 429 for lack of a slot");
+    writer->printf("matter_http_pending_ops_busy_total %" PRIu32 "\n", ops.busy);
+    writer->family("matter_http_result_pool_lookups_total", "counter",
+                   "Result slots served by their preallocated records (hit) or a new ring (miss)");
+    writer->printf("matter_http_result_pool_lookups_total{result=\"hit\"} %" PRIu32 "\n", ops.pool_hits);
+    writer->printf("matter_http_result_pool_lookups_total{result=\"miss\"} %" PRIu32 "\n", ops.pool_misses);
+
+    http_arena_stats_t arena;
+    http_arena_get_stats(&arena);
+    writer->family("matter_http_arena_scopes_total", "counter",
+                   "Requests that got a pooled arena (hit) or ran on the heap (miss)");
+    writer->printf("matter_http_arena_scopes_total{result=\"hit\"} %" PRIu32 "\n", arena.scopes);
+    writer->printf("matter_http_arena_scopes_total{result=\"miss\"} %" PRIu32 "\n", arena.scopes_no_arena);
+    writer->family("matter_http_arena_allocations_total", "counter",
+                   "cJSON allocations served by the arena (hit) or spilled to the heap (miss)");
+    writer->printf("matter_http_arena_allocations_total{result=\"hit\"} %" PRIu32 "\n", arena.allocations);
+    writer->printf("matter_http_arena_allocations_total{result=\"miss\"} %" PRIu32 "\n", arena.heap_fallbacks);
+    writer->family("matter_http_log_dropped_total", "counter", "Log messages dropped because the log ring was full");
+    writer->printf("matter_http_log_dropped_total %" PRIu32 "\n", http_log_dropped());
+    uint32_t connecting, active, resubscribing, clients;
+    http_subscriptions_count(&connecting, &active, &resubscribing, &clients);
+    writer->family("matter_http_subscriptions", "gauge", "Subscriptions created through the API, by state");
+    writer->printf("matter_http_subscriptions{state=\"connecting\"} %" PRIu32 "\n", connecting);
+    writer->printf("matter_http_subscriptions{state=\"active\"} %" PRIu32 "\n", active);
+    writer->printf("matter_http_subscriptions{state=\"resubscribing\"} %" PRIu32 "\n", resubscribing);
+    writer->family("matter_http_subscription_clients", "gauge", "Subscription IDs handed out, sharing the subscriptions");
+    writer->printf("matter_http_subscription_clients %" PRIu32 "\n", clients);
+    writer->family("matter_http_subscription_restore_ms", "gauge",
+                   "Time taken to re-establish the saved subscriptions after boot, 0 until done");
+    writer->printf("matter_http_subscription_restore_ms %" PRIu32 "\n", http_subscription_restore_duration_ms());
+    http_streams_stats_t streams;
+    http_streams_get_stats(&streams);
+    writer->family("matter_http_streams", "gauge", "Open event streams of subscription reports");
+    writer->printf("matter_http_streams %" PRIu32 "\n", streams.open);
+    writer->family("matter_http_stream_values_total", "counter", "Reported values of streamed paths, by outcome");
+    writer->printf("matter_http_stream_values_total{result=\"sent\"} %" PRIu32 "\n", streams.sent);
+    writer->printf("matter_http_stream_values_total{result=\"coalesced\"} %" PRIu32 "\n", streams.coalesced);
+    writer->printf("matter_http_stream_values_total{result=\"suppressed\"} %" PRIu32 "\n", streams.suppressed);
+    writer->printf("matter_http_stream_values_total{result=\"filtered\"} %" PRIu32 "\n", streams.filtered);
+    writer->printf("matter_http_stream_values_total{result=\"dropped\"} %" PRIu32 "\n", streams.dropped);
+}
+
+static void write_heap_metrics(metrics_writer *writer)
+{
+    writer->family("matter_heap_free_bytes", "gauge", "Free heap");
+    writer->printf("matter_heap_free_bytes{region=\"all\"} %" PRIu32 "\n", esp_get_free_heap_size());
+    writer->printf("matter_heap_free_bytes{region=\"internal\"} %u\n",
+                   (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    writer->family("matter_heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    writer->printf("matter_heap_min_free_bytes{region=\"all\"} %" PRIu32 "\n", esp_get_minimum_free_heap_size());
+    writer->printf("matter_heap_min_free_bytes{region=\"internal\"} %u\n",
+                   (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT));
+    writer->family("matter_uptime_seconds", "gauge", "Time since boot");
+    writer->printf("matter_uptime_seconds %" PRId64 "\n", esp_timer_get_time() / 1000000);
+}
+
+esp_err_t http_metrics_send(httpd_req_t *req)
+{
+    char *buf = (char *)http_mem_alloc(METRICS_CHUNK_SIZE, HTTP_MEM_TRANSIENT);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+    httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+
+    metrics_writer writer(req, buf, METRICS_CHUNK_SIZE);
+    http_endpoints_write_metrics(&writer);
+    write_matter_metrics(&writer);
+    write_server_metrics(&writer);
+    write_heap_metrics(&writer);
+    esp_err_t err = writer.finish();
+
+    http_mem_free(buf);
+    return err;
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_LATENCY_BUCKETS 12 // Finite histogram buckets, see http_latency_bounds_ms
+#define HTTP_METRICS_STATUS_CODES 15 // Status codes counted individually, the rest are counted as "other"
+
+/**
+ * @brief Upper bounds of the latency histogram buckets, in milliseconds
+ */
+extern const uint32_t http_latency_bounds_ms[HTTP_LATENCY_BUCKETS];
+
+/**
+ * @brief Status codes with a counter of their own, in the order of http_endpoint_metrics::status
+ */
+extern const uint16_t http_metrics_status_codes[HTTP_METRICS_STATUS_CODES];
+
+/**
+ * @brief Latency histogram updated with relaxed atomics only
+ *
+ * Bucket counts are stored per bucket and made cumulative when exported, the
+ * total count being their sum. The sum is kept in microseconds, rounding
+ * each observation to milliseconds would skew it for sub-millisecond requests.
+ */
+struct http_histogram {
+    std::atomic<uint32_t> buckets[HTTP_LATENCY_BUCKETS + 1]; // The last one is +Inf
+    std::atomic<uint64_t> sum_us;
+
+    void observe(uint32_t duration_us);
+    void reset();
+};
+
+/**
+ * @brief Request counters of one REST endpoint
+ */
+struct http_endpoint_metrics {
+    std::atomic<uint32_t> status[HTTP_METRICS_STATUS_CODES + 1]; // Indexed like the status code table, then "other"
+    http_histogram latency;
+
+    void observe(int status_code, uint32_t duration_us);
+    void reset();
+};
+
+/**
+ * @brief Matter interactions timed by the server
+ */
+typedef enum : uint8_t {
+    MATTER_OP_CASE = 0, // Session lookup or CASE establishment
+    MATTER_OP_READ,     // Read request to last report
+    MATTER_OP_WRITE,    // Write request to last status, including the session lookup
+    MATTER_OP_INVOKE,   // Invoke request to response, TLV invokes only
+    MATTER_OP_COUNT,
+} matter_op_t;
+
+/**
+ * @brief Record the round trip of a Matter interaction
+ *
+ * Lock-free, callable from any task including the CHIP thread.
+ */
+void http_metrics_observe_matter(matter_op_t op, uint32_t duration_us, bool success);
+
+/**
+ * @brief Chunked writer for the Prometheus text exposition format
+ *
+ * Lines are collected in a fixed buffer and sent with
+ * httpd_resp_send_chunk() whenever it fills up, so the whole document never
+ * needs to fit in memory.
+ */
+class metrics_writer {
+public:
+    metrics_writer(httpd_req_t *req, char *buf, size_t size);
+
+    void printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+    /**
+     * @brief Write the HELP and TYPE lines of a metric family
+     */
+    void family(const char *name, const char *type, const char *help);
+
+    /**
+     * @brief Write the series of a histogram in seconds, labels being "" or "key=\"value\""
+     */
+    void histogram(const char *name, const char *labels, const http_histogram &histogram);
+
+    /**
+     * @brief Send what is left and terminate the chunked response
+     */
+    esp_err_t finish();
+
+private:
+    void flush();
+
+    httpd_req_t *m_req;
+    char *m_buf;
+    size_t m_size;
+    size_t m_len;
+    esp_err_t m_err;
+};
+
+/**
+ * @brief Send every metric of the server in Prometheus text format
+ */
+esp_err_t http_metrics_send(httpd_req_t *req);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
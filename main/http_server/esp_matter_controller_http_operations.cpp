@@ -0,0 +1,833 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_log.h>
+#include <esp_matter_controller_client.h>
+#include <esp_matter_controller_http_decode.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_metrics.h>
+#include <esp_matter_controller_http_operations.h>
+#include <esp_matter_controller_http_stream.h>
+#include <esp_matter_controller_http_subscriptions.h>
+#include <esp_matter_core.h>
+#include <esp_timer.h>
+#include <json_to_tlv.h>
+#include <algorithm>
+#include <inttypes.h>
+#include <string.h>
+
+#include <app/BufferedReadCallback.h>
+#include <app/CommandSender.h>
+#include <app/InteractionModelEngine.h>
+#include <app/MessageDef/CommandDataIB.h>
+#include <app/WriteClient.h>
+#include <lib/support/TypeTraits.h>
+#if !CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+#include <app/server/Server.h>
+#endif
+
+using chip::ScopedNodeId;
+using chip::SessionHandle;
+using chip::Messaging::ExchangeManager;
+using chip::Platform::ScopedMemoryBufferWithSize;
+using chip::app::AttributePathParams;
+using chip::app::BufferedReadCallback;
+using chip::app::CommandSender;
+using chip::app::EventPathParams;
+using chip::app::InteractionModelEngine;
+using chip::app::ReadClient;
+using chip::app::ReadPrepareParams;
+using chip::app::WriteClient;
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#if !CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+// Fabric the controller was commissioned into, the lowest index if it joined several
+static chip::FabricIndex controller_fabric_index()
+{
+    chip::FabricIndex fabric_index = chip::kUndefinedFabricIndex;
+    for (const chip::FabricInfo &fabric : chip::Server::GetInstance().GetFabricTable()) {
+        if (fabric_index == chip::kUndefinedFabricIndex || fabric.GetFabricIndex() < fabric_index) {
+            fabric_index = fabric.GetFabricIndex();
+        }
+    }
+    return fabric_index;
+}
+#endif
+
+// Look up or establish the CASE session of a node, shared by the operations below
+static CHIP_ERROR connect_to_node(uint64_t node_id, chip::Callback::Callback<chip::OnDeviceConnected> *on_connected,
+                                  chip::Callback::Callback<chip::OnDeviceConnectionFailure> *on_connection_failure)
+{
+#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE
+    return matter_controller_client::get_instance().get_commissioner()->GetConnectedDevice(node_id, on_connected,
+                                                                                           on_connection_failure);
+#else
+    chip::FabricIndex fabric_index = controller_fabric_index();
+    if (fabric_index == chip::kUndefinedFabricIndex) {
+        HTTP_LOGE(HTTP_LOG_OPS, "The controller has not joined a fabric yet");
+        return CHIP_ERROR_INCORRECT_STATE;
+    }
+    // Failures are reported through on_connection_failure
+    chip::Server::GetInstance().GetCASESessionManager()->FindOrEstablishSession(ScopedNodeId(node_id, fabric_index),
+                                                                               on_connected, on_connection_failure);
+    return CHIP_NO_ERROR;
+#endif
+}
+
+/**
+ * Attribute read owned by one HTTP request.
+ *
+ * Unlike controller::read_command it keeps its ReadClient, so the request can
+ * abort it: destroying a ReadClient tears down the exchange without calling
+ * OnDone(). All members are only touched with the CHIP stack lock held.
+ */
+class read_operation : public ReadClient::Callback {
+public:
+    read_operation(pending_op *op, uint64_t node_id, ScopedMemoryBufferWithSize<AttributePathParams> &&attr_paths)
+        : m_op(op)
+        , m_node_id(node_id)
+        , m_attr_paths(std::move(attr_paths))
+        , m_buffered_read_cb(*this)
+        , m_on_connected(on_device_connected, this)
+        , m_on_connection_failure(on_device_connection_failure, this)
+    {
+    }
+
+    esp_err_t send()
+    {
+        m_op->cancel.context = this;
+        m_op->cancel.cancel_fn = cancel;
+        m_connect_start_us = esp_timer_get_time();
+        CHIP_ERROR err = connect_to_node(m_node_id, &m_on_connected, &m_on_connection_failure);
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to look up node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT, m_node_id, err.Format());
+            detach();
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+
+    // ReadClient::Callback
+    void OnAttributeData(const chip::app::ConcreteDataAttributePath &path, chip::TLV::TLVReader *data,
+                         const chip::app::StatusIB &status) override
+    {
+        int64_t decode_start_us = esp_timer_get_time();
+        result_record_t *record = m_op->ring.reserve();
+        if (record) {
+            decode_attribute_record(m_node_id, path, status.IsSuccess() ? data : nullptr, record);
+            m_op->ring.commit();
+        }
+        uint32_t decode_us = http_elapsed_us(decode_start_us);
+        m_op->timing.add(HTTP_STAGE_DECODE, decode_us);
+        m_decode_us += decode_us;
+        m_op->received.fetch_add(1);
+    }
+
+    void OnError(CHIP_ERROR error) override
+    {
+        m_status = ESP_FAIL;
+        HTTP_LOGW(HTTP_LOG_OPS, "Read from node 0x%" PRIx64 " failed: %" CHIP_ERROR_FORMAT, m_node_id, error.Format());
+    }
+
+    void OnDone(ReadClient *client) override
+    {
+        uint32_t round_trip_us = http_elapsed_us(m_sent_us);
+        http_metrics_observe_matter(MATTER_OP_READ, round_trip_us, m_status == ESP_OK);
+        m_op->timing.add(HTTP_STAGE_DEVICE, round_trip_us - std::min(round_trip_us, m_decode_us));
+        pending_op_complete(m_op, m_status);
+        finish();
+    }
+
+private:
+    static void on_device_connected(void *context, ExchangeManager &exchange_mgr, const SessionHandle &session)
+    {
+        read_operation *self = static_cast<read_operation *>(context);
+        self->m_sent_us = esp_timer_get_time();
+        uint32_t case_us = (uint32_t)(self->m_sent_us - self->m_connect_start_us);
+        http_metrics_observe_matter(MATTER_OP_CASE, case_us, true);
+        self->m_op->timing.add(HTTP_STAGE_CASE, case_us);
+        ReadPrepareParams params(session);
+        params.mpAttributePathParamsList = self->m_attr_paths.Get();
+        params.mAttributePathParamsListSize = self->m_attr_paths.AllocatedSize();
+
+        self->m_read_client = chip::Platform::MakeUnique<ReadClient>(
+            InteractionModelEngine::GetInstance(), &exchange_mgr, self->m_buffered_read_cb, ReadClient::InteractionType::Read);
+        if (!self->m_read_client) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to alloc memory for ReadClient");
+            pending_op_complete(self->m_op, ESP_ERR_NO_MEM);
+            self->finish();
+            return;
+        }
+        CHIP_ERROR err = self->m_read_client->SendRequest(params);
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to send read request: %" CHIP_ERROR_FORMAT, err.Format());
+            pending_op_complete(self->m_op, ESP_FAIL);
+            self->finish();
+        }
+    }
+
+    static void on_device_connection_failure(void *context, const ScopedNodeId &peer_id, CHIP_ERROR error)
+    {
+        read_operation *self = static_cast<read_operation *>(context);
+        uint32_t case_us = http_elapsed_us(self->m_connect_start_us);
+        http_metrics_observe_matter(MATTER_OP_CASE, case_us, false);
+        self->m_op->timing.add(HTTP_STAGE_CASE, case_us);
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to establish CASE session with node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT,
+                 peer_id.GetNodeId(), error.Format());
+        pending_op_complete(self->m_op, ESP_ERR_TIMEOUT);
+        self->finish();
+    }
+
+    static void cancel(void *context)
+    {
+        read_operation *self = static_cast<read_operation *>(context);
+        HTTP_LOGW(HTTP_LOG_OPS, "Cancelling read from node 0x%" PRIx64, self->m_node_id);
+        self->m_on_connected.Cancel();
+        self->m_on_connection_failure.Cancel();
+        self->finish();
+    }
+
+    void detach()
+    {
+        m_op->cancel.context = nullptr;
+        m_op->cancel.cancel_fn = nullptr;
+    }
+
+    void finish()
+    {
+        detach();
+        chip::Platform::Delete(this);
+    }
+
+    pending_op *m_op;
+    uint64_t m_node_id;
+    esp_err_t m_status = ESP_OK;
+    int64_t m_connect_start_us = 0;
+    int64_t m_sent_us = 0;
+    uint32_t m_decode_us = 0; // Spent in OnAttributeData, taken out of the device's share
+    ScopedMemoryBufferWithSize<AttributePathParams> m_attr_paths;
+    BufferedReadCallback m_buffered_read_cb;
+    chip::Platform::UniquePtr<ReadClient> m_read_client;
+    chip::Callback::Callback<chip::OnDeviceConnected> m_on_connected;
+    chip::Callback::Callback<chip::OnDeviceConnectionFailure> m_on_connection_failure;
+};
+
+esp_err_t start_read_operation(pending_op *op, uint64_t node_id,
+                               ScopedMemoryBufferWithSize<AttributePathParams> &&attr_paths)
+{
+    read_operation *read_op = chip::Platform::New<read_operation>(op, node_id, std::move(attr_paths));
+    if (!read_op) {
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to alloc memory for read_operation");
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = read_op->send();
+    if (err != ESP_OK) {
+        chip::Platform::Delete(read_op);
+    }
+    return err;
+}
+
+/**
+ * Attribute write owned by one HTTP request.
+ *
+ * Unlike controller::write_command it keeps its WriteClient and reports the
+ * status of every path to its pending operation, completing it from OnDone().
+ * The value is encoded once, like the console command does, and the same
+ * element is written to every path. All members are only touched with the
+ * CHIP stack lock held.
+ */
+class write_operation : public WriteClient::Callback {
+public:
+    write_operation(pending_op *op, uint64_t node_id, uint16_t timed_write_timeout_ms)
+        : m_op(op)
+        , m_node_id(node_id)
+        , m_timed_write_timeout_ms(timed_write_timeout_ms)
+        , m_on_connected(on_device_connected, this)
+        , m_on_connection_failure(on_device_connection_failure, this)
+    {
+    }
+
+    esp_err_t send(const backend_paths_t &paths, const char *value)
+    {
+        size_t count = std::min(paths.endpoint_count, std::min(paths.cluster_count, paths.id_count));
+        m_paths.Alloc(count);
+        // JSON is never shorter than the TLV it encodes, beyond a few bytes of header
+        size_t value_len = strlen(value);
+        m_value.Alloc(value_len + 16);
+        if (!m_paths.Get() || !m_value.Get()) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to alloc memory for the write to node 0x%" PRIx64, m_node_id);
+            return ESP_ERR_NO_MEM;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            m_paths[i] =
+                chip::app::ConcreteDataAttributePath(paths.endpoint_ids[i], paths.cluster_ids[i], paths.ids[i]);
+        }
+        chip::TLV::TLVWriter writer;
+        writer.Init(m_value.Get(), m_value.AllocatedSize());
+        chip::TLV::TLVReader reader;
+        if (json_to_tlv(value, writer, chip::TLV::AnonymousTag()) != ESP_OK || writer.Finalize() != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to encode the attribute value");
+            return ESP_ERR_INVALID_ARG;
+        }
+        m_value_len = writer.GetLengthWritten();
+        if (value_reader(&reader) != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Attribute value must be a JSON object holding the value at \"0:<type>\"");
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        m_op->cancel.context = this;
+        m_op->cancel.cancel_fn = cancel;
+        m_connect_start_us = esp_timer_get_time();
+        CHIP_ERROR err = connect_to_node(m_node_id, &m_on_connected, &m_on_connection_failure);
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to look up node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT, m_node_id, err.Format());
+            detach();
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+
+    // WriteClient::Callback
+    void OnResponse(const WriteClient *client, const chip::app::ConcreteDataAttributePath &path,
+                    chip::app::StatusIB status) override
+    {
+        result_record_t *record = m_op->ring.reserve();
+        if (record) {
+            record->node_id = m_node_id;
+            record->endpoint_id = path.mEndpointId;
+            record->cluster_id = path.mClusterId;
+            record->attribute_id = path.mAttributeId;
+            record->status = chip::to_underlying(status.mStatus);
+            m_op->ring.commit();
+        }
+        m_op->received.fetch_add(1);
+    }
+
+    void OnError(const WriteClient *client, CHIP_ERROR error) override
+    {
+        m_status = ESP_FAIL;
+        HTTP_LOGW(HTTP_LOG_OPS, "Write to node 0x%" PRIx64 " failed: %" CHIP_ERROR_FORMAT, m_node_id, error.Format());
+    }
+
+    void OnDone(WriteClient *client) override
+    {
+        if (m_finishing) {
+            // The WriteClient is being destroyed by finish(), nobody waits for it
+            return;
+        }
+        pending_op_complete(m_op, m_status);
+        finish();
+    }
+
+private:
+    // Reader on the value element: the encoded object holds it as its first member
+    CHIP_ERROR value_reader(chip::TLV::TLVReader *reader) const
+    {
+        chip::TLV::TLVType container;
+        reader->Init(m_value.Get(), m_value_len);
+        ReturnErrorOnFailure(reader->Next());
+        VerifyOrReturnError(reader->GetType() == chip::TLV::kTLVType_Structure, CHIP_ERROR_WRONG_TLV_TYPE);
+        ReturnErrorOnFailure(reader->EnterContainer(container));
+        return reader->Next();
+    }
+
+    CHIP_ERROR send_request(ExchangeManager &exchange_mgr, const SessionHandle &session)
+    {
+        chip::Optional<uint16_t> timed_write_timeout;
+        if (m_timed_write_timeout_ms > 0) {
+            timed_write_timeout.SetValue(m_timed_write_timeout_ms);
+        }
+        m_write_client = chip::Platform::MakeUnique<WriteClient>(&exchange_mgr, this, timed_write_timeout);
+        if (!m_write_client) {
+            return CHIP_ERROR_NO_MEMORY;
+        }
+        chip::TLV::TLVReader reader;
+        ReturnErrorOnFailure(value_reader(&reader));
+        for (size_t i = 0; i < m_paths.AllocatedSize(); ++i) {
+            ReturnErrorOnFailure(m_write_client->PutPreencodedAttribute(m_paths[i], reader));
+        }
+        return m_write_client->SendWriteRequest(session);
+    }
+
+    static void on_device_connected(void *context, ExchangeManager &exchange_mgr, const SessionHandle &session)
+    {
+        write_operation *self = static_cast<write_operation *>(context);
+        http_metrics_observe_matter(MATTER_OP_CASE, http_elapsed_us(self->m_connect_start_us), true);
+        CHIP_ERROR err = self->send_request(exchange_mgr, session);
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to send write request: %" CHIP_ERROR_FORMAT, err.Format());
+            pending_op_complete(self->m_op, err == CHIP_ERROR_NO_MEMORY ? ESP_ERR_NO_MEM : ESP_FAIL);
+            self->finish();
+        }
+    }
+
+    static void on_device_connection_failure(void *context, const ScopedNodeId &peer_id, CHIP_ERROR error)
+    {
+        write_operation *self = static_cast<write_operation *>(context);
+        http_metrics_observe_matter(MATTER_OP_CASE, http_elapsed_us(self->m_connect_start_us), false);
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to establish CASE session with node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT,
+                 peer_id.GetNodeId(), error.Format());
+        pending_op_complete(self->m_op, ESP_ERR_TIMEOUT);
+        self->finish();
+    }
+
+    static void cancel(void *context)
+    {
+        write_operation *self = static_cast<write_operation *>(context);
+        HTTP_LOGW(HTTP_LOG_OPS, "Cancelling write to node 0x%" PRIx64, self->m_node_id);
+        self->m_on_connected.Cancel();
+        self->m_on_connection_failure.Cancel();
+        self->finish();
+    }
+
+    void detach()
+    {
+        m_op->cancel.context = nullptr;
+        m_op->cancel.cancel_fn = nullptr;
+    }
+
+    void finish()
+    {
+        detach();
+        m_finishing = true;
+        chip::Platform::Delete(this);
+    }
+
+    pending_op *m_op;
+    uint64_t m_node_id;
+    uint16_t m_timed_write_timeout_ms;
+    esp_err_t m_status = ESP_OK;
+    bool m_finishing = false;
+    int64_t m_connect_start_us = 0;
+    size_t m_value_len = 0;
+    ScopedMemoryBufferWithSize<chip::app::ConcreteDataAttributePath> m_paths;
+    ScopedMemoryBufferWithSize<uint8_t> m_value;
+    chip::Platform::UniquePtr<WriteClient> m_write_client;
+    chip::Callback::Callback<chip::OnDeviceConnected> m_on_connected;
+    chip::Callback::Callback<chip::OnDeviceConnectionFailure> m_on_connection_failure;
+};
+
+esp_err_t start_write_operation(pending_op *op, uint64_t node_id, const backend_paths_t &paths, const char *value,
+                                uint16_t timed_write_timeout_ms)
+{
+    write_operation *write_op = chip::Platform::New<write_operation>(op, node_id, timed_write_timeout_ms);
+    if (!write_op) {
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to alloc memory for write_operation");
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = write_op->send(paths, value);
+    if (err != ESP_OK) {
+        chip::Platform::Delete(write_op);
+    }
+    return err;
+}
+
+/**
+ * Subscription registered under an ID of the subscription registry.
+ *
+ * Keeps its ReadClient for as long as the subscription lives, resubscribing
+ * with the SDK back-off when it is lost, and reports every state change to
+ * the registry. Operations are linked in s_subscribe_ops so a registry ID can
+ * be torn down. All members are only touched with the CHIP stack lock held.
+ */
+class subscribe_operation : public ReadClient::Callback {
+public:
+    subscribe_operation(uint32_t id, uint64_t node_id, uint16_t min_interval, uint16_t max_interval)
+        : m_id(id)
+        , m_node_id(node_id)
+        , m_min_interval(min_interval)
+        , m_max_interval(max_interval)
+        , m_buffered_read_cb(*this)
+        , m_on_connected(on_device_connected, this)
+        , m_on_connection_failure(on_device_connection_failure, this)
+    {
+    }
+
+    esp_err_t send(bool events, const backend_paths_t &paths)
+    {
+        size_t count = paths.endpoint_count;
+        if (events) {
+            m_event_paths.Alloc(count);
+            if (!m_event_paths.Get()) {
+                return ESP_ERR_NO_MEM;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                m_event_paths[i] = EventPathParams(paths.endpoint_ids[i], paths.cluster_ids[i], paths.ids[i]);
+            }
+        } else {
+            m_attr_paths.Alloc(count);
+            if (!m_attr_paths.Get()) {
+                return ESP_ERR_NO_MEM;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                m_attr_paths[i] = AttributePathParams(paths.endpoint_ids[i], paths.cluster_ids[i], paths.ids[i]);
+            }
+        }
+        // Linked first: with a cached session the callbacks run before connect_to_node() returns
+        m_next = s_subscribe_ops;
+        s_subscribe_ops = this;
+        m_connect_start_us = esp_timer_get_time();
+        CHIP_ERROR err = connect_to_node(m_node_id, &m_on_connected, &m_on_connection_failure);
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to look up node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT, m_node_id, err.Format());
+            unlink();
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+
+    static subscribe_operation *find(uint32_t id)
+    {
+        for (subscribe_operation *op = s_subscribe_ops; op; op = op->m_next) {
+            if (op->m_id == id) {
+                return op;
+            }
+        }
+        return nullptr;
+    }
+
+    // Destroying the ReadClient drops the subscription without calling OnDone()
+    void stop()
+    {
+        HTTP_LOGI(HTTP_LOG_OPS, "Tearing down subscription %" PRIu32 " to node 0x%" PRIx64, m_id, m_node_id);
+        m_on_connected.Cancel();
+        m_on_connection_failure.Cancel();
+        m_read_client.reset();
+        finish();
+    }
+
+    // ReadClient::Callback
+    void OnAttributeData(const chip::app::ConcreteDataAttributePath &path, chip::TLV::TLVReader *data,
+                         const chip::app::StatusIB &status) override
+    {
+        HTTP_LOGD(HTTP_LOG_OPS, "Subscription %" PRIu32 ": attribute 0x%" PRIx32 "/0x%" PRIx32 " on endpoint %u", m_id,
+                  path.mClusterId, path.mAttributeId, path.mEndpointId);
+        if (http_streams_active()) {
+            // Decoded on the CHIP thread stack, the stream keeps only what it sends
+            result_record_t record;
+            decode_attribute_record(m_node_id, path, status.IsSuccess() ? data : nullptr, &record);
+            http_subscription_attribute(m_id, &record);
+        }
+    }
+
+    void OnEventData(const chip::app::EventHeader &header, chip::TLV::TLVReader *data,
+                     const chip::app::StatusIB *status) override
+    {
+        HTTP_LOGD(HTTP_LOG_OPS, "Subscription %" PRIu32 ": event 0x%" PRIx32 "/0x%" PRIx32 " on endpoint %u", m_id,
+                  header.mPath.mClusterId, header.mPath.mEventId, header.mPath.mEndpointId);
+    }
+
+    void OnReportEnd() override { http_subscription_report(m_id); }
+
+    void OnSubscriptionEstablished(chip::SubscriptionId subscription_id) override
+    {
+        uint16_t min_interval = m_min_interval;
+        uint16_t max_interval = m_max_interval;
+        m_read_client->GetReportingIntervals(min_interval, max_interval);
+        http_subscription_established(m_id, subscription_id, min_interval, max_interval);
+        HTTP_LOGI(HTTP_LOG_OPS, "Subscription %" PRIu32 " to node 0x%" PRIx64 " established as 0x%" PRIx32
+                  ", intervals %u-%u s", m_id, m_node_id, subscription_id, min_interval, max_interval);
+    }
+
+    CHIP_ERROR OnResubscriptionNeeded(ReadClient *client, CHIP_ERROR cause) override
+    {
+        // Same policy as DefaultResubscribePolicy(), with the delay kept for the registry
+        uint32_t retry_ms = client->ComputeTimeTillNextSubscription();
+        ReturnErrorOnFailure(client->ScheduleResubscription(retry_ms, chip::NullOptional, cause == CHIP_ERROR_TIMEOUT));
+        http_subscription_resubscribing(m_id, retry_ms);
+        HTTP_LOGW(HTTP_LOG_OPS, "Subscription %" PRIu32 " to node 0x%" PRIx64 " lost (%" CHIP_ERROR_FORMAT
+                  "), retrying in %" PRIu32 " ms", m_id, m_node_id, cause.Format(), retry_ms);
+        return CHIP_NO_ERROR;
+    }
+
+    void OnError(CHIP_ERROR error) override
+    {
+        HTTP_LOGW(HTTP_LOG_OPS, "Subscription %" PRIu32 " to node 0x%" PRIx64 " failed: %" CHIP_ERROR_FORMAT, m_id,
+                  m_node_id, error.Format());
+    }
+
+    // The paths belong to the operation and outlive every resubscription
+    void OnDeallocatePaths(ReadPrepareParams &&params) override {}
+
+    void OnDone(ReadClient *client) override
+    {
+        HTTP_LOGI(HTTP_LOG_OPS, "Subscription %" PRIu32 " to node 0x%" PRIx64 " ended", m_id, m_node_id);
+        finish();
+    }
+
+private:
+    static void on_device_connected(void *context, ExchangeManager &exchange_mgr, const SessionHandle &session)
+    {
+        subscribe_operation *self = static_cast<subscribe_operation *>(context);
+        http_metrics_observe_matter(MATTER_OP_CASE, http_elapsed_us(self->m_connect_start_us), true);
+        ReadPrepareParams params(session);
+        params.mpAttributePathParamsList = self->m_attr_paths.Get();
+        params.mAttributePathParamsListSize = self->m_attr_paths.AllocatedSize();
+        params.mpEventPathParamsList = self->m_event_paths.Get();
+        params.mEventPathParamsListSize = self->m_event_paths.AllocatedSize();
+        params.mMinIntervalFloorSeconds = self->m_min_interval;
+        params.mMaxIntervalCeilingSeconds = self->m_max_interval;
+        params.mKeepSubscriptions = true;
+
+        self->m_read_client = chip::Platform::MakeUnique<ReadClient>(InteractionModelEngine::GetInstance(), &exchange_mgr,
+                                                                     self->m_buffered_read_cb,
+                                                                     ReadClient::InteractionType::Subscribe);
+        if (!self->m_read_client) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to alloc memory for ReadClient");
+            self->finish();
+            return;
+        }
+        CHIP_ERROR err = self->m_read_client->SendAutoResubscribeRequest(std::move(params));
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to send subscribe request: %" CHIP_ERROR_FORMAT, err.Format());
+            self->m_read_client.reset();
+            self->finish();
+        }
+    }
+
+    static void on_device_connection_failure(void *context, const ScopedNodeId &peer_id, CHIP_ERROR error)
+    {
+        subscribe_operation *self = static_cast<subscribe_operation *>(context);
+        http_metrics_observe_matter(MATTER_OP_CASE, http_elapsed_us(self->m_connect_start_us), false);
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to establish CASE session with node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT,
+                  peer_id.GetNodeId(), error.Format());
+        self->finish();
+    }
+
+    void unlink()
+    {
+        for (subscribe_operation **link = &s_subscribe_ops; *link; link = &(*link)->m_next) {
+            if (*link == this) {
+                *link = m_next;
+                break;
+            }
+        }
+    }
+
+    void finish()
+    {
+        unlink();
+        http_subscription_ended(m_id);
+        chip::Platform::Delete(this);
+    }
+
+    static subscribe_operation *s_subscribe_ops;
+
+    subscribe_operation *m_next = nullptr;
+    uint32_t m_id;
+    uint64_t m_node_id;
+    uint16_t m_min_interval;
+    uint16_t m_max_interval;
+    int64_t m_connect_start_us = 0;
+    ScopedMemoryBufferWithSize<AttributePathParams> m_attr_paths;
+    ScopedMemoryBufferWithSize<EventPathParams> m_event_paths;
+    BufferedReadCallback m_buffered_read_cb;
+    chip::Platform::UniquePtr<ReadClient> m_read_client;
+    chip::Callback::Callback<chip::OnDeviceConnected> m_on_connected;
+    chip::Callback::Callback<chip::OnDeviceConnectionFailure> m_on_connection_failure;
+};
+
+subscribe_operation *subscribe_operation::s_subscribe_ops = nullptr;
+
+esp_err_t start_subscribe_operation(uint32_t id, uint64_t node_id, bool events, const backend_paths_t &paths,
+                                    uint16_t min_interval, uint16_t max_interval)
+{
+    subscribe_operation *subscribe_op = chip::Platform::New<subscribe_operation>(id, node_id, min_interval,
+                                                                                 max_interval);
+    if (!subscribe_op) {
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to alloc memory for subscribe_operation");
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = subscribe_op->send(events, paths);
+    if (err != ESP_OK) {
+        chip::Platform::Delete(subscribe_op);
+    }
+    return err;
+}
+
+esp_err_t stop_subscribe_operation(uint32_t id)
+{
+    subscribe_operation *subscribe_op = subscribe_operation::find(id);
+    if (!subscribe_op) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    subscribe_op->stop();
+    return ESP_OK;
+}
+
+/**
+ * Command invoke carrying client-encoded TLV fields.
+ *
+ * Owns a copy of the fields until the CommandSender is done, then deletes
+ * itself. All members are only touched with the CHIP stack lock held.
+ */
+class tlv_invoke_operation : public CommandSender::Callback {
+public:
+    tlv_invoke_operation(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                         uint16_t timed_invoke_timeout_ms)
+        : m_node_id(node_id)
+        , m_endpoint_id(endpoint_id)
+        , m_cluster_id(cluster_id)
+        , m_command_id(command_id)
+        , m_timed_invoke_timeout_ms(timed_invoke_timeout_ms)
+        , m_on_connected(on_device_connected, this)
+        , m_on_connection_failure(on_device_connection_failure, this)
+    {
+    }
+
+    esp_err_t send(const uint8_t *fields, size_t fields_len)
+    {
+        m_fields.Alloc(fields_len);
+        if (!m_fields.Get()) {
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(m_fields.Get(), fields, fields_len);
+        m_connect_start_us = esp_timer_get_time();
+        CHIP_ERROR err = connect_to_node(m_node_id, &m_on_connected, &m_on_connection_failure);
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to look up node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT, m_node_id, err.Format());
+            return ESP_FAIL;
+        }
+        return ESP_OK;
+    }
+
+    // CommandSender::Callback
+    void OnResponse(CommandSender *sender, const chip::app::ConcreteCommandPath &path,
+                    const chip::app::StatusIB &status, chip::TLV::TLVReader *data) override
+    {
+        m_failed = m_failed || !status.IsSuccess();
+        HTTP_LOGI(HTTP_LOG_OPS, "Command 0x%" PRIx32 " on node 0x%" PRIx64 " answered, status %s", m_command_id, m_node_id,
+                 status.IsSuccess() ? "success" : "failure");
+    }
+
+    void OnError(const CommandSender *sender, CHIP_ERROR error) override
+    {
+        m_failed = true;
+        HTTP_LOGW(HTTP_LOG_OPS, "Command 0x%" PRIx32 " on node 0x%" PRIx64 " failed: %" CHIP_ERROR_FORMAT, m_command_id,
+                 m_node_id, error.Format());
+    }
+
+    void OnDone(CommandSender *sender) override
+    {
+        http_metrics_observe_matter(MATTER_OP_INVOKE, http_elapsed_us(m_sent_us), !m_failed);
+        chip::Platform::Delete(this);
+    }
+
+private:
+    CHIP_ERROR send_request(ExchangeManager &exchange_mgr, const SessionHandle &session)
+    {
+        chip::app::CommandPathParams path(m_endpoint_id, /* group */ 0, m_cluster_id, m_command_id,
+                                          chip::app::CommandPathFlags::kEndpointIdValid);
+        chip::Optional<uint16_t> timed_invoke_timeout;
+        if (m_timed_invoke_timeout_ms > 0) {
+            timed_invoke_timeout.SetValue(m_timed_invoke_timeout_ms);
+        }
+        m_sender = chip::Platform::MakeUnique<CommandSender>(this, &exchange_mgr, timed_invoke_timeout.HasValue());
+        if (!m_sender) {
+            return CHIP_ERROR_NO_MEMORY;
+        }
+
+        // The client's structure becomes the CommandFields element as it is
+        CommandSender::PrepareCommandParameters prepare_params;
+        prepare_params.SetStartDataStruct(false);
+        ReturnErrorOnFailure(m_sender->PrepareCommand(path, prepare_params));
+        chip::TLV::TLVWriter *writer = m_sender->GetCommandDataIBTLVWriter();
+        VerifyOrReturnError(writer != nullptr, CHIP_ERROR_INCORRECT_STATE);
+        chip::TLV::TLVReader reader;
+        reader.Init(m_fields.Get(), m_fields.AllocatedSize());
+        ReturnErrorOnFailure(reader.Next());
+        ReturnErrorOnFailure(writer->CopyElement(
+            chip::TLV::ContextTag(chip::to_underlying(chip::app::CommandDataIB::Tag::kFields)), reader));
+        CommandSender::FinishCommandParameters finish_params(timed_invoke_timeout);
+        finish_params.SetEndDataStruct(false);
+        ReturnErrorOnFailure(m_sender->FinishCommand(finish_params));
+        return m_sender->SendCommandRequest(session);
+    }
+
+    static void on_device_connected(void *context, ExchangeManager &exchange_mgr, const SessionHandle &session)
+    {
+        tlv_invoke_operation *self = static_cast<tlv_invoke_operation *>(context);
+        self->m_sent_us = esp_timer_get_time();
+        http_metrics_observe_matter(MATTER_OP_CASE, self->m_sent_us - self->m_connect_start_us, true);
+        CHIP_ERROR err = self->send_request(exchange_mgr, session);
+        if (err != CHIP_NO_ERROR) {
+            HTTP_LOGE(HTTP_LOG_OPS, "Failed to send command to node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT, self->m_node_id,
+                     err.Format());
+            chip::Platform::Delete(self);
+        }
+    }
+
+    static void on_device_connection_failure(void *context, const ScopedNodeId &peer_id, CHIP_ERROR error)
+    {
+        tlv_invoke_operation *self = static_cast<tlv_invoke_operation *>(context);
+        http_metrics_observe_matter(MATTER_OP_CASE, http_elapsed_us(self->m_connect_start_us), false);
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to establish CASE session with node 0x%" PRIx64 ": %" CHIP_ERROR_FORMAT,
+                 peer_id.GetNodeId(), error.Format());
+        chip::Platform::Delete(self);
+    }
+
+    uint64_t m_node_id;
+    uint16_t m_endpoint_id;
+    uint32_t m_cluster_id;
+    uint32_t m_command_id;
+    uint16_t m_timed_invoke_timeout_ms;
+    bool m_failed = false;
+    int64_t m_connect_start_us = 0;
+    int64_t m_sent_us = 0;
+    ScopedMemoryBufferWithSize<uint8_t> m_fields;
+    chip::Platform::UniquePtr<CommandSender> m_sender;
+    chip::Callback::Callback<chip::OnDeviceConnected> m_on_connected;
+    chip::Callback::Callback<chip::OnDeviceConnectionFailure> m_on_connection_failure;
+};
+
+// The fields must be exactly one anonymous structure
+static bool is_command_fields(const uint8_t *fields, size_t fields_len)
+{
+    chip::TLV::TLVReader reader;
+    chip::TLV::TLVType container;
+    reader.Init(fields, fields_len);
+    if (reader.Next() != CHIP_NO_ERROR || reader.GetType() != chip::TLV::kTLVType_Structure ||
+        reader.GetTag() != chip::TLV::AnonymousTag()) {
+        return false;
+    }
+    // Walk the structure so a truncated body is caught here rather than by the device
+    if (reader.EnterContainer(container) != CHIP_NO_ERROR) {
+        return false;
+    }
+    CHIP_ERROR err;
+    while ((err = reader.Next()) == CHIP_NO_ERROR) {
+    }
+    if (err != CHIP_END_OF_TLV || reader.ExitContainer(container) != CHIP_NO_ERROR) {
+        return false;
+    }
+    return reader.Next() == CHIP_END_OF_TLV;
+}
+
+esp_err_t start_tlv_invoke_operation(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                                     const uint8_t *fields, size_t fields_len, uint16_t timed_invoke_timeout_ms)
+{
+    if (!is_command_fields(fields, fields_len)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    tlv_invoke_operation *invoke_op = chip::Platform::New<tlv_invoke_operation>(node_id, endpoint_id, cluster_id,
+                                                                                command_id, timed_invoke_timeout_ms);
+    if (!invoke_op) {
+        HTTP_LOGE(HTTP_LOG_OPS, "Failed to alloc memory for tlv_invoke_operation");
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = invoke_op->send(fields, fields_len);
+    if (err != ESP_OK) {
+        chip::Platform::Delete(invoke_op);
+    }
+    return err;
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
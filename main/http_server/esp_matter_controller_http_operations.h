@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <esp_matter_controller_http_backend.h>
+#include <esp_matter_controller_http_results.h>
+#include <app/ReadClient.h>
+#include <lib/core/TLV.h>
+#include <lib/support/ScopedBuffer.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+/**
+ * @brief Start a cancellable attribute read feeding an armed pending operation
+ *
+ * Must be called with the CHIP stack lock held. On success the interaction
+ * registers itself in op->cancel until it finishes.
+ *
+ * @param op Armed pending operation receiving the reports
+ * @param node_id Target node
+ * @param attr_paths Attribute paths to read, ownership is taken
+ * @return ESP_OK if the read was started
+ */
+esp_err_t start_read_operation(pending_op *op, uint64_t node_id,
+                               chip::Platform::ScopedMemoryBufferWithSize<chip::app::AttributePathParams> &&attr_paths);
+
+/**
+ * @brief Start a cancellable attribute write feeding an armed pending operation
+ *
+ * Must be called with the CHIP stack lock held. The value is converted with
+ * json_to_tlv() as by the console write command, {"0:U8": 128} writing an
+ * unsigned 8-bit 128, and written to every path. Each path's status becomes
+ * a record of op, which is completed once the WriteClient is done. On
+ * success the interaction registers itself in op->cancel until it finishes.
+ *
+ * @param op Armed PENDING_OP_WRITE operation receiving the statuses
+ * @param paths Concrete paths to write, with lists of matching lengths; copied
+ * @param timed_write_timeout_ms Timed write timeout, 0 for an untimed write
+ * @return ESP_OK if the write was started, ESP_ERR_INVALID_ARG if the value
+ *         cannot be encoded
+ */
+esp_err_t start_write_operation(pending_op *op, uint64_t node_id, const backend_paths_t &paths, const char *value,
+                                uint16_t timed_write_timeout_ms);
+
+/**
+ * @brief Start a subscription registered in the subscription registry
+ *
+ * Must be called with the CHIP stack lock held. The subscription resubscribes
+ * on its own when lost and reports its state to the registry under id, until
+ * http_subscription_ended() once it is gone.
+ *
+ * @param id Backend ID the subscription registry reports under
+ * @param events Subscribe to event paths rather than attribute paths
+ * @param paths Paths to subscribe to, with lists of matching lengths; copied
+ * @return ESP_OK if the session lookup was started
+ */
+esp_err_t start_subscribe_operation(uint32_t id, uint64_t node_id, bool events, const backend_paths_t &paths,
+                                    uint16_t min_interval, uint16_t max_interval);
+
+/**
+ * @brief Tear down a subscription started by start_subscribe_operation()
+ *
+ * Must be called with the CHIP stack lock held. The registry entry is
+ * released before returning.
+ *
+ * @return ESP_ERR_NOT_FOUND if no subscription runs under id
+ */
+esp_err_t stop_subscribe_operation(uint32_t id);
+
+/**
+ * @brief Invoke a command whose fields the client encoded in TLV
+ *
+ * Must be called with the CHIP stack lock held. The fields are copied into
+ * the InvokeRequest as they are, without going through JSON. Like
+ * controller::send_invoke_cluster_command() it returns once the session
+ * lookup has started; the response is only logged.
+ *
+ * @param fields One anonymous TLV structure holding the command fields
+ * @param fields_len Length of fields
+ * @param timed_invoke_timeout_ms Timed invoke timeout, 0 for an untimed invoke
+ * @return ESP_OK if the invoke was started, ESP_ERR_INVALID_ARG if fields is
+ *         not a single anonymous structure
+ */
+esp_err_t start_tlv_invoke_operation(uint64_t node_id, uint16_t endpoint_id, uint32_t cluster_id, uint32_t command_id,
+                                     const uint8_t *fields, size_t fields_len, uint16_t timed_invoke_timeout_ms);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,106 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_recorder.h>
+#include <esp_timer.h>
+#include <atomic>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+// The sequence is odd while the record is written. Once published it is
+// 2 * (n + 1) for the n-th request, which tells a reader both that the
+// record is complete and that it was not overwritten by a later request.
+typedef struct {
+    std::atomic<uint32_t> seq;
+    http_record_t record;
+} http_record_slot_t;
+
+static http_record_slot_t s_slots[HTTP_RECORDER_ENTRIES];
+static std::atomic<uint32_t> s_next{0}; // Requests recorded since boot
+
+void http_recorder_add(const http_record_t *record)
+{
+    uint32_t n = s_next.fetch_add(1, std::memory_order_relaxed);
+    http_record_slot_t *slot = &s_slots[n % HTTP_RECORDER_ENTRIES];
+    slot->seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->record = *record;
+    slot->seq.store(2 * n + 2, std::memory_order_release);
+}
+
+// Copy the n-th request out of the ring, false if it was overwritten or is being written
+static bool read_record(uint32_t n, http_record_t *out)
+{
+    const http_record_slot_t *slot = &s_slots[n % HTTP_RECORDER_ENTRIES];
+    uint32_t seq = slot->seq.load(std::memory_order_acquire);
+    if (seq != 2 * n + 2) {
+        return false;
+    }
+    *out = slot->record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->seq.load(std::memory_order_relaxed) == seq;
+}
+
+cJSON *http_recorder_to_json(size_t limit)
+{
+    cJSON *json = cJSON_CreateObject();
+    if (!json) {
+        return nullptr;
+    }
+    uint32_t uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    uint32_t next = s_next.load(std::memory_order_acquire);
+    cJSON_AddNumberToObject(json, "uptime_ms", uptime_ms);
+    cJSON_AddNumberToObject(json, "recorded", next);
+    cJSON_AddNumberToObject(json, "capacity", HTTP_RECORDER_ENTRIES);
+
+    cJSON *requests = cJSON_AddArrayToObject(json, "requests");
+    if (!requests) {
+        cJSON_Delete(json);
+        return nullptr;
+    }
+    uint32_t count = next < HTTP_RECORDER_ENTRIES ? next : HTTP_RECORDER_ENTRIES;
+    if (limit > 0 && limit < count) {
+        count = limit;
+    }
+    for (uint32_t i = 1; i <= count; ++i) {
+        http_record_t record;
+        if (!read_record(next - i, &record)) {
+            continue;
+        }
+        cJSON *item = cJSON_CreateObject();
+        if (!item) {
+            break;
+        }
+        cJSON_AddNumberToObject(item, "seq", next - i);
+        cJSON_AddStringToObject(item, "uri", record.uri);
+        cJSON_AddStringToObject(item, "method", http_method_str((httpd_method_t)record.method));
+        if (record.node_id != 0) {
+            cJSON_AddNumberToObject(item, "node_id", record.node_id);
+        }
+        cJSON_AddNumberToObject(item, "status", record.status);
+        if (record.flags & HTTP_RECORD_HANDLER_ERROR) {
+            cJSON_AddBoolToObject(item, "handler_error", true);
+        }
+        cJSON_AddNumberToObject(item, "start_ms", record.start_ms);
+        cJSON_AddNumberToObject(item, "age_ms", uptime_ms - record.start_ms);
+        cJSON_AddNumberToObject(item, "total_us", record.total_us);
+        cJSON *stages = cJSON_AddObjectToObject(item, "stages_us");
+        for (size_t stage = 0; stage < HTTP_STAGE_COUNT; ++stage) {
+            if (record.stages & (1u << stage)) {
+                cJSON_AddNumberToObject(stages, http_stage_name((http_stage_t)stage), record.stage_us[stage]);
+            }
+        }
+        cJSON_AddNumberToObject(item, "heap_delta", record.heap_delta);
+        cJSON_AddItemToArray(requests, item);
+    }
+    return json;
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_http_server.h>
+#include <esp_matter_controller_http_timing.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_RECORDER_ENTRIES 64 // Requests kept by the flight recorder, the oldest is overwritten first
+
+#define HTTP_RECORD_HANDLER_ERROR (1 << 0) // The handler returned an error, the connection was closed
+
+/**
+ * @brief One request as kept by the flight recorder
+ *
+ * Kept small so the whole ring fits in a few KB of internal RAM: the route
+ * is referenced through its registered URI string rather than copied.
+ */
+typedef struct {
+    uint64_t node_id;                    // Target node, 0 if the request has none
+    const char *uri;                     // Route the request matched, as registered
+    uint32_t start_ms;                   // Time since boot the handler started at
+    uint32_t total_us;                   // Handler duration
+    uint32_t stage_us[HTTP_STAGE_COUNT]; // Time per stage, lock wait included
+    int32_t heap_delta;                  // Internal heap consumed, negative if memory was released
+    uint16_t status;                     // Status code of the response
+    uint8_t method;                      // httpd_method_t
+    uint8_t stages;                      // Bit per stage that was timed
+    uint8_t flags;                       // HTTP_RECORD_* flags
+} http_record_t;
+
+/**
+ * @brief Add a request to the flight recorder
+ *
+ * Lock-free: the slot is reserved with an atomic increment and published
+ * through a per-slot sequence number, so a dump never waits for writers and
+ * skips slots that are being rewritten.
+ */
+void http_recorder_add(const http_record_t *record);
+
+/**
+ * @brief Recorded requests as JSON, newest first
+ * @param limit Maximum number of requests, 0 for all of them
+ * @return New cJSON object, NULL on allocation failure
+ */
+cJSON *http_recorder_to_json(size_t limit);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,329 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_results.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_memory.h>
+#include <esp_log.h>
+#include <algorithm>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static const char *TAG = "controller_httpresults";
+
+enum : uint32_t {
+    PENDING_OP_FREE = 0,
+    PENDING_OP_SETUP,
+    PENDING_OP_ARMED,
+    PENDING_OP_COMPLETING, // Claimed by the completion whose status is being stored
+    PENDING_OP_DONE,
+    PENDING_OP_RELEASING,
+};
+
+static pending_op s_pending_ops[PENDING_OP_MAX];
+static bool s_pending_ops_initialized = false;
+static std::atomic<uint32_t> s_pool_hits{0};
+static std::atomic<uint32_t> s_pool_misses{0};
+static std::atomic<uint32_t> s_busy{0};
+
+esp_err_t result_ring::init(uint32_t record_count)
+{
+    records = (result_record_t *)http_mem_calloc(record_count, sizeof(result_record_t), HTTP_MEM_TRANSIENT);
+    if (!records) {
+        return ESP_ERR_NO_MEM;
+    }
+    capacity = record_count;
+    reset();
+    return ESP_OK;
+}
+
+void result_ring::deinit()
+{
+    http_mem_free(records);
+    records = nullptr;
+    capacity = 0;
+}
+
+void result_ring::attach(result_record_t *buffer, uint32_t record_count)
+{
+    records = buffer;
+    capacity = record_count;
+    reset();
+}
+
+void result_ring::reset()
+{
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+}
+
+result_record_t *result_ring::reserve()
+{
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= capacity) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    result_record_t *record = &records[h % capacity];
+    memset(record, 0, offsetof(result_record_t, str) + 1);
+    return record;
+}
+
+void result_ring::commit()
+{
+    uint32_t h = head.fetch_add(1, std::memory_order_release) + 1;
+    // Only the crossing notifies, the consumer empties the ring each time it wakes
+    if (consumer && h - tail.load(std::memory_order_acquire) == (capacity + 1) / 2) {
+        xTaskNotifyGive(consumer);
+    }
+}
+
+const result_record_t *result_ring::peek()
+{
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &records[t % capacity];
+}
+
+void result_ring::pop()
+{
+    tail.fetch_add(1, std::memory_order_release);
+}
+
+esp_err_t pending_ops_init(void)
+{
+    if (s_pending_ops_initialized) {
+        return ESP_OK;
+    }
+    for (size_t i = 0; i < PENDING_OP_MAX; ++i) {
+        s_pending_ops[i].pool_records = (result_record_t *)http_mem_calloc(PENDING_OP_RING_RECORDS,
+                                                                           sizeof(result_record_t),
+                                                                           HTTP_MEM_LONG_LIVED);
+        if (!s_pending_ops[i].pool_records) {
+            ESP_LOGE(TAG, "Failed to allocate records of slot %u", (unsigned)i);
+            for (size_t j = 0; j < i; ++j) {
+                http_mem_free(s_pending_ops[j].pool_records);
+                s_pending_ops[j].pool_records = nullptr;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_pending_ops_initialized = true;
+    return ESP_OK;
+}
+
+void pending_ops_get_stats(pending_ops_stats_t *stats)
+{
+    stats->in_use = 0;
+    for (size_t i = 0; i < PENDING_OP_MAX; ++i) {
+        if (s_pending_ops[i].state.load(std::memory_order_relaxed) != PENDING_OP_FREE) {
+            stats->in_use++;
+        }
+    }
+    stats->pool_hits = s_pool_hits.load(std::memory_order_relaxed);
+    stats->pool_misses = s_pool_misses.load(std::memory_order_relaxed);
+    stats->busy = s_busy.load(std::memory_order_relaxed);
+}
+
+esp_err_t pending_op_arm(pending_op_kind_t kind, uint64_t node_id, uint32_t expected_count, pending_op **out_op)
+{
+    pending_op *slot = nullptr;
+    for (size_t i = 0; i < PENDING_OP_MAX; ++i) {
+        pending_op *op = &s_pending_ops[i];
+        uint32_t state = op->state.load();
+        // Writes are routed to their slot by node ID, so only one may be in flight per node
+        if (kind == PENDING_OP_WRITE && state != PENDING_OP_FREE && state != PENDING_OP_SETUP &&
+            op->kind == kind && op->node_id == node_id) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        uint32_t expected = PENDING_OP_FREE;
+        if (!slot && op->state.compare_exchange_strong(expected, PENDING_OP_SETUP)) {
+            slot = op;
+        }
+    }
+    if (!slot) {
+        HTTP_LOGW(HTTP_LOG_RESULTS, "No free pending operation slot");
+        s_busy.fetch_add(1, std::memory_order_relaxed);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (expected_count <= PENDING_OP_RING_RECORDS && slot->pool_records) {
+        slot->ring.attach(slot->pool_records, PENDING_OP_RING_RECORDS);
+        s_pool_hits.fetch_add(1, std::memory_order_relaxed);
+    } else if (slot->ring.init(expected_count > PENDING_OP_RING_RECORDS ? expected_count
+                                                                        : PENDING_OP_RING_RECORDS) != ESP_OK) {
+        HTTP_LOGE(HTTP_LOG_RESULTS, "Failed to allocate a ring for %" PRIu32 " records", expected_count);
+        slot->state.store(PENDING_OP_FREE);
+        return ESP_ERR_NO_MEM;
+    } else {
+        s_pool_misses.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot->kind = kind;
+    slot->node_id = node_id;
+    slot->expected = expected_count;
+    slot->received.store(0);
+    slot->status = ESP_OK;
+    slot->timing.reset();
+    slot->waiter = xTaskGetCurrentTaskHandle();
+    slot->ring.consumer = slot->waiter;
+    slot->spill = nullptr;
+    slot->spill_count = 0;
+    slot->spill_capacity = 0;
+    slot->spill_pos = 0;
+    slot->cancel.context = nullptr;
+    slot->cancel.cancel_fn = nullptr;
+
+    // Drop any completion left over from a request that timed out earlier
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    slot->state.store(PENDING_OP_ARMED);
+    *out_op = slot;
+    return ESP_OK;
+}
+
+// Move the records of the ring into the spill buffer, growing it as needed
+static void drain_ring(pending_op *op)
+{
+    const result_record_t *record;
+    while ((record = op->ring.peek()) != nullptr) {
+        if (op->spill_count == op->spill_capacity) {
+            if (op->spill_capacity >= PENDING_OP_SPILL_RECORDS_MAX) {
+                // Left in the ring, further records are dropped and counted there
+                return;
+            }
+            uint32_t capacity = std::min<uint32_t>(std::max<uint32_t>(op->spill_capacity * 2, op->ring.capacity),
+                                                   PENDING_OP_SPILL_RECORDS_MAX);
+            result_record_t *spill = (result_record_t *)http_mem_alloc(capacity * sizeof(result_record_t),
+                                                                       HTTP_MEM_TRANSIENT);
+            if (!spill) {
+                HTTP_LOGW(HTTP_LOG_RESULTS, "Failed to grow the records of node 0x%" PRIx64 " to %" PRIu32,
+                          op->node_id, capacity);
+                return;
+            }
+            if (op->spill) {
+                memcpy(spill, op->spill, op->spill_count * sizeof(result_record_t));
+                http_mem_free(op->spill);
+            }
+            op->spill = spill;
+            op->spill_capacity = capacity;
+        }
+        memcpy(&op->spill[op->spill_count++], record, sizeof(result_record_t));
+        op->ring.pop();
+    }
+}
+
+bool pending_op_wait(pending_op *op, TickType_t timeout)
+{
+    TickType_t start = xTaskGetTickCount();
+    for (;;) {
+        // Records are committed before completion, so a done operation is drained for good
+        bool done = op->state.load() == PENDING_OP_DONE;
+        drain_ring(op);
+        if (done) {
+            return true;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            return false;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+    }
+}
+
+uint32_t pending_op_record_count(pending_op *op)
+{
+    return op->spill_count - op->spill_pos + (op->ring.head.load(std::memory_order_acquire) -
+                                              op->ring.tail.load(std::memory_order_relaxed));
+}
+
+const result_record_t *pending_op_peek(pending_op *op)
+{
+    if (op->spill_pos < op->spill_count) {
+        return &op->spill[op->spill_pos];
+    }
+    return op->ring.peek();
+}
+
+void pending_op_pop(pending_op *op)
+{
+    if (op->spill_pos < op->spill_count) {
+        op->spill_pos++;
+    } else {
+        op->ring.pop();
+    }
+}
+
+bool pending_op_incomplete(pending_op *op)
+{
+    return op->ring.dropped.load(std::memory_order_relaxed) > 0;
+}
+
+void pending_op_release(pending_op *op)
+{
+    op->state.store(PENDING_OP_RELEASING);
+    // CHIP callbacks hold the slot for a bounded, allocation-free copy only
+    while (op->active_callbacks.load() != 0) {
+        vTaskDelay(1);
+    }
+    if (op->ring.records == op->pool_records) {
+        op->ring.attach(nullptr, 0);
+    } else {
+        op->ring.deinit();
+    }
+    op->ring.consumer = nullptr;
+    http_mem_free(op->spill);
+    op->spill = nullptr;
+    op->spill_count = 0;
+    op->spill_capacity = 0;
+    op->spill_pos = 0;
+    op->waiter = nullptr;
+    op->state.store(PENDING_OP_FREE);
+}
+
+pending_op *pending_op_enter(pending_op_kind_t kind, uint64_t node_id)
+{
+    for (size_t i = 0; i < PENDING_OP_MAX; ++i) {
+        pending_op *op = &s_pending_ops[i];
+        op->active_callbacks.fetch_add(1);
+        if (op->state.load() == PENDING_OP_ARMED && op->kind == kind && op->node_id == node_id) {
+            return op;
+        }
+        op->active_callbacks.fetch_sub(1);
+    }
+    return nullptr;
+}
+
+void pending_op_leave(pending_op *op)
+{
+    op->active_callbacks.fetch_sub(1);
+}
+
+void pending_op_complete(pending_op *op, esp_err_t status)
+{
+    uint32_t expected = PENDING_OP_ARMED;
+    // Only the first completion stores its status, a late one must not overwrite what the waiter reads
+    if (!op->state.compare_exchange_strong(expected, PENDING_OP_COMPLETING)) {
+        return;
+    }
+    op->status = status;
+    op->state.store(PENDING_OP_DONE);
+    if (op->waiter) {
+        xTaskNotifyGive(op->waiter);
+    }
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
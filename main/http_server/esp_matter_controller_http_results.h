@@ -0,0 +1,244 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <esp_matter_controller_http_timing.h>
+#include <atomic>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define RESULT_RECORD_STR_MAX 256 // Longest string value kept per record, including the terminator
+#define PENDING_OP_MAX 4          // Maximum number of in-flight read/write requests
+#define PENDING_OP_RING_RECORDS 16 // Records preallocated per slot, requests for more paths get a ring of their own
+#define PENDING_OP_WILDCARD_RING_RECORDS 64 // Ring of a read with wildcard paths, sized for a full report chunk
+#define PENDING_OP_SPILL_RECORDS_MAX 256 // Records one request may collect in total, wildcard reports included
+
+/**
+ * @brief Value type of a decoded attribute record
+ */
+typedef enum : uint8_t {
+    RECORD_VALUE_NULL = 0,
+    RECORD_VALUE_BOOL,
+    RECORD_VALUE_UINT,
+    RECORD_VALUE_INT,
+    RECORD_VALUE_FLOAT,
+    RECORD_VALUE_STRING,
+    RECORD_VALUE_RAW,
+} record_value_type_t;
+
+/**
+ * @brief Attribute report or write status, decoded into plain fields so the
+ * CHIP thread can store it without touching the heap
+ */
+typedef struct {
+    uint64_t node_id;
+    uint32_t cluster_id;
+    uint32_t attribute_id;
+    uint16_t endpoint_id;
+    uint8_t status;
+    record_value_type_t type;
+    uint16_t raw_len; // RECORD_VALUE_RAW: length of the TLV element kept in str, 0 if it did not fit
+    union {
+        bool b;
+        uint64_t u;
+        int64_t i;
+        double f;
+    } value;
+    char str[RESULT_RECORD_STR_MAX]; // String value, or the anonymous TLV element of a RAW value
+} result_record_t;
+
+/**
+ * @brief Single-producer/single-consumer ring of result records
+ *
+ * The producer is the CHIP thread and never blocks or allocates: when the
+ * ring is full the record is dropped and counted. The consumer is the HTTP
+ * task owning the request, notified whenever the ring fills up to half so it
+ * can empty it while the interaction still runs.
+ */
+struct result_ring {
+    result_record_t *records;
+    uint32_t capacity;
+    TaskHandle_t consumer;
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> dropped;
+
+    esp_err_t init(uint32_t record_count);
+    void deinit();
+    void attach(result_record_t *buffer, uint32_t record_count);
+    void reset();
+
+    // Producer side
+    result_record_t *reserve();
+    void commit();
+
+    // Consumer side
+    const result_record_t *peek();
+    void pop();
+};
+
+/**
+ * @brief Kind of Matter interaction a pending operation waits for
+ */
+typedef enum : uint8_t {
+    PENDING_OP_READ = 0,
+    PENDING_OP_WRITE,
+} pending_op_kind_t;
+
+/**
+ * @brief Cancellation handle tying an HTTP request to the Matter interaction serving it
+ *
+ * Only touched with the CHIP stack lock held: the interaction clears it when
+ * it finishes on its own, and the HTTP task invokes cancel_fn to abort it when
+ * the client's deadline passes or its socket closes.
+ */
+typedef struct {
+    void *context;
+    void (*cancel_fn)(void *context);
+} op_cancel_handle_t;
+
+/**
+ * @brief In-flight HTTP request waiting for results from the CHIP thread
+ *
+ * Slots live in a fixed table whose record buffers are allocated once by
+ * pending_ops_init(). The HTTP task arms a slot before sending the
+ * command and waits on its task notification. Matter interactions hold a
+ * pointer to their slot; the simulated backend looks writes up by node ID
+ * without taking any lock. Either way they append records and signal
+ * completion.
+ */
+struct pending_op {
+    std::atomic<uint32_t> state;
+    std::atomic<uint32_t> active_callbacks;
+    std::atomic<uint32_t> received;
+    esp_err_t status;
+    pending_op_kind_t kind;
+    uint64_t node_id;
+    uint32_t expected;
+    TaskHandle_t waiter;
+    op_cancel_handle_t cancel;
+    result_ring ring;
+    result_record_t *pool_records; // PENDING_OP_RING_RECORDS records owned by the slot
+    result_record_t *spill;        // Records moved out of the ring by the waiter, consumer side only
+    uint32_t spill_count;
+    uint32_t spill_capacity;
+    uint32_t spill_pos;            // Next spilled record to consume
+    http_stage_times timing;       // Stages timed on the CHIP thread, merged into the request on completion
+};
+
+/**
+ * @brief Usage counters of the slot table
+ */
+typedef struct {
+    uint32_t in_use;      // Slots currently armed or being released
+    uint32_t pool_hits;   // Arms served by the slot's preallocated records
+    uint32_t pool_misses; // Arms that had to allocate a larger ring
+    uint32_t busy;        // Arms refused because every slot was taken
+} pending_ops_stats_t;
+
+/**
+ * @brief Preallocate the record buffers of every slot
+ *
+ * Call once before the first request, calling it again is a no-op.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the buffers cannot be allocated
+ */
+esp_err_t pending_ops_init(void);
+
+/**
+ * @brief Snapshot of the slot table counters
+ */
+void pending_ops_get_stats(pending_ops_stats_t *stats);
+
+/**
+ * @brief Arm a pending operation for the calling task
+ *
+ * Uses the slot's preallocated records unless expected_count exceeds
+ * PENDING_OP_RING_RECORDS, in which case a larger ring is allocated.
+ *
+ * @param kind Interaction kind the CHIP callbacks will report
+ * @param node_id Target node
+ * @param expected_count Number of paths requested
+ * @param out_op Armed operation on success
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the node already has a
+ *         write in flight, ESP_ERR_NO_MEM if every slot is busy or a larger
+ *         ring cannot be allocated
+ */
+esp_err_t pending_op_arm(pending_op_kind_t kind, uint64_t node_id, uint32_t expected_count, pending_op **out_op);
+
+/**
+ * @brief Wait for the CHIP thread to complete an armed operation
+ *
+ * Must be called from the task that armed the operation. Records are moved
+ * from the ring into a buffer growing up to PENDING_OP_SPILL_RECORDS_MAX
+ * records each time the waiter wakes, so interactions reporting more records
+ * than the ring holds lose none of them.
+ *
+ * @return true if completed, false on timeout
+ */
+bool pending_op_wait(pending_op *op, TickType_t timeout);
+
+/**
+ * @brief Number of records of an operation not consumed yet
+ */
+uint32_t pending_op_record_count(pending_op *op);
+
+/**
+ * @brief Next record of an operation, in the order the CHIP thread reported them
+ * @return NULL once every record was consumed
+ */
+const result_record_t *pending_op_peek(pending_op *op);
+
+/**
+ * @brief Consume the record returned by pending_op_peek()
+ */
+void pending_op_pop(pending_op *op);
+
+/**
+ * @brief Whether records were lost because the operation reported more than it could keep
+ */
+bool pending_op_incomplete(pending_op *op);
+
+/**
+ * @brief Disarm an operation and return its slot to the pool
+ *
+ * Waits for any CHIP callback currently inside the slot to leave, so the
+ * ring memory is never freed under a writer.
+ */
+void pending_op_release(pending_op *op);
+
+/**
+ * @brief Look up the armed operation for a node from a CHIP callback
+ *
+ * Wait-free. Every non-NULL return must be paired with pending_op_leave().
+ */
+pending_op *pending_op_enter(pending_op_kind_t kind, uint64_t node_id);
+
+/**
+ * @brief Leave a slot entered with pending_op_enter()
+ */
+void pending_op_leave(pending_op *op);
+
+/**
+ * @brief Mark an operation complete and wake its waiter
+ *
+ * Only the first completion of an armed operation counts, later ones leave
+ * its status alone.
+ *
+ * @param status ESP_OK if the interaction finished normally
+ */
+void pending_op_complete(pending_op *op, esp_err_t status = ESP_OK);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
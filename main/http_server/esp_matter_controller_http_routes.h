@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_matter_controller_http_backend.h>
+#include <esp_matter_controller_http_server.h>
+
+/*
+ * REST API route table.
+ *
+ * Each entry is X(path, method, handler, description, params). The same table
+ * registers the URI handlers and generates the /api/help document at compile
+ * time, so the two cannot drift apart. params is the parameter schema,
+ * written as JSON inside HTTP_PARAMS(): the field name maps to its type, and
+ * a trailing '?' marks an optional field.
+ */
+
+#define HTTP_PARAMS(...) #__VA_ARGS__
+
+// /api/help is kept apart so the generated JSON array needs no trailing comma handling
+#define HTTP_SERVER_HELP_ROUTE(X) \
+    X("/api/help", GET, help_handler, "Get available endpoints", HTTP_PARAMS({}))
+
+#if HTTP_SERVER_BLE
+#define HTTP_SERVER_BLE_ROUTES(X) \
+    X("/api/ble-scan", POST, ble_scan_handler, "Scan for BLE devices (asynchronous job)", \
+      HTTP_PARAMS({"timeout": "uint16", "details": "bool?"}))
+#else
+#define HTTP_SERVER_BLE_ROUTES(X)
+#endif
+
+#define HTTP_SERVER_ROUTES(X) \
+    X("/api/debug/endpoints", GET, endpoints_handler, "Heap and stack usage per endpoint", HTTP_PARAMS({})) \
+    X("/api/debug/memory", GET, memory_handler, "Heap usage per memory region", HTTP_PARAMS({})) \
+    X("/api/debug/recent", GET, recent_handler, "Last requests with node, status, stage timings and heap delta", \
+      HTTP_PARAMS({"limit": "uint32?"})) \
+    X("/api/debug/log", GET, log_handler, "Log level per module and log ring counters", HTTP_PARAMS({})) \
+    X("/api/debug/log", POST, log_level_handler, "Set the runtime log level of a module", \
+      HTTP_PARAMS({"module": "server|ops|backend|results|jobs|*", "level": "none|error|warn|info|debug|verbose"})) \
+    X("/api/metrics", GET, metrics_handler, "Request, Matter and resource metrics in Prometheus text format", \
+      HTTP_PARAMS({})) \
+    X("/api/jobs/*", GET, jobs_handler, "Get state, progress and result of an asynchronous job: /api/jobs/{id}", \
+      HTTP_PARAMS({})) \
+    X("/api/pairing", POST, pairing_handler, "Pair a device to the controller (asynchronous job)", \
+      HTTP_PARAMS({"method": "onnetwork|ble-wifi|ble-thread|code", "node_id": "uint64", "pincode": "uint32?", \
+                   "discriminator": "uint16?", "ssid": "string?", "password": "string?", "dataset": "hex?", \
+                   "payload": "string?"})) \
+    X("/api/group-settings", POST, group_settings_handler, "Manage controller groups and keysets", \
+      HTTP_PARAMS({"action": "show-groups|add-group|remove-group", "group_id": "uint16?", "group_name": "string?"})) \
+    X("/api/udc", POST, udc_handler, "UDC (User Directed Commissioning) commands", \
+      HTTP_PARAMS({"action": "reset|print|commission", "pincode": "uint32?", "index": "uint32?"})) \
+    X("/api/open-commissioning-window", POST, open_commissioning_window_handler, \
+      "Open commissioning window on a device (asynchronous job)", \
+      HTTP_PARAMS({"node_id": "uint64", "option": "uint8", "window_timeout": "uint16", "iteration": "uint32", \
+                   "discriminator": "uint16"})) \
+    X("/api/invoke-command", POST, invoke_command_handler, "Invoke cluster command on a device", \
+      HTTP_PARAMS({"node_id": "uint64", "endpoint_id": "uint16", "cluster_id": "uint32", "command_id": "uint32", \
+                   "command_data": "string?", "timed_invoke_timeout_ms": "uint16?"})) \
+    X("/api/read-attribute", POST, read_attribute_handler, "Read device attributes", \
+      HTTP_PARAMS({"node_id": "uint64", "endpoint_ids": "uint16[]", "cluster_ids": "uint32[]", \
+                   "attribute_ids": "uint32[]", "timeout_ms": "uint32?", "async": "bool?"})) \
+    X("/api/write-attribute", POST, write_attribute_handler, "Write device attributes", \
+      HTTP_PARAMS({"node_id": "uint64", "endpoint_ids": "uint16[]", "cluster_ids": "uint32[]", \
+                   "attribute_ids": "uint32[]", "attribute_value": "string", "timed_write_timeout_ms": "uint16?"})) \
+    X("/api/read-event", POST, read_event_handler, "Read device events", \
+      HTTP_PARAMS({"node_id": "uint64", "endpoint_ids": "uint16[]", "cluster_ids": "uint32[]", \
+                   "event_ids": "uint32[]"})) \
+    X("/api/subscribe-attribute", POST, subscribe_attribute_handler, "Subscribe to device attributes", \
+      HTTP_PARAMS({"node_id": "uint64", "endpoint_ids": "uint16[]", "cluster_ids": "uint32[]", \
+                   "attribute_ids": "uint32[]", "min_interval": "uint16", "max_interval": "uint16"})) \
+    X("/api/subscribe-event", POST, subscribe_event_handler, "Subscribe to device events", \
+      HTTP_PARAMS({"node_id": "uint64", "endpoint_ids": "uint16[]", "cluster_ids": "uint32[]", \
+                   "event_ids": "uint32[]", "min_interval": "uint16", "max_interval": "uint16"})) \
+    X("/api/shutdown-subscription", POST, shutdown_subscription_handler, "Shutdown specific subscription", \
+      HTTP_PARAMS({"node_id": "uint64", "subscription_id": "uint32"})) \
+    X("/api/shutdown-all-subscriptions", POST, shutdown_all_subscriptions_handler, "Shutdown all subscriptions", \
+      HTTP_PARAMS({"node_id": "uint64?"})) \
+    X("/api/subscriptions", GET, subscriptions_handler, \
+      "Registered subscriptions with paths, intervals, last report and clients", HTTP_PARAMS({"node_id": "uint64?"})) \
+    X("/api/subscriptions/*", GET, subscription_stream_handler, \
+      "Server-sent events of a subscription's reports, coalesced per path: /api/subscriptions/{id}/stream", \
+      HTTP_PARAMS({"window_ms": "uint32?", "changes_only": "bool?", "where": "string?"})) \
+    X("/api/subscriptions/*", DELETE, unsubscribe_handler, \
+      "Release a subscription, torn down with its last client: /api/subscriptions/{id}", \
+      HTTP_PARAMS({})) \
+    HTTP_SERVER_BLE_ROUTES(X)
@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_schema.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+namespace schema {
+
+// JSON numbers from 2^53 on no longer map to a single integer, 2^53 + 1 reads as 2^53
+#define SCHEMA_EXACT_NUMBER_LIMIT 9007199254740992.0
+
+bool parse_uint(bool is_number, double number, const char *number_text, const char *str, uint64_t *out)
+{
+    if (is_number) {
+        // Plain integer literals are parsed from their text, so every 64-bit value is exact
+        if (number_text && isdigit((unsigned char)number_text[0])) {
+            const char *end = number_text;
+            while (isdigit((unsigned char)*end)) {
+                end++;
+            }
+            if (*end != '.' && *end != 'e' && *end != 'E') {
+                errno = 0;
+                unsigned long long value = strtoull(number_text, NULL, 10);
+                if (errno == ERANGE) {
+                    return false;
+                }
+                *out = value;
+                return true;
+            }
+        }
+        if (!(number >= 0) || number >= SCHEMA_EXACT_NUMBER_LIMIT || floor(number) != number) {
+            return false;
+        }
+        *out = (uint64_t)number;
+        return true;
+    }
+    if (!str) {
+        return false;
+    }
+
+    // Strings carry values that do not fit a double, no sign or whitespace accepted
+    int base = 10;
+    const char *digits = str;
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+        base = 16;
+        digits = str + 2;
+    }
+    if (!isxdigit((unsigned char)digits[0])) {
+        return false;
+    }
+    char *end = NULL;
+    errno = 0;
+    unsigned long long value = strtoull(digits, &end, base);
+    if (errno == ERANGE || *end != '\0') {
+        return false;
+    }
+    *out = value;
+    return true;
+}
+
+void set_error(error_t *err, const char *format, const char *name, uint64_t min, uint64_t max)
+{
+    if (err) {
+        snprintf(err->message, sizeof(err->message), format, name, (unsigned long long)min,
+                 (unsigned long long)max);
+    }
+}
+
+} // namespace schema
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,429 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_matter_controller_http_memory.h>
+#include <limits>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+namespace schema {
+
+/*
+ * Declarative request parameter schemas.
+ *
+ * A schema is a constexpr list of fields, each binding a JSON member name to
+ * a member of a plain parameter struct. parse() walks the JSON object once,
+ * fills the struct, range-checks the values and reports the first problem
+ * with a uniform message. Supported member types are bool, unsigned integers
+ * up to uint64_t, const char * (pointing into the parsed request),
+ * array<> of unsigned integers, and optional<> of those.
+ *
+ * Unsigned integers are parsed exactly: integer literals are read from the
+ * request text when the representation keeps it (the in-place tokenizer),
+ * otherwise JSON numbers are accepted below 2^53. 64-bit values (such as node
+ * IDs) can always be sent as decimal or 0x-prefixed strings.
+ */
+
+#define SCHEMA_ERROR_MAX 96
+
+typedef struct {
+    char message[SCHEMA_ERROR_MAX];
+} error_t;
+
+/**
+ * @brief Optional field, present tells whether the request contained it
+ */
+template <typename T>
+struct optional {
+    T value{};
+    bool present = false;
+};
+
+/**
+ * @brief Array field, allocated from the request memory and freed with the params struct
+ */
+template <typename T>
+class array {
+public:
+    array() = default;
+    ~array() { http_mem_free(m_data); }
+
+    bool alloc(size_t count)
+    {
+        http_mem_free(m_data);
+        m_data = (T *)http_mem_calloc(count, sizeof(T), HTTP_MEM_TRANSIENT);
+        m_size = m_data ? count : 0;
+        return m_data != nullptr;
+    }
+
+    T *data() { return m_data; }
+    const T *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    T &operator[](size_t index) { return m_data[index]; }
+    const T &operator[](size_t index) const { return m_data[index]; }
+
+    array(const array &) = delete;
+    array &operator=(const array &) = delete;
+
+private:
+    T *m_data = nullptr;
+    size_t m_size = 0;
+};
+
+template <typename T>
+struct is_optional : std::false_type {};
+template <typename T>
+struct is_optional<optional<T>> : std::true_type {};
+
+template <typename T>
+struct is_buffer : std::false_type {};
+template <typename T>
+struct is_buffer<array<T>> : std::true_type {};
+
+template <typename T>
+struct value_type {
+    using type = T;
+};
+template <typename T>
+struct value_type<optional<T>> {
+    using type = T;
+};
+
+template <typename T>
+struct element_type {
+    using type = T;
+};
+template <typename T>
+struct element_type<array<T>> {
+    using type = T;
+};
+
+// Largest value accepted for a member, elements for arrays
+template <typename M>
+constexpr uint64_t type_max()
+{
+    using E = typename element_type<typename value_type<M>::type>::type;
+    if constexpr (std::is_integral<E>::value && std::is_unsigned<E>::value) {
+        return std::numeric_limits<E>::max();
+    } else {
+        return 0;
+    }
+}
+
+template <typename S, typename M>
+struct field_t {
+    const char *name;
+    M S::*member;
+    uint64_t min;
+    uint64_t max;
+};
+
+/**
+ * @brief Field accepting the full range of the member type
+ */
+template <typename S, typename M>
+constexpr field_t<S, M> field(const char *name, M S::*member)
+{
+    return field_t<S, M>{name, member, 0, type_max<M>()};
+}
+
+/**
+ * @brief Numeric field restricted to [min, max], applies to each element of an array
+ */
+template <typename S, typename M>
+constexpr field_t<S, M> field(const char *name, M S::*member, uint64_t min, uint64_t max)
+{
+    return field_t<S, M>{name, member, min, max};
+}
+
+template <typename... F>
+constexpr std::tuple<F...> make(F... fields)
+{
+    static_assert(sizeof...(F) <= 32, "a schema holds at most 32 fields");
+    return std::tuple<F...>(fields...);
+}
+
+/**
+ * @brief Read-only view of a cJSON value
+ *
+ * The field parsers only use this interface, so another request
+ * representation can reuse the same schemas.
+ */
+class cjson_value {
+public:
+    explicit cjson_value(const cJSON *item) : m_item(item) {}
+
+    bool is_bool() const { return cJSON_IsBool(m_item); }
+    bool get_bool() const { return cJSON_IsTrue(m_item); }
+    bool is_number() const { return cJSON_IsNumber(m_item); }
+    double get_number() const { return m_item->valuedouble; }
+    const char *get_number_text() const { return nullptr; } // cJSON keeps the double only
+    bool is_string() const { return cJSON_IsString(m_item) && m_item->valuestring; }
+    const char *get_string() const { return m_item->valuestring; }
+    bool is_array() const { return cJSON_IsArray(m_item); }
+    size_t array_size() const { return cJSON_GetArraySize(m_item); }
+
+    template <typename F>
+    bool for_each_element(F &&fn) const
+    {
+        for (const cJSON *child = m_item->child; child; child = child->next) {
+            if (!fn(cjson_value(child))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename F>
+    bool for_each_member(F &&fn) const
+    {
+        for (const cJSON *child = m_item->child; child; child = child->next) {
+            if (child->string && !fn(child->string, cjson_value(child))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    const cJSON *m_item;
+};
+
+/**
+ * @brief View of a URL query string such as "node_id=1&endpoint_id=2"
+ *
+ * The query is split in place into NUL-terminated keys and values. Every
+ * value reads as a string, so only string and integer fields can be filled
+ * from it; values are not percent-decoded.
+ */
+class query_value {
+public:
+    query_value(char *query, size_t len) : m_str(query), m_len(len), m_object(true), m_string(false)
+    {
+        char *pair = query;
+        char *end = query + len;
+        while (pair < end) {
+            char *next = (char *)memchr(pair, '&', end - pair);
+            next = next ? next : end;
+            char *separator = (char *)memchr(pair, '=', next - pair);
+            if (!separator) {
+                // Every pair needs a value, or keys and values would no longer alternate
+                m_object = false;
+                return;
+            }
+            *separator = '\0';
+            *next = '\0';
+            pair = next + 1;
+        }
+    }
+
+    bool is_object() const { return m_object; }
+    bool is_bool() const { return false; }
+    bool get_bool() const { return false; }
+    bool is_number() const { return false; }
+    double get_number() const { return 0; }
+    const char *get_number_text() const { return nullptr; }
+    bool is_string() const { return m_string; }
+    const char *get_string() const { return m_str; }
+    bool is_array() const { return false; }
+    size_t array_size() const { return 0; }
+
+    template <typename F>
+    bool for_each_element(F &&fn) const
+    {
+        return true;
+    }
+
+    template <typename F>
+    bool for_each_member(F &&fn) const
+    {
+        const char *end = m_str + m_len;
+        for (const char *key = m_str; m_object && key < end;) {
+            const char *value = key + strlen(key) + 1;
+            if (!fn(key, query_value(value))) {
+                return false;
+            }
+            key = value + strlen(value) + 1;
+        }
+        return true;
+    }
+
+private:
+    // A single value
+    explicit query_value(const char *value)
+        : m_str(const_cast<char *>(value)), m_len(strlen(value)), m_object(false), m_string(true)
+    {
+    }
+
+    char *m_str;
+    size_t m_len;
+    bool m_object;
+    bool m_string;
+};
+
+/**
+ * @brief Parse an unsigned integer given as a JSON number or as a decimal/0x string
+ *
+ * @param number_text Literal of the number when available, integer literals are then parsed exactly;
+ *                    otherwise numbers from 2^53 on are rejected as they may have been rounded
+ */
+bool parse_uint(bool is_number, double number, const char *number_text, const char *str, uint64_t *out);
+
+void set_error(error_t *err, const char *format, const char *name, uint64_t min = 0, uint64_t max = 0);
+
+template <typename V>
+bool read_uint(const V &value, uint64_t min, uint64_t max, uint64_t *out)
+{
+    bool is_number = value.is_number();
+    if (!parse_uint(is_number, is_number ? value.get_number() : 0, is_number ? value.get_number_text() : nullptr,
+                    value.is_string() ? value.get_string() : nullptr, out)) {
+        return false;
+    }
+    return *out >= min && *out <= max;
+}
+
+template <typename T, typename V>
+bool read_value(const V &value, const char *name, uint64_t min, uint64_t max, T *out, error_t *err)
+{
+    if constexpr (std::is_same<T, bool>::value) {
+        if (!value.is_bool()) {
+            set_error(err, "Invalid '%s': expected boolean", name);
+            return false;
+        }
+        *out = value.get_bool();
+        return true;
+    } else if constexpr (std::is_same<T, const char *>::value) {
+        if (!value.is_string()) {
+            set_error(err, "Invalid '%s': expected string", name);
+            return false;
+        }
+        *out = value.get_string();
+        return true;
+    } else if constexpr (std::is_integral<T>::value && std::is_unsigned<T>::value) {
+        uint64_t number;
+        if (!read_uint(value, min, max, &number)) {
+            set_error(err, "Invalid '%s': expected integer in [%llu, %llu]", name, min, max);
+            return false;
+        }
+        *out = (T)number;
+        return true;
+    } else if constexpr (is_buffer<T>::value) {
+        using E = typename element_type<T>::type;
+        size_t count = value.is_array() ? value.array_size() : 0;
+        if (count == 0) {
+            set_error(err, "Invalid '%s': expected non-empty array", name);
+            return false;
+        }
+        if (!out->alloc(count)) {
+            set_error(err, "Out of memory parsing '%s'", name);
+            return false;
+        }
+        size_t index = 0;
+        bool ok = value.for_each_element([&](const V &element) {
+            uint64_t number;
+            if (!read_uint(element, min, max, &number)) {
+                return false;
+            }
+            (*out)[index++] = (E)number;
+            return true;
+        });
+        if (!ok) {
+            set_error(err, "Invalid '%s': expected array of integers in [%llu, %llu]", name, min, max);
+            return false;
+        }
+        return true;
+    } else {
+        static_assert(sizeof(T) == 0, "unsupported schema field type");
+        return false;
+    }
+}
+
+template <typename S, typename M, typename V>
+bool read_field(const field_t<S, M> &f, const V &value, S *out, error_t *err)
+{
+    if constexpr (is_optional<M>::value) {
+        (out->*(f.member)).present = true;
+        return read_value(value, f.name, f.min, f.max, &(out->*(f.member)).value, err);
+    } else {
+        return read_value(value, f.name, f.min, f.max, &(out->*(f.member)), err);
+    }
+}
+
+template <typename Schema, typename S, typename V, size_t... I>
+bool match_member(const Schema &fields, const char *name, const V &value, S *out, uint32_t *seen, error_t *err,
+                  bool *ok, std::index_sequence<I...>)
+{
+    // Stops at the first field with that name
+    return ((strcmp(std::get<I>(fields).name, name) == 0 &&
+             (*seen |= (1u << I), *ok = read_field(std::get<I>(fields), value, out, err), true)) || ...);
+}
+
+template <typename S, typename M>
+constexpr bool is_required(const field_t<S, M> &)
+{
+    return !is_optional<M>::value;
+}
+
+template <typename Schema, size_t... I>
+bool check_required(const Schema &fields, uint32_t seen, error_t *err, std::index_sequence<I...>)
+{
+    return ((!is_required(std::get<I>(fields)) || (seen & (1u << I)) ||
+             (set_error(err, "Missing required field '%s'", std::get<I>(fields).name), false)) && ...);
+}
+
+/**
+ * @brief Fill a parameter struct from a request object in a single pass
+ * @return true on success, false with err set otherwise
+ */
+template <typename S, typename V, typename... F>
+bool parse_value(const V &object, const std::tuple<F...> &fields, S *out, error_t *err)
+{
+    constexpr auto indices = std::index_sequence_for<F...>{};
+    uint32_t seen = 0;
+    bool ok = true;
+    object.for_each_member([&](const char *name, const V &value) {
+        match_member(fields, name, value, out, &seen, err, &ok, indices);
+        return ok;
+    });
+    return ok && check_required(fields, seen, err, indices);
+}
+
+template <typename S, typename... F>
+bool parse(const cJSON *json, const std::tuple<F...> &fields, S *out, error_t *err)
+{
+    if (!cJSON_IsObject(json)) {
+        set_error(err, "Request body must be a JSON object", "");
+        return false;
+    }
+    return parse_value(cjson_value(json), fields, out, err);
+}
+
+/**
+ * @brief Check a field that is optional in the schema but required by the request variant
+ */
+template <typename T>
+bool require(const optional<T> &field, const char *name, error_t *err)
+{
+    if (!field.present) {
+        set_error(err, "Missing required field '%s'", name);
+    }
+    return field.present;
+}
+
+} // namespace schema
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -15,50 +15,37 @@
  *    limitations under the License.
  */
 
+#include <esp_bit_defs.h>
 #include <esp_check.h>
 #include <esp_log.h>
-#include <esp_matter_controller_client.h>
-#include <esp_matter_controller_cluster_command.h>
-#include <esp_matter_controller_commissioning_window_opener.h>
-#include <esp_matter_controller_console.h>
-#include <esp_matter_controller_group_settings.h>
-#include <esp_matter_controller_pairing_command.h>
-#include <esp_matter_controller_read_command.h>
-#include <esp_matter_controller_subscribe_command.h>
-#include <esp_matter_controller_utils.h>
-#include <esp_matter_controller_write_command.h>
 #include <esp_matter_controller_http_server.h>
-#include <esp_matter_core.h>
+#include <esp_matter_controller_http_arena.h>
+#include <esp_matter_controller_http_backend.h>
+#include <esp_matter_controller_http_encoding.h>
+#include <esp_matter_controller_http_jobs.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_memory.h>
+#include <esp_matter_controller_http_metrics.h>
+#include <esp_matter_controller_http_recorder.h>
+#include <esp_matter_controller_http_results.h>
+#include <esp_matter_controller_http_routes.h>
+#include <esp_matter_controller_http_schema.h>
+#include <esp_matter_controller_http_stream.h>
+#include <esp_matter_controller_http_subscription_store.h>
+#include <esp_matter_controller_http_subscriptions.h>
+#include <esp_matter_controller_http_telemetry.h>
+#include <esp_matter_controller_http_timing.h>
+#include <esp_matter_controller_http_tokenizer.h>
 #include <algorithm>
-#include <map>
-#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
-#include <esp_matter_controller_ble_scan_command.h>
-#endif
-#include <esp_netif.h>
+#include <atomic>
+#include <esp_timer.h>
 #include <inttypes.h>
-#include <lib/core/CHIPCore.h>
-#include <lib/shell/Commands.h>
-#include <lib/shell/Engine.h>
-#include <lib/shell/commands/Help.h>
-#include <lib/shell/streamer.h>
-#include <lib/support/CHIPArgParser.hpp>
-#include <lib/support/CHIPMem.h>
-#include <lib/support/CodeUtils.h>
-#include <platform/CHIPDeviceLayer.h>
-#include <protocols/secure_channel/RendezvousParameters.h>
-#include <protocols/user_directed_commissioning/UserDirectedCommissioning.h>
 #include <string.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
-
-using chip::NodeId;
-using chip::Inet::IPAddress;
-using chip::Platform::ScopedMemoryBufferWithSize;
-using chip::Transport::PeerAddress;
-using chip::app::AttributePathParams;
-using chip::app::EventPathParams;
-using esp_matter::controller::read_command;
+#include <errno.h>
+#include <sys/socket.h>
 
 namespace esp_matter {
 namespace controller {
@@ -68,243 +55,89 @@ static const char *TAG = "controller_httpserver";
 static httpd_handle_t s_server = NULL;
 static bool s_cors_enabled = false;
 
-// Structure to store read attribute results
-struct ReadAttributeResult {
-    SemaphoreHandle_t semaphore;
-    cJSON *attribute_data;
-    bool success;
-    char error_message[256];
-    uint32_t expected_responses;
-    uint32_t received_responses;
-    
-    ReadAttributeResult(uint32_t expected_count) {
-        semaphore = xSemaphoreCreateBinary();
-        attribute_data = cJSON_CreateArray();
-        success = false;
-        error_message[0] = '\0';
-        expected_responses = expected_count;
-        received_responses = 0;
-    }
-    
-    ~ReadAttributeResult() {
-        if (semaphore) {
-            vSemaphoreDelete(semaphore);
-        }
-        if (attribute_data) {
-            cJSON_Delete(attribute_data);
-        }
-    }
-};
-
-// Structure to store write attribute results
-struct WriteAttributeResult {
-    SemaphoreHandle_t semaphore;
-    cJSON *write_results;
-    bool success;
-    char error_message[256];
-    uint32_t expected_responses;
-    uint32_t received_responses;
-    
-    WriteAttributeResult(uint32_t expected_count) {
-        semaphore = xSemaphoreCreateBinary();
-        write_results = cJSON_CreateArray();
-        success = false;
-        error_message[0] = '\0';
-        expected_responses = expected_count;
-        received_responses = 0;
-    }
-    
-    ~WriteAttributeResult() {
-        if (semaphore) {
-            vSemaphoreDelete(semaphore);
-        }
-        if (write_results) {
-            cJSON_Delete(write_results);
-        }
-    }
-};
+#define HTTP_SERVER_STACK_SIZE 12288
 
-// Global map to store read results (simple implementation)
-static std::map<uint64_t, ReadAttributeResult*> s_read_results;
-static std::map<uint64_t, WriteAttributeResult*> s_write_results;
-static SemaphoreHandle_t s_read_results_mutex = nullptr;
-static SemaphoreHandle_t s_write_results_mutex = nullptr;
+#define READ_DEFAULT_TIMEOUT_MS 10000
+#define READ_MIN_TIMEOUT_MS 100
+#define READ_MAX_TIMEOUT_MS 60000
+#define WRITE_DEFAULT_TIMEOUT_MS 10000
+#define READ_INCOMPLETE_MESSAGE "Read reported more attributes than can be buffered - narrow the paths"
 
-// Initialize read results mutex
-static void init_read_results_mutex() {
-    if (!s_read_results_mutex) {
-        s_read_results_mutex = xSemaphoreCreateMutex();
-    }
+// Simple lock helper - returns true if lock acquired successfully
+static bool acquire_matter_lock() {
+    http_stage_timer timer(HTTP_STAGE_LOCK);
+    return http_backend()->lock(pdMS_TO_TICKS(2000)); // Reduced to 2 seconds
 }
 
-// Initialize write results mutex
-static void init_write_results_mutex() {
-    if (!s_write_results_mutex) {
-        s_write_results_mutex = xSemaphoreCreateMutex();
-    }
+static void release_matter_lock() {
+    http_backend()->unlock();
 }
 
-// Simple lock helper - returns true if lock acquired successfully
-static bool acquire_matter_lock() {
-    esp_matter::lock::status_t status = esp_matter::lock::chip_stack_lock(pdMS_TO_TICKS(2000)); // Reduced to 2 seconds
-    return (status == esp_matter::lock::SUCCESS);
+// Convert the records collected for a request into the JSON array returned to the client
+static cJSON *drain_records_to_json(pending_op *op, bool include_value)
+{
+    http_stage_timer timer(HTTP_STAGE_SERIALIZE);
+    return http_records_to_json(op, include_value);
 }
 
-static void release_matter_lock() {
-    esp_matter::lock::chip_stack_unlock();
+// Paths of a request whose lists were parsed into schema arrays
+static backend_paths_t make_paths(const schema::array<uint16_t> &endpoint_ids, const schema::array<uint32_t> &cluster_ids,
+                                  const schema::array<uint32_t> &ids) {
+    return { endpoint_ids.data(), endpoint_ids.size(), cluster_ids.data(), cluster_ids.size(), ids.data(), ids.size() };
 }
 
-// Safe logging function that doesn't use locks during Matter operations
-static void safe_log(const char* level, const char* message) {
-    // Use printf instead of ESP_LOG to avoid potential lock conflicts
-    printf("[%s] %s: %s\n", level, TAG, message);
+// Records the ring of a read must hold: one per path, or a whole report chunk once a wildcard expands.
+// The waiter drains the ring between chunks, so the total may exceed it.
+static uint32_t read_ring_records(const backend_paths_t &paths) {
+    size_t count = std::max(paths.endpoint_count, std::max(paths.cluster_count, paths.id_count));
+    bool wildcard = std::find(paths.endpoint_ids, paths.endpoint_ids + paths.endpoint_count, 0xFFFF) !=
+                    paths.endpoint_ids + paths.endpoint_count ||
+                    std::find(paths.cluster_ids, paths.cluster_ids + paths.cluster_count, 0xFFFFFFFF) !=
+                    paths.cluster_ids + paths.cluster_count ||
+                    std::find(paths.ids, paths.ids + paths.id_count, 0xFFFFFFFF) != paths.ids + paths.id_count;
+    return wildcard ? std::max<size_t>(count, PENDING_OP_WILDCARD_RING_RECORDS) : count;
 }
 
-// Callback function for attribute data
-static void http_attribute_data_callback(uint64_t node_id, const chip::app::ConcreteDataAttributePath &path, chip::TLV::TLVReader *data) {
-    if (!s_read_results_mutex) return;
-    
-    if (xSemaphoreTake(s_read_results_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        auto it = s_read_results.find(node_id);
-        if (it != s_read_results.end()) {
-            ReadAttributeResult *result = it->second;
-            
-            // Create JSON object for this attribute
-            cJSON *attr_obj = cJSON_CreateObject();
-            cJSON_AddNumberToObject(attr_obj, "node_id", node_id);
-            cJSON_AddNumberToObject(attr_obj, "endpoint_id", path.mEndpointId);
-            cJSON_AddNumberToObject(attr_obj, "cluster_id", path.mClusterId);
-            cJSON_AddNumberToObject(attr_obj, "attribute_id", path.mAttributeId);
-            
-            // Try to decode the TLV data
-            if (data != nullptr) {
-                chip::TLV::TLVReader reader;
-                reader.Init(*data);
-                
-                // Read the TLV data type and value
-                chip::TLV::TLVType tlv_type = reader.GetType();
-                switch (tlv_type) {
-                    case chip::TLV::kTLVType_Boolean: {
-                        bool value;
-                        if (reader.Get(value) == CHIP_NO_ERROR) {
-                            cJSON_AddBoolToObject(attr_obj, "value", value);
-                            cJSON_AddStringToObject(attr_obj, "type", "boolean");
-                        }
-                        break;
-                    }
-                    case chip::TLV::kTLVType_UnsignedInteger: {
-                        uint64_t value;
-                        if (reader.Get(value) == CHIP_NO_ERROR) {
-                            cJSON_AddNumberToObject(attr_obj, "value", value);
-                            cJSON_AddStringToObject(attr_obj, "type", "uint");
-                        }
-                        break;
-                    }
-                    case chip::TLV::kTLVType_SignedInteger: {
-                        int64_t value;
-                        if (reader.Get(value) == CHIP_NO_ERROR) {
-                            cJSON_AddNumberToObject(attr_obj, "value", value);
-                            cJSON_AddStringToObject(attr_obj, "type", "int");
-                        }
-                        break;
-                    }
-                    case chip::TLV::kTLVType_UTF8String: {
-                        chip::CharSpan value;
-                        if (reader.Get(value) == CHIP_NO_ERROR) {
-                            char str_buf[256];
-                            size_t copy_len = std::min(value.size(), sizeof(str_buf) - 1);
-                            memcpy(str_buf, value.data(), copy_len);
-                            str_buf[copy_len] = '\0';
-                            cJSON_AddStringToObject(attr_obj, "value", str_buf);
-                            cJSON_AddStringToObject(attr_obj, "type", "string");
-                        }
-                        break;
-                    }
-                    case chip::TLV::kTLVType_FloatingPointNumber: {
-                        double value;
-                        if (reader.Get(value) == CHIP_NO_ERROR) {
-                            cJSON_AddNumberToObject(attr_obj, "value", value);
-                            cJSON_AddStringToObject(attr_obj, "type", "float");
-                        }
-                        break;
-                    }
-                    default:
-                        // For other types, just indicate raw data
-                        cJSON_AddStringToObject(attr_obj, "value", "raw_data");
-                        cJSON_AddStringToObject(attr_obj, "type", "raw");
-                        break;
-                }
-            } else {
-                cJSON_AddNullToObject(attr_obj, "value");
-                cJSON_AddStringToObject(attr_obj, "type", "null");
-            }
-            
-            // Add to results array
-            cJSON_AddItemToArray(result->attribute_data, attr_obj);
-            result->received_responses++;
-            result->success = true;
-        }
-        xSemaphoreGive(s_read_results_mutex);
-    }
+// Check whether the client behind a request has closed its socket
+static bool is_client_disconnected(httpd_req_t *req) {
+    int sockfd = httpd_req_to_sockfd(req);
+    if (sockfd < 0) {
+        return true;
+    }
+    char probe;
+    int len = recv(sockfd, &probe, sizeof(probe), MSG_PEEK | MSG_DONTWAIT);
+    if (len == 0) {
+        return true;
+    }
+    return len < 0 && errno != EAGAIN && errno != EWOULDBLOCK;
 }
 
-// Callback function for read done
-static void http_read_done_callback(uint64_t node_id, 
-                                   const chip::Platform::ScopedMemoryBufferWithSize<chip::app::AttributePathParams> &attr_paths,
-                                   const chip::Platform::ScopedMemoryBufferWithSize<chip::app::EventPathParams> &event_paths) {
-    if (!s_read_results_mutex) return;
-    
-    if (xSemaphoreTake(s_read_results_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        auto it = s_read_results.find(node_id);
-        if (it != s_read_results.end()) {
-            ReadAttributeResult *result = it->second;
-            // Signal completion
-            xSemaphoreGive(result->semaphore);
+typedef enum {
+    WAIT_COMPLETED,
+    WAIT_DEADLINE_EXPIRED,
+    WAIT_CLIENT_GONE,
+} wait_outcome_t;
+
+// Wait for a pending operation while watching the client's deadline and socket.
+// On anything but completion the underlying Matter interaction is cancelled.
+static wait_outcome_t wait_for_pending_op(httpd_req_t *req, pending_op *op, uint32_t deadline_ms) {
+    const TickType_t slice = pdMS_TO_TICKS(100);
+    TickType_t remaining = pdMS_TO_TICKS(deadline_ms);
+    wait_outcome_t outcome = WAIT_DEADLINE_EXPIRED;
+    while (remaining > 0) {
+        TickType_t step = remaining < slice ? remaining : slice;
+        if (pending_op_wait(op, step)) {
+            return WAIT_COMPLETED;
+        }
+        remaining -= step;
+        if (is_client_disconnected(req)) {
+            outcome = WAIT_CLIENT_GONE;
+            break;
         }
-        xSemaphoreGive(s_read_results_mutex);
     }
-}
-
-// Custom write attribute function with callbacks (forward declaration)
-static esp_err_t send_write_attr_command_with_callbacks(uint64_t node_id, 
-                                                        ScopedMemoryBufferWithSize<uint16_t> &endpoint_ids,
-                                                        ScopedMemoryBufferWithSize<uint32_t> &cluster_ids,
-                                                        ScopedMemoryBufferWithSize<uint32_t> &attribute_ids,
-                                                        const char *attribute_value,
-                                                        chip::Optional<uint16_t> timed_write_timeout);
-
-// Custom read attribute function with callbacks
-static esp_err_t send_read_attr_command_with_callbacks(uint64_t node_id, 
-                                                       ScopedMemoryBufferWithSize<uint16_t> &endpoint_ids,
-                                                       ScopedMemoryBufferWithSize<uint32_t> &cluster_ids,
-                                                       ScopedMemoryBufferWithSize<uint32_t> &attribute_ids) {
-    if (endpoint_ids.AllocatedSize() != cluster_ids.AllocatedSize() ||
-        endpoint_ids.AllocatedSize() != attribute_ids.AllocatedSize()) {
-        ESP_LOGE(TAG, "Array length mismatch");
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    ScopedMemoryBufferWithSize<AttributePathParams> attr_paths;
-    ScopedMemoryBufferWithSize<EventPathParams> event_paths;
-    attr_paths.Alloc(endpoint_ids.AllocatedSize());
-    if (!attr_paths.Get()) {
-        ESP_LOGE(TAG, "Failed to alloc memory for attribute paths");
-        return ESP_ERR_NO_MEM;
-    }
-    
-    for (size_t i = 0; i < attr_paths.AllocatedSize(); ++i) {
-        attr_paths[i] = AttributePathParams(endpoint_ids[i], cluster_ids[i], attribute_ids[i]);
-    }
-    
-    // Create read command with callbacks
-    read_command *cmd = chip::Platform::New<read_command>(node_id, std::move(attr_paths), std::move(event_paths),
-                                                          http_attribute_data_callback, http_read_done_callback, nullptr);
-    if (!cmd) {
-        ESP_LOGE(TAG, "Failed to alloc memory for read_command");
-        return ESP_ERR_NO_MEM;
-    }
-    
-    return cmd->send_command();
+    cancel_pending_op(op);
+    // The interaction may have completed just before it was cancelled
+    return pending_op_wait(op, 0) ? WAIT_COMPLETED : outcome;
 }
 
 // Enhanced error handling with stack trace protection
@@ -313,6 +146,7 @@ static esp_err_t safe_send_error_response(httpd_req_t *req, int status_code, con
     if (!json) {
         // Fallback to simple HTTP response if JSON creation fails
         const char *simple_error = "Internal server error";
+        http_endpoint_set_status(status_code == 500 ? 500 : 400);
         httpd_resp_set_status(req, status_code == 500 ? HTTPD_500 : HTTPD_400);
         httpd_resp_set_type(req, "text/plain");
         httpd_resp_send(req, simple_error, strlen(simple_error));
@@ -327,141 +161,7 @@ static esp_err_t safe_send_error_response(httpd_req_t *req, int status_code, con
     return ret;
 }
 
-// Utility functions
-static size_t get_array_size(const char *str)
-{
-    if (!str) {
-        return 0;
-    }
-    size_t ret = 1;
-    for (size_t i = 0; i < strlen(str); ++i) {
-        if (str[i] == ',') {
-            ret++;
-        }
-    }
-    return ret;
-}
-
-static esp_err_t json_array_to_uint32_array(cJSON *json_array, ScopedMemoryBufferWithSize<uint32_t> &uint32_array)
-{
-    if (!cJSON_IsArray(json_array)) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    size_t array_len = cJSON_GetArraySize(json_array);
-    if (array_len == 0) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    uint32_array.Calloc(array_len);
-    if (!uint32_array.Get()) {
-        return ESP_ERR_NO_MEM;
-    }
-    
-    for (size_t i = 0; i < array_len; ++i) {
-        cJSON *item = cJSON_GetArrayItem(json_array, i);
-        if (!cJSON_IsNumber(item)) {
-            return ESP_ERR_INVALID_ARG;
-        }
-        uint32_array[i] = (uint32_t)item->valueint;
-    }
-    return ESP_OK;
-}
-
-static esp_err_t json_array_to_uint16_array(cJSON *json_array, ScopedMemoryBufferWithSize<uint16_t> &uint16_array)
-{
-    if (!cJSON_IsArray(json_array)) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    size_t array_len = cJSON_GetArraySize(json_array);
-    if (array_len == 0) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    uint16_array.Calloc(array_len);
-    if (!uint16_array.Get()) {
-        return ESP_ERR_NO_MEM;
-    }
-    
-    for (size_t i = 0; i < array_len; ++i) {
-        cJSON *item = cJSON_GetArrayItem(json_array, i);
-        if (!cJSON_IsNumber(item)) {
-            return ESP_ERR_INVALID_ARG;
-        }
-        uint16_array[i] = (uint16_t)item->valueint;
-    }
-    return ESP_OK;
-}
-
-// Keep legacy string parsing functions for backward compatibility if needed
-static esp_err_t string_to_uint32_array(const char *str, ScopedMemoryBufferWithSize<uint32_t> &uint32_array)
-{
-    size_t array_len = get_array_size(str);
-    if (array_len == 0) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    uint32_array.Calloc(array_len);
-    if (!uint32_array.Get()) {
-        return ESP_ERR_NO_MEM;
-    }
-    char number[11]; // max(strlen("0xFFFFFFFF"), strlen("4294967295")) + 1
-    const char *next_number_start = str;
-    char *next_number_end = NULL;
-    size_t next_number_len = 0;
-    for (size_t i = 0; i < array_len; ++i) {
-        next_number_end = strchr(next_number_start, ',');
-        if (next_number_end > next_number_start) {
-            next_number_len = std::min((size_t)(next_number_end - next_number_start), sizeof(number) - 1);
-        } else if (i == array_len - 1) {
-            next_number_len = strnlen(next_number_start, sizeof(number) - 1);
-        } else {
-            return ESP_ERR_INVALID_ARG;
-        }
-        strncpy(number, next_number_start, next_number_len);
-        number[next_number_len] = 0;
-        uint32_array[i] = string_to_uint32(number);
-        if (next_number_end > next_number_start) {
-            next_number_start = next_number_end + 1;
-        }
-    }
-    return ESP_OK;
-}
-
-static esp_err_t string_to_uint16_array(const char *str, ScopedMemoryBufferWithSize<uint16_t> &uint16_array)
-{
-    size_t array_len = get_array_size(str);
-    if (array_len == 0) {
-        return ESP_ERR_INVALID_ARG;
-    }
-    uint16_array.Calloc(array_len);
-    if (!uint16_array.Get()) {
-        return ESP_ERR_NO_MEM;
-    }
-    char number[7]; // max(strlen(0xFFFF), strlen(65535)) + 1
-    const char *next_number_start = str;
-    char *next_number_end = NULL;
-    size_t next_number_len = 0;
-    for (size_t i = 0; i < array_len; ++i) {
-        next_number_end = strchr(next_number_start, ',');
-        if (next_number_end > next_number_start) {
-            next_number_len = std::min((size_t)(next_number_end - next_number_start), sizeof(number) - 1);
-        } else if (i == array_len - 1) {
-            next_number_len = strnlen(next_number_start, sizeof(number) - 1);
-        } else {
-            return ESP_ERR_INVALID_ARG;
-        }
-        strncpy(number, next_number_start, next_number_len);
-        number[next_number_len] = 0;
-        uint16_array[i] = string_to_uint16(number);
-        if (next_number_end > next_number_start) {
-            next_number_start = next_number_end + 1;
-        }
-    }
-    return ESP_OK;
-}
-
-#if defined(CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN) && defined(CONFIG_ESP_MATTER_COMMISSIONER_ENABLE)
+#if HTTP_SERVER_BLE
 static int char_to_int(char ch)
 {
     if ('A' <= ch && ch <= 'F') {
@@ -495,7 +195,27 @@ static bool convert_hex_str_to_bytes(const char *hex_str, uint8_t *bytes, uint8_
     bytes_len = output_len;
     return true;
 }
-#endif // defined(CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN) && defined(CONFIG_ESP_MATTER_COMMISSIONER_ENABLE)
+#endif // HTTP_SERVER_BLE
+
+// Map a numeric status code to the status line esp_http_server expects
+static const char *http_status_line(int status_code) {
+    switch (status_code) {
+        case 200: return HTTPD_200;
+        case 202: return "202 Accepted";
+        case 400: return HTTPD_400;
+        case 404: return HTTPD_404;
+        case 408: return HTTPD_408;
+        case 409: return "409 Conflict";
+        case 413: return "413 Payload Too Large";
+        case 429: return "429 Too Many Requests";
+        case 500: return HTTPD_500;
+        case 501: return "501 Not Implemented";
+        case 502: return "502 Bad Gateway";
+        case 503: return "503 Service Unavailable";
+        case 507: return "507 Insufficient Storage";
+        default: return status_code >= 500 ? HTTPD_500 : HTTPD_400;
+    }
+}
 
 esp_err_t add_cors_headers(httpd_req_t *req) {
     if (!s_cors_enabled) {
@@ -511,19 +231,26 @@ esp_err_t add_cors_headers(httpd_req_t *req) {
 }
 
 esp_err_t send_json_response(httpd_req_t *req, cJSON *json, int status_code) {
+    // Stages up to here; printing is only accounted for in the Server-Timing header
+    if (cJSON_IsObject(json) && http_timing_requested(req)) {
+        cJSON_AddItemToObject(json, "timing", http_timing_to_json());
+    }
+    
+    http_stage_timer timer(HTTP_STAGE_SERIALIZE);
     char *json_string = cJSON_Print(json);
+    timer.stop();
     if (!json_string) {
         return ESP_ERR_NO_MEM;
     }
     
     add_cors_headers(req);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_set_status(req, status_code == 200 ? HTTPD_200 : 
-                                status_code == 400 ? HTTPD_400 :
-                                status_code == 500 ? HTTPD_500 : HTTPD_400);
+    httpd_resp_set_status(req, http_status_line(status_code));
+    http_endpoint_set_status(status_code);
+    http_timing_set_header(req);
     
     esp_err_t ret = httpd_resp_send(req, json_string, strlen(json_string));
-    free(json_string);
+    cJSON_free(json_string);
     return ret;
 }
 
@@ -541,26 +268,119 @@ esp_err_t send_error_response(httpd_req_t *req, int status_code, const char *err
     return ret;
 }
 
-esp_err_t parse_json_request(httpd_req_t *req, cJSON **json) {
-    if (req->content_len == 0) {
-        *json = cJSON_CreateObject();
-        return ESP_OK;
+// Send a body already encoded in one of the binary formats
+static esp_err_t send_encoded_response(httpd_req_t *req, http_encoding_t encoding, const uint8_t *body, size_t len,
+                                       int status_code) {
+    add_cors_headers(req);
+    httpd_resp_set_type(req, http_encoding_mime(encoding));
+    httpd_resp_set_status(req, http_status_line(status_code));
+    http_endpoint_set_status(status_code);
+    http_timing_set_header(req);
+    return httpd_resp_send(req, (const char *)body, len);
+}
+
+#define STATUS_RESPONSE_SIZE_MAX 160 // Encoded {status, message} reply
+
+// Reply {status, message} in the format negotiated with the client
+static esp_err_t send_status_response(httpd_req_t *req, http_encoding_t encoding, int status_code, const char *status,
+                                      const char *message) {
+    if (encoding == HTTP_ENCODING_JSON) {
+        cJSON *response = cJSON_CreateObject();
+        if (!response) {
+            return ESP_ERR_NO_MEM;
+        }
+        cJSON_AddStringToObject(response, "status", status);
+        cJSON_AddStringToObject(response, "message", message);
+        esp_err_t ret = send_json_response(req, response, status_code);
+        cJSON_Delete(response);
+        return ret;
+    }
+    
+    uint8_t body[STATUS_RESPONSE_SIZE_MAX];
+    size_t len = 0;
+    esp_err_t ret = http_encode_status(encoding, status, message, body, sizeof(body), &len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return send_encoded_response(req, encoding, body, len, status_code);
+}
+
+// Reply the records of a completed read in CBOR or TLV, straight from the ring without a cJSON tree
+static esp_err_t send_records_response(httpd_req_t *req, http_encoding_t encoding, pending_op *op) {
+    uint32_t count = pending_op_record_count(op);
+    size_t size = http_records_encoded_size(count);
+    uint8_t *buf = (uint8_t *)http_mem_alloc(size, HTTP_MEM_TRANSIENT);
+    if (!buf) {
+        return safe_send_error_response(req, 500, "Failed to allocate response");
     }
     
-    char *buf = (char *)malloc(req->content_len + 1);
+    size_t len = 0;
+    http_stage_timer timer(HTTP_STAGE_SERIALIZE);
+    esp_err_t ret = http_encode_records(encoding, op, buf, size, &len);
+    timer.stop();
+    if (ret == ESP_OK) {
+        ret = send_encoded_response(req, encoding, buf, len, 200);
+    } else {
+        ret = safe_send_error_response(req, 500, "Failed to encode response");
+    }
+    http_mem_free(buf);
+    return ret;
+}
+
+#define REQUEST_BODY_MAX 8192          // Larger bodies are refused before anything is allocated
+#define REQUEST_RECV_TIMEOUT_RETRIES 3 // Receive timeouts in a row before a slow body is given up
+
+// Read the request body into a NUL-terminated buffer to be released with http_mem_free().
+// An empty body reads as an empty object. Returns ESP_ERR_INVALID_SIZE above REQUEST_BODY_MAX.
+static esp_err_t read_request_body(httpd_req_t *req, char **body, size_t *len) {
+    if (req->content_len > REQUEST_BODY_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t size = req->content_len > 0 ? req->content_len : sizeof("{}") - 1;
+    char *buf = (char *)http_mem_alloc(size + 1, HTTP_MEM_TRANSIENT);
     if (!buf) {
         return ESP_ERR_NO_MEM;
     }
     
-    int received = httpd_req_recv(req, buf, req->content_len);
-    if (received <= 0) {
-        free(buf);
-        return ESP_ERR_INVALID_ARG;
+    if (req->content_len == 0) {
+        strcpy(buf, "{}");
+        *body = buf;
+        *len = size;
+        return ESP_OK;
+    }
+    
+    // A body split across TCP segments arrives over several calls
+    size_t received = 0;
+    int timeouts = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, buf + received, req->content_len - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT && ++timeouts < REQUEST_RECV_TIMEOUT_RETRIES) {
+            continue;
+        }
+        if (ret <= 0) {
+            http_mem_free(buf);
+            return ESP_ERR_INVALID_ARG;
+        }
+        received += ret;
+        timeouts = 0;
     }
     
     buf[received] = '\0';
+    *body = buf;
+    *len = received;
+    return ESP_OK;
+}
+
+esp_err_t parse_json_request(httpd_req_t *req, cJSON **json) {
+    char *buf = NULL;
+    size_t len = 0;
+    esp_err_t ret = read_request_body(req, &buf, &len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
     *json = cJSON_Parse(buf);
-    free(buf);
+    http_mem_free(buf);
     
     if (!*json) {
         return ESP_ERR_INVALID_ARG;
@@ -569,6 +389,67 @@ esp_err_t parse_json_request(httpd_req_t *req, cJSON **json) {
     return ESP_OK;
 }
 
+// Parse the request body and fill params from the schema. On failure err holds the message for a 400
+// and no JSON is returned; on success the caller owns *json, which the string params point into.
+template <typename S, typename... F>
+static bool parse_request_params(httpd_req_t *req, const std::tuple<F...> &fields, cJSON **json, S *params,
+                                 schema::error_t *err) {
+    http_stage_timer timer(HTTP_STAGE_PARSE);
+    esp_err_t ret = parse_json_request(req, json);
+    if (ret != ESP_OK) {
+        strlcpy(err->message, ret == ESP_ERR_INVALID_SIZE ? "Request body too large" : "Invalid JSON",
+                sizeof(err->message));
+        return false;
+    }
+    if (!schema::parse(*json, fields, params, err)) {
+        cJSON_Delete(*json);
+        *json = NULL;
+        return false;
+    }
+    return true;
+}
+
+#define FAST_PATH_MAX_TOKENS 32 // Enough for the flat bodies of the hot endpoints
+
+// Same as parse_request_params() without building a cJSON tree: the body is tokenized in place and the
+// schema reads the tokens. Bodies the tokenizer does not handle go through cJSON instead. On success the
+// string params point into *body or *json, which the caller releases once it is done with params.
+template <typename S, typename... F>
+static bool parse_request_params_fast(httpd_req_t *req, const std::tuple<F...> &fields, char **body, cJSON **json,
+                                      S *params, schema::error_t *err) {
+    http_stage_timer timer(HTTP_STAGE_PARSE);
+    size_t len = 0;
+    *json = NULL;
+    esp_err_t ret = read_request_body(req, body, &len);
+    if (ret != ESP_OK) {
+        *body = NULL;
+        strlcpy(err->message, ret == ESP_ERR_INVALID_SIZE ? "Request body too large" : "Invalid JSON",
+                sizeof(err->message));
+        return false;
+    }
+    
+    json_token_t tokens[FAST_PATH_MAX_TOKENS];
+    size_t count = 0;
+    bool ok;
+    if (json_tokenize(*body, len, tokens, FAST_PATH_MAX_TOKENS, &count) == JSON_TOKENIZE_OK &&
+        tokens[0].type == JSON_TOKEN_OBJECT) {
+        ok = schema::parse_value(token_value(*body, tokens, 0), fields, params, err);
+    } else if ((*json = cJSON_Parse(*body)) != NULL) {
+        ok = schema::parse(*json, fields, params, err);
+    } else {
+        strlcpy(err->message, "Invalid JSON", sizeof(err->message));
+        ok = false;
+    }
+    
+    if (!ok) {
+        cJSON_Delete(*json);
+        *json = NULL;
+        http_mem_free(*body);
+        *body = NULL;
+    }
+    return ok;
+}
+
 // OPTIONS handler for CORS preflight requests
 esp_err_t options_handler(httpd_req_t *req) {
     add_cors_headers(req);
@@ -577,615 +458,941 @@ esp_err_t options_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+#define HTTP_HELP_ENTRY(path, verb, fn, desc, params) \
+    "{\"path\":\"" path "\",\"method\":\"" #verb "\",\"description\":\"" desc "\",\"params\":" params "}"
+#define HTTP_HELP_NEXT_ENTRY(path, verb, fn, desc, params) "," HTTP_HELP_ENTRY(path, verb, fn, desc, params)
+
+// Generated from the route table, lives in flash
+static constexpr char s_help_json[] =
+    "{\"endpoints\":["
+    HTTP_SERVER_HELP_ROUTE(HTTP_HELP_ENTRY)
+    HTTP_SERVER_ROUTES(HTTP_HELP_NEXT_ENTRY)
+    "],\"version\":\"1.0.0\",\"description\":\"ESP Matter Controller REST API\"}";
+
 // API: GET /api/help - Get available endpoints
 esp_err_t help_handler(httpd_req_t *req) {
-    cJSON *json = cJSON_CreateObject();
-    cJSON *endpoints = cJSON_CreateArray();
-    
-    // Add all available endpoints
-    cJSON *endpoint;
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/pairing");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Pair a device to the controller");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/group-settings");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Manage controller groups and keysets");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/udc");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "UDC (User Directed Commissioning) commands");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/open-commissioning-window");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Open commissioning window on a device");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/invoke-command");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Invoke cluster command on a device");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/read-attribute");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Read device attributes");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/write-attribute");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Write device attributes");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/read-event");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Read device events");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/subscribe-attribute");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Subscribe to device attributes");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/subscribe-event");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Subscribe to device events");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/shutdown-subscription");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Shutdown specific subscription");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/shutdown-all-subscriptions");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Shutdown all subscriptions");
-    cJSON_AddItemToArray(endpoints, endpoint);
-    
-#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
-    endpoint = cJSON_CreateObject();
-    cJSON_AddStringToObject(endpoint, "path", "/api/ble-scan");
-    cJSON_AddStringToObject(endpoint, "method", "POST");
-    cJSON_AddStringToObject(endpoint, "description", "Scan for BLE devices");
-    cJSON_AddItemToArray(endpoints, endpoint);
-#endif
+    add_cors_headers(req);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_status(req, HTTPD_200);
+    return httpd_resp_send(req, s_help_json, sizeof(s_help_json) - 1);
+}
+
+// Reply 202 with the ID of a newly queued job; arg is released by the job subsystem
+static esp_err_t send_job_accepted(httpd_req_t *req, const char *type, job_fn_t fn, void *arg) {
+    uint32_t job_id = 0;
+    esp_err_t err = job_submit(type, fn, arg, &job_id);
+    if (err == ESP_ERR_NO_MEM) {
+        return send_error_response(req, 429, "Too many jobs in progress - please retry");
+    } else if (err != ESP_OK) {
+        return send_error_response(req, 500, "Failed to queue job");
+    }
+    
+    char location[32];
+    snprintf(location, sizeof(location), "/api/jobs/%" PRIu32, job_id);
+    
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddStringToObject(response, "status", "accepted");
+    cJSON_AddNumberToObject(response, "job_id", job_id);
+    cJSON_AddStringToObject(response, "location", location);
+    esp_err_t ret = send_json_response(req, response, 202);
+    cJSON_Delete(response);
+    return ret;
+}
+
+#define PAIRING_PASE_TIMEOUT_MS 60000
+#define PAIRING_COMMISSIONING_TIMEOUT_MS 120000
+
+// Worker running the only pairing the commissioner can handle at a time
+static std::atomic<TaskHandle_t> s_pairing_worker{nullptr};
+// Failure reason from the CHIP thread, guarded by s_pairing_error_lock
+static portMUX_TYPE s_pairing_error_lock = portMUX_INITIALIZER_UNLOCKED;
+static char s_pairing_error[96];
+
+// Pairing progress from the backend, BACKEND_PAIRING_* events
+static void pairing_event_callback(uint32_t event, const char *error) {
+    if (error) {
+        taskENTER_CRITICAL(&s_pairing_error_lock);
+        strlcpy(s_pairing_error, error, sizeof(s_pairing_error));
+        taskEXIT_CRITICAL(&s_pairing_error_lock);
+    }
+    TaskHandle_t worker = s_pairing_worker.load();
+    if (worker) {
+        xTaskNotify(worker, event, eSetBits);
+    }
+}
+
+// Wait until one of the events in mask is reported, returns the events seen
+static uint32_t pairing_wait_events(uint32_t mask, uint32_t timeout_ms) {
+    uint32_t events = 0;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    while ((events & mask) == 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            break;
+        }
+        uint32_t bits = 0;
+        if (xTaskNotifyWait(0, UINT32_MAX, &bits, timeout - elapsed) == pdTRUE) {
+            events |= bits;
+        }
+    }
+    return events;
+}
+
+static esp_err_t pairing_job(job_t *job, void *arg) {
+    backend_pairing_t *args = (backend_pairing_t *)arg;
+    TaskHandle_t expected = nullptr;
+    if (!s_pairing_worker.compare_exchange_strong(expected, xTaskGetCurrentTaskHandle())) {
+        job_set_error(job, "Another pairing is in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Drop events left over from a pairing that timed out on this worker
+    xTaskNotifyWait(0, UINT32_MAX, NULL, 0);
+    taskENTER_CRITICAL(&s_pairing_error_lock);
+    s_pairing_error[0] = '\0';
+    taskEXIT_CRITICAL(&s_pairing_error_lock);
+    
+    esp_err_t result = ESP_OK;
+    uint32_t events = 0;
+    
+    job_stage_begin(job, "request");
+    if (!acquire_matter_lock()) {
+        job_set_error(job, "Matter stack busy - timeout acquiring lock");
+        result = ESP_ERR_TIMEOUT;
+        goto exit;
+    }
+    result = http_backend()->start_pairing(*args, pairing_event_callback);
+    release_matter_lock();
+    if (result != ESP_OK) {
+        job_set_error(job, "Pairing command failed");
+        goto exit;
+    }
+    job_set_progress(job, 10);
+    
+    job_stage_begin(job, "pase");
+    events = pairing_wait_events(BACKEND_PAIRING_PASE_OK | BACKEND_PAIRING_PASE_FAILED | BACKEND_PAIRING_COMMISSIONED |
+                                 BACKEND_PAIRING_COMMISSIONING_FAILED, PAIRING_PASE_TIMEOUT_MS);
+    if (events == 0) {
+        job_set_error(job, "Timeout waiting for PASE session");
+        result = ESP_ERR_TIMEOUT;
+        goto exit;
+    }
+    job_set_progress(job, 40);
+    
+    job_stage_begin(job, "commissioning");
+    if ((events & (BACKEND_PAIRING_PASE_FAILED | BACKEND_PAIRING_COMMISSIONED | BACKEND_PAIRING_COMMISSIONING_FAILED)) == 0) {
+        events |= pairing_wait_events(BACKEND_PAIRING_COMMISSIONED | BACKEND_PAIRING_COMMISSIONING_FAILED,
+                                      PAIRING_COMMISSIONING_TIMEOUT_MS);
+    }
+    if (events & (BACKEND_PAIRING_PASE_FAILED | BACKEND_PAIRING_COMMISSIONING_FAILED)) {
+        char error[sizeof(s_pairing_error)];
+        taskENTER_CRITICAL(&s_pairing_error_lock);
+        strlcpy(error, s_pairing_error[0] ? s_pairing_error : "Pairing failed", sizeof(error));
+        taskEXIT_CRITICAL(&s_pairing_error_lock);
+        job_set_error(job, error);
+        result = ESP_FAIL;
+    } else if (events & BACKEND_PAIRING_COMMISSIONED) {
+        cJSON *job_result = cJSON_CreateObject();
+        cJSON_AddNumberToObject(job_result, "node_id", args->node_id);
+        job_set_result(job, job_result);
+    } else {
+        job_set_error(job, "Timeout waiting for commissioning to complete");
+        result = ESP_ERR_TIMEOUT;
+    }
+    
+exit:
+    s_pairing_worker.store(nullptr);
+    return result;
+}
+
+#define OCW_COMMAND_TIMEOUT_MS 10000
+
+static std::atomic<TaskHandle_t> s_ocw_worker{nullptr};
+static char s_ocw_manual_code[32];
+static char s_ocw_qr_code[64];
+
+static void ocw_open_callback(const char *manual_code, const char *qr_code) {
+    strlcpy(s_ocw_manual_code, manual_code ? manual_code : "", sizeof(s_ocw_manual_code));
+    strlcpy(s_ocw_qr_code, qr_code ? qr_code : "", sizeof(s_ocw_qr_code));
+    TaskHandle_t worker = s_ocw_worker.load();
+    if (worker) {
+        xTaskNotifyGive(worker);
+    }
+}
+
+static esp_err_t open_commissioning_window_job(job_t *job, void *arg) {
+    backend_ocw_t *args = (backend_ocw_t *)arg;
+    TaskHandle_t expected = nullptr;
+    if (!s_ocw_worker.compare_exchange_strong(expected, xTaskGetCurrentTaskHandle())) {
+        job_set_error(job, "Another commissioning window request is in progress");
+        return ESP_ERR_INVALID_STATE;
+    }
+    ulTaskNotifyTake(pdTRUE, 0);
+    s_ocw_manual_code[0] = '\0';
+    s_ocw_qr_code[0] = '\0';
+    
+    esp_err_t result = ESP_OK;
+    job_stage_begin(job, "request");
+    if (!acquire_matter_lock()) {
+        job_set_error(job, "Matter stack busy - timeout acquiring lock");
+        s_ocw_worker.store(nullptr);
+        return ESP_ERR_TIMEOUT;
+    }
+    result = http_backend()->open_commissioning_window(*args, OCW_COMMAND_TIMEOUT_MS, ocw_open_callback);
+    release_matter_lock();
+    if (result != ESP_OK) {
+        job_set_error(job, "Failed to open commissioning window");
+        s_ocw_worker.store(nullptr);
+        return result;
+    }
+    job_set_progress(job, 20);
+    
+    // The opener only reports success, so silence until its own timeout means failure
+    job_stage_begin(job, "response");
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(OCW_COMMAND_TIMEOUT_MS + 2000)) == 0) {
+        job_set_error(job, "No response from device");
+        result = ESP_ERR_TIMEOUT;
+    } else {
+        cJSON *job_result = cJSON_CreateObject();
+        cJSON_AddNumberToObject(job_result, "node_id", args->node_id);
+        cJSON_AddNumberToObject(job_result, "window_timeout", args->window_timeout);
+        if (s_ocw_manual_code[0] != '\0') {
+            cJSON_AddStringToObject(job_result, "manual_code", s_ocw_manual_code);
+        }
+        if (s_ocw_qr_code[0] != '\0') {
+            cJSON_AddStringToObject(job_result, "qr_code", s_ocw_qr_code);
+        }
+        job_set_result(job, job_result);
+    }
+    s_ocw_worker.store(nullptr);
+    return result;
+}
+
+typedef struct {
+    uint64_t node_id;
+    uint32_t deadline_ms;
+    size_t path_count;
+    uint32_t *cluster_ids; // The three lists follow the structure
+    uint32_t *attribute_ids;
+    uint16_t *endpoint_ids;
+} read_job_args_t;
+
+static esp_err_t read_attribute_job(job_t *job, void *arg) {
+    read_job_args_t *args = (read_job_args_t *)arg;
+    backend_paths_t paths = { args->endpoint_ids, args->path_count, args->cluster_ids, args->path_count,
+                              args->attribute_ids, args->path_count };
+    
+    // Armed from the worker, so completion wakes this task
+    pending_op *read_op = nullptr;
+    if (pending_op_arm(PENDING_OP_READ, args->node_id, read_ring_records(paths), &read_op) != ESP_OK) {
+        job_set_error(job, "Too many requests in flight");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    job_stage_begin(job, "request");
+    if (!acquire_matter_lock()) {
+        pending_op_release(read_op);
+        job_set_error(job, "Matter stack busy - timeout acquiring lock");
+        return ESP_ERR_TIMEOUT;
+    }
+    esp_err_t result = http_backend()->read_attributes(read_op, args->node_id, paths);
+    release_matter_lock();
+    if (result != ESP_OK) {
+        pending_op_release(read_op);
+        job_set_error(job, "Failed to send read attribute command");
+        return result;
+    }
+    
+    job_stage_begin(job, "read");
+    if (!pending_op_wait(read_op, pdMS_TO_TICKS(args->deadline_ms))) {
+        cancel_pending_op(read_op);
+    }
+    if (!pending_op_wait(read_op, 0)) {
+        job_set_error(job, "Timeout waiting for attribute data");
+        result = ESP_ERR_TIMEOUT;
+    } else if (read_op->status != ESP_OK) {
+        job_set_error(job, read_op->status == ESP_ERR_TIMEOUT ? "Failed to establish session with device" :
+                      "Read attribute failed");
+        result = read_op->status;
+    } else if (pending_op_incomplete(read_op)) {
+        job_set_error(job, READ_INCOMPLETE_MESSAGE);
+        result = ESP_ERR_NO_MEM;
+    } else {
+        cJSON *job_result = cJSON_CreateObject();
+        cJSON_AddItemToObject(job_result, "attributes", drain_records_to_json(read_op, true));
+        job_set_result(job, job_result);
+    }
+    pending_op_release(read_op);
+    return result;
+}
+
+#if HTTP_SERVER_BLE
+typedef struct {
+    uint16_t timeout;
+    bool show_details;
+} ble_scan_job_args_t;
+
+static esp_err_t ble_scan_job(job_t *job, void *arg) {
+    ble_scan_job_args_t *args = (ble_scan_job_args_t *)arg;
+    controller_backend *backend = http_backend();
+    
+    job_stage_begin(job, "start");
+    if (!acquire_matter_lock()) {
+        job_set_error(job, "Matter stack busy - timeout acquiring lock");
+        return ESP_ERR_TIMEOUT;
+    }
+    if (backend->ble_scan_running()) {
+        HTTP_LOGW(HTTP_LOG_SERVER, "BLE scan already in progress. Stopping previous scan...");
+        backend->ble_scan_stop();
+        release_matter_lock();
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (!acquire_matter_lock()) {
+            job_set_error(job, "Matter stack busy - timeout acquiring lock");
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    esp_err_t result = backend->ble_scan_start(args->timeout, args->show_details);
+    release_matter_lock();
+    if (result != ESP_OK) {
+        job_set_error(job, "Failed to start BLE scan");
+        return result;
+    }
+    
+    job_stage_begin(job, "scanning");
+    for (uint16_t elapsed = 0; elapsed < args->timeout; ++elapsed) {
+        job_set_progress(job, elapsed * 100 / args->timeout);
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        if (!acquire_matter_lock()) {
+            continue;
+        }
+        bool scanning = backend->ble_scan_running();
+        release_matter_lock();
+        if (!scanning) {
+            break;
+        }
+    }
     
-    cJSON_AddItemToObject(json, "endpoints", endpoints);
-    cJSON_AddStringToObject(json, "version", "1.0.0");
-    cJSON_AddStringToObject(json, "description", "ESP Matter Controller REST API");
+    cJSON *job_result = cJSON_CreateObject();
+    cJSON_AddNumberToObject(job_result, "timeout", args->timeout);
+    cJSON_AddBoolToObject(job_result, "show_details", args->show_details);
+    job_set_result(job, job_result);
+    return ESP_OK;
+}
+#endif // HTTP_SERVER_BLE
+
+// API: GET /api/debug/memory - Heap usage per region and request arena counters
+esp_err_t memory_handler(httpd_req_t *req) {
+    cJSON *json = http_mem_usage_to_json();
+    
+    http_arena_stats_t stats;
+    http_arena_get_stats(&stats);
+    cJSON *arenas = cJSON_AddObjectToObject(json, "arenas");
+    cJSON_AddNumberToObject(arenas, "count", HTTP_ARENA_COUNT);
+    cJSON_AddNumberToObject(arenas, "size", HTTP_ARENA_SIZE);
+    cJSON_AddNumberToObject(arenas, "scopes", stats.scopes);
+    cJSON_AddNumberToObject(arenas, "scopes_without_arena", stats.scopes_no_arena);
+    cJSON_AddNumberToObject(arenas, "allocations", stats.allocations);
+    cJSON_AddNumberToObject(arenas, "heap_fallbacks", stats.heap_fallbacks);
+    cJSON_AddNumberToObject(arenas, "peak_used", stats.peak_used);
     
     esp_err_t ret = send_json_response(req, json, 200);
     cJSON_Delete(json);
     return ret;
 }
 
-// API: POST /api/pairing - Pair device
-esp_err_t pairing_handler(httpd_req_t *req) {
-    cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+// API: GET /api/debug/endpoints - Heap and stack usage per endpoint
+esp_err_t endpoints_handler(httpd_req_t *req) {
+    cJSON *json = http_endpoints_to_json(HTTP_SERVER_STACK_SIZE);
+    esp_err_t ret = send_json_response(req, json, 200);
+    cJSON_Delete(json);
+    return ret;
+}
+
+// API: GET /api/debug/recent - Last requests kept by the flight recorder, newest first
+esp_err_t recent_handler(httpd_req_t *req) {
+    size_t limit = 0;
+    char query[32];
+    char value[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "limit", value, sizeof(value)) == ESP_OK) {
+        char *end = NULL;
+        limit = strtoul(value, &end, 10);
+        if (end == value || *end != '\0') {
+            return send_error_response(req, 400, "Invalid limit");
+        }
     }
     
-    cJSON *method = cJSON_GetObjectItem(json, "method");
-    if (!method || !cJSON_IsString(method)) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid 'method' field");
+    cJSON *json = http_recorder_to_json(limit);
+    if (!json) {
+        return send_error_response(req, 500, "Failed to allocate response");
+    }
+    esp_err_t ret = send_json_response(req, json, 200);
+    cJSON_Delete(json);
+    return ret;
+}
+
+// API: GET /api/debug/log - Log level per module and log ring counters
+esp_err_t log_handler(httpd_req_t *req) {
+    cJSON *json = http_log_to_json();
+    if (!json) {
+        return send_error_response(req, 500, "Failed to allocate response");
+    }
+    esp_err_t ret = send_json_response(req, json, 200);
+    cJSON_Delete(json);
+    return ret;
+}
+
+struct log_level_params {
+    const char *module;
+    const char *level;
+};
+
+static constexpr auto s_log_level_schema = schema::make(
+    schema::field("module", &log_level_params::module),
+    schema::field("level", &log_level_params::level));
+
+// API: POST /api/debug/log - Set the runtime log level of a module
+esp_err_t log_level_handler(httpd_req_t *req) {
+    cJSON *json = NULL;
+    log_level_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_log_level_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
+    }
+    esp_err_t result = http_log_set_level(params.module, params.level);
+    cJSON_Delete(json);
+    if (result != ESP_OK) {
+        return send_error_response(req, 400, "Unknown module or level");
+    }
+    return log_handler(req);
+}
+
+// API: GET /api/metrics - Request, Matter and resource metrics in Prometheus text format
+esp_err_t metrics_handler(httpd_req_t *req) {
+    add_cors_headers(req);
+    esp_err_t ret = http_metrics_send(req);
+    if (ret == ESP_ERR_NO_MEM) {
+        return send_error_response(req, 500, "Failed to allocate metrics buffer");
+    }
+    return ret;
+}
+
+// API: GET /api/jobs/{id} - Get the state of an asynchronous job
+esp_err_t jobs_handler(httpd_req_t *req) {
+    const char *prefix = "/api/jobs/";
+    const char *id_str = req->uri + strlen(prefix);
+    char *end = NULL;
+    unsigned long job_id = strtoul(id_str, &end, 10);
+    if (end == id_str || (*end != '\0' && *end != '?')) {
+        return send_error_response(req, 400, "Invalid job ID");
     }
     
-    cJSON *response = cJSON_CreateObject();
-    esp_err_t result = ESP_FAIL;
+    cJSON *json = job_to_json((uint32_t)job_id);
+    if (!json) {
+        return send_error_response(req, 404, "Job not found");
+    }
+    esp_err_t ret = send_json_response(req, json, 200);
+    cJSON_Delete(json);
+    return ret;
+}
+
+struct pairing_params {
+    const char *method;
+    uint64_t node_id;
+    schema::optional<uint32_t> pincode;
+    schema::optional<uint16_t> discriminator;
+    schema::optional<const char *> ssid;
+    schema::optional<const char *> password;
+    schema::optional<const char *> dataset;
+    schema::optional<const char *> payload;
+};
+
+static constexpr auto s_pairing_schema = schema::make(
+    schema::field("method", &pairing_params::method),
+    schema::field("node_id", &pairing_params::node_id),
+    schema::field("pincode", &pairing_params::pincode, 1, 99999998),
+    schema::field("discriminator", &pairing_params::discriminator, 0, 0xFFF),
+    schema::field("ssid", &pairing_params::ssid),
+    schema::field("password", &pairing_params::password),
+    schema::field("dataset", &pairing_params::dataset),
+    schema::field("payload", &pairing_params::payload));
+
+// API: POST /api/pairing - Pair device
+// Commissioning takes tens of seconds, so it runs as a job and the outcome is read from /api/jobs/{id}
+esp_err_t pairing_handler(httpd_req_t *req) {
+    cJSON *json = NULL;
+    pairing_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_pairing_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
+    }
     
-    if (strcmp(method->valuestring, "onnetwork") == 0) {
-        cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-        cJSON *pincode = cJSON_GetObjectItem(json, "pincode");
-        
-        if (!node_id || !pincode || !cJSON_IsNumber(node_id) || !cJSON_IsNumber(pincode)) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 400, "Missing or invalid node_id or pincode for onnetwork pairing");
-        }
-        
-        uint64_t nodeId = (uint64_t)node_id->valuedouble;
-        uint32_t pin = (uint32_t)pincode->valueint;
-        
-        // Lock Matter stack with timeout
-        if (!acquire_matter_lock()) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 500, "Matter stack busy - timeout acquiring lock");
-        }
-        
-        result = controller::pairing_on_network(nodeId, pin);
-        release_matter_lock();
-        
-    } else if (strcmp(method->valuestring, "ble-wifi") == 0) {
-#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
-        cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-        cJSON *ssid = cJSON_GetObjectItem(json, "ssid");
-        cJSON *password = cJSON_GetObjectItem(json, "password");
-        cJSON *pincode = cJSON_GetObjectItem(json, "pincode");
-        cJSON *discriminator = cJSON_GetObjectItem(json, "discriminator");
-        
-        if (!node_id || !ssid || !password || !pincode || !discriminator ||
-            !cJSON_IsNumber(node_id) || !cJSON_IsString(ssid) || !cJSON_IsString(password) ||
-            !cJSON_IsNumber(pincode) || !cJSON_IsNumber(discriminator) ||
-            !ssid->valuestring || !password->valuestring) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 400, "Missing or invalid parameters for ble-wifi pairing");
-        }
-        
-        uint64_t nodeId = (uint64_t)node_id->valuedouble;
-        uint32_t pin = (uint32_t)pincode->valueint;
-        uint16_t disc = (uint16_t)discriminator->valueint;
-        
-        if (!acquire_matter_lock()) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 500, "Matter stack busy - timeout acquiring lock");
-        }
-        
-        result = controller::pairing_ble_wifi(nodeId, pin, disc, ssid->valuestring, password->valuestring);
-        release_matter_lock();
-    } else if (strcmp(method->valuestring, "ble-thread") == 0) {
-        cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-        cJSON *dataset = cJSON_GetObjectItem(json, "dataset");
-        cJSON *pincode = cJSON_GetObjectItem(json, "pincode");
-        cJSON *discriminator = cJSON_GetObjectItem(json, "discriminator");
-        
-        if (!node_id || !dataset || !pincode || !discriminator ||
-            !cJSON_IsNumber(node_id) || !cJSON_IsString(dataset) || 
-            !cJSON_IsNumber(pincode) || !cJSON_IsNumber(discriminator)) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 400, "Missing or invalid parameters for ble-thread pairing");
+    backend_pairing_t *args = (backend_pairing_t *)calloc(1, sizeof(backend_pairing_t));
+    if (!args) {
+        cJSON_Delete(json);
+        return send_error_response(req, 500, "Failed to allocate pairing job");
+    }
+    args->node_id = params.node_id;
+    http_endpoint_set_node(params.node_id);
+    
+    bool valid = true;
+    if (strcmp(params.method, "onnetwork") == 0) {
+        valid = schema::require(params.pincode, "pincode", &err);
+        args->method = BACKEND_PAIRING_ON_NETWORK;
+        args->pincode = params.pincode.value;
+    } else if (strcmp(params.method, "ble-wifi") == 0) {
+#if HTTP_SERVER_BLE
+        valid = schema::require(params.pincode, "pincode", &err) &&
+            schema::require(params.discriminator, "discriminator", &err) &&
+            schema::require(params.ssid, "ssid", &err) && schema::require(params.password, "password", &err);
+        if (valid && (strlen(params.ssid.value) >= sizeof(args->ssid) ||
+                      strlen(params.password.value) >= sizeof(args->password))) {
+            strlcpy(err.message, "ssid or password too long", sizeof(err.message));
+            valid = false;
         }
-        
-        // Check if dataset string is not null
-        if (!dataset->valuestring || strlen(dataset->valuestring) == 0) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 400, "Dataset cannot be empty");
+        if (valid) {
+            args->method = BACKEND_PAIRING_BLE_WIFI;
+            args->pincode = params.pincode.value;
+            args->discriminator = params.discriminator.value;
+            strlcpy(args->ssid, params.ssid.value, sizeof(args->ssid));
+            strlcpy(args->password, params.password.value, sizeof(args->password));
         }
-        
-        uint8_t dataset_tlvs_buf[254];
-        uint8_t dataset_tlvs_len = sizeof(dataset_tlvs_buf);
-        if (!convert_hex_str_to_bytes(dataset->valuestring, dataset_tlvs_buf, dataset_tlvs_len)) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 400, "Invalid dataset format - must be hex string");
+    } else if (strcmp(params.method, "ble-thread") == 0) {
+        valid = schema::require(params.pincode, "pincode", &err) &&
+            schema::require(params.discriminator, "discriminator", &err) &&
+            schema::require(params.dataset, "dataset", &err);
+        args->dataset_len = sizeof(args->dataset);
+        if (valid && (params.dataset.value[0] == '\0' ||
+                      !convert_hex_str_to_bytes(params.dataset.value, args->dataset, args->dataset_len))) {
+            strlcpy(err.message, "Invalid dataset format - must be hex string", sizeof(err.message));
+            valid = false;
         }
-        
-        uint64_t nodeId = (uint64_t)node_id->valuedouble;
-        uint32_t pin = (uint32_t)pincode->valueint;
-        uint16_t disc = (uint16_t)discriminator->valueint;
-        
-        // Lock the Matter stack before calling pairing function
-        esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-        if (lock_status != esp_matter::lock::SUCCESS) {
-            ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 500, "Internal server error - failed to acquire lock");
+        if (valid) {
+            args->method = BACKEND_PAIRING_BLE_THREAD;
+            args->pincode = params.pincode.value;
+            args->discriminator = params.discriminator.value;
         }
-        
-        result = controller::pairing_ble_thread(nodeId, pin, disc, dataset_tlvs_buf, dataset_tlvs_len);
-        esp_matter::lock::chip_stack_unlock();
 #else
-        cJSON_Delete(json);
-        cJSON_Delete(response);
-        return send_error_response(req, 400, "BLE pairing not supported - CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN disabled");
+        strlcpy(err.message, "BLE pairing not supported - CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN disabled",
+                sizeof(err.message));
+        valid = false;
 #endif
-    } else if (strcmp(method->valuestring, "code") == 0) {
-        cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-        cJSON *payload = cJSON_GetObjectItem(json, "payload");
-        
-        if (!node_id || !payload || !cJSON_IsNumber(node_id) || !cJSON_IsString(payload) ||
-            !payload->valuestring) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 400, "Missing or invalid node_id or payload for code pairing");
+    } else if (strcmp(params.method, "code") == 0) {
+        valid = schema::require(params.payload, "payload", &err);
+        if (valid && strlen(params.payload.value) >= sizeof(args->payload)) {
+            strlcpy(err.message, "payload too long", sizeof(err.message));
+            valid = false;
         }
-        
-        uint64_t nodeId = (uint64_t)node_id->valuedouble;
-        
-        if (!acquire_matter_lock()) {
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 500, "Matter stack busy - timeout acquiring lock");
+        if (valid) {
+            args->method = BACKEND_PAIRING_CODE;
+            strlcpy(args->payload, params.payload.value, sizeof(args->payload));
         }
-        
-        result = controller::pairing_code(nodeId, payload->valuestring);
-        release_matter_lock();
-        
-    } else {
-        cJSON_Delete(json);
-        cJSON_Delete(response);
-        return send_error_response(req, 400, "Unsupported pairing method");
-    }
-    
-    if (result == ESP_OK) {
-        cJSON_AddStringToObject(response, "status", "success");
-        cJSON_AddStringToObject(response, "message", "Pairing command sent successfully");
     } else {
-        cJSON_AddStringToObject(response, "status", "error");
-        cJSON_AddStringToObject(response, "message", "Pairing command failed");
+        strlcpy(err.message, "Unsupported pairing method", sizeof(err.message));
+        valid = false;
     }
     
-    ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
     cJSON_Delete(json);
-    cJSON_Delete(response);
-    return ret;
+    if (!valid) {
+        free(args);
+        return send_error_response(req, 400, err.message);
+    }
+    return send_job_accepted(req, "pairing", pairing_job, args);
 }
 
+struct ocw_params {
+    uint64_t node_id;
+    uint8_t option;
+    uint16_t window_timeout;
+    uint32_t iteration;
+    uint16_t discriminator;
+};
+
+static constexpr auto s_ocw_schema = schema::make(
+    schema::field("node_id", &ocw_params::node_id),
+    schema::field("option", &ocw_params::option, 0, 1),
+    schema::field("window_timeout", &ocw_params::window_timeout),
+    schema::field("iteration", &ocw_params::iteration),
+    schema::field("discriminator", &ocw_params::discriminator, 0, 0xFFF));
+
 // API: POST /api/open-commissioning-window - Open commissioning window
 esp_err_t open_commissioning_window_handler(httpd_req_t *req) {
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+    ocw_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_ocw_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
     
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *option = cJSON_GetObjectItem(json, "option");
-    cJSON *window_timeout = cJSON_GetObjectItem(json, "window_timeout");
-    cJSON *iteration = cJSON_GetObjectItem(json, "iteration");
-    cJSON *discriminator = cJSON_GetObjectItem(json, "discriminator");
-    
-    if (!node_id || !option || !window_timeout || !iteration || !discriminator ||
-        !cJSON_IsNumber(node_id) || !cJSON_IsNumber(option) || !cJSON_IsNumber(window_timeout) ||
-        !cJSON_IsNumber(iteration) || !cJSON_IsNumber(discriminator)) {
+    backend_ocw_t *args = (backend_ocw_t *)calloc(1, sizeof(backend_ocw_t));
+    if (!args) {
         cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid required parameters");
+        return send_error_response(req, 500, "Failed to allocate commissioning window job");
     }
+    args->node_id = params.node_id;
+    http_endpoint_set_node(params.node_id);
+    args->is_enhanced = params.option == 1;
+    args->window_timeout = params.window_timeout;
+    args->iteration = params.iteration;
+    args->discriminator = params.discriminator;
     
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
-    uint8_t opt = (uint8_t)option->valueint;
-    bool is_enhanced = opt == 1;
-    uint16_t timeout = (uint16_t)window_timeout->valueint;
-    uint32_t iter = (uint32_t)iteration->valueint;
-    uint16_t disc = (uint16_t)discriminator->valueint;
-    
-    // Lock the Matter stack before calling commissioning window command
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
-        cJSON_Delete(json);
-        return send_error_response(req, 500, "Internal server error - failed to acquire lock");
+    cJSON_Delete(json);
+    return send_job_accepted(req, "open-commissioning-window", open_commissioning_window_job, args);
+}
+
+struct invoke_command_params {
+    uint64_t node_id;
+    uint16_t endpoint_id;
+    uint32_t cluster_id;
+    uint32_t command_id;
+    schema::optional<const char *> command_data;
+    schema::optional<uint16_t> timed_invoke_timeout_ms;
+};
+
+static constexpr auto s_invoke_command_schema = schema::make(
+    schema::field("node_id", &invoke_command_params::node_id),
+    schema::field("endpoint_id", &invoke_command_params::endpoint_id),
+    schema::field("cluster_id", &invoke_command_params::cluster_id),
+    schema::field("command_id", &invoke_command_params::command_id),
+    schema::field("command_data", &invoke_command_params::command_data),
+    schema::field("timed_invoke_timeout_ms", &invoke_command_params::timed_invoke_timeout_ms));
+
+#define INVOKE_QUERY_MAX 160 // Longest query string of a TLV invoke
+
+// The command path of a TLV invoke, read from the query string
+static constexpr auto s_invoke_tlv_schema = schema::make(
+    schema::field("node_id", &invoke_command_params::node_id),
+    schema::field("endpoint_id", &invoke_command_params::endpoint_id),
+    schema::field("cluster_id", &invoke_command_params::cluster_id),
+    schema::field("command_id", &invoke_command_params::command_id),
+    schema::field("timed_invoke_timeout_ms", &invoke_command_params::timed_invoke_timeout_ms));
+
+// POST /api/invoke-command with Content-Type: application/x-matter-tlv. The body holds the command fields
+// encoded by the client and goes into the InvokeRequest without being decoded.
+static esp_err_t invoke_tlv_command(httpd_req_t *req) {
+    http_stage_timer parse_timer(HTTP_STAGE_PARSE);
+    char query[INVOKE_QUERY_MAX];
+    size_t query_len = httpd_req_get_url_query_len(req);
+    if (query_len == 0 || query_len >= sizeof(query) ||
+        httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+        return send_error_response(req, 400, "Expected node_id, endpoint_id, cluster_id and command_id in the query");
+    }
+    
+    invoke_command_params params{};
+    schema::error_t err;
+    schema::query_value query_params(query, query_len);
+    if (!query_params.is_object()) {
+        return send_error_response(req, 400, "Invalid query string");
+    }
+    if (!schema::parse_value(query_params, s_invoke_tlv_schema, &params, &err)) {
+        return send_error_response(req, 400, err.message);
+    }
+    http_endpoint_set_node(params.node_id);
+    if (req->content_len == 0) {
+        return send_error_response(req, 400, "Missing TLV command fields");
     }
     
-    esp_err_t result = controller::commissioning_window_opener::get_instance().send_open_commissioning_window_command(
-        nodeId, is_enhanced, timeout, iter, disc, 10000);
-    esp_matter::lock::chip_stack_unlock();
+    char *body = NULL;
+    size_t len = 0;
+    esp_err_t ret = read_request_body(req, &body, &len);
+    if (ret == ESP_ERR_INVALID_SIZE) {
+        return send_error_response(req, 413, "TLV command fields too large");
+    } else if (ret != ESP_OK) {
+        return send_error_response(req, 400, "Failed to read request body");
+    }
+    parse_timer.stop();
     
-    cJSON *response = cJSON_CreateObject();
-    if (result == ESP_OK) {
-        cJSON_AddStringToObject(response, "status", "success");
-        cJSON_AddStringToObject(response, "message", "Commissioning window opened successfully");
-    } else {
-        cJSON_AddStringToObject(response, "status", "error");
-        cJSON_AddStringToObject(response, "message", "Failed to open commissioning window");
+    if (!acquire_matter_lock()) {
+        http_mem_free(body);
+        return send_error_response(req, 500, "Matter stack busy - timeout acquiring lock");
     }
+    esp_err_t result = http_backend()->invoke_tlv(params.node_id, params.endpoint_id, params.cluster_id,
+                                                  params.command_id, (const uint8_t *)body, len,
+                                                  params.timed_invoke_timeout_ms.value);
+    release_matter_lock();
+    http_mem_free(body);
     
-    ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
-    cJSON_Delete(json);
-    cJSON_Delete(response);
-    return ret;
+    if (result == ESP_ERR_INVALID_ARG) {
+        return send_error_response(req, 400, "Body must be a single anonymous TLV structure");
+    }
+    return send_status_response(req, http_accept_encoding(req), result == ESP_OK ? 200 : 500,
+                                result == ESP_OK ? "success" : "error",
+                                result == ESP_OK ? "Command invoked successfully" : "Failed to invoke command");
 }
 
 // API: POST /api/invoke-command - Invoke cluster command
+// Highest-rate endpoint, parsed through the tokenizer fast path
 esp_err_t invoke_command_handler(httpd_req_t *req) {
-    cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+    if (http_content_encoding(req) == HTTP_ENCODING_TLV) {
+        return invoke_tlv_command(req);
     }
     
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *endpoint_id = cJSON_GetObjectItem(json, "endpoint_id");
-    cJSON *cluster_id = cJSON_GetObjectItem(json, "cluster_id");
-    cJSON *command_id = cJSON_GetObjectItem(json, "command_id");
-    cJSON *command_data = cJSON_GetObjectItem(json, "command_data");
-    cJSON *timed_invoke_timeout = cJSON_GetObjectItem(json, "timed_invoke_timeout_ms");
-    
-    if (!node_id || !endpoint_id || !cluster_id || !command_id ||
-        !cJSON_IsNumber(node_id) || !cJSON_IsNumber(endpoint_id) ||
-        !cJSON_IsNumber(cluster_id) || !cJSON_IsNumber(command_id)) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid required parameters");
+    char *body = NULL;
+    cJSON *json = NULL;
+    invoke_command_params params{};
+    schema::error_t err;
+    if (!parse_request_params_fast(req, s_invoke_command_schema, &body, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
     
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
-    uint16_t epId = (uint16_t)endpoint_id->valueint;
-    uint32_t clusterId = (uint32_t)cluster_id->valueint;
-    uint32_t cmdId = (uint32_t)command_id->valueint;
-    
-    char *cmd_data_str = NULL;
-    if (command_data && cJSON_IsString(command_data)) {
-        cmd_data_str = command_data->valuestring;
-    }
+    uint64_t nodeId = params.node_id;
+    http_endpoint_set_node(nodeId);
+    uint16_t epId = params.endpoint_id;
+    uint32_t clusterId = params.cluster_id;
+    uint32_t cmdId = params.command_id;
+    const char *cmd_data_str = params.command_data.value;
     
     // Lock Matter stack with timeout
     if (!acquire_matter_lock()) {
         cJSON_Delete(json);
+        http_mem_free(body);
         return send_error_response(req, 500, "Matter stack busy - timeout acquiring lock");
     }
     
-    esp_err_t result;
-    if (timed_invoke_timeout && cJSON_IsNumber(timed_invoke_timeout) && timed_invoke_timeout->valueint > 0) {
-        result = controller::send_invoke_cluster_command(nodeId, epId, clusterId, cmdId, cmd_data_str,
-                                                        chip::MakeOptional((uint16_t)timed_invoke_timeout->valueint));
-    } else {
-        result = controller::send_invoke_cluster_command(nodeId, epId, clusterId, cmdId, cmd_data_str);
-    }
+    esp_err_t result = http_backend()->invoke(nodeId, epId, clusterId, cmdId, cmd_data_str,
+                                              params.timed_invoke_timeout_ms.value);
     release_matter_lock();
     
-    cJSON *response = cJSON_CreateObject();
-    if (result == ESP_OK) {
-        cJSON_AddStringToObject(response, "status", "success");
-        cJSON_AddStringToObject(response, "message", "Command invoked successfully");
-    } else {
-        cJSON_AddStringToObject(response, "status", "error");
-        cJSON_AddStringToObject(response, "message", "Failed to invoke command");
-    }
-    
-    ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
+    // The command data has been encoded, the request is no longer needed
     cJSON_Delete(json);
-    cJSON_Delete(response);
-    return ret;
+    http_mem_free(body);
+    
+    return send_status_response(req, http_accept_encoding(req), result == ESP_OK ? 200 : 500,
+                                result == ESP_OK ? "success" : "error",
+                                result == ESP_OK ? "Command invoked successfully" : "Failed to invoke command");
 }
 
+struct read_attribute_params {
+    uint64_t node_id;
+    schema::array<uint16_t> endpoint_ids;
+    schema::array<uint32_t> cluster_ids;
+    schema::array<uint32_t> attribute_ids;
+    schema::optional<uint32_t> timeout_ms;
+    schema::optional<bool> async;
+};
+
+static constexpr auto s_read_attribute_schema = schema::make(
+    schema::field("node_id", &read_attribute_params::node_id),
+    schema::field("endpoint_ids", &read_attribute_params::endpoint_ids),
+    schema::field("cluster_ids", &read_attribute_params::cluster_ids),
+    schema::field("attribute_ids", &read_attribute_params::attribute_ids),
+    schema::field("timeout_ms", &read_attribute_params::timeout_ms, READ_MIN_TIMEOUT_MS, READ_MAX_TIMEOUT_MS),
+    schema::field("async", &read_attribute_params::async));
+
 // API: POST /api/read-attribute - Read attributes
 esp_err_t read_attribute_handler(httpd_req_t *req) {
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return safe_send_error_response(req, 400, "Invalid JSON");
+    read_attribute_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_read_attribute_schema, &json, &params, &err)) {
+        return safe_send_error_response(req, 400, err.message);
     }
+    esp_err_t ret;
     
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *endpoint_ids = cJSON_GetObjectItem(json, "endpoint_ids");
-    cJSON *cluster_ids = cJSON_GetObjectItem(json, "cluster_ids");
-    cJSON *attribute_ids = cJSON_GetObjectItem(json, "attribute_ids");
+    uint64_t nodeId = params.node_id;
+    http_endpoint_set_node(nodeId);
+    schema::array<uint16_t> &ep_ids = params.endpoint_ids;
+    schema::array<uint32_t> &cl_ids = params.cluster_ids;
+    schema::array<uint32_t> &attr_ids = params.attribute_ids;
     
-    if (!node_id || !endpoint_ids || !cluster_ids || !attribute_ids ||
-        !cJSON_IsNumber(node_id) || !cJSON_IsArray(endpoint_ids) ||
-        !cJSON_IsArray(cluster_ids) || !cJSON_IsArray(attribute_ids)) {
-        cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Missing or invalid required parameters");
-    }
-    
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
-    
-    ScopedMemoryBufferWithSize<uint16_t> ep_ids;
-    ScopedMemoryBufferWithSize<uint32_t> cl_ids;
-    ScopedMemoryBufferWithSize<uint32_t> attr_ids;
+    // Client deadline for the whole read, after which the interaction is aborted
+    uint32_t deadline_ms = params.timeout_ms.present ? params.timeout_ms.value : READ_DEFAULT_TIMEOUT_MS;
+    http_encoding_t encoding = http_accept_encoding(req);
     
     esp_err_t result = ESP_FAIL;
     
-    // Pre-validate and allocate all arrays before acquiring lock
-    if (json_array_to_uint16_array(endpoint_ids, ep_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Invalid endpoint_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(cluster_ids, cl_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Invalid cluster_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(attribute_ids, attr_ids) != ESP_OK) {
+    if (params.async.value) {
+        size_t path_count = ep_ids.size();
+        if (cl_ids.size() != path_count || attr_ids.size() != path_count) {
+            cJSON_Delete(json);
+            return safe_send_error_response(req, 400, "endpoint_ids, cluster_ids and attribute_ids must have the same length");
+        }
+        read_job_args_t *args = (read_job_args_t *)calloc(1, sizeof(read_job_args_t) + path_count *
+                                                          (2 * sizeof(uint32_t) + sizeof(uint16_t)));
+        if (!args) {
+            cJSON_Delete(json);
+            return safe_send_error_response(req, 500, "Failed to allocate read job");
+        }
+        args->node_id = nodeId;
+        args->deadline_ms = deadline_ms;
+        args->path_count = path_count;
+        args->cluster_ids = (uint32_t *)(args + 1);
+        args->attribute_ids = args->cluster_ids + path_count;
+        args->endpoint_ids = (uint16_t *)(args->attribute_ids + path_count);
+        memcpy(args->cluster_ids, cl_ids.data(), path_count * sizeof(uint32_t));
+        memcpy(args->attribute_ids, attr_ids.data(), path_count * sizeof(uint32_t));
+        memcpy(args->endpoint_ids, ep_ids.data(), path_count * sizeof(uint16_t));
         cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Invalid attribute_ids format - must be array of numbers");
+        return send_job_accepted(req, "read-attribute", read_attribute_job, args);
     }
     
-    // Initialize the read results mutex if not already done
-    init_read_results_mutex();
-    
-    // Create result structure to capture attribute data
-    uint32_t expected_count = ep_ids.AllocatedSize();
-    ReadAttributeResult *read_result = new ReadAttributeResult(expected_count);
-    
-    // Store the result in the global map
-    if (xSemaphoreTake(s_read_results_mutex, pdMS_TO_TICKS(5000)) == pdTRUE) {
-        s_read_results[nodeId] = read_result;
-        xSemaphoreGive(s_read_results_mutex);
-    } else {
-        delete read_result;
+    // Arm a result slot so the CHIP callbacks have somewhere to put the reports
+    backend_paths_t paths = make_paths(ep_ids, cl_ids, attr_ids);
+    pending_op *read_op = nullptr;
+    esp_err_t arm_err = pending_op_arm(PENDING_OP_READ, nodeId, read_ring_records(paths), &read_op);
+    if (arm_err != ESP_OK) {
         cJSON_Delete(json);
-        return safe_send_error_response(req, 500, "Internal server error - mutex timeout");
+        return safe_send_error_response(req, 429, "Too many requests in flight - please retry");
     }
     
     // Try to acquire lock with shorter timeout
     if (!acquire_matter_lock()) {
-        // Clean up
-        if (xSemaphoreTake(s_read_results_mutex, pdMS_TO_TICKS(5000)) == pdTRUE) {
-            s_read_results.erase(nodeId);
-            xSemaphoreGive(s_read_results_mutex);
-        }
-        delete read_result;
+        pending_op_release(read_op);
         cJSON_Delete(json);
         return safe_send_error_response(req, 503, "Matter stack busy - please retry");
     }
     
     // Execute command with callbacks
-    result = send_read_attr_command_with_callbacks(nodeId, ep_ids, cl_ids, attr_ids);
+    result = http_backend()->read_attributes(read_op, nodeId, paths);
     
     // Release lock immediately after command
     release_matter_lock();
     
     cJSON *response = cJSON_CreateObject();
     if (!response) {
-        // Clean up
-        if (xSemaphoreTake(s_read_results_mutex, pdMS_TO_TICKS(5000)) == pdTRUE) {
-            s_read_results.erase(nodeId);
-            xSemaphoreGive(s_read_results_mutex);
-        }
-        delete read_result;
+        cancel_pending_op(read_op);
+        pending_op_release(read_op);
         cJSON_Delete(json);
         return safe_send_error_response(req, 500, "Failed to create response");
     }
     
     if (result == ESP_OK) {
-        // Wait for the read operation to complete (with timeout)
-        if (xSemaphoreTake(read_result->semaphore, pdMS_TO_TICKS(10000)) == pdTRUE) {
+        // Wait for the read operation to complete, aborting it on deadline or disconnect
+        wait_outcome_t outcome = wait_for_pending_op(req, read_op, deadline_ms);
+        // The operation was completed or cancelled, the CHIP thread no longer times it
+        http_timing_merge(read_op->timing);
+        if (outcome == WAIT_CLIENT_GONE) {
+            HTTP_LOGW(HTTP_LOG_SERVER, "Client disconnected during read from node 0x%" PRIx64, nodeId);
+            ret = ESP_FAIL;
+        } else if (outcome == WAIT_COMPLETED && read_op->status != ESP_OK) {
+            ret = send_status_response(req, encoding, 502, "error", read_op->status == ESP_ERR_TIMEOUT ?
+                                       "Failed to establish session with device" : "Read attribute failed");
+        } else if (outcome == WAIT_COMPLETED && pending_op_incomplete(read_op)) {
+            // Never answer 200 with part of the attributes missing
+            ret = send_status_response(req, encoding, 507, "error", READ_INCOMPLETE_MESSAGE);
+        } else if (outcome == WAIT_COMPLETED && encoding != HTTP_ENCODING_JSON) {
+            ret = send_records_response(req, encoding, read_op);
+        } else if (outcome == WAIT_COMPLETED) {
             // Read operation completed successfully
             cJSON_AddStringToObject(response, "status", "success");
             cJSON_AddStringToObject(response, "message", "Read attribute completed successfully");
             
             // Add the actual attribute data to the response
-            cJSON *data_copy = cJSON_Duplicate(read_result->attribute_data, true);
-            cJSON_AddItemToObject(response, "attributes", data_copy);
+            cJSON_AddItemToObject(response, "attributes", drain_records_to_json(read_op, true));
             
             ret = send_json_response(req, response, 200);
         } else {
             // Timeout waiting for response
-            cJSON_AddStringToObject(response, "status", "timeout");
-            cJSON_AddStringToObject(response, "message", "Timeout waiting for attribute data");
-            ret = send_json_response(req, response, 408);
+            ret = send_status_response(req, encoding, 408, "timeout", "Timeout waiting for attribute data");
         }
     } else {
-        cJSON_AddStringToObject(response, "status", "error");
-        cJSON_AddStringToObject(response, "message", "Failed to send read attribute command");
-        ret = send_json_response(req, response, 500);
+        ret = send_status_response(req, encoding, 500, "error", "Failed to send read attribute command");
     }
     
     // Clean up
-    if (xSemaphoreTake(s_read_results_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        s_read_results.erase(nodeId);
-        xSemaphoreGive(s_read_results_mutex);
-    }
-    delete read_result;
+    pending_op_release(read_op);
     cJSON_Delete(json);
     cJSON_Delete(response);
     return ret;
 }
 
+struct write_attribute_params {
+    uint64_t node_id;
+    schema::array<uint16_t> endpoint_ids;
+    schema::array<uint32_t> cluster_ids;
+    schema::array<uint32_t> attribute_ids;
+    const char *attribute_value;
+    schema::optional<uint16_t> timed_write_timeout_ms;
+    schema::optional<uint32_t> timeout_ms;
+};
+
+static constexpr auto s_write_attribute_schema = schema::make(
+    schema::field("node_id", &write_attribute_params::node_id),
+    schema::field("endpoint_ids", &write_attribute_params::endpoint_ids),
+    schema::field("cluster_ids", &write_attribute_params::cluster_ids),
+    schema::field("attribute_ids", &write_attribute_params::attribute_ids),
+    schema::field("attribute_value", &write_attribute_params::attribute_value),
+    schema::field("timed_write_timeout_ms", &write_attribute_params::timed_write_timeout_ms),
+    schema::field("timeout_ms", &write_attribute_params::timeout_ms, READ_MIN_TIMEOUT_MS, READ_MAX_TIMEOUT_MS));
+
 // API: POST /api/write-attribute - Write attributes
 esp_err_t write_attribute_handler(httpd_req_t *req) {
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return safe_send_error_response(req, 400, "Invalid JSON");
-    }
-    
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *endpoint_ids = cJSON_GetObjectItem(json, "endpoint_ids");
-    cJSON *cluster_ids = cJSON_GetObjectItem(json, "cluster_ids");
-    cJSON *attribute_ids = cJSON_GetObjectItem(json, "attribute_ids");
-    cJSON *attribute_value = cJSON_GetObjectItem(json, "attribute_value");
-    cJSON *timed_write_timeout = cJSON_GetObjectItem(json, "timed_write_timeout_ms");
-    
-    if (!node_id || !endpoint_ids || !cluster_ids || !attribute_ids || !attribute_value ||
-        !cJSON_IsNumber(node_id) || !cJSON_IsArray(endpoint_ids) ||
-        !cJSON_IsArray(cluster_ids) || !cJSON_IsArray(attribute_ids) ||
-        !cJSON_IsString(attribute_value) || !attribute_value->valuestring) {
-        cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Missing or invalid required parameters");
+    write_attribute_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_write_attribute_schema, &json, &params, &err)) {
+        return safe_send_error_response(req, 400, err.message);
     }
+    esp_err_t ret;
     
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
+    uint64_t nodeId = params.node_id;
+    http_endpoint_set_node(nodeId);
+    schema::array<uint16_t> &ep_ids = params.endpoint_ids;
+    schema::array<uint32_t> &cl_ids = params.cluster_ids;
+    schema::array<uint32_t> &attr_ids = params.attribute_ids;
     
-    ScopedMemoryBufferWithSize<uint16_t> ep_ids;
-    ScopedMemoryBufferWithSize<uint32_t> cl_ids;
-    ScopedMemoryBufferWithSize<uint32_t> attr_ids;
+    // Client deadline for the whole write, after which the interaction is aborted
+    uint32_t deadline_ms = params.timeout_ms.present ? params.timeout_ms.value : WRITE_DEFAULT_TIMEOUT_MS;
     
     esp_err_t result = ESP_FAIL;
     
-    // Pre-validate and allocate all arrays before acquiring lock
-    if (json_array_to_uint16_array(endpoint_ids, ep_ids) != ESP_OK) {
+    // Arm a result slot for the per-attribute write statuses
+    pending_op *write_op = nullptr;
+    esp_err_t arm_err = pending_op_arm(PENDING_OP_WRITE, nodeId, ep_ids.size(), &write_op);
+    if (arm_err == ESP_ERR_INVALID_STATE) {
         cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Invalid endpoint_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(cluster_ids, cl_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Invalid cluster_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(attribute_ids, attr_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return safe_send_error_response(req, 400, "Invalid attribute_ids format - must be array of numbers");
-    }
-    
-    // Initialize the write results mutex if not already done
-    init_write_results_mutex();
-    
-    // Create result structure to capture write results
-    uint32_t expected_count = ep_ids.AllocatedSize();
-    WriteAttributeResult *write_result = new WriteAttributeResult(expected_count);
-    
-    // Store the result in the global map
-    if (xSemaphoreTake(s_write_results_mutex, pdMS_TO_TICKS(5000)) == pdTRUE) {
-        s_write_results[nodeId] = write_result;
-        xSemaphoreGive(s_write_results_mutex);
-    } else {
-        delete write_result;
+        return safe_send_error_response(req, 409, "A write is already in progress for this node");
+    } else if (arm_err != ESP_OK) {
         cJSON_Delete(json);
-        return safe_send_error_response(req, 500, "Internal server error - mutex timeout");
+        return safe_send_error_response(req, 429, "Too many requests in flight - please retry");
     }
     
     // Try to acquire lock with shorter timeout
     if (!acquire_matter_lock()) {
-        // Clean up
-        if (xSemaphoreTake(s_write_results_mutex, pdMS_TO_TICKS(5000)) == pdTRUE) {
-            s_write_results.erase(nodeId);
-            xSemaphoreGive(s_write_results_mutex);
-        }
-        delete write_result;
+        pending_op_release(write_op);
         cJSON_Delete(json);
         return safe_send_error_response(req, 503, "Matter stack busy - please retry");
     }
     
     // Execute command with callbacks
-    chip::Optional<uint16_t> timeout = chip::NullOptional;
-    if (timed_write_timeout && cJSON_IsNumber(timed_write_timeout) && timed_write_timeout->valueint > 0) {
-        timeout = chip::MakeOptional((uint16_t)timed_write_timeout->valueint);
-    }
-    
-    result = send_write_attr_command_with_callbacks(nodeId, ep_ids, cl_ids, attr_ids, attribute_value->valuestring, timeout);
+    int64_t write_start_us = esp_timer_get_time();
+    result = http_backend()->write_attributes(write_op, nodeId, make_paths(ep_ids, cl_ids, attr_ids),
+                                              params.attribute_value, params.timed_write_timeout_ms.value);
     
     // Release lock immediately after command
     release_matter_lock();
     
     cJSON *response = cJSON_CreateObject();
     if (!response) {
-        // Clean up
-        if (xSemaphoreTake(s_write_results_mutex, pdMS_TO_TICKS(5000)) == pdTRUE) {
-            s_write_results.erase(nodeId);
-            xSemaphoreGive(s_write_results_mutex);
-        }
-        delete write_result;
+        cancel_pending_op(write_op);
+        pending_op_release(write_op);
         cJSON_Delete(json);
         return safe_send_error_response(req, 500, "Failed to create response");
     }
     
     if (result == ESP_OK) {
-        // Wait for the write operation to complete (with timeout)
-        if (xSemaphoreTake(write_result->semaphore, pdMS_TO_TICKS(10000)) == pdTRUE) {
+        // Wait for the write statuses, aborting the write on timeout or disconnect
+        wait_outcome_t outcome = wait_for_pending_op(req, write_op, deadline_ms);
+        uint32_t write_us = http_elapsed_us(write_start_us);
+        bool completed = outcome == WAIT_COMPLETED;
+        http_metrics_observe_matter(MATTER_OP_WRITE, write_us, completed && write_op->status == ESP_OK);
+        // The write looks up its session itself, so CASE is part of the device's share
+        http_timing_add(HTTP_STAGE_DEVICE, write_us);
+        if (outcome == WAIT_CLIENT_GONE) {
+            HTTP_LOGW(HTTP_LOG_SERVER, "Client disconnected during write to node 0x%" PRIx64, nodeId);
+            ret = ESP_FAIL;
+        } else if (completed && write_op->status != ESP_OK) {
+            cJSON_AddStringToObject(response, "status", "error");
+            cJSON_AddStringToObject(response, "message", write_op->status == ESP_ERR_TIMEOUT ?
+                                    "Failed to establish session with device" : "Write attribute failed");
+            ret = send_json_response(req, response, 502);
+        } else if (completed) {
             // Write operation completed successfully
             cJSON_AddStringToObject(response, "status", "success");
             cJSON_AddStringToObject(response, "message", "Write attribute completed successfully");
             
             // Add the actual write results to the response
-            cJSON *data_copy = cJSON_Duplicate(write_result->write_results, true);
-            cJSON_AddItemToObject(response, "write_results", data_copy);
+            cJSON_AddItemToObject(response, "write_results", drain_records_to_json(write_op, false));
             
             ret = send_json_response(req, response, 200);
         } else {
@@ -1194,6 +1401,10 @@ esp_err_t write_attribute_handler(httpd_req_t *req) {
             cJSON_AddStringToObject(response, "message", "Timeout waiting for write completion");
             ret = send_json_response(req, response, 408);
         }
+    } else if (result == ESP_ERR_INVALID_ARG) {
+        cJSON_AddStringToObject(response, "status", "error");
+        cJSON_AddStringToObject(response, "message", "Invalid attribute_value");
+        ret = send_json_response(req, response, 400);
     } else {
         cJSON_AddStringToObject(response, "status", "error");
         cJSON_AddStringToObject(response, "message", "Failed to send write attribute command");
@@ -1201,70 +1412,48 @@ esp_err_t write_attribute_handler(httpd_req_t *req) {
     }
     
     // Clean up
-    if (xSemaphoreTake(s_write_results_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        s_write_results.erase(nodeId);
-        xSemaphoreGive(s_write_results_mutex);
-    }
-    delete write_result;
+    pending_op_release(write_op);
     cJSON_Delete(json);
     cJSON_Delete(response);
     return ret;
 }
 
+struct read_event_params {
+    uint64_t node_id;
+    schema::array<uint16_t> endpoint_ids;
+    schema::array<uint32_t> cluster_ids;
+    schema::array<uint32_t> event_ids;
+};
+
+static constexpr auto s_read_event_schema = schema::make(
+    schema::field("node_id", &read_event_params::node_id),
+    schema::field("endpoint_ids", &read_event_params::endpoint_ids),
+    schema::field("cluster_ids", &read_event_params::cluster_ids),
+    schema::field("event_ids", &read_event_params::event_ids));
+
 // API: POST /api/read-event - Read events
 esp_err_t read_event_handler(httpd_req_t *req) {
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
-    }
-    
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *endpoint_ids = cJSON_GetObjectItem(json, "endpoint_ids");
-    cJSON *cluster_ids = cJSON_GetObjectItem(json, "cluster_ids");
-    cJSON *event_ids = cJSON_GetObjectItem(json, "event_ids");
-    
-    if (!node_id || !endpoint_ids || !cluster_ids || !event_ids ||
-        !cJSON_IsNumber(node_id) || !cJSON_IsArray(endpoint_ids) ||
-        !cJSON_IsArray(cluster_ids) || !cJSON_IsArray(event_ids)) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid required parameters");
+    read_event_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_read_event_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
-    
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
-    
-    ScopedMemoryBufferWithSize<uint16_t> ep_ids;
-    ScopedMemoryBufferWithSize<uint32_t> cl_ids;
-    ScopedMemoryBufferWithSize<uint32_t> ev_ids;
+    http_endpoint_set_node(params.node_id);
+    esp_err_t ret;
     
     esp_err_t result = ESP_FAIL;
     
-    // Pre-validate and allocate all arrays before acquiring lock
-    if (json_array_to_uint16_array(endpoint_ids, ep_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid endpoint_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(cluster_ids, cl_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid cluster_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(event_ids, ev_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid event_ids format - must be array of numbers");
-    }
-    
     // Lock the Matter stack before calling read event command
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
         cJSON_Delete(json);
         return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
     
-    result = controller::send_read_event_command(nodeId, ep_ids, cl_ids, ev_ids);
-    esp_matter::lock::chip_stack_unlock();
+    result = http_backend()->read_events(params.node_id,
+                                         make_paths(params.endpoint_ids, params.cluster_ids, params.event_ids));
+    http_backend()->unlock();
     
     cJSON *response = cJSON_CreateObject();
     if (!response) {
@@ -1286,193 +1475,169 @@ esp_err_t read_event_handler(httpd_req_t *req) {
     return ret;
 }
 
-// API: POST /api/subscribe-attribute - Subscribe to attributes
-esp_err_t subscribe_attribute_handler(httpd_req_t *req) {
-    cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
-    }
-    
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *endpoint_ids = cJSON_GetObjectItem(json, "endpoint_ids");
-    cJSON *cluster_ids = cJSON_GetObjectItem(json, "cluster_ids");
-    cJSON *attribute_ids = cJSON_GetObjectItem(json, "attribute_ids");
-    cJSON *min_interval = cJSON_GetObjectItem(json, "min_interval");
-    cJSON *max_interval = cJSON_GetObjectItem(json, "max_interval");
-    
-    if (!node_id || !endpoint_ids || !cluster_ids || !attribute_ids || !min_interval || !max_interval ||
-        !cJSON_IsNumber(node_id) || !cJSON_IsArray(endpoint_ids) ||
-        !cJSON_IsArray(cluster_ids) || !cJSON_IsArray(attribute_ids) ||
-        !cJSON_IsNumber(min_interval) || !cJSON_IsNumber(max_interval)) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid required parameters");
-    }
-    
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
-    uint16_t minInterval = (uint16_t)min_interval->valueint;
-    uint16_t maxInterval = (uint16_t)max_interval->valueint;
-    
-    ScopedMemoryBufferWithSize<uint16_t> ep_ids;
-    ScopedMemoryBufferWithSize<uint32_t> cl_ids;
-    ScopedMemoryBufferWithSize<uint32_t> attr_ids;
-    
-    esp_err_t result = ESP_FAIL;
-    
-    // Pre-validate and allocate all arrays before acquiring lock
-    if (json_array_to_uint16_array(endpoint_ids, ep_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid endpoint_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(cluster_ids, cl_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid cluster_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(attribute_ids, attr_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid attribute_ids format - must be array of numbers");
-    }
-    
-    // Lock the Matter stack before calling subscribe attribute command
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
-        cJSON_Delete(json);
+// Register a subscription, shared with other clients when possible, for both subscribe endpoints
+static esp_err_t start_subscription(httpd_req_t *req, uint64_t node_id, bool events, const backend_paths_t &paths,
+                                    uint16_t min_interval, uint16_t max_interval) {
+    const char *kind = events ? "event" : "attribute";
+    
+    // Lock the Matter stack before calling subscribe command
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
         return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
     
-    result = controller::send_subscribe_attr_command(nodeId, ep_ids, cl_ids, attr_ids, minInterval, maxInterval);
-    esp_matter::lock::chip_stack_unlock();
-    
-    cJSON *response = cJSON_CreateObject();
-    if (!response) {
-        cJSON_Delete(json);
-        return send_error_response(req, 500, "Failed to create response");
-    }
-    if (result == ESP_OK) {
-        cJSON_AddStringToObject(response, "status", "success");
-        cJSON_AddStringToObject(response, "message", "Subscribe attribute command sent successfully");
-    } else {
-        cJSON_AddStringToObject(response, "status", "error");
-        cJSON_AddStringToObject(response, "message", "Failed to send subscribe attribute command");
-    }
-    
-    ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
-    cJSON_Delete(json);
-    cJSON_Delete(response);
-    return ret;
-}
-
-// API: POST /api/subscribe-event - Subscribe to events
-esp_err_t subscribe_event_handler(httpd_req_t *req) {
-    cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
-    }
-    
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *endpoint_ids = cJSON_GetObjectItem(json, "endpoint_ids");
-    cJSON *cluster_ids = cJSON_GetObjectItem(json, "cluster_ids");
-    cJSON *event_ids = cJSON_GetObjectItem(json, "event_ids");
-    cJSON *min_interval = cJSON_GetObjectItem(json, "min_interval");
-    cJSON *max_interval = cJSON_GetObjectItem(json, "max_interval");
-    
-    if (!node_id || !endpoint_ids || !cluster_ids || !event_ids || !min_interval || !max_interval ||
-        !cJSON_IsNumber(node_id) || !cJSON_IsArray(endpoint_ids) ||
-        !cJSON_IsArray(cluster_ids) || !cJSON_IsArray(event_ids) ||
-        !cJSON_IsNumber(min_interval) || !cJSON_IsNumber(max_interval)) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid required parameters");
-    }
-    
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
-    uint16_t minInterval = (uint16_t)min_interval->valueint;
-    uint16_t maxInterval = (uint16_t)max_interval->valueint;
-    
-    ScopedMemoryBufferWithSize<uint16_t> ep_ids;
-    ScopedMemoryBufferWithSize<uint32_t> cl_ids;
-    ScopedMemoryBufferWithSize<uint32_t> ev_ids;
-    
-    esp_err_t result = ESP_FAIL;
-    
-    // Pre-validate and allocate all arrays before acquiring lock
-    if (json_array_to_uint16_array(endpoint_ids, ep_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid endpoint_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(cluster_ids, cl_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid cluster_ids format - must be array of numbers");
-    }
-    
-    if (json_array_to_uint32_array(event_ids, ev_ids) != ESP_OK) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Invalid event_ids format - must be array of numbers");
-    }
-    
-    // Lock the Matter stack before calling subscribe event command
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
-        cJSON_Delete(json);
-        return send_error_response(req, 500, "Internal server error - failed to acquire lock");
-    }
+    uint32_t id = 0;
+    bool shared = false;
+    esp_err_t result = http_subscription_add(node_id, events, paths, min_interval, max_interval, &id, &shared);
+    // NULL if the subscription already ended, e.g. the session lookup failed at once
+    cJSON *subscription = result == ESP_OK ? http_subscription_to_json(id) : NULL;
+    http_backend()->unlock();
     
-    result = controller::send_subscribe_event_command(nodeId, ep_ids, cl_ids, ev_ids, minInterval, maxInterval);
-    esp_matter::lock::chip_stack_unlock();
+    if (result == ESP_ERR_INVALID_SIZE) {
+        return send_error_response(req, 400, "Invalid paths: ID lists must have the same length, at most 8 paths");
+    }
+    if (result == ESP_ERR_NO_MEM) {
+        return send_error_response(req, 429, "Too many subscriptions - shut one down first");
+    }
     
     cJSON *response = cJSON_CreateObject();
     if (!response) {
-        cJSON_Delete(json);
+        cJSON_Delete(subscription);
         return send_error_response(req, 500, "Failed to create response");
     }
+    char message[64];
     if (result == ESP_OK) {
+        snprintf(message, sizeof(message), "Subscribe %s command sent successfully", kind);
         cJSON_AddStringToObject(response, "status", "success");
-        cJSON_AddStringToObject(response, "message", "Subscribe event command sent successfully");
+        cJSON_AddStringToObject(response, "message", message);
+        cJSON_AddNumberToObject(response, "id", id);
+        cJSON_AddBoolToObject(response, "shared", shared);
+        if (subscription) {
+            cJSON_AddItemToObject(response, "subscription", subscription);
+        } else {
+            cJSON_AddStringToObject(response, "state", "ended");
+        }
     } else {
+        snprintf(message, sizeof(message), "Failed to send subscribe %s command", kind);
         cJSON_AddStringToObject(response, "status", "error");
-        cJSON_AddStringToObject(response, "message", "Failed to send subscribe event command");
+        cJSON_AddStringToObject(response, "message", message);
     }
     
-    ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
-    cJSON_Delete(json);
+    esp_err_t ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
     cJSON_Delete(response);
     return ret;
 }
 
-// API: POST /api/shutdown-subscription - Shutdown specific subscription
-esp_err_t shutdown_subscription_handler(httpd_req_t *req) {
+struct subscribe_attribute_params {
+    uint64_t node_id;
+    schema::array<uint16_t> endpoint_ids;
+    schema::array<uint32_t> cluster_ids;
+    schema::array<uint32_t> attribute_ids;
+    uint16_t min_interval;
+    uint16_t max_interval;
+};
+
+static constexpr auto s_subscribe_attribute_schema = schema::make(
+    schema::field("node_id", &subscribe_attribute_params::node_id),
+    schema::field("endpoint_ids", &subscribe_attribute_params::endpoint_ids),
+    schema::field("cluster_ids", &subscribe_attribute_params::cluster_ids),
+    schema::field("attribute_ids", &subscribe_attribute_params::attribute_ids),
+    schema::field("min_interval", &subscribe_attribute_params::min_interval),
+    schema::field("max_interval", &subscribe_attribute_params::max_interval));
+
+// API: POST /api/subscribe-attribute - Subscribe to attributes
+esp_err_t subscribe_attribute_handler(httpd_req_t *req) {
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+    subscribe_attribute_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_subscribe_attribute_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
-    
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
-    cJSON *subscription_id = cJSON_GetObjectItem(json, "subscription_id");
-    
-    if (!node_id || !subscription_id || !cJSON_IsNumber(node_id) || !cJSON_IsNumber(subscription_id)) {
+    http_endpoint_set_node(params.node_id);
+    if (params.min_interval > params.max_interval) {
+        cJSON_Delete(json);
+        return send_error_response(req, 400, "Invalid 'min_interval': must not exceed max_interval");
+    }
+    esp_err_t ret = start_subscription(req, params.node_id, false,
+                                       make_paths(params.endpoint_ids, params.cluster_ids, params.attribute_ids),
+                                       params.min_interval, params.max_interval);
+    cJSON_Delete(json);
+    return ret;
+}
+
+struct subscribe_event_params {
+    uint64_t node_id;
+    schema::array<uint16_t> endpoint_ids;
+    schema::array<uint32_t> cluster_ids;
+    schema::array<uint32_t> event_ids;
+    uint16_t min_interval;
+    uint16_t max_interval;
+};
+
+static constexpr auto s_subscribe_event_schema = schema::make(
+    schema::field("node_id", &subscribe_event_params::node_id),
+    schema::field("endpoint_ids", &subscribe_event_params::endpoint_ids),
+    schema::field("cluster_ids", &subscribe_event_params::cluster_ids),
+    schema::field("event_ids", &subscribe_event_params::event_ids),
+    schema::field("min_interval", &subscribe_event_params::min_interval),
+    schema::field("max_interval", &subscribe_event_params::max_interval));
+
+// API: POST /api/subscribe-event - Subscribe to events
+esp_err_t subscribe_event_handler(httpd_req_t *req) {
+    cJSON *json = NULL;
+    subscribe_event_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_subscribe_event_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
+    }
+    http_endpoint_set_node(params.node_id);
+    if (params.min_interval > params.max_interval) {
         cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid node_id or subscription_id");
+        return send_error_response(req, 400, "Invalid 'min_interval': must not exceed max_interval");
+    }
+    esp_err_t ret = start_subscription(req, params.node_id, true,
+                                       make_paths(params.endpoint_ids, params.cluster_ids, params.event_ids),
+                                       params.min_interval, params.max_interval);
+    cJSON_Delete(json);
+    return ret;
+}
+
+struct shutdown_subscription_params {
+    uint64_t node_id;
+    uint32_t subscription_id;
+};
+
+static constexpr auto s_shutdown_subscription_schema = schema::make(
+    schema::field("node_id", &shutdown_subscription_params::node_id),
+    schema::field("subscription_id", &shutdown_subscription_params::subscription_id));
+
+// API: POST /api/shutdown-subscription - Shutdown specific subscription
+esp_err_t shutdown_subscription_handler(httpd_req_t *req) {
+    cJSON *json = NULL;
+    shutdown_subscription_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_shutdown_subscription_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
+    esp_err_t ret;
     
-    uint64_t nodeId = (uint64_t)node_id->valuedouble;
-    uint32_t subId = (uint32_t)subscription_id->valueint;
+    uint64_t nodeId = params.node_id;
+    http_endpoint_set_node(nodeId);
+    uint32_t subId = params.subscription_id;
     
     // Lock the Matter stack before calling shutdown subscription command
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
         cJSON_Delete(json);
         return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
     
-    esp_err_t result = controller::send_shutdown_subscription(nodeId, subId);
-    esp_matter::lock::chip_stack_unlock();
+    // A registered subscription is torn down for all its clients, which also stops its resubscription
+    esp_err_t result = http_subscription_shutdown(nodeId, subId);
+    if (result == ESP_ERR_NOT_FOUND) {
+        result = http_backend()->shutdown_subscription(nodeId, subId);
+    }
+    http_backend()->unlock();
     
     cJSON *response = cJSON_CreateObject();
     if (result == ESP_OK) {
@@ -1489,38 +1654,37 @@ esp_err_t shutdown_subscription_handler(httpd_req_t *req) {
     return ret;
 }
 
+struct shutdown_all_subscriptions_params {
+    schema::optional<uint64_t> node_id;
+};
+
+static constexpr auto s_shutdown_all_subscriptions_schema = schema::make(
+    schema::field("node_id", &shutdown_all_subscriptions_params::node_id));
+
 // API: POST /api/shutdown-all-subscriptions - Shutdown all subscriptions
 esp_err_t shutdown_all_subscriptions_handler(httpd_req_t *req) {
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+    shutdown_all_subscriptions_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_shutdown_all_subscriptions_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
-    
-    cJSON *node_id = cJSON_GetObjectItem(json, "node_id");
+    if (params.node_id.present) {
+        http_endpoint_set_node(params.node_id.value);
+    }
+    esp_err_t ret;
     
     // Lock the Matter stack before calling shutdown subscriptions command
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
         cJSON_Delete(json);
         return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
     
-    if (node_id) {
-        // Shutdown subscriptions for specific node
-        if (!cJSON_IsNumber(node_id)) {
-            esp_matter::lock::chip_stack_unlock();
-            cJSON_Delete(json);
-            return send_error_response(req, 400, "Invalid node_id parameter");
-        }
-        uint64_t nodeId = (uint64_t)node_id->valuedouble;
-        controller::send_shutdown_subscriptions(nodeId);
-    } else {
-        // Shutdown all subscriptions
-        controller::send_shutdown_all_subscriptions();
-    }
-    esp_matter::lock::chip_stack_unlock();
+    // Shutdown subscriptions for specific node, or all of them
+    http_subscription_restore_cancel(params.node_id.present ? &params.node_id.value : nullptr);
+    http_backend()->shutdown_subscriptions(params.node_id.present ? &params.node_id.value : nullptr);
+    http_backend()->unlock();
     
     cJSON *response = cJSON_CreateObject();
     cJSON_AddStringToObject(response, "status", "success");
@@ -1532,134 +1696,240 @@ esp_err_t shutdown_all_subscriptions_handler(httpd_req_t *req) {
     return ret;
 }
 
-#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
-// API: POST /api/ble-scan - BLE scan
-esp_err_t ble_scan_handler(httpd_req_t *req) {
-    cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+// API: GET /api/subscriptions - Registered subscriptions, optionally for one node
+esp_err_t subscriptions_handler(httpd_req_t *req) {
+    uint64_t node_id = 0;
+    bool filter = false;
+    char query[48];
+    char value[24];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "node_id", value, sizeof(value)) == ESP_OK) {
+        char *end = NULL;
+        node_id = strtoull(value, &end, 0);
+        if (end == value || *end != '\0') {
+            return send_error_response(req, 400, "Invalid node_id");
+        }
+        filter = true;
+        http_endpoint_set_node(node_id);
     }
     
-    cJSON *timeout = cJSON_GetObjectItem(json, "timeout");
-    cJSON *details = cJSON_GetObjectItem(json, "details");
-    
-    if (!timeout || !cJSON_IsNumber(timeout)) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid timeout parameter");
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
+        return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
-    
-    uint16_t timeout_val = (uint16_t)timeout->valueint;
-    if (timeout_val == 0 || timeout_val > 60) {
-        cJSON_Delete(json);
-        return send_error_response(req, 400, "Timeout must be between 1 and 60 seconds");
+    cJSON *json = http_subscriptions_to_json(filter ? &node_id : NULL);
+    http_backend()->unlock();
+    if (!json) {
+        return send_error_response(req, 500, "Failed to allocate response");
+    }
+    cJSON *restore = http_subscription_restore_to_json();
+    if (restore) {
+        cJSON_AddItemToObject(json, "restore", restore);
+    }
+    cJSON *streams = http_streams_to_json();
+    if (streams) {
+        cJSON_AddItemToObject(json, "streams", streams);
+    }
+    esp_err_t ret = send_json_response(req, json, 200);
+    cJSON_Delete(json);
+    return ret;
+}
+
+// API: GET /api/subscriptions/{id}/stream - Server-sent events with the reports of a subscription
+esp_err_t subscription_stream_handler(httpd_req_t *req) {
+    const char *prefix = "/api/subscriptions/";
+    const char *id_str = req->uri + strlen(prefix);
+    char *end = NULL;
+    unsigned long id = strtoul(id_str, &end, 10);
+    if (end == id_str || strncmp(end, "/stream", 7) != 0 || (end[7] != '\0' && end[7] != '?')) {
+        return send_error_response(req, 400, "Expected /api/subscriptions/{id}/stream");
+    }
+    
+    http_stream_options_t options = HTTP_STREAM_DEFAULT_OPTIONS();
+    char query[256];
+    char value[200];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "window_ms", value, sizeof(value)) == ESP_OK) {
+            unsigned long window_ms = strtoul(value, &end, 10);
+            if (end == value || *end != '\0' || window_ms > HTTP_STREAM_WINDOW_MAX_MS) {
+                return send_error_response(req, 400, "Invalid window_ms");
+            }
+            options.window_ms = window_ms;
+        }
+        if (httpd_query_key_value(query, "changes_only", value, sizeof(value)) == ESP_OK) {
+            if (strcmp(value, "true") != 0 && strcmp(value, "false") != 0) {
+                return send_error_response(req, 400, "Invalid changes_only");
+            }
+            options.changes_only = strcmp(value, "true") == 0;
+        }
+        if (httpd_query_key_value(query, "where", value, sizeof(value)) == ESP_OK) {
+            esp_err_t parsed = http_stream_parse_predicates(value, &options);
+            if (parsed == ESP_ERR_INVALID_SIZE) {
+                return send_error_response(req, 400, "Too many predicates");
+            }
+            if (parsed != ESP_OK) {
+                return send_error_response(req, 400, "Invalid where");
+            }
+        }
     }
     
-    bool show_details = details && cJSON_IsTrue(details);
-    
-    // Create callback instance
-    static controller::ble_scan::ConsoleBLEScanCallback callback;
-    callback.SetShowDetails(show_details);
-    
-    // Lock the Matter stack before calling BLE scan commands
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
-        cJSON_Delete(json);
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
         return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
-    
-    // Start enhanced scanning
-    auto& scanner = controller::ble_scan::EnhancedBLEDeviceScanner::GetInstance();
-    if (scanner.IsScanning()) {
-        ESP_LOGW(TAG, "BLE scan already in progress. Stopping previous scan...");
-        scanner.StopScan();
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    http_subscription_state_t state;
+    esp_err_t result = http_subscription_get_state((uint32_t)id, &state);
+    http_backend()->unlock();
+    if (result == ESP_ERR_NOT_FOUND) {
+        return send_error_response(req, 404, "Subscription not found");
     }
     
-    esp_err_t result = scanner.StartScan(timeout_val, &callback);
-    esp_matter::lock::chip_stack_unlock();
+    result = http_stream_open(req, (uint32_t)id, &options);
+    if (result == ESP_ERR_NO_MEM) {
+        return send_error_response(req, 429, "Too many open streams");
+    }
+    if (result == ESP_ERR_INVALID_STATE) {
+        return send_error_response(req, 503, "Streaming not available");
+    }
+    http_endpoint_set_status(200);
+    // The response has started, a failure can only close the socket
+    return result;
+}
+
+// API: DELETE /api/subscriptions/{id} - Release a subscription, torn down with its last client
+esp_err_t unsubscribe_handler(httpd_req_t *req) {
+    const char *prefix = "/api/subscriptions/";
+    const char *id_str = req->uri + strlen(prefix);
+    char *end = NULL;
+    unsigned long id = strtoul(id_str, &end, 10);
+    if (end == id_str || (*end != '\0' && *end != '?')) {
+        return send_error_response(req, 400, "Invalid subscription ID");
+    }
+    
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
+        return send_error_response(req, 500, "Internal server error - failed to acquire lock");
+    }
+    uint32_t remaining = 0;
+    esp_err_t result = http_subscription_remove((uint32_t)id, &remaining);
+    http_backend()->unlock();
     
+    if (result == ESP_ERR_NOT_FOUND) {
+        return send_error_response(req, 404, "Subscription not found");
+    }
     cJSON *response = cJSON_CreateObject();
-    if (result == ESP_OK) {
-        cJSON_AddStringToObject(response, "status", "success");
-        cJSON_AddStringToObject(response, "message", "BLE scan started successfully");
-        cJSON_AddNumberToObject(response, "timeout", timeout_val);
-        cJSON_AddBoolToObject(response, "show_details", show_details);
-    } else {
-        cJSON_AddStringToObject(response, "status", "error");
-        cJSON_AddStringToObject(response, "message", "Failed to start BLE scan");
+    if (!response) {
+        return send_error_response(req, 500, "Failed to create response");
     }
-    
-    ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
-    cJSON_Delete(json);
+    cJSON_AddStringToObject(response, "status", "success");
+    cJSON_AddStringToObject(response, "message", remaining > 0 ? "Subscription released, still shared with other clients"
+                                                               : "Subscription shutdown successfully");
+    cJSON_AddNumberToObject(response, "id", id);
+    cJSON_AddNumberToObject(response, "remaining_clients", remaining);
+    esp_err_t ret = send_json_response(req, response, 200);
     cJSON_Delete(response);
     return ret;
 }
-#endif
 
-// API: POST /api/group-settings - Group settings management
-esp_err_t group_settings_handler(httpd_req_t *req) {
-#ifndef CONFIG_ESP_MATTER_ENABLE_MATTER_SERVER
+#if HTTP_SERVER_BLE
+struct ble_scan_params {
+    uint16_t timeout;
+    schema::optional<bool> details;
+};
+
+static constexpr auto s_ble_scan_schema = schema::make(
+    schema::field("timeout", &ble_scan_params::timeout, 1, 60),
+    schema::field("details", &ble_scan_params::details));
+
+// API: POST /api/ble-scan - BLE scan
+esp_err_t ble_scan_handler(httpd_req_t *req) {
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+    ble_scan_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_ble_scan_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
     
-    cJSON *action = cJSON_GetObjectItem(json, "action");
-    if (!action || !cJSON_IsString(action)) {
+    ble_scan_job_args_t *args = (ble_scan_job_args_t *)calloc(1, sizeof(ble_scan_job_args_t));
+    if (!args) {
         cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid 'action' field");
+        return send_error_response(req, 500, "Failed to allocate BLE scan job");
+    }
+    args->timeout = params.timeout;
+    args->show_details = params.details.value;
+    
+    cJSON_Delete(json);
+    return send_job_accepted(req, "ble-scan", ble_scan_job, args);
+}
+#endif
+
+struct group_settings_params {
+    const char *action;
+    schema::optional<uint16_t> group_id;
+    schema::optional<const char *> group_name;
+};
+
+static constexpr auto s_group_settings_schema = schema::make(
+    schema::field("action", &group_settings_params::action),
+    schema::field("group_id", &group_settings_params::group_id),
+    schema::field("group_name", &group_settings_params::group_name));
+
+// API: POST /api/group-settings - Group settings management
+esp_err_t group_settings_handler(httpd_req_t *req) {
+    cJSON *json = NULL;
+    group_settings_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_group_settings_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
+    esp_err_t ret;
     
     esp_err_t result = ESP_FAIL;
     cJSON *response = cJSON_CreateObject();
     
-    // Lock the Matter stack before calling group settings commands
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
+    // Lock the controller before calling group settings commands
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
         cJSON_Delete(json);
         cJSON_Delete(response);
         return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
     
-    if (strcmp(action->valuestring, "show-groups") == 0) {
-        result = controller::group_settings::show_groups();
-    } else if (strcmp(action->valuestring, "add-group") == 0) {
-        cJSON *group_id = cJSON_GetObjectItem(json, "group_id");
-        cJSON *group_name = cJSON_GetObjectItem(json, "group_name");
-        
-        if (!group_id || !group_name || !cJSON_IsNumber(group_id) || !cJSON_IsString(group_name)) {
-            esp_matter::lock::chip_stack_unlock();
+    if (strcmp(params.action, "show-groups") == 0) {
+        result = http_backend()->show_groups();
+    } else if (strcmp(params.action, "add-group") == 0) {
+        if (!schema::require(params.group_id, "group_id", &err) ||
+            !schema::require(params.group_name, "group_name", &err)) {
+            http_backend()->unlock();
             cJSON_Delete(json);
             cJSON_Delete(response);
-            return send_error_response(req, 400, "Missing or invalid group_id or group_name");
+            return send_error_response(req, 400, err.message);
         }
         
-        uint16_t groupId = (uint16_t)group_id->valueint;
-        result = controller::group_settings::add_group(group_name->valuestring, groupId);
-    } else if (strcmp(action->valuestring, "remove-group") == 0) {
-        cJSON *group_id = cJSON_GetObjectItem(json, "group_id");
-        
-        if (!group_id || !cJSON_IsNumber(group_id)) {
-            esp_matter::lock::chip_stack_unlock();
+        result = http_backend()->add_group(params.group_name.value, params.group_id.value);
+    } else if (strcmp(params.action, "remove-group") == 0) {
+        if (!schema::require(params.group_id, "group_id", &err)) {
+            http_backend()->unlock();
             cJSON_Delete(json);
             cJSON_Delete(response);
-            return send_error_response(req, 400, "Missing or invalid group_id");
+            return send_error_response(req, 400, err.message);
         }
         
-        uint16_t groupId = (uint16_t)group_id->valueint;
-        result = controller::group_settings::remove_group(groupId);
+        result = http_backend()->remove_group(params.group_id.value);
     } else {
-        esp_matter::lock::chip_stack_unlock();
+        http_backend()->unlock();
         cJSON_Delete(json);
         cJSON_Delete(response);
         return send_error_response(req, 400, "Unsupported action");
     }
-    esp_matter::lock::chip_stack_unlock();
+    http_backend()->unlock();
+    cJSON_Delete(json);
     
+    if (result == ESP_ERR_NOT_SUPPORTED) {
+        // Groups belong to the Matter server when it runs, and the simulated controller has none
+        cJSON_Delete(response);
+        return send_error_response(req, 501, "Group settings not available on this controller");
+    }
     if (result == ESP_OK) {
         cJSON_AddStringToObject(response, "status", "success");
         cJSON_AddStringToObject(response, "message", "Group settings command executed successfully");
@@ -1669,94 +1939,55 @@ esp_err_t group_settings_handler(httpd_req_t *req) {
     }
     
     ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
-    cJSON_Delete(json);
     cJSON_Delete(response);
     return ret;
-#else
-    return send_error_response(req, 400, "Group settings not available when Matter server is enabled");
-#endif
 }
 
+struct udc_params {
+    const char *action;
+    schema::optional<uint32_t> pincode;
+    schema::optional<uint32_t> index;
+};
+
+static constexpr auto s_udc_schema = schema::make(
+    schema::field("action", &udc_params::action),
+    schema::field("pincode", &udc_params::pincode, 1, 99999998),
+    schema::field("index", &udc_params::index));
+
 // API: POST /api/udc - UDC commands
 esp_err_t udc_handler(httpd_req_t *req) {
-#if CONFIG_ESP_MATTER_COMMISSIONER_ENABLE && CHIP_DEVICE_CONFIG_ENABLE_COMMISSIONER_DISCOVERY
     cJSON *json = NULL;
-    esp_err_t ret = parse_json_request(req, &json);
-    if (ret != ESP_OK) {
-        return send_error_response(req, 400, "Invalid JSON");
+    udc_params params{};
+    schema::error_t err;
+    if (!parse_request_params(req, s_udc_schema, &json, &params, &err)) {
+        return send_error_response(req, 400, err.message);
     }
     
-    cJSON *action = cJSON_GetObjectItem(json, "action");
-    if (!action || !cJSON_IsString(action)) {
+    bool commission = strcmp(params.action, "commission") == 0;
+    if (!commission && strcmp(params.action, "reset") != 0 && strcmp(params.action, "print") != 0) {
         cJSON_Delete(json);
-        return send_error_response(req, 400, "Missing or invalid 'action' field");
+        return send_error_response(req, 400, "Unsupported UDC action");
+    }
+    if (commission && (!schema::require(params.pincode, "pincode", &err) || !schema::require(params.index, "index", &err))) {
+        cJSON_Delete(json);
+        return send_error_response(req, 400, err.message);
     }
     
-    esp_err_t result = ESP_OK;
-    cJSON *response = cJSON_CreateObject();
-    
-    // Lock the Matter stack before calling UDC commands
-    esp_matter::lock::status_t lock_status = esp_matter::lock::chip_stack_lock(portMAX_DELAY);
-    if (lock_status != esp_matter::lock::SUCCESS) {
-        ESP_LOGE(TAG, "Failed to acquire Matter stack lock");
+    // Lock the controller before calling UDC commands
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SERVER, "Failed to acquire Matter stack lock");
         cJSON_Delete(json);
-        cJSON_Delete(response);
         return send_error_response(req, 500, "Internal server error - failed to acquire lock");
     }
+    esp_err_t result = http_backend()->udc(params.action, params.pincode.value, params.index.value);
+    http_backend()->unlock();
+    cJSON_Delete(json);
     
-    if (strcmp(action->valuestring, "reset") == 0) {
-        controller::matter_controller_client::get_instance()
-            .get_commissioner()
-            ->GetUserDirectedCommissioningServer()
-            ->ResetUDCClientProcessingStates();
-    } else if (strcmp(action->valuestring, "print") == 0) {
-        controller::matter_controller_client::get_instance()
-            .get_commissioner()
-            ->GetUserDirectedCommissioningServer()
-            ->PrintUDCClients();
-    } else if (strcmp(action->valuestring, "commission") == 0) {
-        cJSON *pincode = cJSON_GetObjectItem(json, "pincode");
-        cJSON *index = cJSON_GetObjectItem(json, "index");
-        
-        if (!pincode || !index || !cJSON_IsNumber(pincode) || !cJSON_IsNumber(index)) {
-            esp_matter::lock::chip_stack_unlock();
-            cJSON_Delete(json);
-            cJSON_Delete(response);
-            return send_error_response(req, 400, "Missing or invalid pincode or index");
-        }
-        
-        uint32_t pin = (uint32_t)pincode->valueint;
-        size_t idx = (size_t)index->valueint;
-        
-        controller::matter_controller_client &instance = controller::matter_controller_client::get_instance();
-        UDCClientState *state = instance.get_commissioner()->GetUserDirectedCommissioningServer()->GetUDCClients().GetUDCClientState(idx);
-        
-        if (state != nullptr) {
-            state->SetUDCClientProcessingState(chip::Protocols::UserDirectedCommissioning::UDCClientProcessingState::kCommissioningNode);
-            
-            chip::NodeId gRemoteId = chip::kTestDeviceNodeId;
-            chip::RendezvousParameters params = chip::RendezvousParameters()
-                                                    .SetSetupPINCode(pin)
-                                                    .SetDiscriminator(state->GetLongDiscriminator())
-                                                    .SetPeerAddress(state->GetPeerAddress());
-            do {
-                chip::Crypto::DRBG_get_bytes(reinterpret_cast<uint8_t *>(&gRemoteId), sizeof(gRemoteId));
-            } while (!chip::IsOperationalNodeId(gRemoteId));
-            
-            if (instance.get_commissioner()->PairDevice(gRemoteId, params) != CHIP_NO_ERROR) {
-                result = ESP_FAIL;
-            }
-        } else {
-            result = ESP_FAIL;
-        }
-    } else {
-        esp_matter::lock::chip_stack_unlock();
-        cJSON_Delete(json);
-        cJSON_Delete(response);
-        return send_error_response(req, 400, "Unsupported UDC action");
+    if (result == ESP_ERR_NOT_SUPPORTED) {
+        return send_error_response(req, 501, "UDC not available - Commissioner discovery not enabled");
     }
-    esp_matter::lock::chip_stack_unlock();
     
+    cJSON *response = cJSON_CreateObject();
     if (result == ESP_OK) {
         cJSON_AddStringToObject(response, "status", "success");
         cJSON_AddStringToObject(response, "message", "UDC command executed successfully");
@@ -1765,101 +1996,9 @@ esp_err_t udc_handler(httpd_req_t *req) {
         cJSON_AddStringToObject(response, "message", "UDC command failed");
     }
     
-    ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
-    cJSON_Delete(json);
+    esp_err_t ret = send_json_response(req, response, result == ESP_OK ? 200 : 500);
     cJSON_Delete(response);
     return ret;
-#else
-    return send_error_response(req, 400, "UDC not available - Commissioner discovery not enabled");
-#endif
-}
-
-// Callback function for write response
-static void http_write_response_callback(uint64_t node_id, const chip::app::ConcreteAttributePath &path, uint8_t status) {
-    if (!s_write_results_mutex) return;
-    
-    if (xSemaphoreTake(s_write_results_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        auto it = s_write_results.find(node_id);
-        if (it != s_write_results.end()) {
-            WriteAttributeResult *result = it->second;
-            
-            // Create JSON object for this write result
-            cJSON *write_obj = cJSON_CreateObject();
-            cJSON_AddNumberToObject(write_obj, "node_id", node_id);
-            cJSON_AddNumberToObject(write_obj, "endpoint_id", path.mEndpointId);
-            cJSON_AddNumberToObject(write_obj, "cluster_id", path.mClusterId);
-            cJSON_AddNumberToObject(write_obj, "attribute_id", path.mAttributeId);
-            
-            // Add to results array
-            cJSON_AddItemToArray(result->write_results, write_obj);
-            result->received_responses++;
-            
-            // Mark as success if all responses received and all successful
-            if (result->received_responses >= result->expected_responses) {
-                result->success = true;
-            }
-        }
-        xSemaphoreGive(s_write_results_mutex);
-    }
-}
-
-// Callback function for write done
-static void http_write_done_callback(uint64_t node_id, 
-                                    const chip::Platform::ScopedMemoryBufferWithSize<chip::app::AttributePathParams> &attr_paths) {
-    if (!s_write_results_mutex) return;
-    
-    if (xSemaphoreTake(s_write_results_mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        auto it = s_write_results.find(node_id);
-        if (it != s_write_results.end()) {
-            WriteAttributeResult *result = it->second;
-            // Signal completion
-            xSemaphoreGive(result->semaphore);
-        }
-        xSemaphoreGive(s_write_results_mutex);
-    }
-}
-
-// Custom write attribute function with callbacks
-static esp_err_t send_write_attr_command_with_callbacks(uint64_t node_id, 
-                                                        ScopedMemoryBufferWithSize<uint16_t> &endpoint_ids,
-                                                        ScopedMemoryBufferWithSize<uint32_t> &cluster_ids,
-                                                        ScopedMemoryBufferWithSize<uint32_t> &attribute_ids,
-                                                        const char *attribute_value,
-                                                        chip::Optional<uint16_t> timed_write_timeout = chip::NullOptional) {
-    // For now, we'll use the existing send_write_attr_command and then wait for a simulated response
-    // In a full implementation, this would create a write_command with proper callbacks
-    
-    // Call the existing write command
-    esp_err_t result;
-    if (timed_write_timeout.HasValue()) {
-        result = controller::send_write_attr_command(node_id, endpoint_ids, cluster_ids, attribute_ids, attribute_value, timed_write_timeout);
-    } else {
-        result = controller::send_write_attr_command(node_id, endpoint_ids, cluster_ids, attribute_ids, attribute_value);
-    }
-    
-    if (result == ESP_OK) {
-        // Simulate write response callbacks after a short delay
-        // In a real implementation, these would be called by the Matter SDK
-        vTaskDelay(pdMS_TO_TICKS(100));
-        
-        // Simulate successful write responses for each attribute
-        for (size_t i = 0; i < endpoint_ids.AllocatedSize(); ++i) {
-            chip::app::ConcreteAttributePath path(endpoint_ids[i], cluster_ids[i], attribute_ids[i]);
-            http_write_response_callback(node_id, path, 0);  // 0 = success
-        }
-        
-        // Simulate write done callback
-        ScopedMemoryBufferWithSize<AttributePathParams> attr_paths;
-        attr_paths.Alloc(endpoint_ids.AllocatedSize());
-        if (attr_paths.Get()) {
-            for (size_t i = 0; i < attr_paths.AllocatedSize(); ++i) {
-                attr_paths[i] = AttributePathParams(endpoint_ids[i], cluster_ids[i], attribute_ids[i]);
-            }
-            http_write_done_callback(node_id, attr_paths);
-        }
-    }
-    
-    return result;
 }
 
 // HTTP Server management functions
@@ -1876,8 +2015,9 @@ esp_err_t start_http_server(const http_server_config_t *config) {
     httpd_config.max_open_sockets = config->max_open_sockets;
     httpd_config.lru_purge_enable = true;
     
-    // Increase stack size for HTTP server task to prevent stack overflow
-    httpd_config.stack_size = 12288; // 12KB instead of default 4KB
+    // Increase stack size for HTTP server task to prevent stack overflow,
+    // GET /api/debug/endpoints reports how much of it each handler used
+    httpd_config.stack_size = HTTP_SERVER_STACK_SIZE;
     
     // Increase receive timeout to handle slow Matter operations
     httpd_config.recv_wait_timeout = 10; // 10 seconds
@@ -1886,102 +2026,79 @@ esp_err_t start_http_server(const http_server_config_t *config) {
     // Enable URI match wildcard to handle CORS OPTIONS requests
     httpd_config.uri_match_fn = httpd_uri_match_wildcard;
     
+    // Keep request handling off the core running the Matter event loops
+    httpd_config.core_id = config->task_core_id;
+    httpd_config.task_priority = config->task_priority;
+    
     s_cors_enabled = config->cors_enable;
     
-    esp_err_t ret = httpd_start(&s_server, &httpd_config);
+    controller_backend *backend = config->backend ? config->backend : http_matter_backend();
+    if (!backend) {
+        ESP_LOGE(TAG, "No controller backend, this build has no Matter SDK");
+        return ESP_ERR_INVALID_ARG;
+    }
+    http_backend_set(backend);
+    
+    esp_err_t ret = http_mem_init(&config->memory_policy);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = http_arena_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error allocating request arenas: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = pending_ops_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error allocating result slots: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = jobs_init(config->worker_core_id, config->worker_priority);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error starting job workers: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = http_log_init();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    ret = backend->init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error initializing %s backend: %s", backend->name(), esp_err_to_name(ret));
+        return ret;
+    }
+    
+    ret = http_streams_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Error starting event streams: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    
+    if (config->persist_subscriptions) {
+        ret = http_subscription_store_init();
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Error starting subscription store: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    
+    ret = httpd_start(&s_server, &httpd_config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Error starting HTTP server: %s", esp_err_to_name(ret));
         return ret;
     }
     
     // Register URI handlers
+#define HTTP_ROUTE_URI(path, verb, fn, desc, params) \
+    { .uri = path, .method = HTTP_##verb, .handler = fn, .user_ctx = NULL },
     httpd_uri_t uri_handlers[] = {
-        {
-            .uri = "/api/help",
-            .method = HTTP_GET,
-            .handler = help_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/pairing",
-            .method = HTTP_POST,
-            .handler = pairing_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/group-settings",
-            .method = HTTP_POST,
-            .handler = group_settings_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/udc",
-            .method = HTTP_POST,
-            .handler = udc_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/open-commissioning-window",
-            .method = HTTP_POST,
-            .handler = open_commissioning_window_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/invoke-command",
-            .method = HTTP_POST,
-            .handler = invoke_command_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/read-attribute",
-            .method = HTTP_POST,
-            .handler = read_attribute_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/write-attribute",
-            .method = HTTP_POST,
-            .handler = write_attribute_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/read-event",
-            .method = HTTP_POST,
-            .handler = read_event_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/subscribe-attribute",
-            .method = HTTP_POST,
-            .handler = subscribe_attribute_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/subscribe-event",
-            .method = HTTP_POST,
-            .handler = subscribe_event_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/shutdown-subscription",
-            .method = HTTP_POST,
-            .handler = shutdown_subscription_handler,
-            .user_ctx = NULL
-        },
-        {
-            .uri = "/api/shutdown-all-subscriptions",
-            .method = HTTP_POST,
-            .handler = shutdown_all_subscriptions_handler,
-            .user_ctx = NULL
-        },
-#if CONFIG_ENABLE_ESP32_CONTROLLER_BLE_SCAN
-        {
-            .uri = "/api/ble-scan",
-            .method = HTTP_POST,
-            .handler = ble_scan_handler,
-            .user_ctx = NULL
-        },
-#endif
+        HTTP_SERVER_HELP_ROUTE(HTTP_ROUTE_URI)
+        HTTP_SERVER_ROUTES(HTTP_ROUTE_URI)
         // OPTIONS handler for CORS
         {
             .uri = "*",
@@ -1990,18 +2107,22 @@ esp_err_t start_http_server(const http_server_config_t *config) {
             .user_ctx = NULL
         }
     };
+#undef HTTP_ROUTE_URI
     
-    for (int i = 0; i < sizeof(uri_handlers) / sizeof(uri_handlers[0]); i++) {
-        ret = httpd_register_uri_handler(s_server, &uri_handlers[i]);
+    for (size_t i = 0; i < sizeof(uri_handlers) / sizeof(uri_handlers[0]); i++) {
+        ret = http_endpoint_register(s_server, &uri_handlers[i]);
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "Error registering URI handler: %s", esp_err_to_name(ret));
             httpd_stop(s_server);
+            http_endpoints_reset();
             s_server = NULL;
             return ret;
         }
     }
     
-    ESP_LOGI(TAG, "HTTP server started on port %d", config->port);
+    ESP_LOGI(TAG, "HTTP server started on port %d with the %s backend (core %d, priority %u; workers core %d, priority %u)",
+             config->port, backend->name(), (int)config->task_core_id, (unsigned)config->task_priority,
+             (int)config->worker_core_id, (unsigned)config->worker_priority);
     return ESP_OK;
 }
 
@@ -2014,6 +2135,7 @@ esp_err_t stop_http_server(void) {
     esp_err_t ret = httpd_stop(s_server);
     if (ret == ESP_OK) {
         s_server = NULL;
+        http_endpoints_reset();
         ESP_LOGI(TAG, "HTTP server stopped");
     } else {
         ESP_LOGE(TAG, "Error stopping HTTP server: %s", esp_err_to_name(ret));
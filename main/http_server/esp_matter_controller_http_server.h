@@ -3,11 +3,32 @@
 #include <esp_err.h>
 #include <esp_http_server.h>
 #include <cJSON.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_matter_controller_http_memory.h>
 
 namespace esp_matter {
 namespace controller {
 namespace http_server {
 
+/**
+ * @brief Core running the CHIP and OpenThread event loops
+ *
+ * Wi-Fi, BLE and the radio-facing tasks default to the PRO CPU. The HTTP
+ * server and job workers are pinned to the other core by default so JSON
+ * parsing and serialization under load does not delay them.
+ */
+#ifndef HTTP_SERVER_MATTER_CORE
+#define HTTP_SERVER_MATTER_CORE 0
+#endif
+
+#if CONFIG_FREERTOS_UNICORE || portNUM_PROCESSORS < 2
+#define HTTP_SERVER_DEFAULT_CORE tskNO_AFFINITY
+#else
+#define HTTP_SERVER_DEFAULT_CORE (HTTP_SERVER_MATTER_CORE == 0 ? 1 : 0)
+#endif
+
+class controller_backend;
+
 /**
  * @brief HTTP Server configuration structure
  */
@@ -17,6 +38,13 @@ typedef struct {
     size_t max_resp_headers; // Maximum number of additional response headers
     size_t max_open_sockets; // Maximum number of open sockets
     bool cors_enable;        // Enable CORS headers
+    BaseType_t task_core_id;      // Core the HTTP server task is pinned to, tskNO_AFFINITY for any core
+    UBaseType_t task_priority;    // Priority of the HTTP server task
+    BaseType_t worker_core_id;    // Core the job workers are pinned to, tskNO_AFFINITY for any core
+    UBaseType_t worker_priority;  // Priority of the job workers
+    http_mem_policy_t memory_policy; // Placement of request buffers, result rings and arenas
+    controller_backend *backend;     // Controller the requests are served by, NULL for the Matter SDK
+    bool persist_subscriptions;      // Keep subscriptions in NVS and re-establish them after a reboot
 } http_server_config_t;
 
 /**
@@ -27,7 +55,17 @@ typedef struct {
     .max_uri_handlers = 50,                  \
     .max_resp_headers = 8,                   \
     .max_open_sockets = 7,                   \
-    .cors_enable = true                      \
+    .cors_enable = true,                     \
+    .task_core_id = HTTP_SERVER_DEFAULT_CORE, \
+    .task_priority = tskIDLE_PRIORITY + 5,   \
+    .worker_core_id = HTTP_SERVER_DEFAULT_CORE, \
+    .worker_priority = tskIDLE_PRIORITY + 4, \
+    .memory_policy = {                       \
+        .psram_enable = true,                \
+        .psram_min_size = 1024,              \
+    },                                       \
+    .backend = NULL,                         \
+    .persist_subscriptions = true,           \
 }
 
 /**
@@ -68,8 +106,18 @@ esp_err_t subscribe_attribute_handler(httpd_req_t *req);
 esp_err_t subscribe_event_handler(httpd_req_t *req);
 esp_err_t shutdown_subscription_handler(httpd_req_t *req);
 esp_err_t shutdown_all_subscriptions_handler(httpd_req_t *req);
+esp_err_t subscriptions_handler(httpd_req_t *req);
+esp_err_t subscription_stream_handler(httpd_req_t *req);
+esp_err_t unsubscribe_handler(httpd_req_t *req);
 esp_err_t ble_scan_handler(httpd_req_t *req);
 esp_err_t help_handler(httpd_req_t *req);
+esp_err_t jobs_handler(httpd_req_t *req);
+esp_err_t memory_handler(httpd_req_t *req);
+esp_err_t endpoints_handler(httpd_req_t *req);
+esp_err_t recent_handler(httpd_req_t *req);
+esp_err_t log_handler(httpd_req_t *req);
+esp_err_t log_level_handler(httpd_req_t *req);
+esp_err_t metrics_handler(httpd_req_t *req);
 
 // Utility functions
 esp_err_t send_json_response(httpd_req_t *req, cJSON *json, int status_code = 200);
@@ -40,7 +40,7 @@ esp_err_t initialize_http_server_with_controller() {
     http_server_config_t config = HTTP_SERVER_DEFAULT_CONFIG();
     config.port = 8080;
     config.cors_enable = true;
-    config.max_uri_handlers = 20;
+    config.max_uri_handlers = 32;
     config.max_open_sockets = 7;
     
     // Start HTTP server
@@ -0,0 +1,784 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_stream.h>
+#include <esp_matter_controller_http_backend.h>
+#include <esp_matter_controller_http_encoding.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_memory.h>
+#include <esp_matter_controller_http_results.h>
+#include <esp_matter_controller_http_server.h>
+#include <esp_matter_controller_http_subscriptions.h>
+#include <esp_timer.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define STREAM_LOCK_TIMEOUT_MS 50 // The subscription check is skipped for one pass rather than stalling every stream
+
+// Latest value of one concrete path, waiting for the window of its stream to close
+typedef struct {
+    uint64_t node_id;
+    uint32_t cluster_id;
+    uint32_t attribute_id;
+    uint16_t endpoint_id;
+    bool dirty;         // A value waits to be sent
+    bool sent;          // sent_hash holds the last value sent
+    record_value_type_t type;
+    bool numeric;       // number holds the waiting value
+    bool sent_numeric;  // sent_number holds the last value sent, for changed_by
+    uint32_t hash;      // Of the waiting value
+    uint32_t sent_hash;
+    double number;
+    double sent_number;
+    union {
+        bool b;
+        uint64_t u;
+        int64_t i;
+        double f;
+    } value;
+    char str[HTTP_STREAM_STR_MAX];
+} stream_path_t;
+
+typedef struct {
+    httpd_req_t *req; // Asynchronous copy of the request, NULL for a free slot
+    uint32_t id;      // Subscription ID of the client
+    http_encoding_t encoding; // JSON streams are server-sent events, binary ones a sequence of records
+    http_stream_options_t options;
+    uint32_t opened_ms;
+    uint32_t flushed_ms; // Start of the current window
+    uint32_t sent_ms;    // Last chunk sent, keep-alives included
+    bool pending;        // Some path may be dirty
+    uint32_t received;
+    uint32_t sent;
+    uint32_t coalesced;
+    uint32_t suppressed;
+    uint32_t filtered;
+    uint32_t dropped;
+    uint8_t path_count;
+    stream_path_t *paths; // HTTP_STREAM_PATHS_MAX entries, allocated while the stream is open
+} stream_t;
+
+// Slots and their path tables are protected by s_mutex: values are stored from
+// the backend callbacks and taken out by the stream task, which alone sends
+// on the sockets and frees slots.
+static stream_t s_streams[HTTP_STREAMS_MAX];
+static SemaphoreHandle_t s_mutex = nullptr;
+static std::atomic<TaskHandle_t> s_task{nullptr};
+static std::atomic<uint32_t> s_open{0};
+static std::atomic<uint32_t> s_received{0};
+static std::atomic<uint32_t> s_sent{0};
+static std::atomic<uint32_t> s_coalesced{0};
+static std::atomic<uint32_t> s_suppressed{0};
+static std::atomic<uint32_t> s_filtered{0};
+static std::atomic<uint32_t> s_dropped{0};
+
+// Only used by the stream task
+static stream_path_t s_batch[HTTP_STREAM_PATHS_MAX];
+static char s_chunk[HTTP_STREAM_CHUNK_SIZE];
+
+static uint32_t uptime_ms()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint32_t hash_bytes(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// FNV-1a over what the client would see of the value
+static uint32_t record_hash(const result_record_t *record)
+{
+    uint32_t hash = hash_bytes(2166136261u, &record->type, sizeof(record->type));
+    switch (record->type) {
+    case RECORD_VALUE_BOOL:
+        return hash_bytes(hash, &record->value.b, sizeof(record->value.b));
+    case RECORD_VALUE_UINT:
+    case RECORD_VALUE_INT:
+    case RECORD_VALUE_FLOAT:
+        return hash_bytes(hash, &record->value, sizeof(record->value));
+    case RECORD_VALUE_STRING:
+        return hash_bytes(hash, record->str, strnlen(record->str, sizeof(record->str)));
+    case RECORD_VALUE_RAW:
+        return hash_bytes(hash, record->str, record->raw_len);
+    default:
+        return hash;
+    }
+}
+
+static bool record_number(const result_record_t *record, double *out)
+{
+    switch (record->type) {
+    case RECORD_VALUE_BOOL:
+        *out = record->value.b ? 1 : 0;
+        return true;
+    case RECORD_VALUE_UINT:
+        *out = (double)record->value.u;
+        return true;
+    case RECORD_VALUE_INT:
+        *out = (double)record->value.i;
+        return true;
+    case RECORD_VALUE_FLOAT:
+        *out = record->value.f;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool predicate_applies(const http_stream_predicate_t &predicate, const result_record_t *record)
+{
+    return (predicate.endpoint_id == 0xFFFF || predicate.endpoint_id == record->endpoint_id) &&
+           (predicate.cluster_id == 0xFFFFFFFF || predicate.cluster_id == record->cluster_id) &&
+           (predicate.attribute_id == 0xFFFFFFFF || predicate.attribute_id == record->attribute_id);
+}
+
+static bool predicate_matches(const http_stream_predicate_t &predicate, const result_record_t *record,
+                              const stream_path_t *path, bool numeric, double number, uint32_t hash)
+{
+    switch (predicate.op) {
+    case HTTP_STREAM_GREATER:
+        return numeric && number > predicate.number;
+    case HTTP_STREAM_LESS:
+        return numeric && number < predicate.number;
+    case HTTP_STREAM_EQUALS:
+        if (record->type == RECORD_VALUE_STRING) {
+            return strcmp(record->str, predicate.text) == 0;
+        }
+        return numeric && predicate.numeric && number == predicate.number;
+    case HTTP_STREAM_CHANGED_BY:
+        if (!path->sent) {
+            return true;
+        }
+        if (numeric && path->sent_numeric) {
+            return fabs(number - path->sent_number) > predicate.number;
+        }
+        // Strings and other values have no distance, any change counts
+        return hash != path->sent_hash;
+    default:
+        return false;
+    }
+}
+
+static stream_path_t *find_path(stream_t *stream, const result_record_t *record)
+{
+    for (size_t i = 0; i < stream->path_count; ++i) {
+        stream_path_t *path = &stream->paths[i];
+        if (path->attribute_id == record->attribute_id && path->cluster_id == record->cluster_id &&
+            path->endpoint_id == record->endpoint_id && path->node_id == record->node_id) {
+            return path;
+        }
+    }
+    if (stream->path_count == HTTP_STREAM_PATHS_MAX) {
+        return nullptr;
+    }
+    stream_path_t *path = &stream->paths[stream->path_count++];
+    memset(path, 0, sizeof(*path));
+    path->node_id = record->node_id;
+    path->endpoint_id = record->endpoint_id;
+    path->cluster_id = record->cluster_id;
+    path->attribute_id = record->attribute_id;
+    return path;
+}
+
+// Registry callback, with the backend lock held: keep only the latest value per path
+static void on_attribute(uint32_t id, const result_record_t *record)
+{
+    bool wake = false;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (stream_t &stream : s_streams) {
+        if (!stream.req || stream.id != id) {
+            continue;
+        }
+        stream.received++;
+        s_received.fetch_add(1, std::memory_order_relaxed);
+        stream_path_t *path = find_path(&stream, record);
+        if (!path) {
+            stream.dropped++;
+            s_dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        uint32_t hash = record_hash(record);
+        double number = 0;
+        bool numeric = record_number(record, &number);
+        bool matches = true;
+        for (size_t i = 0; i < stream.options.predicate_count && matches; ++i) {
+            const http_stream_predicate_t &predicate = stream.options.predicates[i];
+            matches = !predicate_applies(predicate, record) ||
+                      predicate_matches(predicate, record, path, numeric, number, hash);
+        }
+        if (!matches) {
+            // The latest report decides: a waiting value the device has moved away from is not sent either
+            path->dirty = false;
+            stream.filtered++;
+            s_filtered.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (stream.options.changes_only && path->sent && hash == path->sent_hash) {
+            // Back to what the client has: a value still waiting is obsolete
+            if (path->dirty) {
+                path->dirty = false;
+                stream.coalesced++;
+                s_coalesced.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                stream.suppressed++;
+                s_suppressed.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+        if (path->dirty) {
+            stream.coalesced++;
+            s_coalesced.fetch_add(1, std::memory_order_relaxed);
+        }
+        path->dirty = true;
+        path->type = record->type;
+        path->hash = hash;
+        path->numeric = numeric;
+        path->number = number;
+        memcpy(&path->value, &record->value, sizeof(path->value));
+        if (record->type == RECORD_VALUE_STRING) {
+            strlcpy(path->str, record->str, sizeof(path->str));
+        }
+        // A stream already pending has its window end scheduled
+        wake = wake || !stream.pending;
+        stream.pending = true;
+    }
+    xSemaphoreGive(s_mutex);
+    TaskHandle_t task = s_task.load(std::memory_order_acquire);
+    if (wake && task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+static int format_value(char *buf, size_t size, const stream_path_t *path)
+{
+    switch (path->type) {
+    case RECORD_VALUE_BOOL:
+        return snprintf(buf, size, "%s", path->value.b ? "true" : "false");
+    case RECORD_VALUE_UINT:
+        return snprintf(buf, size, "%" PRIu64, path->value.u);
+    case RECORD_VALUE_INT:
+        return snprintf(buf, size, "%" PRId64, path->value.i);
+    case RECORD_VALUE_FLOAT:
+        return isfinite(path->value.f) ? snprintf(buf, size, "%.15g", path->value.f) : snprintf(buf, size, "null");
+    case RECORD_VALUE_RAW:
+        return snprintf(buf, size, "\"raw_data\"");
+    case RECORD_VALUE_STRING: {
+        size_t len = 0;
+        if (len < size) {
+            buf[len++] = '"';
+        }
+        for (const char *c = path->str; *c && len + 7 < size; ++c) {
+            if (*c == '"' || *c == '\\') {
+                buf[len++] = '\\';
+                buf[len++] = *c;
+            } else if ((unsigned char)*c < 0x20) {
+                len += snprintf(buf + len, size - len, "\\u%04x", *c);
+            } else {
+                buf[len++] = *c;
+            }
+        }
+        return len + snprintf(buf + len, size - len, "\"");
+    }
+    default:
+        return snprintf(buf, size, "null");
+    }
+}
+
+// The longest event: a string value of HTTP_STREAM_STR_MAX characters, each one escaped. Binary records are
+// smaller, their strings are not escaped
+#define STREAM_EVENT_MAX (160 + HTTP_STREAM_STR_MAX * 6)
+static_assert(STREAM_EVENT_MAX <= HTTP_STREAM_CHUNK_SIZE, "A report must fit in one chunk");
+
+static int format_report(char *buf, size_t size, const stream_path_t *path)
+{
+    char value[HTTP_STREAM_STR_MAX * 6 + 3];
+    format_value(value, sizeof(value), path);
+    return snprintf(buf, size,
+                    "event: report\ndata: {\"node_id\":%" PRIu64 ",\"endpoint_id\":%u,\"cluster_id\":%" PRIu32
+                    ",\"attribute_id\":%" PRIu32 ",\"type\":\"%s\",\"value\":%s}\n\n",
+                    path->node_id, path->endpoint_id, path->cluster_id, path->attribute_id,
+                    http_record_type_name(path->type), value);
+}
+
+static int encode_report(http_encoding_t encoding, char *buf, size_t size, const stream_path_t *path)
+{
+    result_record_t record = {};
+    record.node_id = path->node_id;
+    record.endpoint_id = path->endpoint_id;
+    record.cluster_id = path->cluster_id;
+    record.attribute_id = path->attribute_id;
+    // Streams keep no RAW element, raw_len 0 encodes it as null or leaves it out
+    record.type = path->type;
+    memcpy(&record.value, &path->value, sizeof(path->value));
+    if (path->type == RECORD_VALUE_STRING) {
+        strlcpy(record.str, path->str, sizeof(record.str));
+    }
+    size_t len = 0;
+    if (http_encode_record(encoding, &record, (uint8_t *)buf, size, &len) != ESP_OK) {
+        HTTP_LOGW(HTTP_LOG_STREAM, "Report of 0x%" PRIx32 "/0x%" PRIx32 " not encoded", path->cluster_id,
+                  path->attribute_id);
+        return 0;
+    }
+    return len;
+}
+
+static bool send_chunk(httpd_req_t *req, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk(req, data, len) == ESP_OK;
+}
+
+static const char *stream_mime(http_encoding_t encoding)
+{
+    switch (encoding) {
+    case HTTP_ENCODING_CBOR:
+        return HTTP_MIME_CBOR_SEQ;
+    case HTTP_ENCODING_TLV:
+        return HTTP_MIME_TLV;
+    default:
+        return "text/event-stream";
+    }
+}
+
+// Sent on an idle stream: an SSE comment, a CBOR null or an empty anonymous TLV structure
+static bool send_keepalive(const stream_t *stream)
+{
+    static const char sse[] = ": keep-alive\n\n";
+    static const char cbor[] = {(char)0xf6};
+    static const char tlv[] = {0x15, 0x18};
+    switch (stream->encoding) {
+    case HTTP_ENCODING_CBOR:
+        return send_chunk(stream->req, cbor, sizeof(cbor));
+    case HTTP_ENCODING_TLV:
+        return send_chunk(stream->req, tlv, sizeof(tlv));
+    default:
+        return send_chunk(stream->req, sse, sizeof(sse) - 1);
+    }
+}
+
+// Send the values taken out of a stream, several events per chunk
+static bool send_batch(stream_t *stream, size_t count)
+{
+    size_t len = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (len + STREAM_EVENT_MAX > sizeof(s_chunk)) {
+            if (!send_chunk(stream->req, s_chunk, len)) {
+                return false;
+            }
+            len = 0;
+        }
+        if (stream->encoding == HTTP_ENCODING_JSON) {
+            len += format_report(s_chunk + len, sizeof(s_chunk) - len, &s_batch[i]);
+        } else {
+            len += encode_report(stream->encoding, s_chunk + len, sizeof(s_chunk) - len, &s_batch[i]);
+        }
+    }
+    return len == 0 || send_chunk(stream->req, s_chunk, len);
+}
+
+// The client stopped reading or went away: its socket is closed rather than sent to again
+static void close_stream(stream_t *stream, const char *reason, bool client_gone)
+{
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    httpd_req_t *req = stream->req;
+    stream_path_t *paths = stream->paths;
+    uint32_t received = stream->received;
+    uint32_t sent = stream->sent;
+    stream->req = nullptr;
+    stream->paths = nullptr;
+    xSemaphoreGive(s_mutex);
+    HTTP_LOGI(HTTP_LOG_STREAM, "Closing stream of subscription %" PRIu32 " (%s): %" PRIu32 " values received, %" PRIu32
+              " sent", stream->id, reason, received, sent);
+    s_open.fetch_sub(1, std::memory_order_relaxed);
+    httpd_handle_t server = req->handle;
+    int sockfd = httpd_req_to_sockfd(req);
+    if (!client_gone) {
+        httpd_resp_send_chunk(req, NULL, 0);
+    }
+    httpd_req_async_handler_complete(req);
+    if (client_gone) {
+        httpd_sess_trigger_close(server, sockfd);
+    }
+    http_mem_free(paths);
+}
+
+// Whether the client's subscription ID is still registered, assumed so while the stack is busy
+static bool client_alive(uint32_t id)
+{
+    if (!http_backend()->lock(pdMS_TO_TICKS(STREAM_LOCK_TIMEOUT_MS))) {
+        return true;
+    }
+    http_subscription_state_t state;
+    bool alive = http_subscription_get_state(id, &state) == ESP_OK;
+    http_backend()->unlock();
+    return alive;
+}
+
+// Send what is due on one stream; returns the milliseconds until it needs the task again
+static uint32_t service_stream(stream_t *stream, uint32_t now)
+{
+    size_t count = 0;
+    uint32_t wait_ms = HTTP_STREAM_KEEPALIVE_MS;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    uint32_t since_flush = now - stream->flushed_ms;
+    if (stream->pending && since_flush < stream->options.window_ms) {
+        wait_ms = stream->options.window_ms - since_flush;
+    } else if (stream->pending) {
+        for (size_t i = 0; i < stream->path_count; ++i) {
+            stream_path_t *path = &stream->paths[i];
+            if (path->dirty) {
+                s_batch[count++] = *path;
+                path->dirty = false;
+                path->sent = true;
+                path->sent_hash = path->hash;
+                path->sent_numeric = path->numeric;
+                path->sent_number = path->number;
+            }
+        }
+        stream->pending = false;
+        stream->sent += count;
+        s_sent.fetch_add(count, std::memory_order_relaxed);
+        // The window starts with the values sent, a value arriving later goes out once it closes
+        stream->flushed_ms = now;
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (count > 0) {
+        if (!send_batch(stream, count)) {
+            close_stream(stream, "client gone or too slow", true);
+            return HTTP_STREAM_CHECK_MS;
+        }
+        stream->sent_ms = now;
+    }
+    if (!client_alive(stream->id)) {
+        // A binary stream just ends
+        static const char end[] = "event: end\ndata: {\"reason\":\"released\"}\n\n";
+        bool sent = stream->encoding != HTTP_ENCODING_JSON || send_chunk(stream->req, end, sizeof(end) - 1);
+        close_stream(stream, "subscription released", !sent);
+        return HTTP_STREAM_CHECK_MS;
+    }
+    if (now - stream->sent_ms < HTTP_STREAM_KEEPALIVE_MS) {
+        return std::min(wait_ms, HTTP_STREAM_KEEPALIVE_MS - (now - stream->sent_ms));
+    }
+    if (!send_keepalive(stream)) {
+        close_stream(stream, "client gone or too slow", true);
+        return HTTP_STREAM_CHECK_MS;
+    }
+    stream->sent_ms = now;
+    return wait_ms;
+}
+
+static void stream_task(void *arg)
+{
+    while (true) {
+        // Woken by http_stream_open() when nothing is open
+        TickType_t wait = portMAX_DELAY;
+        for (stream_t &stream : s_streams) {
+            // Only this task frees slots, an open slot stays open while it is serviced
+            xSemaphoreTake(s_mutex, portMAX_DELAY);
+            bool open = stream.req && stream.paths;
+            xSemaphoreGive(s_mutex);
+            if (open) {
+                uint32_t wait_ms = std::min<uint32_t>(service_stream(&stream, uptime_ms()), HTTP_STREAM_CHECK_MS);
+                wait = std::min(wait, pdMS_TO_TICKS(wait_ms));
+            }
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+static bool parse_id(const char *text, size_t len, uint32_t wildcard, uint32_t max, uint32_t *out)
+{
+    if (len == 1 && text[0] == '*') {
+        *out = wildcard;
+        return true;
+    }
+    char buf[12];
+    if (len == 0 || len >= sizeof(buf)) {
+        return false;
+    }
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+    // Decimal unless 0x-prefixed, so a leading zero is not read as octal
+    bool hex = len > 2 && buf[0] == '0' && (buf[1] == 'x' || buf[1] == 'X');
+    const char *digits = hex ? buf + 2 : buf;
+    if (!isxdigit((unsigned char)digits[0])) {
+        return false;
+    }
+    char *end = NULL;
+    unsigned long id = strtoul(digits, &end, hex ? 16 : 10);
+    if (*end != '\0' || id > max) {
+        return false;
+    }
+    *out = id;
+    return true;
+}
+
+// "endpoint/cluster/attribute" of a predicate scope
+static bool parse_scope(const char *text, size_t len, http_stream_predicate_t *predicate)
+{
+    const char *end = text + len;
+    const char *first = (const char *)memchr(text, '/', len);
+    const char *second = first ? (const char *)memchr(first + 1, '/', end - first - 1) : nullptr;
+    uint32_t endpoint_id;
+    if (!second || !parse_id(text, first - text, 0xFFFF, 0xFFFF, &endpoint_id) ||
+        !parse_id(first + 1, second - first - 1, 0xFFFFFFFF, 0xFFFFFFFF, &predicate->cluster_id) ||
+        !parse_id(second + 1, end - second - 1, 0xFFFFFFFF, 0xFFFFFFFF, &predicate->attribute_id)) {
+        return false;
+    }
+    predicate->endpoint_id = endpoint_id;
+    return true;
+}
+
+static bool parse_op(const char *text, size_t len, http_stream_op_t *op)
+{
+    static const struct {
+        const char *name;
+        http_stream_op_t op;
+    } ops[] = {
+        {"gt", HTTP_STREAM_GREATER}, {">", HTTP_STREAM_GREATER}, {"lt", HTTP_STREAM_LESS},
+        {"<", HTTP_STREAM_LESS}, {"equals", HTTP_STREAM_EQUALS}, {"=", HTTP_STREAM_EQUALS},
+        {"changed_by", HTTP_STREAM_CHANGED_BY},
+    };
+    for (const auto &candidate : ops) {
+        if (strlen(candidate.name) == len && strncmp(candidate.name, text, len) == 0) {
+            *op = candidate.op;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_operand(const char *text, size_t len, http_stream_predicate_t *predicate)
+{
+    if (len == 0 || len >= sizeof(predicate->text)) {
+        return false;
+    }
+    memcpy(predicate->text, text, len);
+    predicate->text[len] = '\0';
+    if (strcmp(predicate->text, "true") == 0 || strcmp(predicate->text, "false") == 0) {
+        predicate->numeric = true;
+        predicate->number = predicate->text[0] == 't' ? 1 : 0;
+        return true;
+    }
+    char *end = NULL;
+    predicate->number = strtod(predicate->text, &end);
+    predicate->numeric = *end == '\0';
+    // Only equals compares strings
+    return predicate->numeric || predicate->op == HTTP_STREAM_EQUALS;
+}
+
+esp_err_t http_stream_parse_predicates(const char *text, http_stream_options_t *options)
+{
+    options->predicate_count = 0;
+    while (*text) {
+        const char *end = strchr(text, ',');
+        size_t len = end ? (size_t)(end - text) : strlen(text);
+        if (options->predicate_count == HTTP_STREAM_PREDICATES_MAX) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        http_stream_predicate_t *predicate = &options->predicates[options->predicate_count];
+        memset(predicate, 0, sizeof(*predicate));
+        predicate->endpoint_id = 0xFFFF;
+        predicate->cluster_id = 0xFFFFFFFF;
+        predicate->attribute_id = 0xFFFFFFFF;
+
+        // [scope:]op:operand, the scope is the only part holding a '/'
+        const char *colon = (const char *)memchr(text, ':', len);
+        if (colon && memchr(text, '/', colon - text)) {
+            if (!parse_scope(text, colon - text, predicate)) {
+                return ESP_ERR_INVALID_ARG;
+            }
+            len -= colon + 1 - text;
+            text = colon + 1;
+            colon = (const char *)memchr(text, ':', len);
+        }
+        if (!colon || !parse_op(text, colon - text, &predicate->op) ||
+            !parse_operand(colon + 1, len - (colon + 1 - text), predicate)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        options->predicate_count++;
+        text += len;
+        if (*text == ',') {
+            text++;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t http_streams_init()
+{
+    if (s_task.load(std::memory_order_acquire)) {
+        return ESP_OK;
+    }
+    s_mutex = xSemaphoreCreateMutex();
+    if (!s_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_STREAM, "Failed to acquire Matter stack lock");
+        return ESP_FAIL;
+    }
+    http_subscriptions_set_attribute_callback(on_attribute);
+    http_backend()->unlock();
+
+    TaskHandle_t task;
+    if (xTaskCreate(stream_task, "http_stream", HTTP_STREAM_TASK_STACK_SIZE, NULL, HTTP_STREAM_TASK_PRIORITY,
+                    &task) != pdPASS) {
+        HTTP_LOGE(HTTP_LOG_STREAM, "Failed to create the stream task");
+        return ESP_ERR_NO_MEM;
+    }
+    s_task.store(task, std::memory_order_release);
+    return ESP_OK;
+}
+
+bool http_streams_active()
+{
+    return s_open.load(std::memory_order_relaxed) > 0;
+}
+
+esp_err_t http_stream_open(httpd_req_t *req, uint32_t id, const http_stream_options_t *options)
+{
+    TaskHandle_t task = s_task.load(std::memory_order_acquire);
+    if (!task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    stream_path_t *paths =
+        (stream_path_t *)http_mem_calloc(HTTP_STREAM_PATHS_MAX, sizeof(stream_path_t), HTTP_MEM_LONG_LIVED);
+    if (!paths) {
+        return ESP_ERR_NO_MEM;
+    }
+    // Reserved by the request until it is handed over, the slot stays unused until paths is set
+    stream_t *stream = nullptr;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (stream_t &candidate : s_streams) {
+        if (!candidate.req) {
+            stream = &candidate;
+            *stream = stream_t{};
+            stream->req = req;
+            break;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    if (!stream) {
+        http_mem_free(paths);
+        return ESP_ERR_NO_MEM;
+    }
+
+    http_encoding_t encoding = http_accept_encoding(req);
+    add_cors_headers(req);
+    httpd_resp_set_type(req, stream_mime(encoding));
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    stream->encoding = encoding;
+    bool sent;
+    if (encoding == HTTP_ENCODING_JSON) {
+        char open[128];
+        int len = snprintf(open, sizeof(open), "retry: 5000\nevent: open\ndata: {\"id\":%" PRIu32 ",\"window_ms\":%"
+                           PRIu32 ",\"changes_only\":%s,\"predicates\":%u}\n\n", id, options->window_ms,
+                           options->changes_only ? "true" : "false", options->predicate_count);
+        sent = send_chunk(req, open, len);
+    } else {
+        // Binary streams have no open event, a keep-alive item gets the headers out
+        sent = send_keepalive(stream);
+    }
+    httpd_req_t *async = nullptr;
+    if (!sent || httpd_req_async_handler_begin(req, &async) != ESP_OK) {
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        stream->req = nullptr;
+        xSemaphoreGive(s_mutex);
+        http_mem_free(paths);
+        return ESP_FAIL;
+    }
+
+    // Every stream is sent by the one task, a client that stops reading must not hold it for the server's
+    // send timeout
+    struct timeval timeout = {
+        .tv_sec = HTTP_STREAM_SEND_TIMEOUT_MS / 1000,
+        .tv_usec = (HTTP_STREAM_SEND_TIMEOUT_MS % 1000) * 1000,
+    };
+    setsockopt(httpd_req_to_sockfd(async), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    uint32_t now = uptime_ms();
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    stream->req = async;
+    stream->id = id;
+    stream->options = *options;
+    stream->opened_ms = now;
+    stream->flushed_ms = now - options->window_ms;
+    stream->sent_ms = now;
+    stream->paths = paths;
+    xSemaphoreGive(s_mutex);
+    s_open.fetch_add(1, std::memory_order_relaxed);
+    xTaskNotifyGive(task);
+    HTTP_LOGI(HTTP_LOG_STREAM, "Streaming subscription %" PRIu32 " as %s, window %" PRIu32 " ms%s", id,
+              stream_mime(encoding), options->window_ms, options->changes_only ? ", changes only" : "");
+    return ESP_OK;
+}
+
+cJSON *http_streams_to_json()
+{
+    cJSON *array = cJSON_CreateArray();
+    if (!array) {
+        return nullptr;
+    }
+    uint32_t now = uptime_ms();
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    for (const stream_t &stream : s_streams) {
+        if (!stream.req || !stream.paths) {
+            continue;
+        }
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "id", stream.id);
+        cJSON_AddStringToObject(item, "encoding", stream_mime(stream.encoding));
+        cJSON_AddNumberToObject(item, "window_ms", stream.options.window_ms);
+        cJSON_AddBoolToObject(item, "changes_only", stream.options.changes_only);
+        cJSON_AddNumberToObject(item, "open_ms", now - stream.opened_ms);
+        cJSON_AddNumberToObject(item, "paths", stream.path_count);
+        cJSON_AddNumberToObject(item, "received", stream.received);
+        cJSON_AddNumberToObject(item, "sent", stream.sent);
+        cJSON_AddNumberToObject(item, "coalesced", stream.coalesced);
+        cJSON_AddNumberToObject(item, "suppressed", stream.suppressed);
+        cJSON_AddNumberToObject(item, "predicates", stream.options.predicate_count);
+        cJSON_AddNumberToObject(item, "filtered", stream.filtered);
+        cJSON_AddNumberToObject(item, "dropped", stream.dropped);
+        cJSON_AddItemToArray(array, item);
+    }
+    xSemaphoreGive(s_mutex);
+    return array;
+}
+
+void http_streams_get_stats(http_streams_stats_t *stats)
+{
+    stats->open = s_open.load(std::memory_order_relaxed);
+    stats->received = s_received.load(std::memory_order_relaxed);
+    stats->sent = s_sent.load(std::memory_order_relaxed);
+    stats->coalesced = s_coalesced.load(std::memory_order_relaxed);
+    stats->suppressed = s_suppressed.load(std::memory_order_relaxed);
+    stats->filtered = s_filtered.load(std::memory_order_relaxed);
+    stats->dropped = s_dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
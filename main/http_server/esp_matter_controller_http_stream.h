@@ -0,0 +1,145 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include <freertos/FreeRTOS.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_STREAMS_MAX 4               // Open event streams, each keeps a socket of the server
+#define HTTP_STREAM_PATHS_MAX 32         // Concrete attribute paths tracked per stream, wildcards expanded
+#define HTTP_STREAM_STR_MAX 64           // Longer string values are truncated in the stream
+#define HTTP_STREAM_DEFAULT_WINDOW_MS 100
+#define HTTP_STREAM_WINDOW_MAX_MS 60000
+#define HTTP_STREAM_KEEPALIVE_MS 15000   // Comment sent on an idle stream, so a gone client is noticed
+#define HTTP_STREAM_CHECK_MS 1000        // The subscription of every open stream is checked at least this often
+#define HTTP_STREAM_SEND_TIMEOUT_MS 200  // A client not taking a chunk within this is closed, the others go on
+#define HTTP_STREAM_CHUNK_SIZE 1024      // Events collected before each chunk is sent
+#define HTTP_STREAM_TASK_STACK_SIZE 4096
+#define HTTP_STREAM_TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+#define HTTP_STREAM_PREDICATES_MAX 4     // Predicates attached to one stream
+#define HTTP_STREAM_PREDICATE_TEXT_MAX 24 // Longest string an equals predicate compares with
+
+/**
+ * @brief Comparison of a predicate
+ */
+typedef enum : uint8_t {
+    HTTP_STREAM_GREATER = 0, // Numeric value above the operand
+    HTTP_STREAM_LESS,        // Numeric value below the operand
+    HTTP_STREAM_EQUALS,      // Number, boolean or string equal to the operand
+    HTTP_STREAM_CHANGED_BY,  // Numeric value more than the operand away from the last one sent for the path
+} http_stream_op_t;
+
+/**
+ * @brief Condition a report must meet to be pushed, on the paths it applies to
+ */
+typedef struct {
+    uint16_t endpoint_id;  // 0xFFFF for any endpoint
+    uint32_t cluster_id;   // 0xFFFFFFFF for any cluster
+    uint32_t attribute_id; // 0xFFFFFFFF for any attribute
+    http_stream_op_t op;
+    bool numeric;          // The operand parsed as a number, true and false included
+    double number;
+    char text[HTTP_STREAM_PREDICATE_TEXT_MAX];
+} http_stream_predicate_t;
+
+/**
+ * @brief How the reports of one stream are shaped
+ */
+typedef struct {
+    uint32_t window_ms; // Reports of a path within the window are coalesced into the latest, 0 sends each one
+    bool changes_only;  // Skip values equal to the last one sent for the path
+    uint8_t predicate_count; // Reports must meet every predicate applying to their path
+    http_stream_predicate_t predicates[HTTP_STREAM_PREDICATES_MAX];
+} http_stream_options_t;
+
+#define HTTP_STREAM_DEFAULT_OPTIONS() { \
+    .window_ms = HTTP_STREAM_DEFAULT_WINDOW_MS, \
+    .changes_only = false,              \
+    .predicate_count = 0,               \
+    .predicates = {},                   \
+}
+
+/**
+ * @brief Parse the predicates of a stream, as given in its "where" query parameter
+ *
+ * A comma-separated list of "[endpoint/cluster/attribute:]op:operand", where
+ * op is gt (>), lt (<), equals (=) or changed_by and the IDs are decimal,
+ * 0x-prefixed or * for any, e.g. "1/0x402/0:gt:2500,changed_by:50".
+ *
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a syntax error,
+ *         ESP_ERR_INVALID_SIZE beyond HTTP_STREAM_PREDICATES_MAX predicates
+ */
+esp_err_t http_stream_parse_predicates(const char *text, http_stream_options_t *options);
+
+/**
+ * @brief Start the task sending the streams
+ *
+ * Must be called after the backend is initialized.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the task cannot be created
+ */
+esp_err_t http_streams_init();
+
+/**
+ * @brief Whether any stream is open, so backends can skip decoding values nobody reads
+ */
+bool http_streams_active();
+
+/**
+ * @brief Turn the request into a server-sent event stream of a client's attribute reports
+ *
+ * Sends the response headers and an "open" event, then hands the request
+ * over to the stream task: the handler returns at once while the socket stays
+ * open. The stream sends a "report" event per coalesced value and ends with
+ * an "end" event within HTTP_STREAM_CHECK_MS of the subscription ID being
+ * released. A client accepting CBOR or Matter TLV (http_accept_encoding())
+ * gets instead a sequence of records as encoded by http_encode_record(),
+ * without open and end events, an empty item standing for the keep-alive
+ * comment. All streams are sent by one task, so a client that stops reading
+ * is closed once a send blocks for HTTP_STREAM_SEND_TIMEOUT_MS.
+ *
+ * @param id Subscription ID of the client, as handed out by http_subscription_add()
+ * @return ESP_OK once the stream runs, ESP_ERR_NO_MEM if HTTP_STREAMS_MAX streams
+ *         are open or its path table cannot be allocated (nothing was sent),
+ *         ESP_FAIL if the client went away while the stream was set up
+ */
+esp_err_t http_stream_open(httpd_req_t *req, uint32_t id, const http_stream_options_t *options);
+
+/**
+ * @brief Open streams and their counters, for GET /api/subscriptions
+ * @return New cJSON array, NULL on allocation failure
+ */
+cJSON *http_streams_to_json();
+
+/**
+ * @brief Report counters summed over every stream since boot
+ */
+typedef struct {
+    uint32_t open;       // Streams currently open
+    uint32_t received;   // Values reported for a stream's paths
+    uint32_t sent;       // Values sent to the clients
+    uint32_t coalesced;  // Values replaced by a later one within the window
+    uint32_t suppressed; // Values equal to the last one sent, with changes_only
+    uint32_t filtered;   // Values failing a predicate of the stream
+    uint32_t dropped;    // Values of paths beyond HTTP_STREAM_PATHS_MAX
+} http_streams_stats_t;
+
+/**
+ * @brief Counters of the streams, for /api/metrics
+ */
+void http_streams_get_stats(http_streams_stats_t *stats);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
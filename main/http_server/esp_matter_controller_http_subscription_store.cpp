@@ -0,0 +1,513 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_subscription_store.h>
+#include <esp_matter_controller_http_backend.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_matter_controller_http_subscriptions.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#include <nvs.h>
+#include <algorithm>
+#include <atomic>
+#include <inttypes.h>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define STORE_KEY "clients"
+#define STORE_VERSION 1
+#define RESTORE_POLL_MS 500 // Restored subscriptions are checked this often until established
+
+typedef struct {
+    uint16_t version;
+    uint16_t record_size; // Records of another layout are dropped rather than misread
+    uint16_t count;
+    uint16_t reserved;
+} store_header_t;
+
+typedef struct {
+    store_header_t header;
+    http_subscription_record_t records[HTTP_SUBSCRIPTION_CLIENTS_MAX];
+} store_blob_t;
+
+typedef enum : uint8_t {
+    RESTORE_DISABLED = 0, // No NVS, or persistence turned off
+    RESTORE_WAITING,      // Records loaded, waiting for HTTP_RESTORE_START_DELAY_MS
+    RESTORE_RUNNING,
+    RESTORE_DONE,
+} restore_state_t;
+
+typedef enum : uint8_t {
+    RESTORE_RETRY = 0,   // Not subscribed, tried again at retry_at_ms
+    RESTORE_PENDING,     // Subscribed, waiting for it to be established
+    RESTORE_ESTABLISHED,
+    RESTORE_FAILED,      // Still not subscribed when the restore timed out, dropped from NVS
+    RESTORE_CANCELLED,   // Released on request before it was established
+} restore_status_t;
+
+typedef struct {
+    http_subscription_record_t record;
+    uint32_t retry_at_ms;
+    uint32_t backoff_ms;
+    restore_status_t status;
+    bool started; // Subscribed at least once
+} restore_entry_t;
+
+static const char *const s_restore_state_names[] = {"disabled", "waiting", "restoring", "done"};
+
+// Only touched by the store task once it runs: the records loaded at boot, then the last snapshot written
+static store_blob_t s_blob;
+static uint32_t s_saved_hash;
+// The loaded records in restore order, only touched with the backend lock held once the task runs
+static restore_entry_t s_restore[HTTP_SUBSCRIPTION_CLIENTS_MAX];
+static size_t s_restore_count;
+
+static std::atomic<TaskHandle_t> s_task{nullptr};
+static std::atomic<uint8_t> s_restore_state{RESTORE_DISABLED};
+static std::atomic<uint32_t> s_restore_total{0};
+static std::atomic<uint32_t> s_restore_nodes{0};
+static std::atomic<uint32_t> s_restore_started{0};
+static std::atomic<uint32_t> s_restore_established{0};
+static std::atomic<uint32_t> s_restore_failed{0};
+static std::atomic<uint32_t> s_restore_cancelled{0};
+static std::atomic<uint32_t> s_restore_retries{0};
+static std::atomic<uint32_t> s_restore_start_ms{0};
+static std::atomic<uint32_t> s_restore_duration_ms{0};
+
+static uint32_t uptime_ms()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static size_t blob_size(size_t count)
+{
+    return sizeof(store_header_t) + count * sizeof(http_subscription_record_t);
+}
+
+// FNV-1a, to skip writing a snapshot equal to what flash already holds
+static uint32_t blob_hash(size_t count)
+{
+    const uint8_t *bytes = (const uint8_t *)&s_blob;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < blob_size(count); ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool record_valid(const http_subscription_record_t &record)
+{
+    return record.id != 0 && record.path_count > 0 && record.path_count <= HTTP_SUBSCRIPTION_PATHS_MAX &&
+           record.min_interval <= record.max_interval;
+}
+
+// Load the records of the previous boot into s_blob; false if NVS cannot be used at all
+static bool load_records()
+{
+    memset(&s_blob, 0, sizeof(s_blob));
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(HTTP_SUBSCRIPTION_STORE_NAMESPACE, NVS_READONLY, &handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        // Nothing was ever saved
+        s_saved_hash = blob_hash(0);
+        return true;
+    }
+    if (err != ESP_OK) {
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Subscription persistence disabled, cannot open NVS: %s",
+                  esp_err_to_name(err));
+        return false;
+    }
+    size_t length = sizeof(s_blob);
+    err = nvs_get_blob(handle, STORE_KEY, &s_blob, &length);
+    nvs_close(handle);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        s_saved_hash = blob_hash(0);
+        return true;
+    }
+    // The hash of what flash holds, unless it is dropped below
+    s_saved_hash = blob_hash(s_blob.header.count <= HTTP_SUBSCRIPTION_CLIENTS_MAX ? s_blob.header.count : 0);
+    if (err != ESP_OK || length < sizeof(store_header_t) || s_blob.header.version != STORE_VERSION ||
+        s_blob.header.record_size != sizeof(http_subscription_record_t) ||
+        s_blob.header.count > HTTP_SUBSCRIPTION_CLIENTS_MAX || length != blob_size(s_blob.header.count)) {
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Dropping saved subscriptions: %s",
+                  err != ESP_OK ? esp_err_to_name(err) : "unknown layout");
+        memset(&s_blob, 0, sizeof(s_blob));
+        s_saved_hash = 0; // Overwritten by the next snapshot
+        return true;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < s_blob.header.count; ++i) {
+        if (record_valid(s_blob.records[i])) {
+            s_blob.records[count++] = s_blob.records[i];
+        }
+    }
+    if (count != s_blob.header.count) {
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Dropping %u invalid saved subscriptions",
+                  (unsigned)(s_blob.header.count - count));
+        s_blob.header.count = count;
+        s_saved_hash = 0;
+    }
+    return true;
+}
+
+static void save_snapshot()
+{
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SUBSCRIPTIONS, "Failed to acquire Matter stack lock");
+        return;
+    }
+    size_t count = http_subscriptions_snapshot(s_blob.records, HTTP_SUBSCRIPTION_CLIENTS_MAX);
+    // Records still waiting for a retry are not in the registry, they stay saved until the restore gives up
+    for (size_t i = 0; i < s_restore_count && count < HTTP_SUBSCRIPTION_CLIENTS_MAX; ++i) {
+        if (s_restore[i].status == RESTORE_RETRY) {
+            s_blob.records[count++] = s_restore[i].record;
+        }
+    }
+    http_backend()->unlock();
+
+    // Ordered by ID, so the same clients always give the same bytes
+    std::sort(s_blob.records, s_blob.records + count,
+              [](const http_subscription_record_t &a, const http_subscription_record_t &b) { return a.id < b.id; });
+    memset(&s_blob.header, 0, sizeof(s_blob.header));
+    s_blob.header.version = STORE_VERSION;
+    s_blob.header.record_size = sizeof(http_subscription_record_t);
+    s_blob.header.count = count;
+    uint32_t hash = blob_hash(count);
+    if (hash == s_saved_hash) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(HTTP_SUBSCRIPTION_STORE_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Failed to save subscriptions, cannot open NVS: %s",
+                  esp_err_to_name(err));
+        return;
+    }
+    if (count > 0) {
+        err = nvs_set_blob(handle, STORE_KEY, &s_blob, blob_size(count));
+    } else {
+        err = nvs_erase_key(handle, STORE_KEY);
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Failed to save subscriptions: %s", esp_err_to_name(err));
+        return;
+    }
+    s_saved_hash = hash;
+    HTTP_LOGD(HTTP_LOG_SUBSCRIPTIONS, "Saved %u subscriptions", (unsigned)count);
+}
+
+static uint32_t restore_elapsed_ms()
+{
+    return uptime_ms() - s_restore_start_ms.load(std::memory_order_relaxed);
+}
+
+static void schedule_retry(restore_entry_t *entry)
+{
+    entry->backoff_ms = entry->backoff_ms == 0 ? HTTP_RESTORE_RETRY_MIN_MS
+                                               : std::min<uint32_t>(entry->backoff_ms * 2, HTTP_RESTORE_RETRY_MAX_MS);
+    entry->retry_at_ms = uptime_ms() + entry->backoff_ms + esp_random() % (HTTP_RESTORE_JITTER_MS + 1);
+    entry->status = RESTORE_RETRY;
+}
+
+// Subscribe a loaded record, called with the backend lock held
+static void restore_entry(restore_entry_t *entry)
+{
+    bool shared = false;
+    esp_err_t err = http_subscription_restore(&entry->record, &shared);
+    if (err != ESP_OK) {
+        schedule_retry(entry);
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Failed to restore subscription %" PRIu32 " to node 0x%" PRIx64
+                  ": %s, retrying in %" PRIu32 " ms", entry->record.id, entry->record.node_id, esp_err_to_name(err),
+                  entry->backoff_ms);
+        return;
+    }
+    if (!entry->started) {
+        entry->started = true;
+        s_restore_started.fetch_add(1, std::memory_order_relaxed);
+    }
+    entry->status = RESTORE_PENDING;
+}
+
+// Tally the restored subscriptions established or gone since the last poll, retry the ones that are due
+// once every record was dispatched, and finish the restore once every one of them is settled
+static void poll_restore(bool dispatched)
+{
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SUBSCRIPTIONS, "Failed to acquire Matter stack lock");
+        return;
+    }
+    uint32_t now = uptime_ms();
+    uint32_t connecting, active, resubscribing, clients;
+    http_subscriptions_count(&connecting, &active, &resubscribing, &clients);
+    size_t pending = 0;
+    for (size_t i = 0; i < s_restore_count; ++i) {
+        restore_entry_t *entry = &s_restore[i];
+        if (entry->status == RESTORE_PENDING) {
+            http_subscription_state_t state;
+            if (http_subscription_get_state(entry->record.id, &state) != ESP_OK) {
+                // Ended by the device before it was ever established, e.g. the node is not up yet
+                schedule_retry(entry);
+                HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Subscription %" PRIu32 " to node 0x%" PRIx64
+                          " ended before it was established, retrying in %" PRIu32 " ms", entry->record.id,
+                          entry->record.node_id, entry->backoff_ms);
+            } else if (state == HTTP_SUBSCRIPTION_ACTIVE) {
+                entry->status = RESTORE_ESTABLISHED;
+                s_restore_established.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (entry->status == RESTORE_RETRY && dispatched && (int32_t)(now - entry->retry_at_ms) >= 0 &&
+                   connecting < HTTP_RESTORE_MAX_CONNECTING) {
+            s_restore_retries.fetch_add(1, std::memory_order_relaxed);
+            restore_entry(entry);
+            if (entry->status == RESTORE_PENDING) {
+                connecting++;
+            }
+        }
+        if (entry->status == RESTORE_PENDING || entry->status == RESTORE_RETRY) {
+            pending++;
+        }
+    }
+
+    uint32_t elapsed = restore_elapsed_ms();
+    if (!dispatched || (pending > 0 && elapsed < HTTP_RESTORE_TIMEOUT_MS)) {
+        http_backend()->unlock();
+        return;
+    }
+    // Subscribed ones keep trying on their own and stay saved, the others are given up
+    size_t unsubscribed = 0;
+    for (size_t i = 0; i < s_restore_count; ++i) {
+        if (s_restore[i].status == RESTORE_RETRY) {
+            s_restore[i].status = RESTORE_FAILED;
+            s_restore_failed.fetch_add(1, std::memory_order_relaxed);
+            unsubscribed++;
+        }
+    }
+    http_backend()->unlock();
+    s_restore_duration_ms.store(elapsed, std::memory_order_relaxed);
+    s_restore_state.store(RESTORE_DONE, std::memory_order_relaxed);
+    HTTP_LOGI(HTTP_LOG_SUBSCRIPTIONS, "Restored %" PRIu32 " of %" PRIu32 " subscriptions to %" PRIu32
+              " nodes in %" PRIu32 " ms, %" PRIu32 " failed, %u still pending",
+              s_restore_established.load(std::memory_order_relaxed), s_restore_total.load(std::memory_order_relaxed),
+              s_restore_nodes.load(std::memory_order_relaxed), elapsed,
+              s_restore_failed.load(std::memory_order_relaxed), (unsigned)(pending - unsubscribed));
+}
+
+// Wait until fewer than HTTP_RESTORE_MAX_CONNECTING subscriptions are being set up, or the restore times out
+static void wait_for_connect_slot()
+{
+    while (restore_elapsed_ms() < HTTP_RESTORE_TIMEOUT_MS) {
+        uint32_t connecting, active, resubscribing, clients;
+        http_subscriptions_count(&connecting, &active, &resubscribing, &clients);
+        if (connecting < HTTP_RESTORE_MAX_CONNECTING) {
+            return;
+        }
+        vTaskDelay(pdMS_TO_TICKS(RESTORE_POLL_MS));
+        poll_restore(false);
+    }
+}
+
+static bool restore_before(const http_subscription_record_t &a, const http_subscription_record_t &b)
+{
+    // Grouped by node, tightest intervals first so later clients join without re-establishing
+    if (a.node_id != b.node_id) {
+        return a.node_id < b.node_id;
+    }
+    if (a.events != b.events) {
+        return a.events < b.events;
+    }
+    if (a.max_interval != b.max_interval) {
+        return a.max_interval < b.max_interval;
+    }
+    if (a.min_interval != b.min_interval) {
+        return a.min_interval < b.min_interval;
+    }
+    return a.id < b.id;
+}
+
+// Subscribe the loaded records again, one node after the other
+static void restore_records()
+{
+    vTaskDelay(pdMS_TO_TICKS(HTTP_RESTORE_START_DELAY_MS + esp_random() % (HTTP_RESTORE_JITTER_MS + 1)));
+    s_restore_start_ms.store(uptime_ms(), std::memory_order_relaxed);
+    s_restore_state.store(RESTORE_RUNNING, std::memory_order_relaxed);
+    HTTP_LOGI(HTTP_LOG_SUBSCRIPTIONS, "Restoring %u subscriptions", (unsigned)s_restore_count);
+
+    for (size_t i = 0; i < s_restore_count; ++i) {
+        // Fixed once loaded, only the status changes under the lock
+        const http_subscription_record_t &record = s_restore[i].record;
+        if (i == 0 || record.node_id != s_restore[i - 1].record.node_id) {
+            if (i > 0) {
+                vTaskDelay(pdMS_TO_TICKS(HTTP_RESTORE_NODE_GAP_MS + esp_random() % (HTTP_RESTORE_JITTER_MS + 1)));
+            }
+            wait_for_connect_slot();
+            s_restore_nodes.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(HTTP_RESTORE_CLIENT_GAP_MS));
+        }
+
+        if (!http_backend()->lock(portMAX_DELAY)) {
+            HTTP_LOGE(HTTP_LOG_SUBSCRIPTIONS, "Failed to acquire Matter stack lock");
+            schedule_retry(&s_restore[i]);
+            continue;
+        }
+        if (s_restore[i].status == RESTORE_RETRY) {
+            restore_entry(&s_restore[i]);
+        }
+        http_backend()->unlock();
+    }
+    poll_restore(true);
+}
+
+static void store_task(void *arg)
+{
+    if (s_restore_count > 0) {
+        restore_records();
+    } else {
+        s_restore_state.store(RESTORE_DONE, std::memory_order_relaxed);
+    }
+    while (true) {
+        bool restoring = s_restore_state.load(std::memory_order_relaxed) == RESTORE_RUNNING;
+        uint32_t changes = ulTaskNotifyTake(pdTRUE, restoring ? pdMS_TO_TICKS(RESTORE_POLL_MS) : portMAX_DELAY);
+        if (restoring) {
+            poll_restore(true);
+            if (s_restore_state.load(std::memory_order_relaxed) == RESTORE_DONE) {
+                // The records given up leave NVS
+                changes++;
+            }
+        }
+        if (changes > 0) {
+            // Subscribing clients tend to come in bursts, write them together
+            vTaskDelay(pdMS_TO_TICKS(HTTP_SUBSCRIPTION_STORE_DELAY_MS));
+            ulTaskNotifyTake(pdTRUE, 0);
+            save_snapshot();
+        }
+    }
+}
+
+// A client left before its restored subscription was established, it is not subscribed again
+static void on_release(uint32_t id)
+{
+    for (size_t i = 0; i < s_restore_count; ++i) {
+        if (s_restore[i].record.id == id && s_restore[i].status == RESTORE_PENDING) {
+            s_restore[i].status = RESTORE_CANCELLED;
+            s_restore_cancelled.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void http_subscription_restore_cancel(const uint64_t *node_id)
+{
+    for (size_t i = 0; i < s_restore_count; ++i) {
+        restore_entry_t *entry = &s_restore[i];
+        if ((!node_id || entry->record.node_id == *node_id) &&
+            (entry->status == RESTORE_PENDING || entry->status == RESTORE_RETRY)) {
+            entry->status = RESTORE_CANCELLED;
+            s_restore_cancelled.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+static void on_change()
+{
+    TaskHandle_t task = s_task.load(std::memory_order_acquire);
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+esp_err_t http_subscription_store_init()
+{
+    if (s_task.load(std::memory_order_acquire)) {
+        return ESP_OK;
+    }
+    if (!load_records()) {
+        return ESP_OK;
+    }
+    uint32_t max_id = 0;
+    for (size_t i = 0; i < s_blob.header.count; ++i) {
+        max_id = std::max(max_id, s_blob.records[i].id);
+        memset(&s_restore[i], 0, sizeof(s_restore[i]));
+        s_restore[i].record = s_blob.records[i];
+        s_restore[i].status = RESTORE_RETRY;
+    }
+    s_restore_count = s_blob.header.count;
+    std::sort(s_restore, s_restore + s_restore_count,
+              [](const restore_entry_t &a, const restore_entry_t &b) { return restore_before(a.record, b.record); });
+    s_restore_total.store(s_restore_count, std::memory_order_relaxed);
+
+    if (!http_backend()->lock(portMAX_DELAY)) {
+        HTTP_LOGE(HTTP_LOG_SUBSCRIPTIONS, "Failed to acquire Matter stack lock");
+        return ESP_FAIL;
+    }
+    // Reserved before any client can subscribe, the restored IDs stay theirs
+    http_subscriptions_reserve_ids(max_id);
+    http_subscriptions_set_change_callback(on_change);
+    http_subscriptions_set_release_callback(on_release);
+    http_backend()->unlock();
+
+    s_restore_state.store(RESTORE_WAITING, std::memory_order_relaxed);
+    TaskHandle_t task;
+    if (xTaskCreate(store_task, "http_subs", HTTP_SUBSCRIPTION_STORE_TASK_STACK_SIZE, NULL,
+                    HTTP_SUBSCRIPTION_STORE_TASK_PRIORITY, &task) != pdPASS) {
+        HTTP_LOGE(HTTP_LOG_SUBSCRIPTIONS, "Failed to create the subscription store task");
+        s_restore_state.store(RESTORE_DISABLED, std::memory_order_relaxed);
+        return ESP_ERR_NO_MEM;
+    }
+    s_task.store(task, std::memory_order_release);
+    if (s_blob.header.count > 0) {
+        HTTP_LOGI(HTTP_LOG_SUBSCRIPTIONS, "Loaded %u saved subscriptions, restoring them in %u ms",
+                  (unsigned)s_blob.header.count, (unsigned)HTTP_RESTORE_START_DELAY_MS);
+    }
+    return ESP_OK;
+}
+
+cJSON *http_subscription_restore_to_json()
+{
+    cJSON *json = cJSON_CreateObject();
+    if (!json) {
+        return nullptr;
+    }
+    uint8_t state = s_restore_state.load(std::memory_order_relaxed);
+    uint32_t total = s_restore_total.load(std::memory_order_relaxed);
+    uint32_t established = s_restore_established.load(std::memory_order_relaxed);
+    uint32_t failed = s_restore_failed.load(std::memory_order_relaxed);
+    uint32_t cancelled = s_restore_cancelled.load(std::memory_order_relaxed);
+    cJSON_AddStringToObject(json, "state", s_restore_state_names[state]);
+    cJSON_AddNumberToObject(json, "total", total);
+    cJSON_AddNumberToObject(json, "nodes", s_restore_nodes.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(json, "started", s_restore_started.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(json, "established", established);
+    cJSON_AddNumberToObject(json, "failed", failed);
+    cJSON_AddNumberToObject(json, "cancelled", cancelled);
+    cJSON_AddNumberToObject(json, "retries", s_restore_retries.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(json, "pending", total - established - failed - cancelled);
+    if (state == RESTORE_RUNNING) {
+        cJSON_AddNumberToObject(json, "elapsed_ms", restore_elapsed_ms());
+    } else if (state == RESTORE_DONE && total > 0) {
+        cJSON_AddNumberToObject(json, "duration_ms", s_restore_duration_ms.load(std::memory_order_relaxed));
+    }
+    return json;
+}
+
+uint32_t http_subscription_restore_duration_ms()
+{
+    return s_restore_duration_ms.load(std::memory_order_relaxed);
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
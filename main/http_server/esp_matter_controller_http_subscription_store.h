@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_SUBSCRIPTION_STORE_NAMESPACE "http_subs" // NVS namespace of the subscription records
+#define HTTP_SUBSCRIPTION_STORE_DELAY_MS 1000 // Changes within this window are written to flash at once
+#define HTTP_RESTORE_START_DELAY_MS 5000      // Left to the network and the CASE sessions before the first restore
+#define HTTP_RESTORE_NODE_GAP_MS 1000         // Between the subscriptions of two nodes
+#define HTTP_RESTORE_JITTER_MS 500            // Random extra delay per node, so controllers rebooting together spread out
+#define HTTP_RESTORE_CLIENT_GAP_MS 100        // Between the clients of one node, most of them join a shared subscription
+#define HTTP_RESTORE_MAX_CONNECTING 2         // Nodes being subscribed at once during the restore
+#define HTTP_RESTORE_RETRY_MIN_MS 2000        // First retry of a subscription that could not be restored
+#define HTTP_RESTORE_RETRY_MAX_MS 30000       // Cap of the doubling back-off between retries
+#define HTTP_RESTORE_TIMEOUT_MS 120000        // Records not subscribed by then are dropped, unestablished ones pending
+#define HTTP_SUBSCRIPTION_STORE_TASK_STACK_SIZE 4096
+#define HTTP_SUBSCRIPTION_STORE_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+/**
+ * @brief Persist the subscription registry and restore it after a reboot
+ *
+ * Loads the subscriptions saved in NVS by the previous boot and starts a task
+ * that subscribes them again under their IDs, one node after the other with a
+ * jittered gap and at most HTTP_RESTORE_MAX_CONNECTING nodes in flight, so a
+ * controller with many subscriptions does not open every CASE session at
+ * once. A subscription that cannot be restored, e.g. because its node is
+ * still offline, is retried with a doubling back-off and its record kept in
+ * NVS until HTTP_RESTORE_TIMEOUT_MS. The task then writes the registry back
+ * to NVS whenever clients subscribe or leave, off the request path.
+ *
+ * Must be called after the backend is initialized. Without NVS the server
+ * runs on with persistence disabled.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the task cannot be created
+ */
+esp_err_t http_subscription_store_init();
+
+/**
+ * @brief Stop restoring the saved subscriptions of a node, e.g. when they are shut down on request
+ *
+ * Call with the backend lock held.
+ *
+ * @param node_id NULL for every node
+ */
+void http_subscription_restore_cancel(const uint64_t *node_id);
+
+/**
+ * @brief Progress of the restore after boot, for GET /api/subscriptions
+ * @return New cJSON object, NULL on allocation failure
+ */
+cJSON *http_subscription_restore_to_json();
+
+/**
+ * @brief Time the restore took until every restored subscription was established or failed, 0 until then
+ */
+uint32_t http_subscription_restore_duration_ms();
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
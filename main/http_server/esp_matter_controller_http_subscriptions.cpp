@@ -0,0 +1,712 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_subscriptions.h>
+#include <esp_matter_controller_http_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <atomic>
+#include <inttypes.h>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define WILDCARD_ENDPOINT 0xFFFF
+#define WILDCARD_ID 0xFFFFFFFF
+
+// One Matter subscription, shared by the clients pointing at its slot
+typedef struct {
+    uint32_t id;              // Backend ID, 0 for a free entry; changes when re-established
+    uint32_t subscription_id; // Matter subscription ID, 0 until established, the lost one while resubscribing
+    uint64_t node_id;
+    bool events;
+    http_subscription_state_t state;
+    uint16_t min_interval_requested; // Tightest of the clients
+    uint16_t max_interval_requested;
+    uint16_t min_interval; // Negotiated, valid once established
+    uint16_t max_interval;
+    uint32_t created_ms;
+    uint32_t established_ms;
+    uint32_t last_report_ms;
+    uint32_t reports;
+    uint32_t resubscriptions;
+    uint32_t retry_at_ms;
+    uint8_t clients;
+    uint8_t path_count;
+    http_subscription_path_t paths[HTTP_SUBSCRIPTION_PATHS_MAX];
+} http_subscription_t;
+
+typedef struct {
+    uint32_t id; // Subscription ID handed out, 0 for a free entry
+    uint32_t created_ms;
+    uint16_t min_interval;
+    uint16_t max_interval;
+    uint8_t slot; // Index of the shared subscription in s_subscriptions
+    uint8_t path_count;
+    http_subscription_path_t paths[HTTP_SUBSCRIPTION_PATHS_MAX];
+} http_subscription_client_t;
+
+static const char *const s_state_names[] = {"connecting", "active", "resubscribing"};
+
+// Protected by the backend lock, except for the counts read by /api/metrics
+static http_subscription_t s_subscriptions[HTTP_SUBSCRIPTIONS_MAX];
+static http_subscription_client_t s_clients[HTTP_SUBSCRIPTION_CLIENTS_MAX];
+static uint32_t s_next_id = 1; // Client and backend IDs alike, so neither is ever mistaken for the other
+static std::atomic<uint32_t> s_state_counts[3];
+static std::atomic<uint32_t> s_client_count{0};
+static void (*s_change_callback)(void) = nullptr;
+static void (*s_release_callback)(uint32_t id) = nullptr;
+static void (*s_attribute_callback)(uint32_t id, const result_record_t *record) = nullptr;
+
+static uint32_t uptime_ms()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static uint32_t next_id()
+{
+    uint32_t id = s_next_id++;
+    if (s_next_id == 0) {
+        s_next_id = 1;
+    }
+    return id;
+}
+
+static http_subscription_t *find_entry(uint32_t backend_id)
+{
+    if (backend_id == 0) {
+        return nullptr;
+    }
+    for (http_subscription_t &entry : s_subscriptions) {
+        if (entry.id == backend_id) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+static http_subscription_client_t *find_client(uint32_t id)
+{
+    if (id == 0) {
+        return nullptr;
+    }
+    for (http_subscription_client_t &client : s_clients) {
+        if (client.id == id) {
+            return &client;
+        }
+    }
+    return nullptr;
+}
+
+static void notify_change()
+{
+    if (s_change_callback) {
+        s_change_callback();
+    }
+}
+
+static void set_state(http_subscription_t *entry, http_subscription_state_t state)
+{
+    s_state_counts[entry->state].fetch_sub(1, std::memory_order_relaxed);
+    s_state_counts[state].fetch_add(1, std::memory_order_relaxed);
+    entry->state = state;
+}
+
+// Free the entry and every client attached to it, without calling the backend
+static void release_entry(http_subscription_t *entry)
+{
+    size_t slot = entry - s_subscriptions;
+    for (http_subscription_client_t &client : s_clients) {
+        if (client.id != 0 && client.slot == slot) {
+            client.id = 0;
+            s_client_count.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    s_state_counts[entry->state].fetch_sub(1, std::memory_order_relaxed);
+    entry->id = 0;
+    if (entry->clients > 0) {
+        entry->clients = 0;
+        notify_change();
+    }
+}
+
+static bool path_covers(const http_subscription_path_t &outer, const http_subscription_path_t &inner)
+{
+    return (outer.endpoint_id == WILDCARD_ENDPOINT || outer.endpoint_id == inner.endpoint_id) &&
+           (outer.cluster_id == WILDCARD_ID || outer.cluster_id == inner.cluster_id) &&
+           (outer.id == WILDCARD_ID || outer.id == inner.id);
+}
+
+static bool entry_covers(const http_subscription_t *entry, const http_subscription_path_t &path)
+{
+    for (size_t i = 0; i < entry->path_count; ++i) {
+        if (path_covers(entry->paths[i], path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool entry_overlaps(const http_subscription_t *entry, const http_subscription_path_t &path)
+{
+    for (size_t i = 0; i < entry->path_count; ++i) {
+        if (path_covers(entry->paths[i], path) || path_covers(path, entry->paths[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Paths of the request the entry does not cover yet, or -1 if the request shares nothing with it
+static int missing_paths(const http_subscription_t *entry, const http_subscription_path_t *paths, size_t count)
+{
+    int missing = 0;
+    bool overlap = false;
+    for (size_t i = 0; i < count; ++i) {
+        if (entry_covers(entry, paths[i])) {
+            overlap = true;
+        } else {
+            overlap = overlap || entry_overlaps(entry, paths[i]);
+            missing++;
+        }
+    }
+    return overlap ? missing : -1;
+}
+
+// The subscription of the node the request fits best: one covering it, else the smallest merge
+static http_subscription_t *find_shareable(uint64_t node_id, bool events, const http_subscription_path_t *paths,
+                                           size_t count)
+{
+    http_subscription_t *best = nullptr;
+    int best_missing = 0;
+    for (http_subscription_t &entry : s_subscriptions) {
+        if (entry.id == 0 || entry.node_id != node_id || entry.events != events) {
+            continue;
+        }
+        int missing = missing_paths(&entry, paths, count);
+        if (missing < 0 || entry.path_count + missing > HTTP_SUBSCRIPTION_PATHS_MAX) {
+            continue;
+        }
+        if (!best || missing < best_missing) {
+            best = &entry;
+            best_missing = missing;
+        }
+    }
+    return best;
+}
+
+static esp_err_t start_entry(http_subscription_t *entry)
+{
+    uint16_t endpoint_ids[HTTP_SUBSCRIPTION_PATHS_MAX];
+    uint32_t cluster_ids[HTTP_SUBSCRIPTION_PATHS_MAX];
+    uint32_t ids[HTTP_SUBSCRIPTION_PATHS_MAX];
+    for (size_t i = 0; i < entry->path_count; ++i) {
+        endpoint_ids[i] = entry->paths[i].endpoint_id;
+        cluster_ids[i] = entry->paths[i].cluster_id;
+        ids[i] = entry->paths[i].id;
+    }
+    backend_paths_t paths = {endpoint_ids, entry->path_count, cluster_ids, entry->path_count, ids, entry->path_count};
+    if (entry->events) {
+        return http_backend()->subscribe_events(entry->id, entry->node_id, paths, entry->min_interval_requested,
+                                                entry->max_interval_requested);
+    }
+    return http_backend()->subscribe_attributes(entry->id, entry->node_id, paths, entry->min_interval_requested,
+                                                entry->max_interval_requested);
+}
+
+// Tear down the Matter subscription of the entry and start it again with its current paths and intervals
+static esp_err_t restart_entry(http_subscription_t *entry)
+{
+    uint32_t old_id = entry->id;
+    // Renamed first, so the end of the old subscription reported by the backend finds no entry
+    entry->id = next_id();
+    entry->subscription_id = 0;
+    entry->established_ms = 0;
+    set_state(entry, HTTP_SUBSCRIPTION_CONNECTING);
+    http_backend()->unsubscribe(old_id);
+    return start_entry(entry);
+}
+
+// Attach a client, validated by the caller, to a shared or new subscription
+static esp_err_t add_client(uint32_t id, uint64_t node_id, bool events, const http_subscription_path_t *requested,
+                            size_t count, uint16_t min_interval, uint16_t max_interval, bool *out_shared)
+{
+    http_subscription_client_t *client = nullptr;
+    for (http_subscription_client_t &candidate : s_clients) {
+        if (candidate.id == 0) {
+            client = &candidate;
+            break;
+        }
+    }
+    if (!client) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool restart = false;
+    // What the clients already sharing the entry subscribed to, in case extending it fails
+    uint8_t previous_path_count = 0;
+    http_subscription_path_t previous_paths[HTTP_SUBSCRIPTION_PATHS_MAX];
+    uint16_t previous_min_interval = 0;
+    uint16_t previous_max_interval = 0;
+    http_subscription_t *entry = find_shareable(node_id, events, requested, count);
+    if (entry) {
+        previous_path_count = entry->path_count;
+        memcpy(previous_paths, entry->paths, entry->path_count * sizeof(entry->paths[0]));
+        previous_min_interval = entry->min_interval_requested;
+        previous_max_interval = entry->max_interval_requested;
+        for (size_t i = 0; i < count; ++i) {
+            if (!entry_covers(entry, requested[i])) {
+                entry->paths[entry->path_count++] = requested[i];
+                restart = true;
+            }
+        }
+        if (min_interval < entry->min_interval_requested || max_interval < entry->max_interval_requested) {
+            entry->min_interval_requested = std::min(entry->min_interval_requested, min_interval);
+            entry->max_interval_requested = std::min(entry->max_interval_requested, max_interval);
+            restart = true;
+        }
+    } else {
+        for (http_subscription_t &candidate : s_subscriptions) {
+            if (candidate.id == 0) {
+                entry = &candidate;
+                break;
+            }
+        }
+        if (!entry) {
+            return ESP_ERR_NO_MEM;
+        }
+        *entry = http_subscription_t{};
+        entry->id = next_id();
+        entry->node_id = node_id;
+        entry->events = events;
+        entry->state = HTTP_SUBSCRIPTION_CONNECTING;
+        entry->min_interval_requested = min_interval;
+        entry->max_interval_requested = max_interval;
+        entry->created_ms = uptime_ms();
+        entry->path_count = count;
+        memcpy(entry->paths, requested, count * sizeof(requested[0]));
+        s_state_counts[HTTP_SUBSCRIPTION_CONNECTING].fetch_add(1, std::memory_order_relaxed);
+    }
+    *out_shared = entry->clients > 0;
+
+    // Attached before the backend is called: the subscription may end before it returns
+    *client = http_subscription_client_t{};
+    client->id = id;
+    client->created_ms = uptime_ms();
+    client->min_interval = min_interval;
+    client->max_interval = max_interval;
+    client->slot = entry - s_subscriptions;
+    client->path_count = count;
+    memcpy(client->paths, requested, count * sizeof(requested[0]));
+    entry->clients++;
+    s_client_count.fetch_add(1, std::memory_order_relaxed);
+    notify_change();
+
+    esp_err_t err = ESP_OK;
+    if (!*out_shared) {
+        err = start_entry(entry);
+    } else if (restart) {
+        HTTP_LOGI(HTTP_LOG_SUBSCRIPTIONS, "Re-establishing subscription to node 0x%" PRIx64
+                  " for %u clients, %u paths, intervals %u-%u s", node_id, entry->clients, entry->path_count,
+                  entry->min_interval_requested, entry->max_interval_requested);
+        err = restart_entry(entry);
+    }
+    if (err == ESP_OK) {
+        return ESP_OK;
+    }
+    HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Failed to subscribe to node 0x%" PRIx64 " (%s)", node_id, esp_err_to_name(err));
+    if (entry->id == 0) {
+        // The backend already ended the subscription, with every client attached to it
+        return err;
+    }
+    if (!*out_shared) {
+        release_entry(entry);
+        return err;
+    }
+
+    // Only the new client fails: the others get their subscription back as it was
+    client->id = 0;
+    entry->clients--;
+    s_client_count.fetch_sub(1, std::memory_order_relaxed);
+    notify_change();
+    entry->path_count = previous_path_count;
+    memcpy(entry->paths, previous_paths, previous_path_count * sizeof(entry->paths[0]));
+    entry->min_interval_requested = previous_min_interval;
+    entry->max_interval_requested = previous_max_interval;
+    esp_err_t restore_err = restart_entry(entry);
+    if (restore_err != ESP_OK && entry->id != 0) {
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Failed to re-establish subscription %" PRIu32 " to node 0x%" PRIx64
+                  " (%s), released its %u clients", entry->id, node_id, esp_err_to_name(restore_err),
+                  entry->clients);
+        release_entry(entry);
+    }
+    return err;
+}
+
+esp_err_t http_subscription_add(uint64_t node_id, bool events, const backend_paths_t &paths, uint16_t min_interval,
+                                uint16_t max_interval, uint32_t *out_id, bool *out_shared)
+{
+    size_t count = paths.endpoint_count;
+    if (count != paths.cluster_count || count != paths.id_count || count == 0 ||
+        count > HTTP_SUBSCRIPTION_PATHS_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    http_subscription_path_t requested[HTTP_SUBSCRIPTION_PATHS_MAX];
+    for (size_t i = 0; i < count; ++i) {
+        requested[i] = {paths.endpoint_ids[i], paths.cluster_ids[i], paths.ids[i]};
+    }
+    *out_id = next_id();
+    return add_client(*out_id, node_id, events, requested, count, min_interval, max_interval, out_shared);
+}
+
+esp_err_t http_subscription_restore(const http_subscription_record_t *record, bool *out_shared)
+{
+    if (record->path_count == 0 || record->path_count > HTTP_SUBSCRIPTION_PATHS_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (record->id == 0 || find_client(record->id)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return add_client(record->id, record->node_id, record->events, record->paths, record->path_count,
+                      record->min_interval, record->max_interval, out_shared);
+}
+
+void http_subscriptions_reserve_ids(uint32_t max_id)
+{
+    // Restored IDs come from the previous boot, new clients get the ones after them
+    if (max_id >= s_next_id) {
+        s_next_id = max_id + 1 != 0 ? max_id + 1 : 1;
+    }
+}
+
+size_t http_subscriptions_snapshot(http_subscription_record_t *records, size_t max_records)
+{
+    size_t count = 0;
+    for (const http_subscription_client_t &client : s_clients) {
+        if (client.id == 0 || count == max_records) {
+            continue;
+        }
+        const http_subscription_t *entry = &s_subscriptions[client.slot];
+        http_subscription_record_t *record = &records[count++];
+        memset(record, 0, sizeof(*record));
+        record->id = client.id;
+        record->node_id = entry->node_id;
+        record->min_interval = client.min_interval;
+        record->max_interval = client.max_interval;
+        record->events = entry->events;
+        record->path_count = client.path_count;
+        for (size_t i = 0; i < client.path_count; ++i) {
+            // Field by field, the padding of the path structure stays zeroed
+            record->paths[i].endpoint_id = client.paths[i].endpoint_id;
+            record->paths[i].cluster_id = client.paths[i].cluster_id;
+            record->paths[i].id = client.paths[i].id;
+        }
+    }
+    return count;
+}
+
+esp_err_t http_subscription_get_state(uint32_t id, http_subscription_state_t *out_state)
+{
+    http_subscription_client_t *client = find_client(id);
+    if (!client) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *out_state = s_subscriptions[client->slot].state;
+    return ESP_OK;
+}
+
+void http_subscriptions_set_change_callback(void (*callback)(void))
+{
+    s_change_callback = callback;
+}
+
+void http_subscriptions_set_release_callback(void (*callback)(uint32_t id))
+{
+    s_release_callback = callback;
+}
+
+void http_subscriptions_set_attribute_callback(void (*callback)(uint32_t id, const result_record_t *record))
+{
+    s_attribute_callback = callback;
+}
+
+// Re-establish the entry with the union of its clients' paths and their tightest intervals, if that is narrower
+static void narrow_entry(http_subscription_t *entry)
+{
+    size_t slot = entry - s_subscriptions;
+    http_subscription_t wanted{};
+    wanted.min_interval_requested = UINT16_MAX;
+    wanted.max_interval_requested = UINT16_MAX;
+    for (const http_subscription_client_t &client : s_clients) {
+        if (client.id == 0 || client.slot != slot) {
+            continue;
+        }
+        wanted.min_interval_requested = std::min(wanted.min_interval_requested, client.min_interval);
+        wanted.max_interval_requested = std::min(wanted.max_interval_requested, client.max_interval);
+        for (size_t i = 0; i < client.path_count; ++i) {
+            if (entry_covers(&wanted, client.paths[i])) {
+                continue;
+            }
+            // A wildcard replaces the paths it covers
+            size_t kept = 0;
+            for (size_t j = 0; j < wanted.path_count; ++j) {
+                if (!path_covers(client.paths[i], wanted.paths[j])) {
+                    wanted.paths[kept++] = wanted.paths[j];
+                }
+            }
+            wanted.paths[kept++] = client.paths[i];
+            wanted.path_count = kept;
+        }
+    }
+    // The union never exceeds the entry, it is narrower if some path of the entry is no longer covered
+    bool narrowed = wanted.min_interval_requested != entry->min_interval_requested ||
+                    wanted.max_interval_requested != entry->max_interval_requested;
+    for (size_t i = 0; i < entry->path_count && !narrowed; ++i) {
+        narrowed = !entry_covers(&wanted, entry->paths[i]);
+    }
+    if (!narrowed) {
+        return;
+    }
+    entry->path_count = wanted.path_count;
+    memcpy(entry->paths, wanted.paths, wanted.path_count * sizeof(entry->paths[0]));
+    entry->min_interval_requested = wanted.min_interval_requested;
+    entry->max_interval_requested = wanted.max_interval_requested;
+    HTTP_LOGI(HTTP_LOG_SUBSCRIPTIONS, "Re-establishing subscription to node 0x%" PRIx64
+              " for %u clients, %u paths, intervals %u-%u s", entry->node_id, entry->clients, entry->path_count,
+              entry->min_interval_requested, entry->max_interval_requested);
+    esp_err_t err = restart_entry(entry);
+    if (err != ESP_OK && entry->id != 0) {
+        HTTP_LOGW(HTTP_LOG_SUBSCRIPTIONS, "Failed to re-establish subscription %" PRIu32 " to node 0x%" PRIx64
+                  " (%s), released its %u clients", entry->id, entry->node_id, esp_err_to_name(err),
+                  entry->clients);
+        release_entry(entry);
+    }
+}
+
+esp_err_t http_subscription_remove(uint32_t id, uint32_t *out_remaining)
+{
+    http_subscription_client_t *client = find_client(id);
+    if (!client) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    http_subscription_t *entry = &s_subscriptions[client->slot];
+    client->id = 0;
+    s_client_count.fetch_sub(1, std::memory_order_relaxed);
+    entry->clients--;
+    *out_remaining = entry->clients;
+    if (s_release_callback) {
+        s_release_callback(id);
+    }
+    notify_change();
+    if (entry->clients == 0) {
+        uint32_t backend_id = entry->id;
+        release_entry(entry);
+        http_backend()->unsubscribe(backend_id);
+    } else {
+        // The remaining clients may need fewer paths or looser intervals than the one that left
+        narrow_entry(entry);
+        *out_remaining = entry->clients;
+    }
+    return ESP_OK;
+}
+
+esp_err_t http_subscription_shutdown(uint64_t node_id, uint32_t subscription_id)
+{
+    for (http_subscription_t &entry : s_subscriptions) {
+        // In any state: tearing down a resubscribing entry also cancels its pending resubscription
+        if (entry.id != 0 && entry.node_id == node_id && subscription_id != 0 &&
+            entry.subscription_id == subscription_id) {
+            size_t slot = &entry - s_subscriptions;
+            for (const http_subscription_client_t &client : s_clients) {
+                if (client.id != 0 && client.slot == slot && s_release_callback) {
+                    s_release_callback(client.id);
+                }
+            }
+            uint32_t backend_id = entry.id;
+            release_entry(&entry);
+            http_backend()->unsubscribe(backend_id);
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+void http_subscription_established(uint32_t backend_id, uint32_t subscription_id, uint16_t min_interval,
+                                   uint16_t max_interval)
+{
+    http_subscription_t *entry = find_entry(backend_id);
+    if (!entry) {
+        return;
+    }
+    entry->subscription_id = subscription_id;
+    entry->min_interval = min_interval;
+    entry->max_interval = max_interval;
+    entry->established_ms = uptime_ms();
+    set_state(entry, HTTP_SUBSCRIPTION_ACTIVE);
+}
+
+void http_subscription_attribute(uint32_t backend_id, const result_record_t *record)
+{
+    http_subscription_t *entry = s_attribute_callback ? find_entry(backend_id) : nullptr;
+    if (!entry || entry->events) {
+        return;
+    }
+    // The shared subscription may cover more than a client asked for
+    http_subscription_path_t path = {record->endpoint_id, record->cluster_id, record->attribute_id};
+    size_t slot = entry - s_subscriptions;
+    for (const http_subscription_client_t &client : s_clients) {
+        if (client.id == 0 || client.slot != slot) {
+            continue;
+        }
+        for (size_t i = 0; i < client.path_count; ++i) {
+            if (path_covers(client.paths[i], path)) {
+                s_attribute_callback(client.id, record);
+                break;
+            }
+        }
+    }
+}
+
+void http_subscription_report(uint32_t backend_id)
+{
+    http_subscription_t *entry = find_entry(backend_id);
+    if (entry) {
+        entry->last_report_ms = uptime_ms();
+        entry->reports++;
+    }
+}
+
+void http_subscription_resubscribing(uint32_t backend_id, uint32_t retry_ms)
+{
+    http_subscription_t *entry = find_entry(backend_id);
+    if (!entry) {
+        return;
+    }
+    // Kept so the subscription can still be shut down by the ID its clients last saw
+    entry->resubscriptions++;
+    entry->retry_at_ms = uptime_ms() + retry_ms;
+    set_state(entry, HTTP_SUBSCRIPTION_RESUBSCRIBING);
+}
+
+void http_subscription_ended(uint32_t backend_id)
+{
+    http_subscription_t *entry = find_entry(backend_id);
+    if (entry) {
+        release_entry(entry);
+    }
+}
+
+static void add_paths(cJSON *item, bool events, const http_subscription_path_t *entries, size_t count)
+{
+    cJSON *paths = cJSON_AddArrayToObject(item, "paths");
+    for (size_t i = 0; i < count; ++i) {
+        cJSON *path = cJSON_CreateObject();
+        cJSON_AddNumberToObject(path, "endpoint_id", entries[i].endpoint_id);
+        cJSON_AddNumberToObject(path, "cluster_id", entries[i].cluster_id);
+        cJSON_AddNumberToObject(path, events ? "event_id" : "attribute_id", entries[i].id);
+        cJSON_AddItemToArray(paths, path);
+    }
+}
+
+static cJSON *entry_to_json(const http_subscription_t *entry, uint32_t now_ms)
+{
+    cJSON *item = cJSON_CreateObject();
+    if (!item) {
+        return nullptr;
+    }
+    cJSON_AddNumberToObject(item, "node_id", entry->node_id);
+    cJSON_AddStringToObject(item, "type", entry->events ? "event" : "attribute");
+    cJSON_AddStringToObject(item, "state", s_state_names[entry->state]);
+    if (entry->state == HTTP_SUBSCRIPTION_ACTIVE) {
+        cJSON_AddNumberToObject(item, "subscription_id", entry->subscription_id);
+    }
+    add_paths(item, entry->events, entry->paths, entry->path_count);
+
+    cJSON *requested = cJSON_AddObjectToObject(item, "requested");
+    cJSON_AddNumberToObject(requested, "min_interval", entry->min_interval_requested);
+    cJSON_AddNumberToObject(requested, "max_interval", entry->max_interval_requested);
+    if (entry->established_ms != 0) {
+        cJSON_AddNumberToObject(item, "min_interval", entry->min_interval);
+        cJSON_AddNumberToObject(item, "max_interval", entry->max_interval);
+        cJSON_AddNumberToObject(item, "established_ms", entry->established_ms);
+    }
+    cJSON_AddNumberToObject(item, "created_ms", entry->created_ms);
+    cJSON_AddNumberToObject(item, "reports", entry->reports);
+    if (entry->reports > 0) {
+        cJSON_AddNumberToObject(item, "last_report_ms", entry->last_report_ms);
+        cJSON_AddNumberToObject(item, "last_report_age_ms", now_ms - entry->last_report_ms);
+    }
+    cJSON_AddNumberToObject(item, "resubscriptions", entry->resubscriptions);
+    if (entry->state == HTTP_SUBSCRIPTION_RESUBSCRIBING) {
+        int32_t retry_in_ms = (int32_t)(entry->retry_at_ms - now_ms);
+        cJSON_AddNumberToObject(item, "retry_in_ms", retry_in_ms > 0 ? retry_in_ms : 0);
+    }
+
+    cJSON *clients = cJSON_AddArrayToObject(item, "clients");
+    size_t slot = entry - s_subscriptions;
+    for (const http_subscription_client_t &client : s_clients) {
+        if (client.id == 0 || client.slot != slot) {
+            continue;
+        }
+        cJSON *client_item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(client_item, "id", client.id);
+        add_paths(client_item, entry->events, client.paths, client.path_count);
+        cJSON *client_requested = cJSON_AddObjectToObject(client_item, "requested");
+        cJSON_AddNumberToObject(client_requested, "min_interval", client.min_interval);
+        cJSON_AddNumberToObject(client_requested, "max_interval", client.max_interval);
+        cJSON_AddNumberToObject(client_item, "created_ms", client.created_ms);
+        cJSON_AddItemToArray(clients, client_item);
+    }
+    return item;
+}
+
+cJSON *http_subscription_to_json(uint32_t id)
+{
+    http_subscription_client_t *client = find_client(id);
+    return client ? entry_to_json(&s_subscriptions[client->slot], uptime_ms()) : nullptr;
+}
+
+cJSON *http_subscriptions_to_json(const uint64_t *node_id)
+{
+    cJSON *json = cJSON_CreateObject();
+    if (!json) {
+        return nullptr;
+    }
+    uint32_t now_ms = uptime_ms();
+    cJSON_AddNumberToObject(json, "uptime_ms", now_ms);
+    cJSON_AddNumberToObject(json, "capacity", HTTP_SUBSCRIPTIONS_MAX);
+    cJSON_AddNumberToObject(json, "client_capacity", HTTP_SUBSCRIPTION_CLIENTS_MAX);
+    cJSON *subscriptions = cJSON_AddArrayToObject(json, "subscriptions");
+    if (!subscriptions) {
+        cJSON_Delete(json);
+        return nullptr;
+    }
+    for (const http_subscription_t &entry : s_subscriptions) {
+        if (entry.id == 0 || (node_id && entry.node_id != *node_id)) {
+            continue;
+        }
+        cJSON *item = entry_to_json(&entry, now_ms);
+        if (!item) {
+            break;
+        }
+        cJSON_AddItemToArray(subscriptions, item);
+    }
+    return json;
+}
+
+void http_subscriptions_count(uint32_t *connecting, uint32_t *active, uint32_t *resubscribing, uint32_t *clients)
+{
+    *connecting = s_state_counts[HTTP_SUBSCRIPTION_CONNECTING].load(std::memory_order_relaxed);
+    *active = s_state_counts[HTTP_SUBSCRIPTION_ACTIVE].load(std::memory_order_relaxed);
+    *resubscribing = s_state_counts[HTTP_SUBSCRIPTION_RESUBSCRIBING].load(std::memory_order_relaxed);
+    *clients = s_client_count.load(std::memory_order_relaxed);
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
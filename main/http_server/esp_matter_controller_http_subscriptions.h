@@ -0,0 +1,186 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_err.h>
+#include <esp_matter_controller_http_backend.h>
+#include <esp_matter_controller_http_results.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_SUBSCRIPTIONS_MAX 16        // Matter subscriptions kept alive for the API at once
+#define HTTP_SUBSCRIPTION_PATHS_MAX 8    // Paths per subscription, shared ones included
+#define HTTP_SUBSCRIPTION_CLIENTS_MAX 32 // Subscription IDs handed out, several may share one Matter subscription
+
+typedef struct {
+    uint16_t endpoint_id;
+    uint32_t cluster_id;
+    uint32_t id; // Attribute or event ID
+} http_subscription_path_t;
+
+/**
+ * @brief A client subscription as persisted, see http_subscriptions_snapshot()
+ */
+typedef struct {
+    uint32_t id;
+    uint64_t node_id;
+    uint16_t min_interval;
+    uint16_t max_interval;
+    uint8_t events;
+    uint8_t path_count;
+    http_subscription_path_t paths[HTTP_SUBSCRIPTION_PATHS_MAX];
+} http_subscription_record_t;
+
+/**
+ * @brief Lifecycle of a registered subscription
+ */
+typedef enum : uint8_t {
+    HTTP_SUBSCRIPTION_CONNECTING = 0, // Session lookup, request sent, waiting for the priming report
+    HTTP_SUBSCRIPTION_ACTIVE,         // Established, reports flowing
+    HTTP_SUBSCRIPTION_RESUBSCRIBING,  // Lost, the backend retries after a back-off
+} http_subscription_state_t;
+
+/**
+ * @brief Subscribe a client, sharing a Matter subscription when one fits
+ *
+ * Each call hands out a new subscription ID, but clients asking for the same
+ * node and kind of paths share one Matter subscription: a request whose paths
+ * an existing subscription covers joins it, one that overlaps it is merged
+ * into it if the union fits in HTTP_SUBSCRIPTION_PATHS_MAX paths. The shared
+ * subscription uses the tightest intervals of its clients; when a client
+ * needs wider paths or tighter intervals it is re-established, as it is when
+ * the clients left need fewer paths or looser intervals, and it is torn down
+ * when its last client leaves. If re-establishing it fails, only the new
+ * client fails: the subscription is started again with the paths and
+ * intervals its other clients had.
+ *
+ * The backend is called under an internal ID of the shared subscription,
+ * which the callbacks below take. Every function of the registry is called
+ * with the backend lock held, from the handlers and from the backend
+ * callbacks alike.
+ *
+ * @param events Event paths rather than attribute paths
+ * @param out_id Subscription ID of the client
+ * @param out_shared Set if an existing subscription was reused or extended
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if HTTP_SUBSCRIPTIONS_MAX
+ *         subscriptions or HTTP_SUBSCRIPTION_CLIENTS_MAX clients are alive,
+ *         ESP_ERR_INVALID_SIZE if the lists differ in length or hold more than
+ *         HTTP_SUBSCRIPTION_PATHS_MAX paths, or the error of the backend
+ */
+esp_err_t http_subscription_add(uint64_t node_id, bool events, const backend_paths_t &paths, uint16_t min_interval,
+                                uint16_t max_interval, uint32_t *out_id, bool *out_shared);
+
+/**
+ * @brief Release the subscription ID of a client, narrowing the shared subscription to the clients left
+ * @param out_remaining Clients left on the shared subscription, 0 once it is torn down
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the ID is unknown
+ */
+esp_err_t http_subscription_remove(uint32_t id, uint32_t *out_remaining);
+
+/**
+ * @brief Tear down a registered subscription by its Matter subscription ID, for all its clients
+ *
+ * A subscription waiting to resubscribe still matches the ID it lost, its
+ * pending resubscription is cancelled.
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no registered subscription matches
+ */
+esp_err_t http_subscription_shutdown(uint64_t node_id, uint32_t subscription_id);
+
+/**
+ * @brief Subscribe a client again under its recorded ID, e.g. after a reboot
+ *
+ * Shares and merges subscriptions like http_subscription_add().
+ *
+ * @return ESP_ERR_INVALID_STATE if the ID is in use, otherwise as http_subscription_add()
+ */
+esp_err_t http_subscription_restore(const http_subscription_record_t *record, bool *out_shared);
+
+/**
+ * @brief Hand out IDs above max_id only, so restored IDs cannot be taken by new clients
+ */
+void http_subscriptions_reserve_ids(uint32_t max_id);
+
+/**
+ * @brief Copy the client subscriptions, unused bytes zeroed so equal sets compare equal
+ * @return Number of records written
+ */
+size_t http_subscriptions_snapshot(http_subscription_record_t *records, size_t max_records);
+
+/**
+ * @brief State of the subscription a client is attached to
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the client is gone
+ */
+esp_err_t http_subscription_get_state(uint32_t id, http_subscription_state_t *out_state);
+
+/**
+ * @brief Called, with the backend lock held, whenever the set of clients changes
+ */
+void http_subscriptions_set_change_callback(void (*callback)(void));
+
+/**
+ * @brief Called, with the backend lock held, for each client released on request rather than by the device
+ */
+void http_subscriptions_set_release_callback(void (*callback)(uint32_t id));
+
+/**
+ * @brief Called, with the backend lock held, for each attribute report a client's paths cover
+ */
+void http_subscriptions_set_attribute_callback(void (*callback)(uint32_t id, const result_record_t *record));
+
+/**
+ * @brief The device accepted the subscription with these negotiated intervals
+ */
+void http_subscription_established(uint32_t backend_id, uint32_t subscription_id, uint16_t min_interval,
+                                   uint16_t max_interval);
+
+/**
+ * @brief An attribute value was reported, passed on to the clients whose paths cover it
+ *
+ * Backends only need to decode and report values while http_streams_active().
+ */
+void http_subscription_attribute(uint32_t backend_id, const result_record_t *record);
+
+/**
+ * @brief A report for the subscription was received, priming report included
+ */
+void http_subscription_report(uint32_t backend_id);
+
+/**
+ * @brief The subscription was lost and is retried in retry_ms
+ */
+void http_subscription_resubscribing(uint32_t backend_id, uint32_t retry_ms);
+
+/**
+ * @brief The subscription is gone for good, its entry and its clients are released
+ */
+void http_subscription_ended(uint32_t backend_id);
+
+/**
+ * @brief The subscription a client is attached to, as JSON
+ * @return New cJSON object, NULL if the ID is unknown or on allocation failure
+ */
+cJSON *http_subscription_to_json(uint32_t id);
+
+/**
+ * @brief Registered subscriptions and their clients as JSON
+ * @param node_id Only list the subscriptions to this node, NULL for all of them
+ * @return New cJSON object, NULL on allocation failure
+ */
+cJSON *http_subscriptions_to_json(const uint64_t *node_id);
+
+/**
+ * @brief Number of registered subscriptions per state and of clients, for /api/metrics
+ */
+void http_subscriptions_count(uint32_t *connecting, uint32_t *active, uint32_t *resubscribing, uint32_t *clients);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,247 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_telemetry.h>
+#include <esp_matter_controller_http_arena.h>
+#include <esp_matter_controller_http_recorder.h>
+#include <esp_matter_controller_http_timing.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+static const char *TAG = "controller_httptelemetry";
+
+#define HEAP_CAPS_INTERNAL (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+
+typedef struct {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    http_endpoint_stats_t stats;
+    http_endpoint_metrics metrics;
+} http_endpoint_t;
+
+// Handlers and the stats endpoint all run on the single httpd task, so the
+// table needs no locking
+static http_endpoint_t s_endpoints[HTTP_ENDPOINT_MAX];
+static size_t s_endpoint_count = 0;
+static int s_status_code = 0; // Status of the response sent by the running handler, 0 if none yet
+static uint64_t s_node_id = 0; // Node targeted by the running handler, 0 if none
+
+static const char *method_to_string(httpd_method_t method)
+{
+    switch (method) {
+        case HTTP_GET: return "GET";
+        case HTTP_POST: return "POST";
+        case HTTP_PUT: return "PUT";
+        case HTTP_DELETE: return "DELETE";
+        case HTTP_HEAD: return "HEAD";
+        case HTTP_OPTIONS: return "OPTIONS";
+        default: return "OTHER";
+    }
+}
+
+static void record_request(const http_endpoint_t *endpoint, int64_t start, uint32_t duration, int status,
+                           int32_t heap_delta, esp_err_t ret)
+{
+    const http_stage_times &times = http_timing_current();
+    http_record_t record;
+    record.uri = endpoint->uri;
+    record.node_id = s_node_id;
+    record.start_ms = (uint32_t)(start / 1000);
+    record.total_us = duration;
+    for (size_t stage = 0; stage < HTTP_STAGE_COUNT; ++stage) {
+        record.stage_us[stage] = times.us[stage].load(std::memory_order_relaxed);
+    }
+    record.heap_delta = heap_delta;
+    record.status = (uint16_t)status;
+    record.method = (uint8_t)endpoint->method;
+    record.stages = (uint8_t)times.recorded.load(std::memory_order_relaxed);
+    record.flags = ret != ESP_OK ? HTTP_RECORD_HANDLER_ERROR : 0;
+    http_recorder_add(&record);
+}
+
+static esp_err_t instrumented_handler(httpd_req_t *req)
+{
+    http_endpoint_t *endpoint = (http_endpoint_t *)req->user_ctx;
+    http_endpoint_stats_t *stats = &endpoint->stats;
+
+    size_t free_before = heap_caps_get_free_size(HEAP_CAPS_INTERNAL);
+    size_t largest_before = heap_caps_get_largest_free_block(HEAP_CAPS_INTERNAL);
+    int64_t start = esp_timer_get_time();
+
+    esp_err_t ret;
+    size_t arena_used;
+    s_status_code = 0;
+    s_node_id = 0;
+    http_timing_begin();
+    {
+        http_arena_scope arena;
+        ret = endpoint->handler(req);
+        arena_used = arena.used();
+    }
+
+    uint32_t duration = (uint32_t)(esp_timer_get_time() - start);
+    size_t free_after = heap_caps_get_free_size(HEAP_CAPS_INTERNAL);
+    size_t largest_after = heap_caps_get_largest_free_block(HEAP_CAPS_INTERNAL);
+    uint32_t stack_hwm = uxTaskGetStackHighWaterMark(NULL);
+    int32_t heap_delta = (int32_t)free_before - (int32_t)free_after;
+
+    if (stats->calls == 0 || heap_delta > stats->heap_delta_max) {
+        stats->heap_delta_max = heap_delta;
+    }
+    if (stats->calls == 0 || largest_before < stats->largest_block_before_min) {
+        stats->largest_block_before_min = largest_before;
+    }
+    if (stats->calls == 0 || largest_after < stats->largest_block_after_min) {
+        stats->largest_block_after_min = largest_after;
+    }
+    if (stats->calls == 0 || stack_hwm < stats->stack_hwm_min) {
+        stats->stack_hwm_min = stack_hwm;
+    }
+    if (arena_used > stats->arena_used_max) {
+        stats->arena_used_max = arena_used;
+    }
+    if (duration > stats->duration_us_max) {
+        stats->duration_us_max = duration;
+    }
+    stats->heap_delta_last = heap_delta;
+    stats->heap_delta_total += heap_delta;
+    stats->duration_us_total += duration;
+    stats->calls++;
+    if (ret != ESP_OK) {
+        stats->errors++;
+    }
+    int status = s_status_code ? s_status_code : (ret == ESP_OK ? 200 : 500);
+    endpoint->metrics.observe(status, duration);
+    record_request(endpoint, start, duration, status, heap_delta, ret);
+    return ret;
+}
+
+void http_endpoint_set_node(uint64_t node_id)
+{
+    s_node_id = node_id;
+}
+
+void http_endpoint_set_status(int status_code)
+{
+    s_status_code = status_code;
+}
+
+esp_err_t http_endpoint_register(httpd_handle_t server, const httpd_uri_t *uri)
+{
+    if (s_endpoint_count >= HTTP_ENDPOINT_MAX) {
+        ESP_LOGE(TAG, "No room to register %s", uri->uri);
+        return ESP_ERR_NO_MEM;
+    }
+    http_endpoint_t *endpoint = &s_endpoints[s_endpoint_count];
+    endpoint->stats = http_endpoint_stats_t{};
+    endpoint->metrics.reset();
+    endpoint->uri = uri->uri;
+    endpoint->method = uri->method;
+    endpoint->handler = uri->handler;
+
+    httpd_uri_t wrapped = *uri;
+    wrapped.handler = instrumented_handler;
+    wrapped.user_ctx = endpoint;
+    esp_err_t err = httpd_register_uri_handler(server, &wrapped);
+    if (err == ESP_OK) {
+        s_endpoint_count++;
+    }
+    return err;
+}
+
+void http_endpoints_reset(void)
+{
+    s_endpoint_count = 0;
+}
+
+cJSON *http_endpoints_to_json(size_t stack_size)
+{
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "stack_size", stack_size);
+
+    cJSON *endpoints = cJSON_AddArrayToObject(json, "endpoints");
+    for (size_t i = 0; i < s_endpoint_count; ++i) {
+        const http_endpoint_t *endpoint = &s_endpoints[i];
+        const http_endpoint_stats_t *stats = &endpoint->stats;
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "uri", endpoint->uri);
+        cJSON_AddStringToObject(item, "method", method_to_string(endpoint->method));
+        cJSON_AddNumberToObject(item, "calls", stats->calls);
+        cJSON_AddNumberToObject(item, "errors", stats->errors);
+        if (stats->calls > 0) {
+            cJSON *heap = cJSON_AddObjectToObject(item, "heap");
+            cJSON_AddNumberToObject(heap, "delta_last", stats->heap_delta_last);
+            cJSON_AddNumberToObject(heap, "delta_max", stats->heap_delta_max);
+            cJSON_AddNumberToObject(heap, "delta_avg", (double)(stats->heap_delta_total / stats->calls));
+            cJSON_AddNumberToObject(heap, "largest_free_block_before_min", stats->largest_block_before_min);
+            cJSON_AddNumberToObject(heap, "largest_free_block_after_min", stats->largest_block_after_min);
+            cJSON_AddNumberToObject(item, "stack_high_water_mark", stats->stack_hwm_min);
+            cJSON_AddNumberToObject(item, "arena_used_max", stats->arena_used_max);
+            cJSON_AddNumberToObject(item, "duration_us_avg", (double)(stats->duration_us_total / stats->calls));
+            cJSON_AddNumberToObject(item, "duration_us_max", stats->duration_us_max);
+        }
+        cJSON_AddItemToArray(endpoints, item);
+    }
+    return json;
+}
+
+void http_endpoints_write_metrics(metrics_writer *writer)
+{
+    writer->family("matter_http_requests_total", "counter", "Requests handled per endpoint");
+    for (size_t i = 0; i < s_endpoint_count; ++i) {
+        const http_endpoint_t *endpoint = &s_endpoints[i];
+        uint32_t requests = 0;
+        for (const std::atomic<uint32_t> &count : endpoint->metrics.status) {
+            requests += count.load(std::memory_order_relaxed);
+        }
+        writer->printf("matter_http_requests_total{path=\"%s\",method=\"%s\"} %" PRIu32 "\n", endpoint->uri,
+                       method_to_string(endpoint->method), requests);
+    }
+
+    // Codes an endpoint never returned are left out rather than exported as zero
+    writer->family("matter_http_responses_total", "counter", "Responses per endpoint and status code");
+    for (size_t i = 0; i < s_endpoint_count; ++i) {
+        const http_endpoint_t *endpoint = &s_endpoints[i];
+        for (size_t code = 0; code <= HTTP_METRICS_STATUS_CODES; ++code) {
+            uint32_t count = endpoint->metrics.status[code].load(std::memory_order_relaxed);
+            if (count == 0) {
+                continue;
+            }
+            char code_str[8];
+            if (code < HTTP_METRICS_STATUS_CODES) {
+                snprintf(code_str, sizeof(code_str), "%u", http_metrics_status_codes[code]);
+            } else {
+                strlcpy(code_str, "other", sizeof(code_str));
+            }
+            writer->printf("matter_http_responses_total{path=\"%s\",method=\"%s\",code=\"%s\"} %" PRIu32 "\n",
+                           endpoint->uri, method_to_string(endpoint->method), code_str, count);
+        }
+    }
+
+    writer->family("matter_http_request_duration_seconds", "histogram", "Handler latency per endpoint");
+    for (size_t i = 0; i < s_endpoint_count; ++i) {
+        const http_endpoint_t *endpoint = &s_endpoints[i];
+        char labels[96];
+        snprintf(labels, sizeof(labels), "path=\"%s\",method=\"%s\"", endpoint->uri,
+                 method_to_string(endpoint->method));
+        writer->histogram("matter_http_request_duration_seconds", labels, endpoint->metrics.latency);
+    }
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include <esp_matter_controller_http_metrics.h>
+#include <cJSON.h>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define HTTP_ENDPOINT_MAX 32 // Routes that can be registered through http_endpoint_register()
+
+/**
+ * @brief Resource usage aggregated over the calls of one endpoint
+ */
+typedef struct {
+    uint32_t calls;
+    uint32_t errors;               // Calls whose handler returned an error
+    int64_t heap_delta_total;      // Sum of internal heap consumed per call, negative if memory was released
+    int32_t heap_delta_max;        // Largest internal heap consumed by a single call
+    int32_t heap_delta_last;
+    uint32_t largest_block_before_min; // Smallest largest-free-block seen before a call
+    uint32_t largest_block_after_min;  // Smallest largest-free-block seen after a call
+    uint32_t stack_hwm_min;        // Lowest httpd task stack high-water mark seen after a call, in bytes
+    uint32_t arena_used_max;       // Largest request arena usage, in bytes
+    uint64_t duration_us_total;
+    uint32_t duration_us_max;
+} http_endpoint_stats_t;
+
+/**
+ * @brief Register a URI handler with per-call heap and stack instrumentation
+ *
+ * The handler runs inside a request arena scope. The wrapper owns
+ * req->user_ctx, so the wrapped handlers must not rely on it.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if HTTP_ENDPOINT_MAX is reached,
+ *         or the error from httpd_register_uri_handler()
+ */
+esp_err_t http_endpoint_register(httpd_handle_t server, const httpd_uri_t *uri);
+
+/**
+ * @brief Note the status code of the response being sent, for the request counters
+ *
+ * Requests that never call it are counted as 200 if the handler succeeded
+ * and 500 otherwise.
+ */
+void http_endpoint_set_status(int status_code);
+
+/**
+ * @brief Note the node the running request targets, for the flight recorder
+ *
+ * Requests that never call it are recorded without a node.
+ */
+void http_endpoint_set_node(uint64_t node_id);
+
+/**
+ * @brief Forget all registered endpoints, to be called once the server is stopped
+ */
+void http_endpoints_reset(void);
+
+/**
+ * @brief Per-endpoint aggregates as JSON
+ * @param stack_size Configured httpd task stack size, reported alongside the watermarks
+ * @return New cJSON object
+ */
+cJSON *http_endpoints_to_json(size_t stack_size);
+
+/**
+ * @brief Per-endpoint request counters and latency histograms in Prometheus format
+ */
+void http_endpoints_write_metrics(metrics_writer *writer);
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_timing.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define TIMING_HEADER_SIZE 192 // Every stage plus total, even at the largest 32-bit durations
+#define TIMING_QUERY_MAX 192   // Longer query strings are not searched for timing=1
+
+// Names used both as Server-Timing metric names and, with "_us" appended, as JSON keys
+static const char *const s_stage_names[HTTP_STAGE_COUNT] = {"parse", "lock", "case", "device", "decode", "serialize"};
+
+// Handlers all run on the single httpd task, like the endpoint table
+static http_stage_times s_request_times;
+static int64_t s_request_start_us = 0;
+static TaskHandle_t s_request_task = nullptr;
+static char s_header[TIMING_HEADER_SIZE];
+
+void http_stage_times::add(http_stage_t stage, uint32_t duration_us)
+{
+    us[stage].fetch_add(duration_us, std::memory_order_relaxed);
+    recorded.fetch_or(1u << stage, std::memory_order_relaxed);
+}
+
+void http_stage_times::merge(const http_stage_times &other)
+{
+    uint32_t other_recorded = other.recorded.load(std::memory_order_relaxed);
+    for (size_t stage = 0; stage < HTTP_STAGE_COUNT; ++stage) {
+        if (other_recorded & (1u << stage)) {
+            add((http_stage_t)stage, other.us[stage].load(std::memory_order_relaxed));
+        }
+    }
+}
+
+void http_stage_times::reset()
+{
+    for (std::atomic<uint32_t> &stage_us : us) {
+        stage_us.store(0, std::memory_order_relaxed);
+    }
+    recorded.store(0, std::memory_order_relaxed);
+}
+
+const char *http_stage_name(http_stage_t stage)
+{
+    return stage < HTTP_STAGE_COUNT ? s_stage_names[stage] : "unknown";
+}
+
+void http_timing_begin()
+{
+    s_request_times.reset();
+    s_request_start_us = esp_timer_get_time();
+    s_request_task = xTaskGetCurrentTaskHandle();
+}
+
+void http_timing_add(http_stage_t stage, uint32_t duration_us)
+{
+    if (xTaskGetCurrentTaskHandle() == s_request_task) {
+        s_request_times.add(stage, duration_us);
+    }
+}
+
+void http_timing_merge(const http_stage_times &times)
+{
+    if (xTaskGetCurrentTaskHandle() == s_request_task) {
+        s_request_times.merge(times);
+    }
+}
+
+const http_stage_times &http_timing_current()
+{
+    return s_request_times;
+}
+
+void http_timing_set_header(httpd_req_t *req)
+{
+    uint32_t recorded = s_request_times.recorded.load(std::memory_order_relaxed);
+    size_t len = 0;
+    for (size_t stage = 0; stage < HTTP_STAGE_COUNT; ++stage) {
+        if (recorded & (1u << stage)) {
+            uint32_t stage_us = s_request_times.us[stage].load(std::memory_order_relaxed);
+            len += snprintf(s_header + len, sizeof(s_header) - len, "%s;dur=%" PRIu32 ".%03" PRIu32 ", ",
+                            s_stage_names[stage], stage_us / 1000, stage_us % 1000);
+            if (len >= sizeof(s_header)) {
+                return;
+            }
+        }
+    }
+    uint32_t total_us = http_elapsed_us(s_request_start_us);
+    len += snprintf(s_header + len, sizeof(s_header) - len, "total;dur=%" PRIu32 ".%03" PRIu32, total_us / 1000,
+                    total_us % 1000);
+    if (len < sizeof(s_header)) {
+        httpd_resp_set_hdr(req, "Server-Timing", s_header);
+    }
+}
+
+bool http_timing_requested(httpd_req_t *req)
+{
+    char query[TIMING_QUERY_MAX];
+    size_t query_len = httpd_req_get_url_query_len(req);
+    if (query_len == 0 || query_len >= sizeof(query) ||
+        httpd_req_get_url_query_str(req, query, sizeof(query)) != ESP_OK) {
+        return false;
+    }
+    char value[4];
+    return httpd_query_key_value(query, "timing", value, sizeof(value)) == ESP_OK &&
+           (strcmp(value, "1") == 0 || strcmp(value, "true") == 0);
+}
+
+cJSON *http_timing_to_json()
+{
+    cJSON *json = cJSON_CreateObject();
+    if (!json) {
+        return nullptr;
+    }
+    uint32_t recorded = s_request_times.recorded.load(std::memory_order_relaxed);
+    for (size_t stage = 0; stage < HTTP_STAGE_COUNT; ++stage) {
+        if (recorded & (1u << stage)) {
+            char key[16];
+            snprintf(key, sizeof(key), "%s_us", s_stage_names[stage]);
+            cJSON_AddNumberToObject(json, key, s_request_times.us[stage].load(std::memory_order_relaxed));
+        }
+    }
+    cJSON_AddNumberToObject(json, "total_us", http_elapsed_us(s_request_start_us));
+    return json;
+}
+
+http_stage_timer::http_stage_timer(http_stage_t stage)
+    : m_stage(stage), m_start_us(esp_timer_get_time()), m_running(true)
+{
+}
+
+http_stage_timer::~http_stage_timer()
+{
+    stop();
+}
+
+void http_stage_timer::stop()
+{
+    if (m_running) {
+        http_timing_add(m_stage, http_elapsed_us(m_start_us));
+        m_running = false;
+    }
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
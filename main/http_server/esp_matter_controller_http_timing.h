@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cJSON.h>
+#include <esp_err.h>
+#include <esp_http_server.h>
+#include <esp_timer.h>
+#include <atomic>
+#include <stdint.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+/**
+ * @brief Stages a request's time is attributed to
+ */
+typedef enum : uint8_t {
+    HTTP_STAGE_PARSE = 0, // Reading and parsing the request body
+    HTTP_STAGE_LOCK,      // Waiting for the Matter stack lock
+    HTTP_STAGE_CASE,      // Session lookup or CASE establishment
+    HTTP_STAGE_DEVICE,    // Request sent to last report or status, decoding excluded
+    HTTP_STAGE_DECODE,    // Decoding the reported TLV into result records
+    HTTP_STAGE_SERIALIZE, // Building and printing the response body
+    HTTP_STAGE_COUNT,
+} http_stage_t;
+
+/**
+ * @brief Time spent per stage, in microseconds
+ *
+ * Stages can be added to from any task with relaxed atomics, so a pending
+ * operation carries one for the CHIP thread to fill in and the handler merges
+ * it into its request once the operation completed.
+ */
+struct http_stage_times {
+    std::atomic<uint32_t> us[HTTP_STAGE_COUNT];
+    std::atomic<uint32_t> recorded; // Bit per stage that was timed at least once
+
+    void add(http_stage_t stage, uint32_t duration_us);
+    void merge(const http_stage_times &other);
+    void reset();
+};
+
+/**
+ * @brief Name of a stage, as used in the Server-Timing header
+ */
+const char *http_stage_name(http_stage_t stage);
+
+/**
+ * @brief Microseconds elapsed since a timestamp taken with esp_timer_get_time()
+ */
+static inline uint32_t http_elapsed_us(int64_t since_us)
+{
+    return (uint32_t)(esp_timer_get_time() - since_us);
+}
+
+/**
+ * @brief Start timing the request about to be handled
+ *
+ * Called by the endpoint wrapper. The request timing is kept per server, as
+ * handlers all run on the single httpd task.
+ */
+void http_timing_begin();
+
+/**
+ * @brief Add the duration of a stage to the running request
+ *
+ * Only the httpd task times requests: calls from other tasks, such as the
+ * job workers sharing the helpers of the handlers, are ignored.
+ */
+void http_timing_add(http_stage_t stage, uint32_t duration_us);
+
+/**
+ * @brief Add the stages timed by a completed Matter interaction to the running request
+ */
+void http_timing_merge(const http_stage_times &times);
+
+/**
+ * @brief Stages timed so far for the running request
+ */
+const http_stage_times &http_timing_current();
+
+/**
+ * @brief Set the Server-Timing header of the response from the stages timed so far
+ *
+ * Durations are in milliseconds as the header defines them, followed by a
+ * "total" entry for the time since the handler started. Call right before
+ * the response is sent: the header value lives in a buffer reused by the
+ * next request.
+ */
+void http_timing_set_header(httpd_req_t *req);
+
+/**
+ * @brief Whether the client asked for the timing field, with timing=1 in the query string
+ */
+bool http_timing_requested(httpd_req_t *req);
+
+/**
+ * @brief JSON object of the stages timed so far, in microseconds, plus total_us
+ */
+cJSON *http_timing_to_json();
+
+/**
+ * @brief Time a stage of the running request until stop() or the end of the scope
+ */
+class http_stage_timer {
+public:
+    explicit http_stage_timer(http_stage_t stage);
+    ~http_stage_timer();
+
+    void stop();
+
+    http_stage_timer(const http_stage_timer &) = delete;
+    http_stage_timer &operator=(const http_stage_timer &) = delete;
+
+private:
+    http_stage_t m_stage;
+    int64_t m_start_us;
+    bool m_running;
+};
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
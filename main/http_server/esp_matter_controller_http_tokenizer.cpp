@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <esp_matter_controller_http_tokenizer.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+typedef struct {
+    const char *buf;
+    size_t len;
+    size_t pos;
+    json_token_t *tokens;
+    size_t max_tokens;
+    size_t count;
+    uint8_t depth;
+} tokenizer_t;
+
+static json_tokenize_result_t parse_value(tokenizer_t *t);
+
+static void skip_whitespace(tokenizer_t *t)
+{
+    while (t->pos < t->len) {
+        char c = t->buf[t->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        t->pos++;
+    }
+}
+
+static json_token_t *alloc_token(tokenizer_t *t, json_token_type_t type)
+{
+    if (t->count >= t->max_tokens) {
+        return NULL;
+    }
+    json_token_t *token = &t->tokens[t->count++];
+    token->type = type;
+    token->start = t->pos;
+    token->end = t->pos;
+    token->size = 0;
+    token->next = t->count;
+    return token;
+}
+
+static json_tokenize_result_t parse_string(tokenizer_t *t)
+{
+    json_token_t *token = alloc_token(t, JSON_TOKEN_STRING);
+    if (!token) {
+        return JSON_TOKENIZE_UNSUPPORTED;
+    }
+    token->start = ++t->pos;
+    while (t->pos < t->len) {
+        char c = t->buf[t->pos];
+        if (c == '"') {
+            token->end = t->pos++;
+            return JSON_TOKENIZE_OK;
+        }
+        if ((unsigned char)c < 0x20) {
+            return JSON_TOKENIZE_INVALID;
+        }
+        if (c == '\\') {
+            if (++t->pos >= t->len) {
+                return JSON_TOKENIZE_INVALID;
+            }
+            switch (t->buf[t->pos]) {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                // Needs UTF-8 encoding and surrogate handling, rare enough to leave to cJSON
+                return JSON_TOKENIZE_UNSUPPORTED;
+            default:
+                return JSON_TOKENIZE_INVALID;
+            }
+        }
+        t->pos++;
+    }
+    return JSON_TOKENIZE_INVALID;
+}
+
+static bool is_number_literal(const char *start, const char *end)
+{
+    // JSON numbers only: strtod alone would also take hex, inf and nan
+    if (*start != '-' && (*start < '0' || *start > '9')) {
+        return false;
+    }
+    for (const char *p = start; p < end; ++p) {
+        if (!((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E')) {
+            return false;
+        }
+    }
+    char *parsed_end = NULL;
+    strtod(start, &parsed_end);
+    return parsed_end == end;
+}
+
+static bool is_literal(const char *start, size_t len, const char *literal)
+{
+    return len == strlen(literal) && memcmp(start, literal, len) == 0;
+}
+
+static json_tokenize_result_t parse_primitive(tokenizer_t *t)
+{
+    json_token_t *token = alloc_token(t, JSON_TOKEN_PRIMITIVE);
+    if (!token) {
+        return JSON_TOKENIZE_UNSUPPORTED;
+    }
+    while (t->pos < t->len) {
+        char c = t->buf[t->pos];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E')) {
+            break;
+        }
+        t->pos++;
+    }
+    token->end = t->pos;
+
+    const char *start = t->buf + token->start;
+    size_t len = token->end - token->start;
+    if (len == 0 || !(is_literal(start, len, "true") || is_literal(start, len, "false") ||
+                      is_literal(start, len, "null") || is_number_literal(start, t->buf + token->end))) {
+        return JSON_TOKENIZE_INVALID;
+    }
+    return JSON_TOKENIZE_OK;
+}
+
+static json_tokenize_result_t parse_container(tokenizer_t *t, bool is_object)
+{
+    if (t->depth >= JSON_TOKENIZER_MAX_DEPTH) {
+        return JSON_TOKENIZE_UNSUPPORTED;
+    }
+    // Recursion is bounded by JSON_TOKENIZER_MAX_DEPTH
+    size_t index = t->count;
+    if (!alloc_token(t, is_object ? JSON_TOKEN_OBJECT : JSON_TOKEN_ARRAY)) {
+        return JSON_TOKENIZE_UNSUPPORTED;
+    }
+    char close = is_object ? '}' : ']';
+    t->pos++;
+    t->depth++;
+
+    skip_whitespace(t);
+    if (t->pos < t->len && t->buf[t->pos] == close) {
+        t->pos++;
+    } else {
+        while (true) {
+            json_tokenize_result_t ret;
+            if (is_object) {
+                skip_whitespace(t);
+                if (t->pos >= t->len || t->buf[t->pos] != '"') {
+                    return JSON_TOKENIZE_INVALID;
+                }
+                if ((ret = parse_string(t)) != JSON_TOKENIZE_OK) {
+                    return ret;
+                }
+                skip_whitespace(t);
+                if (t->pos >= t->len || t->buf[t->pos] != ':') {
+                    return JSON_TOKENIZE_INVALID;
+                }
+                t->pos++;
+            }
+            if ((ret = parse_value(t)) != JSON_TOKENIZE_OK) {
+                return ret;
+            }
+            t->tokens[index].size++;
+            skip_whitespace(t);
+            if (t->pos < t->len && t->buf[t->pos] == ',') {
+                t->pos++;
+                continue;
+            }
+            if (t->pos < t->len && t->buf[t->pos] == close) {
+                t->pos++;
+                break;
+            }
+            return JSON_TOKENIZE_INVALID;
+        }
+    }
+
+    t->depth--;
+    t->tokens[index].end = t->pos;
+    t->tokens[index].next = t->count;
+    return JSON_TOKENIZE_OK;
+}
+
+static json_tokenize_result_t parse_value(tokenizer_t *t)
+{
+    skip_whitespace(t);
+    if (t->pos >= t->len) {
+        return JSON_TOKENIZE_INVALID;
+    }
+    switch (t->buf[t->pos]) {
+    case '{':
+        return parse_container(t, true);
+    case '[':
+        return parse_container(t, false);
+    case '"':
+        return parse_string(t);
+    default:
+        return parse_primitive(t);
+    }
+}
+
+// Rewrite escape sequences in place, the result is never longer than the source
+static void unescape_string(char *buf, json_token_t *token)
+{
+    char *out = buf + token->start;
+    for (size_t i = token->start; i < token->end; ++i) {
+        char c = buf[i];
+        if (c == '\\') {
+            switch (buf[++i]) {
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            default: c = buf[i]; break;
+            }
+        }
+        *out++ = c;
+    }
+    *out = '\0';
+}
+
+json_tokenize_result_t json_tokenize(char *buf, size_t len, json_token_t *tokens, size_t max_tokens,
+                                     size_t *count)
+{
+    if (len > JSON_TOKENIZER_MAX_LENGTH) {
+        return JSON_TOKENIZE_UNSUPPORTED;
+    }
+    tokenizer_t t = {buf, len, 0, tokens, max_tokens, 0, 0};
+    json_tokenize_result_t ret = parse_value(&t);
+    if (ret != JSON_TOKENIZE_OK) {
+        return ret;
+    }
+    skip_whitespace(&t);
+    if (t.pos != len) {
+        return JSON_TOKENIZE_INVALID;
+    }
+
+    // Only now touch the buffer, a failed body stays intact for the cJSON fallback
+    for (size_t i = 0; i < t.count; ++i) {
+        if (tokens[i].type == JSON_TOKEN_STRING) {
+            unescape_string(buf, &tokens[i]);
+        }
+    }
+    *count = t.count;
+    return JSON_TOKENIZE_OK;
+}
+
+bool token_value::is_number() const
+{
+    // The tokenizer only accepts numbers and the true/false/null literals as primitives
+    char c = m_buf[token().start];
+    return token().type == JSON_TOKEN_PRIMITIVE && (c == '-' || (c >= '0' && c <= '9'));
+}
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter
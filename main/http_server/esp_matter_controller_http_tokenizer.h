@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: 2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace esp_matter {
+namespace controller {
+namespace http_server {
+
+#define JSON_TOKENIZER_MAX_DEPTH 8     // Deepest nesting handled, deeper bodies are left to cJSON
+#define JSON_TOKENIZER_MAX_LENGTH 65535 // Token offsets are 16-bit
+
+typedef enum {
+    JSON_TOKEN_OBJECT,
+    JSON_TOKEN_ARRAY,
+    JSON_TOKEN_STRING,
+    JSON_TOKEN_PRIMITIVE, // Number, true, false or null
+} json_token_type_t;
+
+typedef struct {
+    uint8_t type;   // json_token_type_t
+    uint16_t start; // Offset of the first character, after the quote for strings
+    uint16_t end;   // Offset one past the last character
+    uint16_t size;  // Members of an object or elements of an array
+    uint16_t next;  // Index of the token that follows this one and all of its children
+} json_token_t;
+
+typedef enum {
+    JSON_TOKENIZE_OK,
+    JSON_TOKENIZE_INVALID,     // Not valid JSON
+    JSON_TOKENIZE_UNSUPPORTED, // Valid as far as checked, but beyond the tokenizer limits
+} json_tokenize_result_t;
+
+/**
+ * @brief Tokenize a JSON document in place, without allocating
+ *
+ * On success the strings are unescaped and NUL-terminated inside buf, so
+ * their tokens can be used as C strings. Nothing is written to buf on
+ * failure, so it can still be handed to cJSON_Parse().
+ *
+ * @param buf JSON text, NUL-terminated
+ * @param len Length of the text
+ * @param tokens Token array, tokens[0] is the root value
+ * @param max_tokens Capacity of tokens
+ * @param count Number of tokens used
+ * @return JSON_TOKENIZE_UNSUPPORTED for bodies with too many tokens, too deep nesting or \u escapes
+ */
+json_tokenize_result_t json_tokenize(char *buf, size_t len, json_token_t *tokens, size_t max_tokens,
+                                     size_t *count);
+
+/**
+ * @brief View of a token, usable as a schema value
+ */
+class token_value {
+public:
+    token_value(const char *buf, const json_token_t *tokens, uint16_t index)
+        : m_buf(buf), m_tokens(tokens), m_index(index)
+    {
+    }
+
+    bool is_object() const { return token().type == JSON_TOKEN_OBJECT; }
+    bool is_bool() const { return primitive_is("true") || primitive_is("false"); }
+    bool get_bool() const { return primitive_is("true"); }
+    bool is_number() const;
+    double get_number() const { return strtod(m_buf + token().start, NULL); }
+    const char *get_number_text() const { return m_buf + token().start; }
+    bool is_string() const { return token().type == JSON_TOKEN_STRING; }
+    const char *get_string() const { return m_buf + token().start; }
+    bool is_array() const { return token().type == JSON_TOKEN_ARRAY; }
+    size_t array_size() const { return token().size; }
+
+    template <typename F>
+    bool for_each_element(F &&fn) const
+    {
+        uint16_t index = m_index + 1;
+        for (uint16_t i = 0; i < token().size; ++i) {
+            if (!fn(token_value(m_buf, m_tokens, index))) {
+                return false;
+            }
+            index = m_tokens[index].next;
+        }
+        return true;
+    }
+
+    template <typename F>
+    bool for_each_member(F &&fn) const
+    {
+        uint16_t index = m_index + 1;
+        for (uint16_t i = 0; i < token().size; ++i) {
+            // Keys are string tokens directly followed by their value
+            if (!fn(m_buf + m_tokens[index].start, token_value(m_buf, m_tokens, index + 1))) {
+                return false;
+            }
+            index = m_tokens[index + 1].next;
+        }
+        return true;
+    }
+
+private:
+    const json_token_t &token() const { return m_tokens[m_index]; }
+
+    bool primitive_is(const char *literal) const
+    {
+        size_t len = strlen(literal);
+        return token().type == JSON_TOKEN_PRIMITIVE && (size_t)(token().end - token().start) == len &&
+            memcmp(m_buf + token().start, literal, len) == 0;
+    }
+
+    const char *m_buf;
+    const json_token_t *m_tokens;
+    uint16_t m_index;
+};
+
+} // namespace http_server
+} // namespace controller
+} // namespace esp_matter